@@ -0,0 +1,569 @@
+/* gmbench：SM3 与 SM4 各内核、各工作模式的统一基准
+ *
+ * 每个算法在 16B..64MB 的消息长度上各测一组样本，报告：
+ *   cycles_per_byte  单次调用周期数的中位数 / 字节数
+ *   gbps             总字节数 / 总耗时（1 GB = 1e9 字节）
+ *   p50_ns / p99_ns  单次调用延迟的分位数
+ * 短消息一次样本连续调用多次（inner 次，凑够约 4KB），延迟按平均到每次调用计算，避免计时开销淹没结果。
+ * 周期来源：perf_event_open 的 CPU 周期计数（只统计本线程的用户态），不可用时退回 rdtsc
+ * （TSC 按固定频率计数，睿频下与核心周期不同，输出里给出 TSC 频率供换算）。
+ *
+ * 输出 JSON（每个结果独占一行，便于 diff）；--baseline 读入以前的输出，
+ * 任一结果吞吐下降超过 --threshold 百分比时返回 2，供 CI 捕捉性能回退；
+ * 基线读不到、里面没有结果、或者没有一个结果对得上时返回 3。
+ *
+ * 编译：在仓库根目录用 CMake 构建（目标 gmbench）
+ * 用法：gmbench [-o 文件] [--baseline 文件] [--threshold 10] [--filter 子串]
+ *               [--min-size 16] [--max-size 64M] [--time 0.2] [--cpu 0] [--counter perf|tsc]
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <x86intrin.h>
+#ifdef __linux__
+#include <sched.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+#include "gmcrypto.h"
+#include "sm4_lanes.h"
+
+#define MIN_REPS    5
+#define MAX_REPS    20000
+#define INNER_BYTES 4096           /* 短消息每个样本至少处理的字节数 */
+#define MAX_CASES   32
+
+/* ===== 计时 ===== */
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int perfFd = -1;
+
+/* 打开本线程的 CPU 周期计数器；内核不允许（perf_event_paranoid、虚拟机）时返回 0 */
+static int perf_open(void) {
+#ifdef __linux__
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_CPU_CYCLES;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    perfFd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    if (perfFd < 0) return 0;
+    ioctl(perfFd, PERF_EVENT_IOC_ENABLE, 0);
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+static inline uint64_t cycles_begin(void) {
+#ifdef __linux__
+    if (perfFd >= 0) {
+        uint64_t v = 0;
+        if (read(perfFd, &v, sizeof(v)) != sizeof(v)) v = 0;
+        return v;
+    }
+#endif
+    _mm_lfence();
+    return __rdtsc();
+}
+
+static inline uint64_t cycles_end(void) {
+#ifdef __linux__
+    if (perfFd >= 0) return cycles_begin();
+#endif
+    unsigned aux;
+    uint64_t t = __rdtscp(&aux);
+    _mm_lfence();
+    return t;
+}
+
+/* TSC 频率：对照单调时钟数 100ms */
+static double tsc_ghz(void) {
+    double t0 = now_ns();
+    uint64_t c0 = __rdtsc();
+    while (now_ns() - t0 < 1e8) {}
+    return (double)(__rdtsc() - c0) / (now_ns() - t0);
+}
+
+static int pin_cpu(int cpu) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return 0;
+#endif
+}
+
+/* ===== 被测算法 =====
+ *   prep 在每个消息长度开始前调用一次（建立上下文、生成 open 用的合法标签），run 为一次调用。 */
+
+typedef struct {
+    char name[32];
+    int arg;
+    void (*prep)(int arg, size_t len);
+    void (*run)(int arg, size_t len);
+} bench_case;
+
+static uint8_t *gIn, *gOut;
+static uint8_t gUserKey[32], gIv[16], gTag[16];
+static sm4_key gEnc;
+static sm4_key_pair gPair, gTweak;
+static sm4_gcm_key gGcm;
+static sm4_mode_ctx gMode;
+static const uint8_t *gMsgs[64];
+static size_t gLens[64];
+static uint32_t gDigests[64][8];
+static sm3_hmac_key gHmacKey;
+static const sm3_hmac_key *gHmacKeys[64];
+static uint8_t gMacs[64][32];
+
+static void prep_none(int arg, size_t len) { (void)arg; (void)len; }
+
+static void run_sm3(int arg, size_t len) {
+    uint32_t h[8];
+    (void)arg;
+    sm3_hash(gIn, len, h);
+}
+
+/* 多缓冲：同样的总字节数切成 arg 条等长消息 */
+static void prep_sm3_mb(int arg, size_t len) {
+    for (int i = 0; i < arg; ++i) {
+        gMsgs[i] = gIn + i * (len / arg);
+        gLens[i] = len / arg;
+    }
+}
+
+static void run_sm3_mb(int arg, size_t len) {
+    (void)len;
+    sm3_hash_many(gMsgs, gLens, gDigests, (size_t)arg);
+}
+
+/* HMAC：密钥的 ipad/opad 状态预先算好；批量版同样把总字节数切成 arg 条令牌 */
+static void run_sm3_hmac(int arg, size_t len) {
+    uint8_t mac[32];
+    (void)arg;
+    sm3_hmac(&gHmacKey, gIn, len, mac);
+}
+
+static void prep_sm3_hmac_mb(int arg, size_t len) {
+    prep_sm3_mb(arg, len);
+    for (int i = 0; i < arg; ++i) gHmacKeys[i] = &gHmacKey;
+}
+
+static void run_sm3_hmac_mb(int arg, size_t len) {
+    (void)len;
+    sm3_hmac_many(gHmacKeys, gMsgs, gLens, gMacs, (size_t)arg);
+}
+
+/* 单分组延迟路径：逐块调用 sm4_crypt_block */
+static void run_sm4_block(int arg, size_t len) {
+    (void)arg;
+    for (size_t off = 0; off < len; off += 16) sm4_crypt_block(&gEnc, gIn + off, gOut + off);
+}
+
+/* arg < 0 为自动选择，否则为 enum sm4_batch_isa；查表内核单独一项 */
+#define ECB_AUTO   (-1)
+#define ECB_TTABLE (-2)
+
+static void run_sm4_ecb(int arg, size_t len) {
+    if (arg == ECB_AUTO) sm4_crypt_blocks(&gEnc, gIn, gOut, len / 16);
+    else if (arg == ECB_TTABLE) sm4_ttable_blocks(gEnc.rk, gIn, gOut, len / 16);
+    else sm4_crypt_blocks_isa((enum sm4_batch_isa)arg, &gEnc, gIn, gOut, len / 16);
+}
+
+static void run_sm4_ctr(int arg, size_t len) {
+    (void)arg;
+    sm4_ctr_blocks(&gEnc, gIv, gIn, gOut, len / 16);
+}
+
+/* 工作模式：arg = mode * 2 + enc；每次调用换 IV 开始一条新消息 */
+static void prep_sm4_mode(int arg, size_t len) {
+    (void)len;
+    sm4_mode_init_keys(&gMode, (enum sm4_mode)(arg / 2), arg % 2, &gPair, &gTweak, gIv);
+}
+
+static void run_sm4_mode(int arg, size_t len) {
+    size_t n;
+    (void)arg;
+    sm4_mode_set_iv(&gMode, gIv);
+    n = sm4_mode_update(&gMode, gIn, gOut, len);
+    sm4_mode_final(&gMode, gOut + n);
+}
+
+/* CCM 的 nonce 取 11 字节，长度字段 4 字节，64MB 的消息也放得下 */
+#define CCM_NONCE 11
+
+/* AEAD：arg 0 = GCM seal，1 = GCM open，2 = CCM seal，3 = CCM open；open 前先算出合法标签 */
+static void prep_aead(int arg, size_t len) {
+    if (arg == 1) sm4_gcm_seal(&gGcm, gIv, 12, NULL, 0, gIn, len, gOut, gTag, 16);
+    if (arg == 3) sm4_ccm_seal(&gEnc, gIv, CCM_NONCE, NULL, 0, gIn, len, gOut, gTag, 16);
+    if (arg == 1 || arg == 3) memcpy(gIn + len, gOut, len);   /* 密文放在明文之后，open 读它 */
+}
+
+static void run_aead(int arg, size_t len) {
+    int ok = 0;
+    switch (arg) {
+        case 0: ok = sm4_gcm_seal(&gGcm, gIv, 12, NULL, 0, gIn, len, gOut, gTag, 16); break;
+        case 1: ok = sm4_gcm_open(&gGcm, gIv, 12, NULL, 0, gIn + len, len, gOut, gTag, 16); break;
+        case 2: ok = sm4_ccm_seal(&gEnc, gIv, CCM_NONCE, NULL, 0, gIn, len, gOut, gTag, 16); break;
+        case 3: ok = sm4_ccm_open(&gEnc, gIv, CCM_NONCE, NULL, 0, gIn + len, len, gOut, gTag, 16); break;
+    }
+    if (ok != 0) {
+        fprintf(stderr, "aead case %d failed at %zu bytes\n", arg, len);
+        exit(1);
+    }
+}
+
+static bench_case gCases[MAX_CASES];
+static int gNumCases;
+
+static void add_case(const char *name, int arg,
+                     void (*prep)(int, size_t), void (*run)(int, size_t)) {
+    bench_case *c = &gCases[gNumCases++];
+    snprintf(c->name, sizeof(c->name), "%s", name);
+    c->arg = arg;
+    c->prep = prep;
+    c->run = run;
+}
+
+static void build_cases(void) {
+    static const struct { const char *name; enum sm4_mode mode; int enc; } modes[] = {
+        {"sm4-cbc-enc", SM4_MODE_CBC, 1}, {"sm4-cbc-dec", SM4_MODE_CBC, 0},
+        {"sm4-cfb-enc", SM4_MODE_CFB, 1}, {"sm4-cfb-dec", SM4_MODE_CFB, 0},
+        {"sm4-ofb", SM4_MODE_OFB, 1},
+        {"sm4-xts-enc", SM4_MODE_XTS, 1}, {"sm4-xts-dec", SM4_MODE_XTS, 0},
+    };
+    char name[32];
+
+    add_case("sm3", 0, prep_none, run_sm3);
+    add_case("sm3-mb", 16, prep_sm3_mb, run_sm3_mb);
+    add_case("sm3-hmac", 0, prep_none, run_sm3_hmac);
+    add_case("sm3-hmac-mb", 16, prep_sm3_hmac_mb, run_sm3_hmac_mb);
+
+    snprintf(name, sizeof(name), "sm4-block-%s", sm4_block_impl_name());
+    add_case(name, 0, prep_none, run_sm4_block);
+    add_case("sm4-ecb", ECB_AUTO, prep_none, run_sm4_ecb);
+    for (int isa = SM4_BATCH_SSE2; isa <= SM4_BATCH_AVX512; ++isa) {
+        if (!sm4_batch_isa_supported((enum sm4_batch_isa)isa)) continue;
+        snprintf(name, sizeof(name), "sm4-ecb-%s", sm4_batch_isa_name((enum sm4_batch_isa)isa));
+        add_case(name, isa, prep_none, run_sm4_ecb);
+    }
+    add_case("sm4-ecb-ttable", ECB_TTABLE, prep_none, run_sm4_ecb);
+    add_case("sm4-ctr", 0, prep_none, run_sm4_ctr);
+    for (size_t i = 0; i < sizeof(modes) / sizeof(modes[0]); ++i)
+        add_case(modes[i].name, modes[i].mode * 2 + modes[i].enc, prep_sm4_mode, run_sm4_mode);
+    add_case("sm4-gcm-seal", 0, prep_aead, run_aead);
+    add_case("sm4-gcm-open", 1, prep_aead, run_aead);
+    add_case("sm4-ccm-seal", 2, prep_aead, run_aead);
+    add_case("sm4-ccm-open", 3, prep_aead, run_aead);
+}
+
+/* ===== 测量 ===== */
+
+typedef struct {
+    size_t reps, inner;
+    double cpb, gbps, p50_ns, p99_ns;
+} bench_result;
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(const double *sorted, size_t n, double p) {
+    size_t i = (size_t)(p * (n - 1) + 0.5);
+    return sorted[i < n ? i : n - 1];
+}
+
+static bench_result measure(const bench_case *c, size_t len, double budget_ns,
+                            double *ns, double *cyc) {
+    bench_result r;
+    size_t inner = len < INNER_BYTES ? INNER_BYTES / len : 1;
+    double total_ns = 0;
+
+    c->prep(c->arg, len);
+    for (size_t i = 0; i < inner; ++i) c->run(c->arg, len);   /* 预热 */
+
+    r.reps = 0;
+    while (r.reps < MAX_REPS && (r.reps < MIN_REPS || total_ns < budget_ns)) {
+        uint64_t c0 = cycles_begin();
+        double t0 = now_ns();
+        for (size_t i = 0; i < inner; ++i) c->run(c->arg, len);
+        double t1 = now_ns();
+        uint64_t c1 = cycles_end();
+        ns[r.reps] = (t1 - t0) / inner;
+        cyc[r.reps] = (double)(c1 - c0) / inner;
+        total_ns += t1 - t0;
+        r.reps++;
+    }
+
+    qsort(ns, r.reps, sizeof(double), cmp_double);
+    qsort(cyc, r.reps, sizeof(double), cmp_double);
+    r.inner = inner;
+    r.cpb = percentile(cyc, r.reps, 0.5) / len;
+    r.gbps = (double)len * inner * r.reps / total_ns;
+    r.p50_ns = percentile(ns, r.reps, 0.5);
+    r.p99_ns = percentile(ns, r.reps, 0.99);
+    return r;
+}
+
+/* ===== 基线比较 ===== */
+
+typedef struct {
+    char name[32];
+    size_t size;
+    double gbps;
+} baseline_entry;
+
+/* 在 [p, end) 里找 "key"，跳过其后的空白与冒号，返回值的起点；找不到返回 NULL */
+static const char *json_field(const char *p, const char *end, const char *key) {
+    size_t klen = strlen(key);
+    for (; p + klen + 2 <= end; ++p) {
+        if (p[0] != '"' || memcmp(p + 1, key, klen) != 0 || p[klen + 1] != '"') continue;
+        const char *v = p + klen + 2;
+        while (v < end && (*v == ' ' || *v == '\t' || *v == '\r' || *v == '\n')) ++v;
+        if (v >= end || *v != ':') continue;
+        ++v;
+        while (v < end && (*v == ' ' || *v == '\t' || *v == '\r' || *v == '\n')) ++v;
+        return v < end ? v : NULL;
+    }
+    return NULL;
+}
+
+/* 读入以前的输出：取 "results" 数组里的每个对象，与缩进、换行无关（结果对象里没有嵌套）。
+ * 打不开、读失败或内存不足返回 -1；*count 为取到 name / size / gbps 三个字段都齐全的结果数 */
+static int load_baseline(const char *path, baseline_entry **out, size_t *count) {
+    FILE *f = fopen(path, "rb");
+    char *text = NULL;
+    size_t len = 0, cap = 0, n = 0, ncap = 0;
+    baseline_entry *list = NULL;
+    int rc = -1;
+    if (!f) return -1;
+    for (;;) {
+        if (len + 4096 + 1 > cap) {
+            cap = cap ? cap * 2 : 65536;
+            char *t = (char *)realloc(text, cap);
+            if (!t) goto done;
+            text = t;
+        }
+        size_t got = fread(text + len, 1, cap - len - 1, f);
+        len += got;
+        if (got == 0) break;
+    }
+    if (ferror(f)) goto done;
+    text[len] = 0;
+
+    const char *end = text + len, *p = json_field(text, end, "results");
+    if (p && *p == '[') {
+        for (++p; p < end && *p != ']'; ++p) {
+            if (*p != '{') continue;
+            const char *close = memchr(p, '}', (size_t)(end - p));
+            if (!close) break;
+            const char *nm = json_field(p, close, "name"), *sz = json_field(p, close, "size"),
+                       *gb = json_field(p, close, "gbps");
+            if (nm && *nm == '"' && sz && gb) {
+                if (n == ncap) {
+                    ncap = ncap ? ncap * 2 : 256;
+                    baseline_entry *t = (baseline_entry *)realloc(list, ncap * sizeof(*list));
+                    if (!t) goto done;
+                    list = t;
+                }
+                size_t k = 0;
+                for (++nm; nm < close && *nm != '"' && k + 1 < sizeof(list[n].name); ++nm)
+                    list[n].name[k++] = *nm;
+                list[n].name[k] = 0;
+                list[n].size = (size_t)strtoull(sz, NULL, 10);
+                list[n].gbps = strtod(gb, NULL);
+                n++;
+            }
+            p = close;
+        }
+    }
+    rc = 0;
+
+done:
+    fclose(f);
+    free(text);
+    if (rc != 0) {
+        free(list);
+        list = NULL;
+        n = 0;
+    }
+    *out = list;
+    *count = n;
+    return rc;
+}
+
+static const baseline_entry *find_baseline(const baseline_entry *list, size_t n,
+                                           const char *name, size_t size) {
+    for (size_t i = 0; i < n; ++i)
+        if (list[i].size == size && strcmp(list[i].name, name) == 0) return &list[i];
+    return NULL;
+}
+
+/* ===== 主程序 ===== */
+
+static size_t parse_size(const char *s) {
+    char *end;
+    size_t v = (size_t)strtoull(s, &end, 10);
+    if (*end == 'K' || *end == 'k') v <<= 10;
+    else if (*end == 'M' || *end == 'm') v <<= 20;
+    return v;
+}
+
+static void usage(void) {
+    fprintf(stderr,
+            "usage: gmbench [-o FILE] [--baseline FILE] [--threshold PCT] [--filter STR]\n"
+            "               [--min-size N] [--max-size N] [--time SEC] [--cpu N|-1]\n"
+            "               [--counter perf|tsc] [--list]\n");
+}
+
+int main(int argc, char **argv) {
+    const char *outPath = NULL, *basePath = NULL, *filter = NULL, *counter = "perf";
+    size_t minSize = 16, maxSize = (size_t)64 << 20;
+    double threshold = 10, seconds = 0.2;
+    int cpu = 0, list = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        const char *a = argv[i];
+        int more = i + 1 < argc;
+        if (!strcmp(a, "-o") && more) outPath = argv[++i];
+        else if (!strcmp(a, "--baseline") && more) basePath = argv[++i];
+        else if (!strcmp(a, "--threshold") && more) threshold = atof(argv[++i]);
+        else if (!strcmp(a, "--filter") && more) filter = argv[++i];
+        else if (!strcmp(a, "--min-size") && more) minSize = parse_size(argv[++i]);
+        else if (!strcmp(a, "--max-size") && more) maxSize = parse_size(argv[++i]);
+        else if (!strcmp(a, "--time") && more) seconds = atof(argv[++i]);
+        else if (!strcmp(a, "--cpu") && more) cpu = atoi(argv[++i]);
+        else if (!strcmp(a, "--counter") && more) counter = argv[++i];
+        else if (!strcmp(a, "--list")) list = 1;
+        else { usage(); return 1; }
+    }
+    if (minSize < 16) minSize = 16;
+    if (maxSize < minSize) maxSize = minSize;
+
+    gmcrypto_init();
+    build_cases();
+    if (list) {
+        for (int i = 0; i < gNumCases; ++i) printf("%s\n", gCases[i].name);
+        return 0;
+    }
+
+    int pinned = cpu >= 0 && pin_cpu(cpu);
+    if (strcmp(counter, "perf") == 0 && !perf_open()) counter = "tsc";
+    else if (strcmp(counter, "perf") != 0) counter = "tsc";
+    double ghz = tsc_ghz();
+
+    /* open 把密文放在明文之后，输入区留两倍长度 */
+    gIn = (uint8_t *)malloc(2 * maxSize);
+    gOut = (uint8_t *)malloc(maxSize + 32);
+    if (!gIn || !gOut) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    for (size_t i = 0; i < 2 * maxSize; ++i) gIn[i] = (uint8_t)(i * 131 + 17);
+    for (int i = 0; i < 32; ++i) gUserKey[i] = (uint8_t)(0x10 * i + 7);
+    for (int i = 0; i < 16; ++i) gIv[i] = (uint8_t)i;
+    sm4_set_encrypt_key(&gEnc, gUserKey);
+    sm4_key_pair_init(&gPair, gUserKey);
+    sm4_key_pair_init(&gTweak, gUserKey + 16);
+    sm4_gcm_init(&gGcm, gUserKey);
+    sm3_hmac_key_init(&gHmacKey, gUserKey, 32);
+
+    FILE *out = outPath ? fopen(outPath, "w") : stdout;
+    if (!out) {
+        perror(outPath);
+        return 1;
+    }
+    /* 给了基线却读不到、或者一个结果都没有，CI 门禁不能当作通过 */
+    size_t baseCount = 0, baseMatched = 0;
+    baseline_entry *base = NULL;
+    if (basePath && load_baseline(basePath, &base, &baseCount) != 0) {
+        fprintf(stderr, "error: cannot read baseline %s\n", basePath);
+        return 3;
+    }
+    if (basePath && baseCount == 0) {
+        fprintf(stderr, "error: no results found in baseline %s\n", basePath);
+        return 3;
+    }
+
+    double *ns = (double *)malloc(MAX_REPS * sizeof(double));
+    double *cyc = (double *)malloc(MAX_REPS * sizeof(double));
+    int regressions = 0, first = 1;
+
+    fprintf(out, "{\n");
+    fprintf(out, "  \"tool\": \"gmbench\",\n");
+    fprintf(out, "  \"version\": \"%d.%d.%d\",\n", GMCRYPTO_VERSION_MAJOR,
+            GMCRYPTO_VERSION_MINOR, GMCRYPTO_VERSION_PATCH);
+    fprintf(out, "  \"dispatch\": \"%s\",\n", gmcrypto_dispatch_info());
+    fprintf(out, "  \"counter\": \"%s\",\n", counter);
+    fprintf(out, "  \"tsc_ghz\": %.3f,\n", ghz);
+    fprintf(out, "  \"cpu\": %d,\n", pinned ? cpu : -1);
+    fprintf(out, "  \"time_per_point\": %.3f,\n", seconds);
+    fprintf(out, "  \"results\": [\n");
+
+    fprintf(stderr, "counter=%s tsc=%.3fGHz cpu=%d  %s\n", counter, ghz,
+            pinned ? cpu : -1, gmcrypto_dispatch_info());
+    fprintf(stderr, "%-24s %10s %8s %10s %9s %12s %12s\n",
+            "name", "size", "reps", "cyc/B", "GB/s", "p50 ns", "p99 ns");
+
+    for (int ci = 0; ci < gNumCases; ++ci) {
+        const bench_case *c = &gCases[ci];
+        if (filter && !strstr(c->name, filter)) continue;
+        for (size_t len = minSize; len <= maxSize; len *= 4) {
+            bench_result r = measure(c, len, seconds * 1e9, ns, cyc);
+            fprintf(out, "%s    {\"name\": \"%s\", \"size\": %zu, \"reps\": %zu, \"inner\": %zu, "
+                    "\"cycles_per_byte\": %.3f, \"gbps\": %.4f, \"p50_ns\": %.1f, \"p99_ns\": %.1f}",
+                    first ? "" : ",\n", c->name, len, r.reps, r.inner,
+                    r.cpb, r.gbps, r.p50_ns, r.p99_ns);
+            first = 0;
+            fprintf(stderr, "%-24s %10zu %8zu %10.2f %9.3f %12.1f %12.1f", c->name, len,
+                    r.reps, r.cpb, r.gbps, r.p50_ns, r.p99_ns);
+
+            const baseline_entry *b = base ? find_baseline(base, baseCount, c->name, len) : NULL;
+            if (b && b->gbps > 0) {
+                baseMatched++;
+                double delta = (r.gbps / b->gbps - 1) * 100;
+                fprintf(stderr, "  %+6.1f%%", delta);
+                if (delta < -threshold) {
+                    fprintf(stderr, " REGRESSION");
+                    regressions++;
+                }
+            }
+            fprintf(stderr, "\n");
+            if (len > maxSize / 4) break;
+        }
+    }
+    fprintf(out, "\n  ]\n}\n");
+    if (out != stdout) fclose(out);
+
+    int status = regressions ? 2 : 0;
+    if (basePath) {
+        fprintf(stderr, "%d regression(s) beyond %.1f%% vs %s (%zu of %zu baseline results matched)\n",
+                regressions, threshold, basePath, baseMatched, baseCount);
+        if (baseMatched == 0) {
+            fprintf(stderr, "error: no result matched the baseline\n");
+            status = 3;
+        }
+        free(base);
+    }
+    free(ns);
+    free(cyc);
+    free(gIn);
+    free(gOut);
+    return status;
+}
@@ -0,0 +1,137 @@
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H
+
+/*
+ * 运行时 CPU 特性检测（CPUID + XGETBV）
+ * 供 SM3/SM4 等模块在运行时选择 SSE/AVX2/AVX-512/GFNI 等内核。
+ * AVX/AVX-512 除了 CPUID 位之外还要确认操作系统保存了对应的寄存器状态。
+ */
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+typedef struct {
+    int sse2;
+    int ssse3;
+    int sse41;
+    int aesni;
+    int pclmul;
+    int avx;
+    int avx2;
+    int bmi2;
+    int adx;
+    int avx512f;
+    int avx512bw;
+    int avx512vl;
+    int gfni;
+    int vaes;
+    int vpclmul;
+} cpu_features_t;
+
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+static inline void cpu_cpuid(unsigned leaf, unsigned sub, unsigned r[4]) {
+#if defined(_MSC_VER)
+    int t[4];
+    __cpuidex(t, (int)leaf, (int)sub);
+    r[0] = (unsigned)t[0]; r[1] = (unsigned)t[1];
+    r[2] = (unsigned)t[2]; r[3] = (unsigned)t[3];
+#else
+    r[0] = r[1] = r[2] = r[3] = 0;
+    __cpuid_count(leaf, sub, r[0], r[1], r[2], r[3]);
+#endif
+}
+
+static inline unsigned long long cpu_xgetbv0(void) {
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    unsigned lo, hi;
+    __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return ((unsigned long long)hi << 32) | lo;
+#endif
+}
+#endif
+
+/* 初始化状态的原子读写：读用 acquire，发布用 release，读到“已就绪”时 f 的内容一定已经可见 */
+static inline long cpu_state_load(long *p) {
+#if defined(_MSC_VER)
+    return _InterlockedOr((volatile long *)p, 0);
+#else
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+#endif
+}
+
+/* 0 -> 1，成功表示由当前线程负责检测 */
+static inline int cpu_state_claim(long *p) {
+#if defined(_MSC_VER)
+    return _InterlockedCompareExchange((volatile long *)p, 1, 0) == 0;
+#else
+    long expect = 0;
+    return __atomic_compare_exchange_n(p, &expect, 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE);
+#endif
+}
+
+static inline void cpu_state_publish(long *p) {
+#if defined(_MSC_VER)
+    _InterlockedExchange((volatile long *)p, 2);
+#else
+    __atomic_store_n(p, 2, __ATOMIC_RELEASE);
+#endif
+}
+
+/* 检测一次并缓存结果：第一个线程检测并发布，同时进来的其他线程等它发布后再读 */
+static inline const cpu_features_t *cpu_features(void) {
+    static cpu_features_t f;
+    static long state = 0;      /* 0 未检测，1 检测中，2 已就绪 */
+    if (cpu_state_load(&state) == 2) return &f;
+    if (!cpu_state_claim(&state)) {
+        while (cpu_state_load(&state) != 2) {
+        }
+        return &f;
+    }
+
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+    unsigned r[4];
+    cpu_cpuid(0, 0, r);
+    unsigned max_leaf = r[0];
+
+    cpu_cpuid(1, 0, r);
+    unsigned ecx1 = r[2], edx1 = r[3];
+    f.sse2   = (edx1 >> 26) & 1;
+    f.ssse3  = (ecx1 >> 9) & 1;
+    f.sse41  = (ecx1 >> 19) & 1;
+    f.aesni  = (ecx1 >> 25) & 1;
+    f.pclmul = (ecx1 >> 1) & 1;
+
+    /* OSXSAVE 置位时才能读 XCR0：bit1/2 = SSE/AVX，bit5/6/7 = opmask/ZMM */
+    int os_avx = 0, os_avx512 = 0;
+    if ((ecx1 >> 27) & 1) {
+        unsigned long long xcr0 = cpu_xgetbv0();
+        os_avx = (xcr0 & 0x6) == 0x6;
+        os_avx512 = os_avx && (xcr0 & 0xe0) == 0xe0;
+    }
+    f.avx = os_avx && ((ecx1 >> 28) & 1);
+
+    if (max_leaf >= 7) {
+        cpu_cpuid(7, 0, r);
+        unsigned ebx7 = r[1], ecx7 = r[2];
+        f.avx2     = f.avx && ((ebx7 >> 5) & 1);
+        f.bmi2     = (ebx7 >> 8) & 1;
+        f.adx      = (ebx7 >> 19) & 1;
+        f.avx512f  = os_avx512 && ((ebx7 >> 16) & 1);
+        f.avx512bw = f.avx512f && ((ebx7 >> 30) & 1);
+        f.avx512vl = f.avx512f && ((ebx7 >> 31) & 1);
+        f.gfni     = f.sse41 && ((ecx7 >> 8) & 1);
+        f.vaes     = f.avx && ((ecx7 >> 9) & 1);
+        f.vpclmul  = f.avx && ((ecx7 >> 10) & 1);
+    }
+#endif
+
+    cpu_state_publish(&state);
+    return &f;
+}
+
+#endif /* CPU_FEATURES_H */
@@ -0,0 +1,117 @@
+#ifndef GM_TRACE_H
+#define GM_TRACE_H
+
+/*
+ * 库内部的计时区段（对外接口见 include/gmcrypto_trace.h）
+ *   GM_TRACE_ZONE(区段, 字节数) 放在函数体开头：进入时取时间戳，离开作用域时记一次；
+ *   字节数表达式只在计时打开时求值，可以写循环求和之类的东西。
+ *   没有定义 GMCRYPTO_INSTRUMENT 时宏展开为空语句，不产生任何代码。
+ * 打开时的开销：计时关着只多一次全局变量读和一个分支；开着约两次 rdtsc 加一次直方图更新（几十个周期）。
+ * 计时层只支持 GCC / Clang（__atomic 内建函数、C 里的 cleanup 属性）和 POSIX 线程，
+ * MSVC 或 Windows 上打开 GMCRYPTO_INSTRUMENT 时 CMake 直接报错；默认构建不受影响。
+ */
+
+#include "gmcrypto_trace.h"
+
+#ifdef GMCRYPTO_INSTRUMENT
+
+#if !defined(__GNUC__) || defined(_WIN32)
+#error "GMCRYPTO_INSTRUMENT needs GCC or Clang on a POSIX system"
+#endif
+
+#include <stdint.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <time.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    int flags;          /* 进入时的 gm_trace_flags，0 表示这次不计 */
+    int zone;
+    uint64_t bytes;
+    uint64_t t0;
+    uint64_t pmc[4];
+} gm_trace_scope;
+
+/* 小于 0 表示还没读过环境变量 */
+extern int gm_trace_flags;
+
+int gm_trace_init(void);
+void gm_trace_pmc(uint64_t v[4]);
+void gm_trace_record(gm_trace_scope *s, uint64_t t1);
+
+/* 时间戳：TSC 频率在汇总时对照单调时钟换算；不是 x86 时直接是纳秒 */
+static inline uint64_t gm_trace_begin_ticks(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_lfence();
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+/* rdtscp 等前面的指令都执行完才读 TSC，不会把区段里的尾巴算到外面去 */
+static inline uint64_t gm_trace_end_ticks(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned aux;
+    return __rdtscp(&aux);
+#else
+    return gm_trace_begin_ticks();
+#endif
+}
+
+static inline int gm_trace_enter(gm_trace_scope *s, int zone) {
+    int f = __atomic_load_n(&gm_trace_flags, __ATOMIC_RELAXED);
+    if (f < 0) f = gm_trace_init();
+    s->flags = f;
+    s->zone = zone;
+    return f;
+}
+
+static inline void gm_trace_start(gm_trace_scope *s) {
+    if (s->flags & GMCRYPTO_TRACE_PERF) gm_trace_pmc(s->pmc);
+    s->t0 = gm_trace_begin_ticks();
+}
+
+static inline void gm_trace_leave(gm_trace_scope *s) {
+    if (s->flags) gm_trace_record(s, gm_trace_end_ticks());
+}
+
+#define GM_TRACE_CAT2(a, b) a##b
+#define GM_TRACE_CAT(a, b) GM_TRACE_CAT2(a, b)
+
+#ifdef __cplusplus
+}
+
+struct gm_trace_guard {
+    gm_trace_scope s;
+    ~gm_trace_guard() { gm_trace_leave(&s); }
+};
+#define GM_TRACE_DECL(v) gm_trace_guard GM_TRACE_CAT(v, _g); gm_trace_scope &v = GM_TRACE_CAT(v, _g).s
+#else
+#define GM_TRACE_DECL(v) gm_trace_scope v __attribute__((cleanup(gm_trace_leave)))
+#endif
+
+#define GM_TRACE_VAR GM_TRACE_CAT(gm_trace_zone_, __LINE__)
+
+#define GM_TRACE_ZONE(zone, nbytes)                                 \
+    GM_TRACE_DECL(GM_TRACE_VAR);                                     \
+    if (gm_trace_enter(&GM_TRACE_VAR, (zone))) {                     \
+        GM_TRACE_VAR.bytes = (uint64_t)(nbytes);                     \
+        gm_trace_start(&GM_TRACE_VAR);                               \
+    }
+
+#else /* !GMCRYPTO_INSTRUMENT */
+
+#define GM_TRACE_ZONE(zone, nbytes) ((void)0)
+
+#endif /* GMCRYPTO_INSTRUMENT */
+
+#endif /* GM_TRACE_H */
@@ -0,0 +1,171 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * 简单的常驻线程池
+ * parallel_for(n, fn) 把 [0, n) 的下标交给各线程通过原子计数器自取（动态调度），
+ * 调用线程也参与计算，返回时所有 fn(i) 均已完成。
+ * parallel_for_stealing(n, fn) 是工作窃取版本：先把 [0, n) 均分成各线程的连续区间，
+ * 线程从自己区间的前端逐个取，取完后从别的线程区间的后端偷走剩下的一半。
+ * 单个任务耗时不均时负载仍然均衡，相邻下标大多落在同一线程上。
+ */
+class thread_pool {
+public:
+    explicit thread_pool(unsigned threads = 0)
+        : stop_(false), generation_(0), running_(0), job_(nullptr) {
+        if (threads == 0) threads = std::thread::hardware_concurrency();
+        if (threads == 0) threads = 1;
+        // 调用线程自己算一份，只需再起 threads - 1 个
+        for (unsigned i = 1; i < threads; i++) {
+            workers_.emplace_back([this, i] { worker_loop(i); });
+        }
+    }
+
+    ~thread_pool() {
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        for (size_t i = 0; i < workers_.size(); i++) workers_[i].join();
+    }
+
+    thread_pool(const thread_pool &) = delete;
+    thread_pool &operator=(const thread_pool &) = delete;
+
+    unsigned size() const { return (unsigned)workers_.size() + 1; }
+
+    // fn(i) 或 fn(i, worker)，worker 为 [0, size()) 内的线程编号，可用来索引线程私有数据
+    template <class F>
+    void parallel_for(size_t n, F fn) {
+        if (n == 0) return;
+        std::atomic<size_t> next(0);
+        run([&](unsigned worker) {
+            for (size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < n;) {
+                call(fn, i, worker);
+            }
+        });
+    }
+
+    template <class F>
+    void parallel_for_stealing(size_t n, F fn) {
+        if (n == 0) return;
+        const unsigned t = size();
+        if (t == 1 || n >= ((uint64_t)1 << 32)) {
+            parallel_for(n, fn);
+            return;
+        }
+        // 每个区间 [lo, hi) 打包成一个 64 位字，主人和窃取者都用 CAS 修改
+        std::vector<steal_range> ranges(t);
+        for (unsigned w = 0; w < t; w++) {
+            ranges[w].r.store(pack(n * w / t, n * (w + 1) / t), std::memory_order_relaxed);
+        }
+        run([&](unsigned worker) {
+            std::atomic<uint64_t> &own = ranges[worker].r;
+            for (;;) {
+                uint64_t cur = own.load(std::memory_order_acquire);
+                while (range_lo(cur) < range_hi(cur)) {
+                    size_t i = range_lo(cur);
+                    if (own.compare_exchange_weak(cur, pack(i + 1, range_hi(cur)),
+                                                  std::memory_order_acq_rel)) {
+                        call(fn, i, worker);
+                        cur = own.load(std::memory_order_acquire);
+                    }
+                }
+                // 自己的区间空了：依次找其他线程，偷后一半
+                bool stolen = false;
+                for (unsigned k = 1; k < t && !stolen; k++) {
+                    std::atomic<uint64_t> &victim = ranges[(worker + k) % t].r;
+                    uint64_t v = victim.load(std::memory_order_acquire);
+                    while (range_lo(v) < range_hi(v)) {
+                        size_t lo = range_lo(v), hi = range_hi(v);
+                        size_t mid = hi - (hi - lo + 1) / 2;
+                        if (victim.compare_exchange_weak(v, pack(lo, mid), std::memory_order_acq_rel)) {
+                            own.store(pack(mid, hi), std::memory_order_release);
+                            stolen = true;
+                            break;
+                        }
+                    }
+                }
+                if (!stolen) return;
+            }
+        });
+    }
+
+    // 每个线程（含调用线程）执行一次 fn(worker)
+    void run(const std::function<void(unsigned)> &fn) {
+        if (workers_.empty()) {
+            fn(0);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            job_ = &fn;
+            running_ = workers_.size();
+            generation_++;
+        }
+        cv_.notify_all();
+        fn(0);
+        std::unique_lock<std::mutex> lk(mu_);
+        done_cv_.wait(lk, [this] { return running_ == 0; });
+        job_ = nullptr;
+    }
+
+private:
+    // 独占一条缓存行，避免相邻线程的 CAS 互相干扰
+    struct steal_range {
+        std::atomic<uint64_t> r;
+        char pad[64 - sizeof(std::atomic<uint64_t>)];
+    };
+    static uint64_t pack(size_t lo, size_t hi) { return ((uint64_t)hi << 32) | (uint64_t)lo; }
+    static size_t range_lo(uint64_t v) { return (size_t)(uint32_t)v; }
+    static size_t range_hi(uint64_t v) { return (size_t)(v >> 32); }
+
+    template <class F>
+    static auto call(F &fn, size_t i, unsigned worker) -> decltype(fn(i, worker), void()) {
+        fn(i, worker);
+    }
+    template <class F>
+    static auto call(F &fn, size_t i, ...) -> decltype(fn(i), void()) {
+        fn(i);
+    }
+
+    void worker_loop(unsigned id) {
+        size_t seen = 0;
+        for (;;) {
+            const std::function<void(unsigned)> *job;
+            {
+                std::unique_lock<std::mutex> lk(mu_);
+                cv_.wait(lk, [&] { return stop_ || generation_ != seen; });
+                if (stop_) return;
+                seen = generation_;
+                job = job_;
+            }
+            (*job)(id);
+            {
+                std::lock_guard<std::mutex> lk(mu_);
+                if (--running_ == 0) done_cv_.notify_one();
+            }
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    std::mutex mu_;
+    std::condition_variable cv_;
+    std::condition_variable done_cv_;
+    bool stop_;
+    size_t generation_;
+    size_t running_;
+    const std::function<void(unsigned)> *job_;
+};
+
+#endif // THREAD_POOL_H
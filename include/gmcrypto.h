@@ -0,0 +1,36 @@
+#ifndef GMCRYPTO_H
+#define GMCRYPTO_H
+
+/*
+ * libgmcrypto 对外头文件：SM4（单分组 / 批量 / 工作模式 / GCM / CCM / 轮密钥缓存）、SM3（流式 / 多缓冲 / 树模式 / HMAC / SM2 KDF / Merkle 累加器）
+ * 与 SM2（签名 / 验签 / 加密 / 解密）
+ * 每种算法的 SSE2、SSSE3、AES-NI、AVX2、GFNI、AVX-512 内核都编进同一个库，按 CPUID 选用；
+ * 共享库在加载时就选定全部实现。静态库里这个初始化单元可能不会被链接器拉进来，
+ * 多线程程序最好在启动线程前调用一次 gmcrypto_init()。
+ * 以 GMCRYPTO_INSTRUMENT 构建时各内核入口带计时区段，统计接口见 gmcrypto_trace.h。
+ */
+
+#include "sm4_pro.h"
+#include "sm3_promax.h"
+#include "sm2_pro.h"
+#include "gmcrypto_trace.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define GMCRYPTO_VERSION_MAJOR 1
+#define GMCRYPTO_VERSION_MINOR 0
+#define GMCRYPTO_VERSION_PATCH 0
+
+/* 检测 CPU 并选定所有内核；可重复调用 */
+void gmcrypto_init(void);
+
+/* 当前选用的实现，如 "sm4-block=gfni sm4-batch=avx512-gfnix16 ..."，字符串静态存储 */
+const char *gmcrypto_dispatch_info(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GMCRYPTO_H */
@@ -0,0 +1,74 @@
+#ifndef GMCRYPTO_TRACE_H
+#define GMCRYPTO_TRACE_H
+
+/*
+ * 库内热点计时：每个内核入口（SM3 压缩、SM4 轮函数、密钥扩展、各工作模式）是一个区段，
+ * 每次调用的耗时计入调用线程自己的直方图，随时可以汇总输出。
+ *   只有用 -DGMCRYPTO_INSTRUMENT=ON 构建的库才真正计时；默认构建里区段宏展开为空，下面的函数都是空实现
+ *   （gmcrypto_trace_enable 返回 -1），调用方不用区分两种构建。
+ *   计时只支持 GCC / Clang 与 POSIX 线程（Linux、macOS 等），MSVC / Windows 上不能打开 GMCRYPTO_INSTRUMENT。
+ *   时间戳 x86 上用 rdtsc / rdtscp，其他平台用 clock_gettime；
+ *   GMCRYPTO_TRACE_PERF 另外用 perf_event_open 为每个线程开一组计数器（周期、指令、缓存缺失、分支预测失败），
+ *   每个区段进出各多一次 read 系统调用，只适合看长调用。
+ *   区段可以嵌套，统计的是含子区段的时间：CTR 模式的耗时里包含它调用的批量轮函数。
+ * 环境变量（第一次进入区段时读取）：
+ *   GMCRYPTO_TRACE=0|time|perf   默认 time
+ *   GMCRYPTO_TRACE_DUMP=stderr|文件   进程退出时输出汇总，文件名以 .json 结尾时输出 JSON
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum gmcrypto_zone {
+    GMCRYPTO_ZONE_SM3_COMPRESS = 0,     /* sm3_compress_blocks（sm3_hash / update / final 都经过这里） */
+    GMCRYPTO_ZONE_SM3_MB,               /* sm3_hash_many 系列 */
+    GMCRYPTO_ZONE_SM4_KEY_SCHEDULE,     /* sm4_set_encrypt_key（解密密钥、密钥对也由它扩展） */
+    GMCRYPTO_ZONE_SM4_BLOCK,            /* sm4_crypt_block：单分组 32 轮 */
+    GMCRYPTO_ZONE_SM4_BATCH,            /* sm4_crypt_blocks / sm4_crypt_blocks_isa：批量 32 轮 */
+    GMCRYPTO_ZONE_SM4_CTR_BLOCKS,       /* sm4_ctr_blocks */
+    GMCRYPTO_ZONE_SM4_MODE_CTR,         /* sm4_mode_update，按 enum sm4_mode 的顺序排列 */
+    GMCRYPTO_ZONE_SM4_MODE_CBC,
+    GMCRYPTO_ZONE_SM4_MODE_CFB,
+    GMCRYPTO_ZONE_SM4_MODE_OFB,
+    GMCRYPTO_ZONE_SM4_MODE_XTS,
+    GMCRYPTO_ZONE_SM4_GCM,              /* sm4_gcm_seal / open */
+    GMCRYPTO_ZONE_SM4_CCM,              /* sm4_ccm_seal / open */
+    GMCRYPTO_ZONE_COUNT
+};
+
+#define GMCRYPTO_TRACE_TIME 1
+#define GMCRYPTO_TRACE_PERF 2
+
+typedef struct {
+    uint64_t calls;
+    uint64_t bytes;
+    double total_ns;
+    double min_ns, max_ns;
+    double p50_ns, p99_ns;      /* 来自直方图（每个 2 的幂分 4 档），误差在 ±12% 以内 */
+    /* 以下只在 GMCRYPTO_TRACE_PERF 生效时累计；内核或虚拟机不提供的计数器为 0 */
+    uint64_t cycles;
+    uint64_t instructions;
+    uint64_t cache_misses;
+    uint64_t branch_misses;
+} gmcrypto_zone_stats;
+
+/* 打开 / 关闭计时，flags 为 GMCRYPTO_TRACE_* 的组合，0 关闭。
+ * 返回实际生效的 flags（perf 计数器打不开时去掉 PERF）；库没有编入计时返回 -1 */
+int gmcrypto_trace_enable(int flags);
+const char *gmcrypto_zone_name(int zone);
+/* 汇总所有线程（含已退出的线程）；区段编号非法或库没有编入计时返回 -1 */
+int gmcrypto_trace_stats(int zone, gmcrypto_zone_stats *out);
+/* 清零全部统计；各线程在下次进入区段时各自清掉自己的数据，不需要加锁 */
+void gmcrypto_trace_reset(void);
+/* 输出有调用记录的区段：json 为 0 时是对齐的表格，否则是一个 JSON 对象；没有编入计时返回 -1 */
+int gmcrypto_trace_dump(FILE *f, int json);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GMCRYPTO_TRACE_H */
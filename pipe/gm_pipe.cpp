@@ -0,0 +1,612 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "gm_pipe.h"
+#include "sm3_promax.h"
+#include "sm4_pro.h"
+
+// 没有 io_uring 头文件的老系统只编译线程池后端
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define GM_PIPE_HAVE_URING 1
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+#endif
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+void gm_pipe_default_params(gm_pipe_params *params) {
+    params->buf_size = 1u << 20;
+    params->depth = 8;
+    params->backend = GM_PIPE_AUTO;
+    params->io_threads = 2;
+    params->hash = GM_PIPE_HASH_CIPHERTEXT;
+    params->decrypt = 0;
+    params->direct = 0;
+}
+
+/* ===== I/O 后端 ===== */
+
+enum { PIPE_READ = 0, PIPE_WRITE = 1 };
+
+struct pipe_cqe {
+    unsigned slot;
+    int op;
+    long res;   // 字节数，出错为 -errno
+};
+
+// 异步读写的提交 / 完成接口；每次请求的结果与一次 pread / pwrite 相同，短读写由调用方续传
+class pipe_io {
+public:
+    virtual ~pipe_io() {}
+    // off < 0 表示按文件当前位置顺序读写（管道等）
+    virtual int submit(int op, unsigned slot, int fd, uint8_t *buf, size_t len, int64_t off) = 0;
+    // 把已排队的请求交给内核；开始计算之前调用，计算期间 I/O 照常进行
+    virtual int flush() = 0;
+    // 取已完成的请求，最多 max 个；block 非 0 时至少等到一个
+    virtual int reap(pipe_cqe *out, unsigned max, int block) = 0;
+    virtual const char *name() const = 0;
+};
+
+#ifdef GM_PIPE_HAVE_URING
+
+/*
+ * 不依赖 liburing：io_uring_setup 之后把 SQ / CQ 环和 SQE 数组映射进来，
+ * 尾指针用 release 写、头指针用 acquire 读，与内核之间不需要别的同步。
+ * 缓冲区注册成功时用 READ_FIXED / WRITE_FIXED，省掉每次请求的页面固定；否则用 READV / WRITEV。
+ */
+class uring_io : public pipe_io {
+public:
+    uring_io() : fd_(-1), sq_ptr_(MAP_FAILED), cq_ptr_(MAP_FAILED), sqes_((io_uring_sqe *)MAP_FAILED),
+                 pending_(0), fixed_(0) {}
+
+    ~uring_io() {
+        if (sqes_ != MAP_FAILED) munmap(sqes_, sqes_size_);
+        if (cq_ptr_ != MAP_FAILED && cq_ptr_ != sq_ptr_) munmap(cq_ptr_, cq_size_);
+        if (sq_ptr_ != MAP_FAILED) munmap(sq_ptr_, sq_size_);
+        if (fd_ >= 0) close(fd_);
+    }
+
+    int init(unsigned entries, uint8_t *base, unsigned nbuf, size_t buf_size) {
+        io_uring_params p;
+        memset(&p, 0, sizeof(p));
+        fd_ = (int)syscall(__NR_io_uring_setup, entries, &p);
+        if (fd_ < 0) return -1;
+        sq_size_ = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+        cq_size_ = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+        const int single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single) sq_size_ = cq_size_ = sq_size_ > cq_size_ ? sq_size_ : cq_size_;
+        sq_ptr_ = mmap(NULL, sq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQ_RING);
+        if (sq_ptr_ == MAP_FAILED) return -1;
+        cq_ptr_ = single ? sq_ptr_
+                         : mmap(NULL, cq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_,
+                                IORING_OFF_CQ_RING);
+        if (cq_ptr_ == MAP_FAILED) return -1;
+        sqes_size_ = p.sq_entries * sizeof(io_uring_sqe);
+        sqes_ = (io_uring_sqe *)mmap(NULL, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_,
+                                     IORING_OFF_SQES);
+        if (sqes_ == MAP_FAILED) return -1;
+
+        uint8_t *sq = (uint8_t *)sq_ptr_, *cq = (uint8_t *)cq_ptr_;
+        sq_head_ = (unsigned *)(sq + p.sq_off.head);
+        sq_tail_ = (unsigned *)(sq + p.sq_off.tail);
+        sq_mask_ = *(unsigned *)(sq + p.sq_off.ring_mask);
+        sq_entries_ = *(unsigned *)(sq + p.sq_off.ring_entries);
+        sq_array_ = (unsigned *)(sq + p.sq_off.array);
+        cq_head_ = (unsigned *)(cq + p.cq_off.head);
+        cq_tail_ = (unsigned *)(cq + p.cq_off.tail);
+        cq_mask_ = *(unsigned *)(cq + p.cq_off.ring_mask);
+        cqes_ = (io_uring_cqe *)(cq + p.cq_off.cqes);
+
+        // 注册失败（RLIMIT_MEMLOCK 太小等）不算错误，退回向量读写
+        std::vector<iovec> iov(nbuf);
+        for (unsigned i = 0; i < nbuf; i++) {
+            iov[i].iov_base = base + (size_t)i * buf_size;
+            iov[i].iov_len = buf_size;
+        }
+        fixed_ = syscall(__NR_io_uring_register, fd_, IORING_REGISTER_BUFFERS, iov.data(), nbuf) == 0;
+        iov_.resize(2 * (size_t)nbuf);
+        return 0;
+    }
+
+    int submit(int op, unsigned slot, int fd, uint8_t *buf, size_t len, int64_t off) {
+        unsigned tail = *sq_tail_;
+        if (tail - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) == sq_entries_) {
+            if (flush() != 0) return -1;
+            if (tail - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) == sq_entries_) {
+                errno = EBUSY;
+                return -1;
+            }
+        }
+        const unsigned idx = tail & sq_mask_;
+        io_uring_sqe *sqe = &sqes_[idx];
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->fd = fd;
+        sqe->off = off < 0 ? (uint64_t)-1 : (uint64_t)off;
+        if (fixed_) {
+            sqe->opcode = op == PIPE_READ ? IORING_OP_READ_FIXED : IORING_OP_WRITE_FIXED;
+            sqe->addr = (uint64_t)(uintptr_t)buf;
+            sqe->len = (uint32_t)len;
+            sqe->buf_index = (uint16_t)slot;
+        } else {
+            iovec *v = &iov_[2 * (size_t)slot + op];
+            v->iov_base = buf;
+            v->iov_len = len;
+            sqe->opcode = op == PIPE_READ ? IORING_OP_READV : IORING_OP_WRITEV;
+            sqe->addr = (uint64_t)(uintptr_t)v;
+            sqe->len = 1;
+        }
+        sqe->user_data = (uint64_t)slot * 2 + op;
+        sq_array_[idx] = idx;
+        __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+        pending_++;
+        return 0;
+    }
+
+    int flush() {
+        while (pending_) {
+            int r = enter(pending_, 0, 0);
+            if (r < 0) return -1;
+        }
+        return 0;
+    }
+
+    int reap(pipe_cqe *out, unsigned max, int block) {
+        for (;;) {
+            unsigned head = *cq_head_, tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE), n = 0;
+            while (head != tail && n < max) {
+                const io_uring_cqe *c = &cqes_[head & cq_mask_];
+                out[n].slot = (unsigned)(c->user_data >> 1);
+                out[n].op = (int)(c->user_data & 1);
+                out[n].res = c->res;
+                n++;
+                head++;
+            }
+            __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+            if (n || !block) return (int)n;
+            if (enter(pending_, 1, IORING_ENTER_GETEVENTS) < 0) return -1;
+        }
+    }
+
+    const char *name() const { return "io_uring"; }
+
+private:
+    int enter(unsigned to_submit, unsigned min_complete, unsigned flags) {
+        for (;;) {
+            long r = syscall(__NR_io_uring_enter, fd_, to_submit, min_complete, flags, NULL, 0);
+            if (r >= 0) {
+                pending_ -= (unsigned)r < pending_ ? (unsigned)r : pending_;
+                return 0;
+            }
+            if (errno != EINTR) return -1;
+        }
+    }
+
+    int fd_;
+    void *sq_ptr_, *cq_ptr_;
+    size_t sq_size_, cq_size_, sqes_size_;
+    io_uring_sqe *sqes_;
+    unsigned *sq_head_, *sq_tail_, *sq_array_, sq_mask_, sq_entries_;
+    unsigned *cq_head_, *cq_tail_, cq_mask_;
+    io_uring_cqe *cqes_;
+    unsigned pending_;
+    int fixed_;
+    std::vector<iovec> iov_;
+};
+
+#endif // GM_PIPE_HAVE_URING
+
+// 退路：请求排进队列，I/O 线程做阻塞的 pread / pwrite，结果放进完成队列
+class thread_io : public pipe_io {
+public:
+    explicit thread_io(unsigned threads) : stop_(false) {
+        if (threads == 0) threads = 1;
+        for (unsigned i = 0; i < threads; i++) workers_.emplace_back([this] { worker_loop(); });
+    }
+
+    ~thread_io() {
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            stop_ = true;
+        }
+        sq_cv_.notify_all();
+        for (size_t i = 0; i < workers_.size(); i++) workers_[i].join();
+    }
+
+    int submit(int op, unsigned slot, int fd, uint8_t *buf, size_t len, int64_t off) {
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            sq_.push_back(request{op, slot, fd, buf, len, off});
+        }
+        sq_cv_.notify_one();
+        return 0;
+    }
+
+    int flush() { return 0; }
+
+    int reap(pipe_cqe *out, unsigned max, int block) {
+        std::unique_lock<std::mutex> lk(mu_);
+        if (block) cq_cv_.wait(lk, [this] { return !cq_.empty(); });
+        unsigned n = 0;
+        while (!cq_.empty() && n < max) {
+            out[n++] = cq_.front();
+            cq_.pop_front();
+        }
+        return (int)n;
+    }
+
+    const char *name() const { return "threads"; }
+
+private:
+    struct request {
+        int op;
+        unsigned slot;
+        int fd;
+        uint8_t *buf;
+        size_t len;
+        int64_t off;
+    };
+
+    void worker_loop() {
+        for (;;) {
+            request r;
+            {
+                std::unique_lock<std::mutex> lk(mu_);
+                sq_cv_.wait(lk, [this] { return stop_ || !sq_.empty(); });
+                // 停止时丢掉还没开始的请求；调用方在销毁前已经等完了自己关心的完成事件
+                if (stop_) return;
+                r = sq_.front();
+                sq_.pop_front();
+            }
+            ssize_t n;
+            do {
+                if (r.op == PIPE_READ) {
+                    n = r.off < 0 ? read(r.fd, r.buf, r.len) : pread(r.fd, r.buf, r.len, (off_t)r.off);
+                } else {
+                    n = r.off < 0 ? write(r.fd, r.buf, r.len) : pwrite(r.fd, r.buf, r.len, (off_t)r.off);
+                }
+            } while (n < 0 && errno == EINTR);
+            pipe_cqe c = {r.slot, r.op, n < 0 ? -(long)errno : (long)n};
+            {
+                std::lock_guard<std::mutex> lk(mu_);
+                cq_.push_back(c);
+            }
+            cq_cv_.notify_one();
+        }
+    }
+
+    std::mutex mu_;
+    std::condition_variable sq_cv_, cq_cv_;
+    std::deque<request> sq_;
+    std::deque<pipe_cqe> cq_;
+    bool stop_;
+    std::vector<std::thread> workers_;
+};
+
+/* ===== 流水线 ===== */
+
+enum {
+    SLOT_FREE,
+    SLOT_READING,
+    SLOT_READY,      // 读完，等着按顺序处理
+    SLOT_QUEUED,     // 处理完，等着提交写请求
+    SLOT_WRITING,
+};
+
+struct pipe_slot {
+    int state;
+    uint64_t seq;    // 第几个缓冲区大小的块
+    int64_t off;     // 文件偏移，顺序读写时为 -1
+    size_t len;      // 读请求的长度；读完后为有效字节数
+    size_t done;     // 已读 / 已写的字节数
+};
+
+static void pipe_free(void *p) { free(p); }
+
+int gm_pipe_run(int in_fd, int out_fd, const uint8_t *key, const uint8_t iv[16], const gm_pipe_params *params,
+                uint8_t digest[32], gm_pipe_stats *stats) {
+    gm_pipe_params def;
+    if (!params) {
+        gm_pipe_default_params(&def);
+        params = &def;
+    }
+    const size_t bs = params->buf_size;
+    const unsigned depth = params->depth;
+    if (bs == 0 || bs % 4096 || bs > ((size_t)1 << 30) || depth == 0 || depth > 256 ||
+        params->hash < GM_PIPE_HASH_CIPHERTEXT || params->hash > GM_PIPE_HASH_NONE ||
+        params->backend < GM_PIPE_AUTO || params->backend > GM_PIPE_THREADS || (key && !iv)) {
+        errno = EINVAL;
+        return -1;
+    }
+    struct stat st;
+    if (fstat(in_fd, &st) != 0) return -1;
+    const int seq_in = !S_ISREG(st.st_mode);
+    const uint64_t size = seq_in ? 0 : (uint64_t)st.st_size;
+    const uint64_t nchunks = seq_in ? 0 : (size + bs - 1) / bs;
+    int seq_out = 0;
+    if (out_fd >= 0) {
+        if (fstat(out_fd, &st) != 0) return -1;
+        seq_out = !S_ISREG(st.st_mode);
+    }
+
+    double t0 = now_sec(), cpu = 0, wait = 0;
+    void *mem = NULL;
+    if (posix_memalign(&mem, 4096, bs * depth) != 0) {
+        errno = ENOMEM;
+        return -1;
+    }
+    std::unique_ptr<void, void (*)(void *)> mem_guard(mem, pipe_free);
+    uint8_t *base = (uint8_t *)mem;
+
+    std::unique_ptr<pipe_io> io;
+#ifdef GM_PIPE_HAVE_URING
+    if (params->backend != GM_PIPE_THREADS) {
+        std::unique_ptr<uring_io> u(new uring_io);
+        if (u->init(2 * depth, base, depth, bs) == 0) {
+            io.reset(u.release());
+        } else if (params->backend == GM_PIPE_URING) {
+            return -1;
+        }
+    }
+#else
+    if (params->backend == GM_PIPE_URING) {
+        errno = ENOSYS;
+        return -1;
+    }
+#endif
+    if (!io) io.reset(new thread_io(params->io_threads));
+
+    // 哈希输入侧还是输出侧：加密时密文在输出侧，解密时在输入侧；不加密时只有输入
+    const int hashing = params->hash != GM_PIPE_HASH_NONE;
+    const int hash_input = !key || (params->hash == GM_PIPE_HASH_CIPHERTEXT) == (params->decrypt != 0);
+    sm4_mode_ctx ctr;
+    if (key && sm4_mode_init(&ctr, SM4_MODE_CTR, 1, key, iv) != 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    sm3_ctx hctx;
+    sm3_init(&hctx);
+
+    std::vector<pipe_slot> slots(depth);
+    for (unsigned i = 0; i < depth; i++) slots[i].state = SLOT_FREE;
+    std::deque<unsigned> write_q;
+    std::vector<pipe_cqe> cqes(2 * depth);
+    uint64_t next_seq = 0, next_proc = 0, bytes = 0, nreads = 0, nwrites = 0;
+    unsigned reads_inflight = 0, writes_inflight = 0;
+    int read_eof = seq_in ? 0 : nchunks == 0, err = 0;
+
+    while (!err) {
+        // 1. 空闲缓冲区都去读下一块
+        for (unsigned i = 0; i < depth && !read_eof && !err; i++) {
+            pipe_slot &s = slots[i];
+            if (s.state != SLOT_FREE) continue;
+            if (seq_in && reads_inflight) break;
+            s.seq = next_seq++;
+            s.off = seq_in ? -1 : (int64_t)(s.seq * bs);
+            s.len = seq_in ? bs : (size_t)(size - s.seq * bs < bs ? size - s.seq * bs : bs);
+            s.done = 0;
+            s.state = SLOT_READING;
+            // 请求长度向上取整到 4096：O_DIRECT 要求长度对齐，文件尾的最后一块照样短读
+            const size_t want = seq_in ? bs : (s.len + 4095) & ~(size_t)4095;
+            if (io->submit(PIPE_READ, i, in_fd, base + (size_t)i * bs, want, s.off) != 0) {
+                err = errno;
+                s.state = SLOT_FREE;
+                break;
+            }
+            reads_inflight++;
+            if (!seq_in && next_seq == nchunks) read_eof = 1;
+        }
+        // 2. 处理完的按顺序提交写
+        while (!err && !write_q.empty() && (!seq_out || writes_inflight == 0)) {
+            const unsigned i = write_q.front();
+            write_q.pop_front();
+            pipe_slot &s = slots[i];
+            s.done = 0;
+            s.state = SLOT_WRITING;
+            if (io->submit(PIPE_WRITE, i, out_fd, base + (size_t)i * bs, s.len, seq_out ? -1 : s.off) != 0) {
+                err = errno;
+                s.state = SLOT_FREE;
+                break;
+            }
+            writes_inflight++;
+        }
+        if (!err && io->flush() != 0) err = errno;
+        if (err) break;
+
+        // 3. 轮到的缓冲区：分段加密、哈希，这一段还在缓存里时两件事都做完
+        int progressed = 0;
+        for (unsigned i = 0; i < depth; i++) {
+            pipe_slot &s = slots[i];
+            if (s.state != SLOT_READY || s.seq != next_proc) continue;
+            double c0 = now_sec();
+            uint8_t *p = base + (size_t)i * bs;
+            for (size_t off = 0; off < s.len; off += GM_PIPE_CHUNK) {
+                const size_t n = s.len - off < GM_PIPE_CHUNK ? s.len - off : GM_PIPE_CHUNK;
+                if (hashing && hash_input) sm3_update(&hctx, p + off, n);
+                if (key) sm4_mode_update(&ctr, p + off, p + off, n);
+                if (hashing && !hash_input) sm3_update(&hctx, p + off, n);
+            }
+            cpu += now_sec() - c0;
+            bytes += s.len;
+            next_proc++;
+            if (out_fd >= 0) {
+                s.state = SLOT_QUEUED;
+                write_q.push_back(i);
+            } else {
+                s.state = SLOT_FREE;
+            }
+            progressed = 1;
+            break;
+        }
+
+        if (read_eof && reads_inflight == 0 && writes_inflight == 0 && write_q.empty() && next_proc == next_seq) break;
+
+        // 4. 收完成事件；刚处理过一块就不阻塞，先回去补读请求
+        double w0 = now_sec();
+        int n = io->reap(cqes.data(), (unsigned)cqes.size(), !progressed);
+        if (!progressed) wait += now_sec() - w0;
+        if (n < 0) {
+            err = errno;
+            break;
+        }
+        // 不再有请求在途的缓冲区（含出错的）一律标成空闲：出错后只需等 READING / WRITING 的完成
+        for (int k = 0; k < n; k++) {
+            const pipe_cqe &c = cqes[k];
+            pipe_slot &s = slots[c.slot];
+            uint8_t *p = base + (size_t)c.slot * bs;
+            if (err) {
+                s.state = SLOT_FREE;
+                continue;
+            }
+            if (c.res < 0 && (c.res == -EINTR || c.res == -EAGAIN)) {
+                // 原样重发
+                if (io->submit(c.op, c.slot, c.op == PIPE_READ ? in_fd : out_fd, p + s.done, s.len - s.done,
+                               s.off < 0 ? -1 : s.off + (int64_t)s.done) != 0) {
+                    err = errno;
+                    s.state = SLOT_FREE;
+                }
+                continue;
+            }
+            if (c.res < 0 || (c.res == 0 && (c.op == PIPE_WRITE || !seq_in))) {
+                // 普通文件在长度以内读到 0：文件被截短了
+                err = c.res < 0 ? (int)-c.res : EIO;
+                s.state = SLOT_FREE;
+                continue;
+            }
+            if (c.op == PIPE_READ) {
+                nreads++;
+                if (c.res == 0) {
+                    read_eof = 1;
+                    reads_inflight--;
+                    if (s.done) {
+                        s.len = s.done;
+                        s.state = SLOT_READY;
+                    } else {
+                        s.state = SLOT_FREE;
+                        next_seq--;
+                    }
+                    continue;
+                }
+                s.done += (size_t)c.res;
+                if (seq_in) {
+                    // 管道有多少收多少，不凑满
+                    s.len = s.done;
+                } else if (s.done < s.len) {
+                    // 中途的短读：续传剩余部分（这时偏移不再对齐，O_DIRECT 下可能失败，只在文件被并发修改等情形出现）
+                    if (io->submit(PIPE_READ, c.slot, in_fd, p + s.done, s.len - s.done, s.off + (int64_t)s.done) != 0) {
+                        err = errno;
+                        s.state = SLOT_FREE;
+                    }
+                    continue;
+                }
+                reads_inflight--;
+                s.state = SLOT_READY;
+            } else {
+                nwrites++;
+                s.done += (size_t)c.res;
+                if (s.done < s.len) {
+                    if (io->submit(PIPE_WRITE, c.slot, out_fd, p + s.done, s.len - s.done,
+                                   s.off < 0 ? -1 : s.off + (int64_t)s.done) != 0) {
+                        err = errno;
+                        s.state = SLOT_FREE;
+                    }
+                    continue;
+                }
+                writes_inflight--;
+                s.state = SLOT_FREE;
+            }
+        }
+    }
+
+    if (err) {
+        // 缓冲区释放前等在途请求全部结束，内核不能再往里写
+        io->flush();
+        for (;;) {
+            unsigned busy = 0;
+            for (unsigned i = 0; i < depth; i++) busy += slots[i].state == SLOT_READING || slots[i].state == SLOT_WRITING;
+            if (!busy) break;
+            int n = io->reap(cqes.data(), (unsigned)cqes.size(), 1);
+            if (n < 0) break;
+            for (int k = 0; k < n; k++) slots[cqes[k].slot].state = SLOT_FREE;
+        }
+        if (key) memset(&ctr, 0, sizeof(ctr));
+        errno = err;
+        return -1;
+    }
+
+    if (hashing && digest) {
+        uint32_t h[8];
+        sm3_final(&hctx, h);
+        for (int i = 0; i < 8; i++) {
+            digest[4 * i] = (uint8_t)(h[i] >> 24);
+            digest[4 * i + 1] = (uint8_t)(h[i] >> 16);
+            digest[4 * i + 2] = (uint8_t)(h[i] >> 8);
+            digest[4 * i + 3] = (uint8_t)h[i];
+        }
+    }
+    if (key) memset(&ctr, 0, sizeof(ctr));
+    if (stats) {
+        stats->bytes = bytes;
+        stats->reads = nreads;
+        stats->writes = nwrites;
+        stats->seconds = now_sec() - t0;
+        stats->cpu_seconds = cpu;
+        stats->wait_seconds = wait;
+        stats->backend = io->name();
+    }
+    return 0;
+}
+
+int gm_pipe_file(const char *in, const char *out, const uint8_t *key, const uint8_t iv[16],
+                 const gm_pipe_params *params, uint8_t digest[32], gm_pipe_stats *stats) {
+    int in_fd = -1;
+#ifdef O_DIRECT
+    // 文件系统不支持 O_DIRECT（tmpfs 等）时 open 返回 EINVAL，改用普通读
+    if (params && params->direct) in_fd = open(in, O_RDONLY | O_DIRECT);
+#endif
+    if (in_fd < 0) in_fd = open(in, O_RDONLY);
+    if (in_fd < 0) return -1;
+#ifdef POSIX_FADV_SEQUENTIAL
+    posix_fadvise(in_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    int out_fd = -1;
+    if (out) {
+        out_fd = open(out, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (out_fd < 0) {
+            int e = errno;
+            close(in_fd);
+            errno = e;
+            return -1;
+        }
+    }
+    struct stat st;
+    const int out_reg = out_fd >= 0 && fstat(out_fd, &st) == 0 && S_ISREG(st.st_mode);
+    int rc = gm_pipe_run(in_fd, out_fd, key, iv, params, digest, stats);
+    int e = errno;
+    close(in_fd);
+    if (out_fd >= 0 && close(out_fd) != 0 && rc == 0) {
+        rc = -1;
+        e = errno;
+    }
+    // 失败时不留下写了一半的输出（设备、管道等不删）
+    if (rc != 0 && out_reg) unlink(out);
+    errno = e;
+    return rc;
+}
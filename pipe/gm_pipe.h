@@ -0,0 +1,65 @@
+#ifndef GM_PIPE_H
+#define GM_PIPE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * 文件加密 + 哈希流水线：每个文件只读一遍、写一遍。
+ *   depth 个 4096 对齐的缓冲区排成环，读请求按文件偏移提前发出；轮到某个缓冲区时，按 GM_PIPE_CHUNK 分段
+ *   先做 SM4-CTR 再把这段（仍在缓存里）送进流式 SM3，或者反过来，随后异步写回同一偏移。
+ *   CPU 处理当前缓冲区时，后面缓冲区的读和前面缓冲区的写都在内核里进行。
+ * I/O 后端：io_uring（直接用系统调用，缓冲区预先注册，走 READ_FIXED / WRITE_FIXED），
+ *   不可用时（老内核、seccomp 禁用）退回 I/O 线程池，提交与完成的接口相同。
+ * CTR 与 SM3 都要求按顺序处理，计算只占一个线程；并行来自计算与 I/O 的重叠。
+ * 输入输出不是普通文件（管道等）时，该方向同一时刻只有一个请求在途，按顺序读写。
+ */
+
+#define GM_PIPE_CHUNK (64u << 10)
+
+enum gm_pipe_backend {
+    GM_PIPE_AUTO = 0,
+    GM_PIPE_URING = 1,
+    GM_PIPE_THREADS = 2,
+};
+
+enum gm_pipe_hash {
+    GM_PIPE_HASH_CIPHERTEXT = 0,   // 加密时哈希输出，解密时哈希输入
+    GM_PIPE_HASH_PLAINTEXT = 1,
+    GM_PIPE_HASH_NONE = 2,
+};
+
+typedef struct {
+    size_t buf_size;       // 每个缓冲区的字节数，4096 的倍数，默认 1 MB
+    unsigned depth;        // 缓冲区个数（在途读写的上限），1..256，默认 8
+    int backend;           // gm_pipe_backend
+    unsigned io_threads;   // 线程池后端的 I/O 线程数，默认 2
+    int hash;              // gm_pipe_hash
+    int decrypt;           // CTR 加解密相同，只影响哪一侧算作密文
+    int direct;            // 输入用 O_DIRECT 绕过页缓存（gm_pipe_file 打开失败时自动退回普通读）
+} gm_pipe_params;
+
+typedef struct {
+    uint64_t bytes;         // 处理的字节数
+    uint64_t reads, writes; // 完成的读写请求数（含短读写的续传）
+    double seconds;         // 总耗时
+    double cpu_seconds;     // 加密与哈希
+    double wait_seconds;    // 阻塞等待 I/O 完成；与 cpu_seconds 之和远小于 seconds 说明两者重叠得好
+    const char *backend;    // "io_uring" 或 "threads"
+} gm_pipe_stats;
+
+void gm_pipe_default_params(gm_pipe_params *params);
+
+/*
+ * 从 in_fd 读到文件尾，out_fd >= 0 时写出处理结果（普通文件按偏移写，调用方负责截断）。
+ * key 为 NULL 时不加密，只算哈希；digest 在 hash 不为 NONE 时输出 32 字节 SM3 摘要。
+ * 出错返回 -1 并设置 errno。stats 可为 NULL。
+ */
+int gm_pipe_run(int in_fd, int out_fd, const uint8_t *key, const uint8_t iv[16], const gm_pipe_params *params,
+                uint8_t digest[32], gm_pipe_stats *stats);
+
+// 按路径打开；out 为 NULL 时只读输入
+int gm_pipe_file(const char *in, const char *out, const uint8_t *key, const uint8_t iv[16],
+                 const gm_pipe_params *params, uint8_t digest[32], gm_pipe_stats *stats);
+
+#endif // GM_PIPE_H
@@ -0,0 +1,326 @@
+// gmpipe：SM4-CTR 加解密与 SM3 摘要一次读写完成
+// 编译：g++ -O2 gmpipe.cpp gm_pipe.cpp -I../project_1 -I../project_4 -o gmpipe -lgmcrypto -lpthread
+// 用法：gmpipe                                  自检：两种后端、不同深度与缓冲区，对照整段加密与一次性 SM3，并报告吞吐
+//       gmpipe [选项] 输入 [输出]              输出摘要 "<hex>  <输入>"；无输出文件时只读
+//   -k hex   16 字节密钥；不给则只算摘要
+//   -i hex   16 字节初始计数器，默认全 0
+//   -d       解密（CTR 加解密相同，只影响 -H cipher 哈希哪一侧）
+//   -H cipher|plain|none   摘要对象，默认密文
+//   -q N     队列深度（缓冲区个数），默认 8
+//   -b KB    缓冲区大小，4 的倍数，默认 1024
+//   -B uring|threads       指定 I/O 后端，默认先试 io_uring
+//   -j N     线程后端的 I/O 线程数，默认 2
+//   -D       输入用 O_DIRECT
+//   -v       向 stderr 报告耗时、吞吐与计算 / 等待占比
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <thread>
+#include <vector>
+#include "gm_pipe.h"
+#include "sm3_promax.h"
+#include "sm4_pro.h"
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int parse_hex16(const char *hex, uint8_t out[16]) {
+    if (strlen(hex) != 32) return -1;
+    for (int i = 0; i < 16; i++) {
+        unsigned v;
+        if (sscanf(hex + 2 * i, "%2x", &v) != 1) return -1;
+        out[i] = (uint8_t)v;
+    }
+    return 0;
+}
+
+static void print_hex(const uint8_t *p, size_t n) {
+    for (size_t i = 0; i < n; i++) printf("%02x", p[i]);
+}
+
+static void print_stats(const gm_pipe_stats *st) {
+    fprintf(stderr, "[%s] %.1f MB in %.3f s = %.1f MB/s, cpu %.0f%%, wait %.0f%%, %llu reads, %llu writes\n",
+            st->backend, st->bytes / 1e6, st->seconds, st->bytes / 1e6 / st->seconds,
+            100 * st->cpu_seconds / st->seconds, 100 * st->wait_seconds / st->seconds,
+            (unsigned long long)st->reads, (unsigned long long)st->writes);
+}
+
+/* ===== 自检 ===== */
+
+static int read_all(const char *path, std::vector<uint8_t> &out) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return -1;
+    out.clear();
+    uint8_t buf[65536];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) out.insert(out.end(), buf, buf + n);
+    fclose(f);
+    return 0;
+}
+
+static void digest_of(const uint8_t *p, size_t n, uint8_t d[32]) {
+    sm3_ctx c;
+    uint32_t h[8];
+    sm3_init(&c);
+    sm3_update(&c, p, n);
+    sm3_final(&c, h);
+    for (int i = 0; i < 32; i++) d[i] = (uint8_t)(h[i / 4] >> (24 - 8 * (i % 4)));
+}
+
+// 对照：先加密整个文件写出，再把密文读回来算 SM3，每个字节过两遍磁盘
+static double two_pass(const char *in, const char *out, const uint8_t key[16], const uint8_t iv[16], uint8_t d[32]) {
+    const size_t bs = 1u << 20;
+    std::vector<uint8_t> buf(bs);
+    double t0 = now_sec();
+    int fi = open(in, O_RDONLY), fo = open(out, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    sm4_mode_ctx ctr;
+    sm4_mode_init(&ctr, SM4_MODE_CTR, 1, key, iv);
+    ssize_t n;
+    while ((n = read(fi, buf.data(), bs)) > 0) {
+        sm4_mode_update(&ctr, buf.data(), buf.data(), (size_t)n);
+        if (write(fo, buf.data(), (size_t)n) != n) break;
+    }
+    close(fi);
+    close(fo);
+    sm3_ctx c;
+    uint32_t h[8];
+    sm3_init(&c);
+    fi = open(out, O_RDONLY);
+    while ((n = read(fi, buf.data(), bs)) > 0) sm3_update(&c, buf.data(), (size_t)n);
+    close(fi);
+    sm3_final(&c, h);
+    for (int i = 0; i < 32; i++) d[i] = (uint8_t)(h[i / 4] >> (24 - 8 * (i % 4)));
+    return now_sec() - t0;
+}
+
+static int self_test(void) {
+    const char *dir = getenv("TMPDIR");
+    if (!dir) dir = "/tmp";
+    // out、back 比 in 多 ".enc" / ".dec" 四个字符，不会截断
+    char in[512], out[sizeof(in) + 5], back[sizeof(in) + 5];
+    if ((size_t)snprintf(in, sizeof(in), "%s/gmpipe_in_XXXXXX", dir) >= sizeof(in)) {
+        fprintf(stderr, "TMPDIR 路径太长\n");
+        return 1;
+    }
+    int fd = mkstemp(in);
+    if (fd < 0) {
+        perror("mkstemp");
+        return 1;
+    }
+    snprintf(out, sizeof(out), "%s.enc", in);
+    snprintf(back, sizeof(back), "%s.dec", in);
+
+    // 长度故意不是缓冲区与分组的整数倍
+    const size_t size = (32u << 20) + 12345;
+    std::vector<uint8_t> plain(size);
+    uint64_t x = 0x9E3779B97F4A7C15ull;
+    for (size_t i = 0; i < size; i++) {
+        x ^= x << 13, x ^= x >> 7, x ^= x << 17;
+        plain[i] = (uint8_t)x;
+    }
+    if (write(fd, plain.data(), size) != (ssize_t)size) {
+        perror("write");
+        close(fd);
+        unlink(in);
+        return 1;
+    }
+    close(fd);
+
+    uint8_t key[16], iv[16];
+    for (int i = 0; i < 16; i++) key[i] = (uint8_t)(0x11 * i), iv[i] = (uint8_t)(0xF0 - i);
+    iv[15] = 0xFE;   // 计数器很快进位到高字节
+    std::vector<uint8_t> cipher(size), got;
+    sm4_mode_ctx ctr;
+    sm4_mode_init(&ctr, SM4_MODE_CTR, 1, key, iv);
+    sm4_mode_update(&ctr, plain.data(), cipher.data(), size);
+    uint8_t d_cipher[32], d_plain[32], d[32];
+    digest_of(cipher.data(), size, d_cipher);
+    digest_of(plain.data(), size, d_plain);
+
+    struct {
+        int backend;
+        size_t buf_size;
+        unsigned depth;
+    } cfgs[] = {
+        {GM_PIPE_URING, 4096, 1},      {GM_PIPE_URING, 64u << 10, 4},   {GM_PIPE_URING, 1u << 20, 8},
+        {GM_PIPE_URING, 4u << 20, 32}, {GM_PIPE_THREADS, 4096, 1},      {GM_PIPE_THREADS, 64u << 10, 4},
+        {GM_PIPE_THREADS, 1u << 20, 8}, {GM_PIPE_THREADS, 4u << 20, 32},
+    };
+    int fails = 0;
+    for (size_t c = 0; c < sizeof(cfgs) / sizeof(cfgs[0]); c++) {
+        gm_pipe_params p;
+        gm_pipe_default_params(&p);
+        p.backend = cfgs[c].backend;
+        p.buf_size = cfgs[c].buf_size;
+        p.depth = cfgs[c].depth;
+        gm_pipe_stats st;
+        const char *bname = p.backend == GM_PIPE_URING ? "uring" : "threads";
+        if (gm_pipe_file(in, out, key, iv, &p, d, &st) != 0) {
+            if (p.backend == GM_PIPE_URING && (errno == ENOSYS || errno == EPERM)) {
+                printf("SKIP %-7s buf %7zu depth %2u: io_uring 不可用\n", bname, p.buf_size, p.depth);
+                continue;
+            }
+            printf("FAIL %-7s buf %7zu depth %2u: %s\n", bname, p.buf_size, p.depth, strerror(errno));
+            fails++;
+            continue;
+        }
+        int ok = read_all(out, got) == 0 && got == cipher && memcmp(d, d_cipher, 32) == 0;
+        printf("%s %-7s buf %7zu depth %2u: %7.1f MB/s (cpu %3.0f%%, wait %3.0f%%)\n", ok ? "PASS" : "FAIL", bname,
+               p.buf_size, p.depth, size / 1e6 / st.seconds, 100 * st.cpu_seconds / st.seconds,
+               100 * st.wait_seconds / st.seconds);
+        fails += !ok;
+    }
+
+    // 解密回来：-H cipher 在解密时哈希输入，摘要应与加密时相同；另外验证明文摘要与只读模式
+    gm_pipe_params p;
+    gm_pipe_default_params(&p);
+    p.decrypt = 1;
+    int ok = gm_pipe_file(out, back, key, iv, &p, d, NULL) == 0 && read_all(back, got) == 0 && got == plain &&
+             memcmp(d, d_cipher, 32) == 0;
+    printf("%s 解密往返，摘要取密文侧\n", ok ? "PASS" : "FAIL");
+    fails += !ok;
+    p.decrypt = 0;
+    p.hash = GM_PIPE_HASH_PLAINTEXT;
+    ok = gm_pipe_file(in, out, key, iv, &p, d, NULL) == 0 && memcmp(d, d_plain, 32) == 0;
+    printf("%s 加密时摘要取明文侧\n", ok ? "PASS" : "FAIL");
+    fails += !ok;
+    p.hash = GM_PIPE_HASH_CIPHERTEXT;
+    ok = gm_pipe_file(in, NULL, NULL, NULL, &p, d, NULL) == 0 && memcmp(d, d_plain, 32) == 0;
+    printf("%s 只读只哈希\n", ok ? "PASS" : "FAIL");
+    fails += !ok;
+
+    // 管道输入：顺序读，短读不凑满
+    int pfd[2];
+    if (pipe(pfd) == 0) {
+        std::thread feeder([&] {
+            for (size_t off = 0; off < size;) {
+                size_t n = size - off < 100000 ? size - off : 100000;
+                ssize_t w = write(pfd[1], plain.data() + off, n);
+                if (w <= 0) break;
+                off += (size_t)w;
+            }
+            close(pfd[1]);
+        });
+        int ofd = open(out, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        ok = gm_pipe_run(pfd[0], ofd, key, iv, NULL, d, NULL) == 0;
+        feeder.join();
+        close(pfd[0]);
+        close(ofd);
+        ok = ok && read_all(out, got) == 0 && got == cipher && memcmp(d, d_cipher, 32) == 0;
+        printf("%s 管道输入\n", ok ? "PASS" : "FAIL");
+        fails += !ok;
+    }
+
+    // 对照：两遍的做法
+    double t2 = two_pass(in, out, key, iv, d);
+    gm_pipe_default_params(&p);
+    gm_pipe_stats st;
+    gm_pipe_file(in, out, key, iv, &p, d, &st);
+    printf("两遍（加密写出后再读回哈希）%.1f MB/s，一遍流水线（%s）%.1f MB/s\n", size / 1e6 / t2, st.backend,
+           size / 1e6 / st.seconds);
+
+    unlink(in);
+    unlink(out);
+    unlink(back);
+    printf(fails ? "%d 项失败\n" : "全部通过\n", fails);
+    return fails ? 1 : 0;
+}
+
+static void usage(void) {
+    fprintf(stderr,
+            "用法：gmpipe [-k 密钥hex] [-i IVhex] [-d] [-H cipher|plain|none] [-q 深度] [-b KB] [-B uring|threads]\n"
+            "             [-j I/O线程] [-D] [-v] 输入 [输出]\n"
+            "      gmpipe                 自检\n");
+}
+
+int main(int argc, char **argv) {
+    if (argc == 1) return self_test();
+
+    gm_pipe_params p;
+    gm_pipe_default_params(&p);
+    uint8_t key[16], iv[16];
+    memset(iv, 0, sizeof(iv));
+    int have_key = 0, verbose = 0;
+    int i = 1;
+    for (; i < argc && argv[i][0] == '-' && argv[i][1]; i++) {
+        const char *a = argv[i];
+        const char *v = i + 1 < argc ? argv[i + 1] : NULL;
+        if (!strcmp(a, "-d")) {
+            p.decrypt = 1;
+        } else if (!strcmp(a, "-D")) {
+            p.direct = 1;
+        } else if (!strcmp(a, "-v")) {
+            verbose = 1;
+        } else if (!v) {
+            usage();
+            return 2;
+        } else if (!strcmp(a, "-k")) {
+            if (parse_hex16(v, key) != 0) {
+                fprintf(stderr, "密钥应为 32 个十六进制字符\n");
+                return 2;
+            }
+            have_key = 1;
+            i++;
+        } else if (!strcmp(a, "-i")) {
+            if (parse_hex16(v, iv) != 0) {
+                fprintf(stderr, "IV 应为 32 个十六进制字符\n");
+                return 2;
+            }
+            i++;
+        } else if (!strcmp(a, "-H")) {
+            if (!strcmp(v, "cipher")) p.hash = GM_PIPE_HASH_CIPHERTEXT;
+            else if (!strcmp(v, "plain")) p.hash = GM_PIPE_HASH_PLAINTEXT;
+            else if (!strcmp(v, "none")) p.hash = GM_PIPE_HASH_NONE;
+            else {
+                usage();
+                return 2;
+            }
+            i++;
+        } else if (!strcmp(a, "-q")) {
+            p.depth = (unsigned)atoi(v);
+            i++;
+        } else if (!strcmp(a, "-b")) {
+            p.buf_size = (size_t)atol(v) << 10;
+            i++;
+        } else if (!strcmp(a, "-B")) {
+            if (!strcmp(v, "uring")) p.backend = GM_PIPE_URING;
+            else if (!strcmp(v, "threads")) p.backend = GM_PIPE_THREADS;
+            else {
+                usage();
+                return 2;
+            }
+            i++;
+        } else if (!strcmp(a, "-j")) {
+            p.io_threads = (unsigned)atoi(v);
+            i++;
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (i >= argc || argc - i > 2) {
+        usage();
+        return 2;
+    }
+    const char *in = argv[i], *out = i + 1 < argc ? argv[i + 1] : NULL;
+    uint8_t d[32];
+    gm_pipe_stats st;
+    if (gm_pipe_file(in, out, have_key ? key : NULL, iv, &p, d, &st) != 0) {
+        fprintf(stderr, "gmpipe: %s: %s\n", in, strerror(errno));
+        return 1;
+    }
+    if (p.hash != GM_PIPE_HASH_NONE) {
+        print_hex(d, 32);
+        printf("  %s\n", in);
+    }
+    if (verbose) print_stats(&st);
+    return 0;
+}
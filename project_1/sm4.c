@@ -1,12 +1,34 @@
-#include<stdio.h>
-#include <windows.h>
-#define u8 unsigned char
-#define u32 unsigned long
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <time.h>
+#define u8 uint8_t
+#define u32 uint32_t
+
+/* 单调时钟，单位秒 */
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
 
 /* 非线性置换表 S 盒 */
 const u8 Sbox[256] = {
     0xd6,0x90,0xe9,0xfe,0xcc,0xe1,0x3d,0xb7,0x16,0xb6,0x14,0xc2,0x28,0xfb,0x2c,0x05,
-    /* …… 其余字节省略 …… */
+    0x2b,0x67,0x9a,0x76,0x2a,0xbe,0x04,0xc3,0xaa,0x44,0x13,0x26,0x49,0x86,0x06,0x99,
+    0x9c,0x42,0x50,0xf4,0x91,0xef,0x98,0x7a,0x33,0x54,0x0b,0x43,0xed,0xcf,0xac,0x62,
+    0xe4,0xb3,0x1c,0xa9,0xc9,0x08,0xe8,0x95,0x80,0xdf,0x94,0xfa,0x75,0x8f,0x3f,0xa6,
+    0x47,0x07,0xa7,0xfc,0xf3,0x73,0x17,0xba,0x83,0x59,0x3c,0x19,0xe6,0x85,0x4f,0xa8,
+    0x68,0x6b,0x81,0xb2,0x71,0x64,0xda,0x8b,0xf8,0xeb,0x0f,0x4b,0x70,0x56,0x9d,0x35,
+    0x1e,0x24,0x0e,0x5e,0x63,0x58,0xd1,0xa2,0x25,0x22,0x7c,0x3b,0x01,0x21,0x78,0x87,
+    0xd4,0x00,0x46,0x57,0x9f,0xd3,0x27,0x52,0x4c,0x36,0x02,0xe7,0xa0,0xc4,0xc8,0x9e,
+    0xea,0xbf,0x8a,0xd2,0x40,0xc7,0x38,0xb5,0xa3,0xf7,0xf2,0xce,0xf9,0x61,0x15,0xa1,
+    0xe0,0xae,0x5d,0xa4,0x9b,0x34,0x1a,0x55,0xad,0x93,0x32,0x30,0xf5,0x8c,0xb1,0xe3,
+    0x1d,0xf6,0xe2,0x2e,0x82,0x66,0xca,0x60,0xc0,0x29,0x23,0xab,0x0d,0x53,0x4e,0x6f,
+    0xd5,0xdb,0x37,0x45,0xde,0xfd,0x8e,0x2f,0x03,0xff,0x6a,0x72,0x6d,0x6c,0x5b,0x51,
+    0x8d,0x1b,0xaf,0x92,0xbb,0xdd,0xbc,0x7f,0x11,0xd9,0x5c,0x41,0x1f,0x10,0x5a,0xd8,
+    0x0a,0xc1,0x31,0x88,0xa5,0xcd,0x7b,0xbd,0x2d,0x74,0xd0,0x12,0xb8,0xe5,0xb4,0xb0,
+    0x89,0x69,0x97,0x4a,0x0c,0x96,0x77,0x7e,0x65,0xb9,0xf1,0x09,0xc5,0x6e,0xc6,0x84,
     0x18,0xf0,0x7d,0xec,0x3a,0xdc,0x4d,0x20,0x79,0xee,0x5f,0x3e,0xd7,0xcb,0x39,0x48
 };
 
@@ -18,8 +40,13 @@ const u32 FK[4] = {
 /* 固定参数 CK */
 const u32 CK[32] = {
     0x00070e15, 0x1c232a31, 0x383f464d, 0x545b6269,
-    /* …… 其余常量省略 …… */
-    0x484f565d, 0x646b7279
+    0x70777e85, 0x8c939aa1, 0xa8afb6bd, 0xc4cbd2d9,
+    0xe0e7eef5, 0xfc030a11, 0x181f262d, 0x343b4249,
+    0x50575e65, 0x6c737a81, 0x888f969d, 0xa4abb2b9,
+    0xc0c7ced5, 0xdce3eaf1, 0xf8ff060d, 0x141b2229,
+    0x30373e45, 0x4c535a61, 0x686f767d, 0x848b9299,
+    0xa0a7aeb5, 0xbcc3cad1, 0xd8dfe6ed, 0xf4fb0209,
+    0x10171e25, 0x2c333a41, 0x484f565d, 0x646b7279
 };
 
 /* 函数原型 */
@@ -28,6 +55,8 @@ u32 loopLeft(u32 a, short length);
 u32 functionL1(u32 a);
 u32 functionL2(u32 a);
 u32 functionT(u32 a, short mode);
+void initTableT(void);
+u32 functionTTable(u32 a);
 void extendFirst(u32 MK[], u32 K[]);
 void extendSecond(u32 RK[], u32 K[]);
 void getRK(u32 MK[], u32 K[], u32 RK[]);
@@ -50,13 +79,26 @@ u32 functionB(u32 b) {
     return b;
 }
 
-/* 循环左移 */
+/* 循环左移（一次移位完成，length 取 0..31） */
 u32 loopLeft(u32 a, short length) {
+    length &= 31;
+    if (length == 0) return a;
+    return (a << length) | (a >> (32 - length));
+}
+
+/* 原先的逐位循环左移与对应的 T，只留给轮函数微基准做对照 */
+static u32 loopLeftBitwise(u32 a, short length) {
     for (short i = 0; i < length; ++i)
         a = (a << 1) | (a >> 31);
     return a;
 }
 
+static u32 functionTBitwise(u32 a) {
+    u32 b = functionB(a);
+    return b ^ loopLeftBitwise(b, 2) ^ loopLeftBitwise(b, 10) ^
+           loopLeftBitwise(b, 18) ^ loopLeftBitwise(b, 24);
+}
+
 /* 线性变换 L */
 u32 functionL1(u32 a) {
     return a ^ loopLeft(a, 2) ^ loopLeft(a, 10) ^
@@ -73,6 +115,32 @@ u32 functionT(u32 a, short mode) {
     return (mode == 1) ? functionL1(functionB(a)) : functionL2(functionB(a));
 }
 
+/* ===== 查表版合成变换 T =====
+ * L 是线性的，且对 4 个字节的 S 盒输出可以分开计算：
+ *   T(a) = L(S(a0)<<24) ^ L(S(a1)<<16) ^ L(S(a2)<<8) ^ L(S(a3))
+ * 预先算好 4 张 256 项的表，每轮只需 4 次查表和 3 次异或。
+ * 查表下标依赖密钥与明文，存在缓存计时侧信道；需要常数时间时用 sm4_pro 的 SIMD 路径。 */
+u32 tableT[4][256];
+
+void initTableT(void) {
+    for (int x = 0; x < 256; ++x) {
+        for (int k = 0; k < 4; ++k)
+            tableT[k][x] = functionL1((u32)Sbox[x] << (24 - 8 * k));
+    }
+}
+
+u32 functionTTable(u32 a) {
+    return tableT[0][(a >> 24) & 0xFF] ^ tableT[1][(a >> 16) & 0xFF] ^
+           tableT[2][(a >> 8) & 0xFF]  ^ tableT[3][a & 0xFF];
+}
+
+/* 加密轮函数：编译时定义 SM4_TTABLE 走查表，否则逐字节查 S 盒再做 L */
+#ifdef SM4_TTABLE
+#define roundT(a) functionTTable(a)
+#else
+#define roundT(a) functionT(a, 1)
+#endif
+
 /* 密钥扩展第一步：K = MK ^ FK */
 void extendFirst(u32 MK[], u32 K[]) {
     for (int i = 0; i < 4; ++i)
@@ -100,7 +168,7 @@ void iterate32(u32 X[], u32 RK[]) {
     for (short i = 0; i < 32; ++i) {
         u32 tmp = X[(i + 1) % 4] ^ X[(i + 2) % 4] ^
                   X[(i + 3) % 4] ^ RK[i];
-        X[(i + 4) % 4] = X[i % 4] ^ functionT(tmp, 1);
+        X[(i + 4) % 4] = X[i % 4] ^ roundT(tmp);
     }
 }
 
@@ -116,13 +184,13 @@ void encryptSM4(u32 X[], u32 RK[], u32 Y[]) {
     reverse(X, Y);
 }
 
-/* 解密 */
+/* 解密：倒序使用轮密钥，不再每次复制一份反转的数组 */
 void decryptSM4(u32 X[], u32 RK[], u32 Y[]) {
-    u32 reverseRK[32];
-    for (short i = 0; i < 32; ++i)
-        reverseRK[i] = RK[31 - i];
-
-    iterate32(X, reverseRK);
+    for (short i = 0; i < 32; ++i) {
+        u32 tmp = X[(i + 1) % 4] ^ X[(i + 2) % 4] ^
+                  X[(i + 3) % 4] ^ RK[31 - i];
+        X[(i + 4) % 4] = X[i % 4] ^ roundT(tmp);
+    }
     reverse(X, Y);
 }
 
@@ -134,15 +202,15 @@ int main(void) {
     u32 cipher[4];  
     u32 verify[4];  
 
+    initTableT();
+
     printf("Enter 128-bit plaintext (8 hex numbers, e.g., 01234567 89abcdef ...):\n");
-    scanf_s("%8x%8x%8x%8x", &plain[0], &plain[1], &plain[2], &plain[3]);
+    scanf("%8" SCNx32 "%8" SCNx32 "%8" SCNx32 "%8" SCNx32, &plain[0], &plain[1], &plain[2], &plain[3]);
 
     printf("Enter 128-bit key (8 hex numbers):\n");
-    scanf_s("%8x%8x%8x%8x", &key[0], &key[1], &key[2], &key[3]);
+    scanf("%8" SCNx32 "%8" SCNx32 "%8" SCNx32 "%8" SCNx32, &key[0], &key[1], &key[2], &key[3]);
 
-        LARGE_INTEGER freq, t1, t2;
-    QueryPerformanceFrequency(&freq);
-    QueryPerformanceCounter(&t1);
+    double t1 = now_sec();
 
     getRK(key, ktmp, rk);
     printf("\n======== Round Keys ========\n");
@@ -159,9 +227,42 @@ int main(void) {
     printf("\n======== Decryption Result ========\n");
     printf("Plaintext: %08x %08x %08x %08x\n", verify[0], verify[1], verify[2], verify[3]);
 
-    QueryPerformanceCounter(&t2);
-    double elapsed = (double)(t2.QuadPart - t1.QuadPart) / (double)freq.QuadPart;
+    double elapsed = now_sec() - t1;
     printf("\nTotal time elapsed: %.6f seconds\n", elapsed);
 
+    /* 轮函数微基准：两种 T 逐个输入比对，再各自跑一条前后依赖的调用链 */
+    const long rounds = 10000000;
+    int same = 1;
+    for (u32 a = 0; a < (1u << 20); ++a) {
+        u32 x = a * 0x9e3779b9u;
+        same &= functionT(x, 1) == functionTTable(x);
+    }
+    printf("\n======== Round Function Benchmark ========\n");
+    printf("T-table vs functionT: %s\n", same ? "identical" : "MISMATCH");
+
+    u32 acc = 0x01234567;
+    t1 = now_sec();
+    for (long i = 0; i < rounds; ++i) acc = functionTBitwise(acc ^ (u32)i);
+    double tBitwise = now_sec() - t1;
+
+    t1 = now_sec();
+    for (long i = 0; i < rounds; ++i) acc = functionT(acc ^ (u32)i, 1);
+    double tBase = now_sec() - t1;
+
+    t1 = now_sec();
+    for (long i = 0; i < rounds; ++i) acc = functionTTable(acc ^ (u32)i);
+    double tTable = now_sec() - t1;
+
+    printf("bitwise rotate: %.2f ns/round\n", tBitwise * 1e9 / rounds);
+    printf("functionT     : %.2f ns/round\n", tBase * 1e9 / rounds);
+    printf("functionTTable: %.2f ns/round  (%.1fx vs functionT, %.1fx vs bitwise)\n",
+           tTable * 1e9 / rounds, tBase / tTable, tBitwise / tTable);
+    printf("(checksum %08x, encryption rounds use %s)\n", acc,
+#ifdef SM4_TTABLE
+           "T-table");
+#else
+           "functionT");
+#endif
+
     return 0;
 }
\ No newline at end of file
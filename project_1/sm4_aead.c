@@ -0,0 +1,359 @@
+/* SM4 认证加密：GCM（GHASH 用 PCLMULQDQ 或 4 位查表）与 CCM
+ * 数据按块分批：一批计数器块交给 sm4_crypt_blocks 生成密钥流，异或后趁密文还在 L1 里
+ * 立即做 GHASH / CBC-MAC，整条 seal / open 路径只遍历一次数据。 */
+#include <string.h>
+#include <emmintrin.h>
+#include "sm4_pro.h"
+#include "sm4_ghash.h"
+#include "../common/cpu_features.h"
+#include "../common/gm_trace.h"
+
+/* 每批处理的分组数（密钥流缓冲在栈上，约 512B） */
+#define SM4_AEAD_CHUNK 32
+
+static inline uint32_t load_be32(const uint8_t *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static inline void store_be32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)(v >> 24); p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);  p[3] = (uint8_t)v;
+}
+
+static inline uint64_t load_be64(const uint8_t *p) {
+    return ((uint64_t)load_be32(p) << 32) | load_be32(p + 4);
+}
+
+static inline void store_be64(uint8_t *p, uint64_t v) {
+    store_be32(p, (uint32_t)(v >> 32));
+    store_be32(p + 4, (uint32_t)v);
+}
+
+/* out = a ^ b，共 len 字节 */
+static void xor_bytes(uint8_t *out, const uint8_t *a, const uint8_t *b, size_t len) {
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(a + i));
+        __m128i y = _mm_loadu_si128((const __m128i *)(b + i));
+        _mm_storeu_si128((__m128i *)(out + i), _mm_xor_si128(x, y));
+    }
+    for (; i < len; ++i) out[i] = a[i] ^ b[i];
+}
+
+/* 常数时间比较：耗时与第一个不同字节的位置无关 */
+static int ct_equal(const uint8_t *a, const uint8_t *b, size_t len) {
+    uint8_t d = 0;
+    for (size_t i = 0; i < len; ++i) d |= a[i] ^ b[i];
+    return d == 0;
+}
+
+/* ===== 表驱动 GHASH（Shoup 4 位表，没有 PCLMULQDQ 时使用） =====
+ * 按 GCM 规范的位序：H 的第 0 位是最高位，乘 x 即右移 1 位，溢出时异或 0xe1 << 120。
+ * 注意查表下标取自数据，存在缓存时序侧信道，只作为兼容路径。 */
+static const uint16_t ghash_last4[16] = {
+    0x0000, 0x1c20, 0x3840, 0x2460, 0x7080, 0x6ca0, 0x48c0, 0x54e0,
+    0xe100, 0xfd20, 0xd940, 0xc560, 0x9180, 0x8da0, 0xa9c0, 0xb5e0
+};
+
+static void ghash_table_init(sm4_gcm_key *g) {
+    uint64_t vh = load_be64(g->h), vl = load_be64(g->h + 8);
+    g->hh[0] = g->hl[0] = 0;
+    g->hh[8] = vh;
+    g->hl[8] = vl;
+    /* hh/hl[4], [2], [1] = H·x, H·x^2, H·x^3 */
+    for (int i = 4; i > 0; i >>= 1) {
+        uint64_t t = (vl & 1) * 0xe100000000000000ULL;
+        vl = (vh << 63) | (vl >> 1);
+        vh = (vh >> 1) ^ t;
+        g->hh[i] = vh;
+        g->hl[i] = vl;
+    }
+    /* 其余下标按位线性组合 */
+    for (int i = 2; i <= 8; i <<= 1) {
+        for (int j = 1; j < i; ++j) {
+            g->hh[i + j] = g->hh[i] ^ g->hh[j];
+            g->hl[i + j] = g->hl[i] ^ g->hl[j];
+        }
+    }
+}
+
+/* x = x·H，每次吃 4 位，从最后一个字节的低半字节开始 */
+static void ghash_table_mul(const sm4_gcm_key *g, uint8_t x[16]) {
+    uint64_t zh, zl;
+    unsigned lo = x[15] & 0xf, hi, rem;
+    zh = g->hh[lo];
+    zl = g->hl[lo];
+    for (int i = 15; i >= 0; --i) {
+        lo = x[i] & 0xf;
+        hi = x[i] >> 4;
+        if (i != 15) {
+            rem = (unsigned)zl & 0xf;
+            zl = (zh << 60) | (zl >> 4);
+            zh = (zh >> 4) ^ ((uint64_t)ghash_last4[rem] << 48);
+            zh ^= g->hh[lo];
+            zl ^= g->hl[lo];
+        }
+        rem = (unsigned)zl & 0xf;
+        zl = (zh << 60) | (zl >> 4);
+        zh = (zh >> 4) ^ ((uint64_t)ghash_last4[rem] << 48);
+        zh ^= g->hh[hi];
+        zl ^= g->hl[hi];
+    }
+    store_be64(x, zh);
+    store_be64(x + 8, zl);
+}
+
+static void ghash_blocks(const sm4_gcm_key *g, uint8_t xi[16], const uint8_t *in, size_t nblocks) {
+    if (g->clmul) {
+        sm4_ghash_clmul(xi, g->hpow, in, nblocks);
+        return;
+    }
+    for (; nblocks > 0; --nblocks, in += 16) {
+        xor_bytes(xi, xi, in, 16);
+        ghash_table_mul(g, xi);
+    }
+}
+
+/* 整块走 ghash_blocks，末尾不足一个分组补零 */
+static void ghash_bytes(const sm4_gcm_key *g, uint8_t xi[16], const uint8_t *in, size_t len) {
+    ghash_blocks(g, xi, in, len / 16);
+    if (len % 16) {
+        uint8_t b[16] = {0};
+        memcpy(b, in + len - len % 16, len % 16);
+        ghash_blocks(g, xi, b, 1);
+    }
+}
+
+/* ===== GCM ===== */
+
+void sm4_gcm_init(sm4_gcm_key *g, const uint8_t key[16]) {
+    const cpu_features_t *f = cpu_features();
+    static const uint8_t zero[16] = {0};
+    memset(g, 0, sizeof(*g));
+    sm4_set_encrypt_key(&g->key, key);
+    sm4_crypt_block(&g->key, zero, g->h);
+    ghash_table_init(g);
+    g->clmul = f->pclmul && f->ssse3;
+    if (g->clmul) sm4_ghash_clmul_init(g->hpow, g->h);
+}
+
+/* J0：96 位 IV 直接拼 0x00000001，其他长度对 IV 做 GHASH */
+static void gcm_j0(const sm4_gcm_key *g, const uint8_t *iv, size_t iv_len, uint8_t j0[16]) {
+    if (iv_len == 12) {
+        memcpy(j0, iv, 12);
+        store_be32(j0 + 12, 1);
+        return;
+    }
+    uint8_t lb[16] = {0};
+    memset(j0, 0, 16);
+    ghash_bytes(g, j0, iv, iv_len);
+    store_be64(lb + 8, (uint64_t)iv_len * 8);
+    ghash_blocks(g, j0, lb, 1);
+}
+
+/* 生成 n 个计数器块的密钥流；GCM 只递增低 32 位（inc32） */
+static void gcm_keystream(const sm4_key *key, uint8_t ctr[16], uint8_t *ks, size_t n) {
+    uint32_t c = load_be32(ctr + 12);
+    for (size_t i = 0; i < n; ++i) {
+        memcpy(ks + i * 16, ctr, 12);
+        store_be32(ks + i * 16 + 12, c + (uint32_t)i);
+    }
+    store_be32(ctr + 12, c + (uint32_t)n);
+    sm4_crypt_blocks(key, ks, ks, n);
+}
+
+/* 加密时对输出做 GHASH，解密时对输入做 GHASH；先读后写，原地处理安全 */
+static void gcm_crypt(const sm4_gcm_key *g, int enc, const uint8_t *iv, size_t iv_len,
+                      const uint8_t *aad, size_t aad_len,
+                      const uint8_t *in, size_t len, uint8_t *out, uint8_t tag[16]) {
+    GM_TRACE_ZONE(GMCRYPTO_ZONE_SM4_GCM, aad_len + len);
+    const size_t chunk = SM4_AEAD_CHUNK * 16;
+    uint8_t ctr[16], ej0[16], xi[16] = {0}, lb[16];
+    uint8_t ks[(SM4_AEAD_CHUNK + 1) * 16];
+    const uint8_t *kp = ks + 16;
+    size_t n = (len < chunk) ? len : chunk;
+
+    /* 第一批连同 J0 一起加密：E(J0) 留给标签，省掉一次单独的串行分组加密（短记录上很明显） */
+    gcm_j0(g, iv, iv_len, ctr);
+    gcm_keystream(&g->key, ctr, ks, (n + 15) / 16 + 1);
+    memcpy(ej0, ks, 16);
+
+    ghash_bytes(g, xi, aad, aad_len);
+    for (size_t done = 0; done < len; done += n) {
+        if (done > 0) {
+            n = (len - done < chunk) ? len - done : chunk;
+            gcm_keystream(&g->key, ctr, ks, (n + 15) / 16);
+            kp = ks;
+        }
+        if (!enc) ghash_bytes(g, xi, in + done, n);
+        xor_bytes(out + done, in + done, kp, n);
+        if (enc) ghash_bytes(g, xi, out + done, n);
+    }
+
+    store_be64(lb, (uint64_t)aad_len * 8);
+    store_be64(lb + 8, (uint64_t)len * 8);
+    ghash_blocks(g, xi, lb, 1);
+
+    xor_bytes(tag, ej0, xi, 16);
+}
+
+/* 规范上限：IV 非空，标签 4..16 字节，明文不超过 2^36 - 32 字节 */
+static int gcm_check(size_t iv_len, size_t len, size_t tag_len) {
+    if (iv_len == 0 || tag_len < 4 || tag_len > 16) return -1;
+    if ((uint64_t)len > ((uint64_t)1 << 36) - 32) return -1;
+    return 0;
+}
+
+int sm4_gcm_seal(const sm4_gcm_key *g, const uint8_t *iv, size_t iv_len,
+                 const uint8_t *aad, size_t aad_len,
+                 const uint8_t *in, size_t len, uint8_t *out,
+                 uint8_t *tag, size_t tag_len) {
+    uint8_t full[16];
+    if (gcm_check(iv_len, len, tag_len) < 0) return -1;
+    gcm_crypt(g, 1, iv, iv_len, aad, aad_len, in, len, out, full);
+    memcpy(tag, full, tag_len);
+    return 0;
+}
+
+int sm4_gcm_open(const sm4_gcm_key *g, const uint8_t *iv, size_t iv_len,
+                 const uint8_t *aad, size_t aad_len,
+                 const uint8_t *in, size_t len, uint8_t *out,
+                 const uint8_t *tag, size_t tag_len) {
+    uint8_t full[16];
+    if (gcm_check(iv_len, len, tag_len) < 0) return -1;
+    gcm_crypt(g, 0, iv, iv_len, aad, aad_len, in, len, out, full);
+    if (!ct_equal(full, tag, tag_len)) {
+        memset(out, 0, len);
+        return -1;
+    }
+    return 0;
+}
+
+/* ===== CCM（NIST SP 800-38C / RFC 3610） ===== */
+
+/* CBC-MAC 吸收任意长度数据；pos 为当前分组已填的字节数，凑满即加密 */
+static void ccm_absorb(const sm4_key *key, uint8_t x[16], size_t *pos,
+                       const uint8_t *in, size_t len) {
+    size_t p = *pos;
+    while (len > 0) {
+        if (p == 0 && len >= 16) {
+            xor_bytes(x, x, in, 16);
+            sm4_crypt_block(key, x, x);
+            in += 16;
+            len -= 16;
+            continue;
+        }
+        x[p++] ^= *in++;
+        --len;
+        if (p == 16) {
+            sm4_crypt_block(key, x, x);
+            p = 0;
+        }
+    }
+    *pos = p;
+}
+
+/* 计数器在最后 q 个字节里；q <= 8 且分组数小于 2^(8q)，低 64 位递增不会溢出到 nonce */
+static void ccm_keystream(const sm4_key *key, uint8_t ctr[16], uint8_t *ks, size_t n) {
+    uint64_t c = load_be64(ctr + 8);
+    for (size_t i = 0; i < n; ++i) {
+        memcpy(ks + i * 16, ctr, 8);
+        store_be64(ks + i * 16 + 8, c + i);
+    }
+    store_be64(ctr + 8, c + n);
+    sm4_crypt_blocks(key, ks, ks, n);
+}
+
+static int ccm_crypt(const sm4_key *key, int enc, const uint8_t *nonce, size_t nonce_len,
+                     const uint8_t *aad, size_t aad_len,
+                     const uint8_t *in, size_t len, uint8_t *out,
+                     uint8_t tag[16], size_t tag_len) {
+    GM_TRACE_ZONE(GMCRYPTO_ZONE_SM4_CCM, aad_len + len);
+    const size_t chunk = SM4_AEAD_CHUNK * 16;
+    uint8_t x[16], ctr[16], s0[16];
+    uint8_t ks[(SM4_AEAD_CHUNK + 1) * 16];
+    const uint8_t *kp = ks + 16;
+    size_t q = 15 - nonce_len, pos = 0;
+    size_t n = (len < chunk) ? len : chunk;
+
+    if (nonce_len < 7 || nonce_len > 13) return -1;
+    if (tag_len < 4 || tag_len > 16 || (tag_len & 1)) return -1;
+    if (q < 8 && ((uint64_t)len >> (8 * q)) != 0) return -1;
+
+    /* B0 = flags || nonce || 消息长度（q 字节大端） */
+    x[0] = (uint8_t)((aad_len ? 0x40 : 0) | (((tag_len - 2) / 2) << 3) | (q - 1));
+    memcpy(x + 1, nonce, nonce_len);
+    for (size_t i = 0; i < q; ++i) x[15 - i] = (i < 8) ? (uint8_t)((uint64_t)len >> (8 * i)) : 0;
+    sm4_crypt_block(key, x, x);
+
+    /* 附加数据：长度前缀 2 / 6 / 10 字节，末尾补零凑满分组 */
+    if (aad_len > 0) {
+        uint8_t hdr[10];
+        size_t h;
+        if (aad_len < 0xff00) {
+            hdr[0] = (uint8_t)(aad_len >> 8);
+            hdr[1] = (uint8_t)aad_len;
+            h = 2;
+        } else if (((uint64_t)aad_len >> 32) == 0) {
+            hdr[0] = 0xff; hdr[1] = 0xfe;
+            store_be32(hdr + 2, (uint32_t)aad_len);
+            h = 6;
+        } else {
+            hdr[0] = 0xff; hdr[1] = 0xff;
+            store_be64(hdr + 2, (uint64_t)aad_len);
+            h = 10;
+        }
+        ccm_absorb(key, x, &pos, hdr, h);
+        ccm_absorb(key, x, &pos, aad, aad_len);
+        if (pos > 0) {
+            sm4_crypt_block(key, x, x);
+            pos = 0;
+        }
+    }
+
+    /* A_i = (q - 1) || nonce || i；A_0 与第一批一起加密，留给标签 */
+    memset(ctr, 0, 16);
+    ctr[0] = (uint8_t)(q - 1);
+    memcpy(ctr + 1, nonce, nonce_len);
+    ccm_keystream(key, ctr, ks, (n + 15) / 16 + 1);
+    memcpy(s0, ks, 16);
+
+    /* CBC-MAC 作用在明文上：加密时先吸收再异或，解密时先异或再吸收 */
+    for (size_t done = 0; done < len; done += n) {
+        if (done > 0) {
+            n = (len - done < chunk) ? len - done : chunk;
+            ccm_keystream(key, ctr, ks, (n + 15) / 16);
+            kp = ks;
+        }
+        if (enc) ccm_absorb(key, x, &pos, in + done, n);
+        xor_bytes(out + done, in + done, kp, n);
+        if (!enc) ccm_absorb(key, x, &pos, out + done, n);
+    }
+    if (pos > 0) sm4_crypt_block(key, x, x);
+
+    xor_bytes(tag, x, s0, 16);
+    return 0;
+}
+
+int sm4_ccm_seal(const sm4_key *key, const uint8_t *nonce, size_t nonce_len,
+                 const uint8_t *aad, size_t aad_len,
+                 const uint8_t *in, size_t len, uint8_t *out,
+                 uint8_t *tag, size_t tag_len) {
+    uint8_t full[16];
+    if (ccm_crypt(key, 1, nonce, nonce_len, aad, aad_len, in, len, out, full, tag_len) < 0) return -1;
+    memcpy(tag, full, tag_len);
+    return 0;
+}
+
+int sm4_ccm_open(const sm4_key *key, const uint8_t *nonce, size_t nonce_len,
+                 const uint8_t *aad, size_t aad_len,
+                 const uint8_t *in, size_t len, uint8_t *out,
+                 const uint8_t *tag, size_t tag_len) {
+    uint8_t full[16];
+    if (ccm_crypt(key, 0, nonce, nonce_len, aad, aad_len, in, len, out, full, tag_len) < 0) return -1;
+    if (!ct_equal(full, tag, tag_len)) {
+        memset(out, 0, len);
+        return -1;
+    }
+    return 0;
+}
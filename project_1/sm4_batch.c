@@ -0,0 +1,210 @@
+/* SM4 批量接口：按 CPUID 选择车道内核，ECB 与 CTR 都走这里 */
+#include <string.h>
+#include <emmintrin.h>
+#include "sm4_pro.h"
+#include "sm4_lanes.h"
+#include "../common/cpu_features.h"
+#include "../common/gm_trace.h"
+
+typedef void (*sm4_lanes_fn)(const uint32_t *rk, const uint8_t *in, uint8_t *out, size_t nblocks);
+
+/* CTR 每次生成的密钥流分组数（在栈上，1KB） */
+#define SM4_CTR_CHUNK 64
+
+int sm4_batch_isa_supported(enum sm4_batch_isa isa) {
+    const cpu_features_t *f = cpu_features();
+    switch (isa) {
+        case SM4_BATCH_SSE2:      return f->sse2;
+        case SM4_BATCH_AESNI:     return f->ssse3 && f->aesni;
+        case SM4_BATCH_AVX2:      return f->avx2 && f->aesni;
+        case SM4_BATCH_AVX2_GFNI: return f->avx2 && f->gfni;
+        case SM4_BATCH_AVX512:    return f->avx512f && f->avx512bw && f->gfni;
+    }
+    return 0;
+}
+
+/* 与 sm4_one_pick 一样按 cpu_features 的三态方式发布，读到 2 之后 best 一定已经写好 */
+enum sm4_batch_isa sm4_batch_best_isa(void) {
+    static long state = 0;
+    static int best = SM4_BATCH_SSE2;
+    if (cpu_state_load(&state) == 2) return (enum sm4_batch_isa)best;
+    if (cpu_state_claim(&state)) {
+        int isa = SM4_BATCH_AVX512;
+        while (isa > SM4_BATCH_SSE2 && !sm4_batch_isa_supported((enum sm4_batch_isa)isa)) isa--;
+        best = isa;
+        cpu_state_publish(&state);
+    } else {
+        while (cpu_state_load(&state) != 2) {
+        }
+    }
+    return (enum sm4_batch_isa)best;
+}
+
+const char *sm4_batch_isa_name(enum sm4_batch_isa isa) {
+    switch (isa) {
+        case SM4_BATCH_SSE2:      return "sse2-bitslicedx16";
+        case SM4_BATCH_AESNI:     return "aesnix4";
+        case SM4_BATCH_AVX2:      return "avx2x8";
+        case SM4_BATCH_AVX2_GFNI: return "avx2-gfnix8";
+        case SM4_BATCH_AVX512:    return "avx512-gfnix16";
+    }
+    return "unknown";
+}
+
+unsigned sm4_batch_isa_lanes(enum sm4_batch_isa isa) {
+    switch (isa) {
+        case SM4_BATCH_SSE2:
+        case SM4_BATCH_AVX512:    return 16;
+        case SM4_BATCH_AVX2:
+        case SM4_BATCH_AVX2_GFNI: return 8;
+        default:                  return 4;
+    }
+}
+
+static sm4_lanes_fn sm4_batch_kernel(enum sm4_batch_isa isa) {
+    switch (isa) {
+        case SM4_BATCH_AESNI:     return sm4_lanes_aesni;
+        case SM4_BATCH_AVX2:      return sm4_lanes_avx2;
+        case SM4_BATCH_AVX2_GFNI: return sm4_lanes_avx2_gfni;
+        case SM4_BATCH_AVX512:    return sm4_lanes_avx512;
+        default:                  return sm4_lanes_sse2;
+    }
+}
+
+/* 分组数不够填满宽车道时退到较窄的内核，少做无用的补齐分组 */
+static enum sm4_batch_isa sm4_batch_pick(size_t nblocks) {
+    int isa = sm4_batch_best_isa();
+    while (isa > SM4_BATCH_AESNI &&
+           (nblocks < sm4_batch_isa_lanes((enum sm4_batch_isa)isa) ||
+            !sm4_batch_isa_supported((enum sm4_batch_isa)isa))) {
+        isa--;
+    }
+    if (!sm4_batch_isa_supported((enum sm4_batch_isa)isa)) isa = SM4_BATCH_SSE2;
+    return (enum sm4_batch_isa)isa;
+}
+
+static void sm4_batch_run(enum sm4_batch_isa isa, const sm4_key *key,
+                          const uint8_t *in, uint8_t *out, size_t nblocks) {
+    sm4_lanes_fn fn = sm4_batch_kernel(isa);
+    size_t lanes = sm4_batch_isa_lanes(isa);
+    size_t full = nblocks - nblocks % lanes;
+
+    if (full > 0) fn(key->rk, in, out, full);
+
+    /* 尾部不足一组：补零凑满车道，只取回有效分组 */
+    if (full < nblocks) {
+        uint8_t buf[16 * 16];
+        size_t rest = (nblocks - full) * 16;
+        memcpy(buf, in + full * 16, rest);
+        memset(buf + rest, 0, lanes * 16 - rest);
+        fn(key->rk, buf, buf, lanes);
+        memcpy(out + full * 16, buf, rest);
+    }
+}
+
+void sm4_crypt_blocks_isa(enum sm4_batch_isa isa, const sm4_key *key,
+                          const uint8_t *in, uint8_t *out, size_t nblocks) {
+    GM_TRACE_ZONE(GMCRYPTO_ZONE_SM4_BATCH, nblocks * 16);
+    sm4_batch_run(isa, key, in, out, nblocks);
+}
+
+/* 自动选择的路径：编译时定义 SM4_TTABLE 后，只有 SSE2 的 CPU 改用查表内核
+ * （比位切片快一个数量级，但不是常数时间）；显式指定 ISA 的接口不受影响 */
+static void sm4_batch_auto(enum sm4_batch_isa isa, const sm4_key *key,
+                           const uint8_t *in, uint8_t *out, size_t nblocks) {
+    GM_TRACE_ZONE(GMCRYPTO_ZONE_SM4_BATCH, nblocks * 16);
+#ifdef SM4_TTABLE
+    if (isa == SM4_BATCH_SSE2) {
+        sm4_ttable_blocks(key->rk, in, out, nblocks);
+        return;
+    }
+#endif
+    sm4_batch_run(isa, key, in, out, nblocks);
+}
+
+void sm4_crypt_blocks(const sm4_key *key, const uint8_t *in, uint8_t *out, size_t nblocks) {
+    sm4_batch_auto(sm4_batch_pick(nblocks), key, in, out, nblocks);
+}
+
+typedef void (*sm4_one_fn)(const uint32_t *rk, const uint8_t *in, uint8_t *out);
+
+/* 单分组：挑 S 盒延迟最短的实现（GFNI 2 条指令，AES-NI 约 8 条）。
+ * 选择结果按 cpu_features 的三态方式发布，读到 2 之后 fn 一定已经写好 */
+static sm4_one_fn sm4_one_pick(void) {
+    static long state = 0;
+    static sm4_one_fn fn = NULL;
+    if (cpu_state_load(&state) == 2) return fn;
+    if (cpu_state_claim(&state)) {
+        const cpu_features_t *f = cpu_features();
+        if (f->avx2 && f->gfni)         fn = sm4_one_gfni;
+        else if (f->ssse3 && f->aesni)  fn = sm4_one_aesni;
+        cpu_state_publish(&state);
+    } else {
+        while (cpu_state_load(&state) != 2) {
+        }
+    }
+    return fn;
+}
+
+const char *sm4_block_impl_name(void) {
+    sm4_one_fn fn = sm4_one_pick();
+    if (fn == sm4_one_gfni)  return "gfni";
+    if (fn == sm4_one_aesni) return "aesni";
+#ifdef SM4_TTABLE
+    return "ttable";
+#else
+    return sm4_batch_isa_name(SM4_BATCH_SSE2);
+#endif
+}
+
+void sm4_crypt_block(const sm4_key *key, const uint8_t in[16], uint8_t out[16]) {
+    GM_TRACE_ZONE(GMCRYPTO_ZONE_SM4_BLOCK, 16);
+    sm4_one_fn fn = sm4_one_pick();
+    if (fn != NULL) fn(key->rk, in, out);
+    else sm4_batch_auto(SM4_BATCH_SSE2, key, in, out, 1);
+}
+
+static inline uint64_t load_be64(const uint8_t *p) {
+    uint64_t v;
+    memcpy(&v, p, 8);
+#if defined(_MSC_VER)
+    return _byteswap_uint64(v);
+#else
+    return __builtin_bswap64(v);
+#endif
+}
+
+static inline void store_be64(uint8_t *p, uint64_t v) {
+#if defined(_MSC_VER)
+    v = _byteswap_uint64(v);
+#else
+    v = __builtin_bswap64(v);
+#endif
+    memcpy(p, &v, 8);
+}
+
+void sm4_ctr_blocks(const sm4_key *key, const uint8_t iv[16],
+                    const uint8_t *in, uint8_t *out, size_t nblocks) {
+    GM_TRACE_ZONE(GMCRYPTO_ZONE_SM4_CTR_BLOCKS, nblocks * 16);
+    enum sm4_batch_isa isa = sm4_batch_pick(nblocks);
+    uint8_t ks[SM4_CTR_CHUNK * 16];
+    uint64_t hi = load_be64(iv), lo = load_be64(iv + 8);
+
+    while (nblocks > 0) {
+        size_t n = (nblocks < SM4_CTR_CHUNK) ? nblocks : SM4_CTR_CHUNK;
+        for (size_t i = 0; i < n; ++i) {
+            store_be64(ks + i * 16, hi);
+            store_be64(ks + i * 16 + 8, lo);
+            if (++lo == 0) ++hi;
+        }
+        sm4_batch_auto(isa, key, ks, ks, n);
+        for (size_t i = 0; i < n; ++i) {
+            __m128i x = _mm_loadu_si128((const __m128i *)(in + i * 16));
+            __m128i k = _mm_loadu_si128((const __m128i *)(ks + i * 16));
+            _mm_storeu_si128((__m128i *)(out + i * 16), _mm_xor_si128(x, k));
+        }
+        in += n * 16;
+        out += n * 16;
+        nblocks -= n;
+    }
+}
@@ -0,0 +1,16 @@
+#ifndef SM4_GHASH_H
+#define SM4_GHASH_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * GHASH 的 PCLMULQDQ 内核（仅供 sm4_aead.c 调用）
+ * 分组先做字节反序，在 Intel 白皮书的反射表示下相乘，乘积左移 1 位后再模 x^128 + x^7 + x^2 + x + 1 约简。
+ * hpow[i] 为 H^(i+1)（同样是内部表示）；8 个或 4 个分组的未约简乘积先异或累加，最后只约简一次。
+ * xi 为 GCM 规范里的字节序，进出内核时转换。
+ */
+void sm4_ghash_clmul_init(uint8_t hpow[8][16], const uint8_t h[16]);
+void sm4_ghash_clmul(uint8_t xi[16], const uint8_t hpow[8][16], const uint8_t *in, size_t nblocks);
+
+#endif /* SM4_GHASH_H */
@@ -0,0 +1,109 @@
+/* GHASH：PCLMULQDQ 无进位乘法，8 / 4 个分组聚合约简 */
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC target("ssse3,pclmul")
+#endif
+#include <immintrin.h>
+#include "sm4_sbox.h"
+#include "sm4_ghash.h"
+
+/* 16 字节整体反序（pshufb），格式同 sm4_sbox.h：(高 8 字节, 低 8 字节) */
+#define GHASH_BSWAP 0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL
+
+static inline __m128i ghash_load(const uint8_t *p) {
+    return _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)p), SM4_M128(GHASH_BSWAP));
+}
+
+static inline void ghash_store(uint8_t *p, __m128i x) {
+    _mm_storeu_si128((__m128i *)p, _mm_shuffle_epi8(x, SM4_M128(GHASH_BSWAP)));
+}
+
+/* a * b 的 256 位乘积按 (lo, mid, hi) 三部分累加，mid 是两个交叉项之和 */
+#define CLMUL_ACC(a, b, lo, mid, hi) do {                                          \
+        lo = _mm_xor_si128(lo, _mm_clmulepi64_si128(a, b, 0x00));                  \
+        hi = _mm_xor_si128(hi, _mm_clmulepi64_si128(a, b, 0x11));                  \
+        mid = _mm_xor_si128(mid, _mm_xor_si128(_mm_clmulepi64_si128(a, b, 0x01),   \
+                                               _mm_clmulepi64_si128(a, b, 0x10))); \
+    } while (0)
+
+/* 合成 256 位乘积，左移 1 位（反射表示的修正），再约简到 128 位 */
+static inline __m128i ghash_reduce(__m128i lo, __m128i mid, __m128i hi) {
+    __m128i t0, t1, t2;
+    lo = _mm_xor_si128(lo, _mm_slli_si128(mid, 8));
+    hi = _mm_xor_si128(hi, _mm_srli_si128(mid, 8));
+
+    /* hi:lo <<= 1 */
+    t0 = _mm_srli_epi32(lo, 31);
+    t1 = _mm_srli_epi32(hi, 31);
+    lo = _mm_slli_epi32(lo, 1);
+    hi = _mm_slli_epi32(hi, 1);
+    t2 = _mm_srli_si128(t0, 12);
+    t1 = _mm_slli_si128(t1, 4);
+    t0 = _mm_slli_si128(t0, 4);
+    lo = _mm_or_si128(lo, t0);
+    hi = _mm_or_si128(hi, _mm_or_si128(t1, t2));
+
+    /* 第一步：x^128 = x^7 + x^2 + x + 1，反射表示下对应左移 31 / 30 / 25 位，先折回 lo 自身 */
+    t0 = _mm_xor_si128(_mm_xor_si128(_mm_slli_epi32(lo, 31), _mm_slli_epi32(lo, 30)),
+                       _mm_slli_epi32(lo, 25));
+    t1 = _mm_srli_si128(t0, 4);
+    lo = _mm_xor_si128(lo, _mm_slli_si128(t0, 12));
+
+    /* 第二步：右移 1 / 2 / 7 位后并入高半部分 */
+    t2 = _mm_xor_si128(_mm_xor_si128(_mm_srli_epi32(lo, 1), _mm_srli_epi32(lo, 2)),
+                       _mm_xor_si128(_mm_srli_epi32(lo, 7), t1));
+    return _mm_xor_si128(hi, _mm_xor_si128(lo, t2));
+}
+
+static inline __m128i ghash_mul(__m128i a, __m128i b) {
+    __m128i lo = _mm_setzero_si128(), mid = lo, hi = lo;
+    CLMUL_ACC(a, b, lo, mid, hi);
+    return ghash_reduce(lo, mid, hi);
+}
+
+void sm4_ghash_clmul_init(uint8_t hpow[8][16], const uint8_t h[16]) {
+    __m128i H = ghash_load(h), p = H;
+    _mm_storeu_si128((__m128i *)hpow[0], H);
+    for (int i = 1; i < 8; ++i) {
+        p = ghash_mul(p, H);
+        _mm_storeu_si128((__m128i *)hpow[i], p);
+    }
+}
+
+/*
+ * X' = (X ^ B0)·H^n ^ B1·H^(n-1) ^ ... ^ B(n-1)·H
+ * n 个乘法互不依赖，clmul 可以流水；约简是线性的，累加后只做一次。
+ */
+void sm4_ghash_clmul(uint8_t xi[16], const uint8_t hpow[8][16], const uint8_t *in, size_t nblocks) {
+    __m128i H[8];
+    __m128i x = ghash_load(xi);
+    for (int i = 0; i < 8; ++i) H[i] = _mm_loadu_si128((const __m128i *)hpow[i]);
+
+    for (; nblocks >= 8; nblocks -= 8, in += 128) {
+        __m128i lo = _mm_setzero_si128(), mid = lo, hi = lo;
+        __m128i b = _mm_xor_si128(x, ghash_load(in));
+        CLMUL_ACC(b, H[7], lo, mid, hi);
+        for (int j = 1; j < 8; ++j) {
+            b = ghash_load(in + 16 * j);
+            CLMUL_ACC(b, H[7 - j], lo, mid, hi);
+        }
+        x = ghash_reduce(lo, mid, hi);
+    }
+
+    if (nblocks >= 4) {
+        __m128i lo = _mm_setzero_si128(), mid = lo, hi = lo;
+        __m128i b = _mm_xor_si128(x, ghash_load(in));
+        CLMUL_ACC(b, H[3], lo, mid, hi);
+        for (int j = 1; j < 4; ++j) {
+            b = ghash_load(in + 16 * j);
+            CLMUL_ACC(b, H[3 - j], lo, mid, hi);
+        }
+        x = ghash_reduce(lo, mid, hi);
+        nblocks -= 4;
+        in += 64;
+    }
+
+    for (; nblocks > 0; --nblocks, in += 16) {
+        x = ghash_mul(_mm_xor_si128(x, ghash_load(in)), H[0]);
+    }
+    ghash_store(xi, x);
+}
@@ -0,0 +1,153 @@
+/* SM4 轮密钥缓存：固定容量的哈希表 + 双向链表 LRU
+ * 条目一次性分配好，淘汰时原地复用，运行中不再分配内存。 */
+#include <stdlib.h>
+#include <string.h>
+#include "sm4_pro.h"
+
+#define SM4_CACHE_NIL (-1)
+
+typedef struct SM4_CACHE_ALIGN {
+    sm4_key_pair keys;          /* 放在开头，对齐到缓存行 */
+    uint8_t user_key[16];
+    uint64_t fp;
+    int32_t prev, next;         /* LRU 链表，head 为最近使用 */
+    int32_t hnext;              /* 同一哈希桶内的下一个条目 */
+} sm4_cache_entry;
+
+struct sm4_key_cache {
+    sm4_cache_entry *entries;
+    int32_t *buckets;
+    size_t capacity, used;
+    size_t mask;                /* 桶数 - 1，桶数取不小于 2 * capacity 的 2 的幂 */
+    int32_t head, tail;
+    uint64_t hits, misses;
+};
+
+static void *cache_aligned_alloc(size_t size) {
+#if defined(_MSC_VER)
+    return _aligned_malloc(size, 64);
+#else
+    void *p = NULL;
+    return posix_memalign(&p, 64, size) == 0 ? p : NULL;
+#endif
+}
+
+static void cache_aligned_free(void *p) {
+#if defined(_MSC_VER)
+    _aligned_free(p);
+#else
+    free(p);
+#endif
+}
+
+/* 密钥指纹：两半 64 位各乘奇常数后混合，再做一次 64 位末端扰动 */
+static uint64_t key_fingerprint(const uint8_t k[16]) {
+    uint64_t a, b, h;
+    memcpy(&a, k, 8);
+    memcpy(&b, k + 8, 8);
+    h = a * 0x9e3779b97f4a7c15ULL ^ (b + 0x632be59bd9b4e019ULL) * 0xc2b2ae3d27d4eb4fULL;
+    h ^= h >> 31;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 29;
+    return h;
+}
+
+sm4_key_cache *sm4_key_cache_new(size_t capacity) {
+    sm4_key_cache *c;
+    size_t nb = 1;
+    if (capacity == 0 || capacity > 0x3fffffff) return NULL;
+    while (nb < 2 * capacity) nb <<= 1;
+
+    c = (sm4_key_cache *)calloc(1, sizeof(*c));
+    if (!c) return NULL;
+    c->entries = (sm4_cache_entry *)cache_aligned_alloc(capacity * sizeof(sm4_cache_entry));
+    c->buckets = (int32_t *)malloc(nb * sizeof(int32_t));
+    if (!c->entries || !c->buckets) {
+        sm4_key_cache_free(c);
+        return NULL;
+    }
+    for (size_t i = 0; i < nb; ++i) c->buckets[i] = SM4_CACHE_NIL;
+    c->capacity = capacity;
+    c->mask = nb - 1;
+    c->head = c->tail = SM4_CACHE_NIL;
+    return c;
+}
+
+void sm4_key_cache_free(sm4_key_cache *c) {
+    if (!c) return;
+    if (c->entries) {
+        /* 条目里是密钥材料，释放前清零 */
+        volatile uint8_t *p = (volatile uint8_t *)c->entries;
+        for (size_t i = 0; i < c->used * sizeof(sm4_cache_entry); ++i) p[i] = 0;
+        cache_aligned_free(c->entries);
+    }
+    free(c->buckets);
+    free(c);
+}
+
+static void lru_unlink(sm4_key_cache *c, int32_t i) {
+    sm4_cache_entry *e = &c->entries[i];
+    if (e->prev != SM4_CACHE_NIL) c->entries[e->prev].next = e->next;
+    else c->head = e->next;
+    if (e->next != SM4_CACHE_NIL) c->entries[e->next].prev = e->prev;
+    else c->tail = e->prev;
+}
+
+static void lru_push_front(sm4_key_cache *c, int32_t i) {
+    sm4_cache_entry *e = &c->entries[i];
+    e->prev = SM4_CACHE_NIL;
+    e->next = c->head;
+    if (c->head != SM4_CACHE_NIL) c->entries[c->head].prev = i;
+    c->head = i;
+    if (c->tail == SM4_CACHE_NIL) c->tail = i;
+}
+
+/* 从哈希桶链里摘掉条目 i */
+static void bucket_remove(sm4_key_cache *c, int32_t i) {
+    int32_t *link = &c->buckets[c->entries[i].fp & c->mask];
+    while (*link != i) link = &c->entries[*link].hnext;
+    *link = c->entries[i].hnext;
+}
+
+const sm4_key_pair *sm4_key_cache_get(sm4_key_cache *c, const uint8_t user_key[16]) {
+    uint64_t fp = key_fingerprint(user_key);
+    int32_t *bucket = &c->buckets[fp & c->mask];
+    int32_t i;
+
+    for (i = *bucket; i != SM4_CACHE_NIL; i = c->entries[i].hnext) {
+        sm4_cache_entry *e = &c->entries[i];
+        if (e->fp == fp && memcmp(e->user_key, user_key, 16) == 0) {
+            if (c->head != i) {
+                lru_unlink(c, i);
+                lru_push_front(c, i);
+            }
+            c->hits++;
+            return &e->keys;
+        }
+    }
+
+    /* 未命中：有空位用空位，否则复用最久未用的条目 */
+    c->misses++;
+    if (c->used < c->capacity) {
+        i = (int32_t)c->used++;
+    } else {
+        i = c->tail;
+        lru_unlink(c, i);
+        bucket_remove(c, i);
+    }
+    {
+        sm4_cache_entry *e = &c->entries[i];
+        sm4_key_pair_init(&e->keys, user_key);
+        memcpy(e->user_key, user_key, 16);
+        e->fp = fp;
+        e->hnext = *bucket;
+        *bucket = i;
+        lru_push_front(c, i);
+        return &e->keys;
+    }
+}
+
+void sm4_key_cache_stats(const sm4_key_cache *c, uint64_t *hits, uint64_t *misses) {
+    if (hits) *hits = c->hits;
+    if (misses) *misses = c->misses;
+}
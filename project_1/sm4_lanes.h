@@ -0,0 +1,164 @@
+#ifndef SM4_LANES_H
+#define SM4_LANES_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * SM4 批量车道内核
+ * rk 为 32 个轮密钥；nblocks 必须是车道数的整数倍（尾部由 sm4_batch.c 补齐），in 与 out 可以相同。
+ */
+void sm4_lanes_sse2(const uint32_t *rk, const uint8_t *in, uint8_t *out, size_t nblocks);
+void sm4_lanes_aesni(const uint32_t *rk, const uint8_t *in, uint8_t *out, size_t nblocks);
+void sm4_lanes_avx2(const uint32_t *rk, const uint8_t *in, uint8_t *out, size_t nblocks);
+void sm4_lanes_avx2_gfni(const uint32_t *rk, const uint8_t *in, uint8_t *out, size_t nblocks);
+void sm4_lanes_avx512(const uint32_t *rk, const uint8_t *in, uint8_t *out, size_t nblocks);
+
+/* 单分组内核：状态放在通用寄存器里，只有 S 盒用 128 位向量指令，
+ * 串行模式（CBC 加密、CFB 加密、OFB）的速度由这条依赖链的延迟决定。
+ * 位切片 S 盒一次只算一个字太浪费，只有 SSE2 时仍走 16 路内核。 */
+void sm4_one_aesni(const uint32_t *rk, const uint8_t *in, uint8_t *out);
+void sm4_one_gfni(const uint32_t *rk, const uint8_t *in, uint8_t *out);
+
+/* 查表内核（sm4_ttable.c），任意分组数；只在定义 SM4_TTABLE 时代替只有 SSE2 时的位切片内核 */
+void sm4_ttable_blocks(const uint32_t *rk, const uint8_t *in, uint8_t *out, size_t nblocks);
+
+/* 每个 32 位字内的字节重排（pshufb），格式同 sm4_sbox.h：(高 8 字节, 低 8 字节) */
+#define SM4_BSWAP32 0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL
+#define SM4_ROL8    0x0e0d0c0f0a09080bULL, 0x0605040702010003ULL
+#define SM4_ROL16   0x0d0c0f0e09080b0aULL, 0x0504070601000302ULL
+#define SM4_ROL24   0x0c0f0e0d080b0a09ULL, 0x0407060500030201ULL
+
+#endif /* SM4_LANES_H */
+
+/*
+ * 以下内核体由各 ISA 翻译单元在 #pragma GCC target 下定义 SM4_LANES_DEFINE_KERNEL 后包含，
+ * 每个翻译单元只包含一次，辅助函数都是 static。
+ *
+ * 需要事先定义：
+ *   SM4_LANES_FN（函数名）、V（寄存器类型）、W（每次处理的分组数 = 32 位车道数），
+ *   V_LOADU、V_STOREU、V_XOR、V_SET1、V_ROL(v, n)、V_BSWAP32、V_SBOX，
+ *   V_UNPACKLO32、V_UNPACKHI32、V_UNPACKLO64、V_UNPACKHI64（均在 128 位分区内）。
+ *   V_ROL8 / V_ROL16 / V_ROL24 可选，有 pshufb 时定义成字节重排更快。
+ *
+ * 布局：连续 4 个寄存器装 W 个分组，每个 128 位分区做 4x4 转置后，X0..X3 的第 k 个车道
+ * 就是同一个分组的 4 个字。所有车道共用轮密钥，分组落在哪个车道无关紧要，
+ * 逆转置回同一位置即可，因此不需要跨 128 位分区的重排。
+ */
+#ifdef SM4_LANES_DEFINE_KERNEL
+
+#ifndef V_ROL8
+#define V_ROL8(v) V_ROL(v, 8)
+#endif
+#ifndef V_ROL16
+#define V_ROL16(v) V_ROL(v, 16)
+#endif
+#ifndef V_ROL24
+#define V_ROL24(v) V_ROL(v, 24)
+#endif
+
+/* L(B) = B ^ B<<<2 ^ B<<<10 ^ B<<<18 ^ B<<<24 = B ^ B<<<24 ^ (B ^ B<<<8 ^ B<<<16)<<<2 */
+static inline V sm4_lanes_l1(V b) {
+    V t = V_XOR(V_XOR(b, V_ROL8(b)), V_ROL16(b));
+    return V_XOR(V_XOR(b, V_ROL24(b)), V_ROL(t, 2));
+}
+
+#define SM4_LANES_ROUND(x0, x1, x2, x3, k) \
+    x0 = V_XOR(x0, sm4_lanes_l1(V_SBOX(V_XOR(V_XOR(x1, x2), V_XOR(x3, V_SET1(k))))))
+
+/* 4x4 转置（每个 128 位分区独立） */
+#define SM4_LANES_TRANSPOSE(a, b, c, d) do {                    \
+        V t0_ = V_UNPACKLO32(a, b), t1_ = V_UNPACKLO32(c, d);   \
+        V t2_ = V_UNPACKHI32(a, b), t3_ = V_UNPACKHI32(c, d);   \
+        a = V_UNPACKLO64(t0_, t1_); b = V_UNPACKHI64(t0_, t1_); \
+        c = V_UNPACKLO64(t2_, t3_); d = V_UNPACKHI64(t2_, t3_); \
+    } while (0)
+
+#define SM4_LANES_LOAD(p, x0, x1, x2, x3) do {   \
+        x0 = V_BSWAP32(V_LOADU(p));              \
+        x1 = V_BSWAP32(V_LOADU((p) + 4 * W));    \
+        x2 = V_BSWAP32(V_LOADU((p) + 8 * W));    \
+        x3 = V_BSWAP32(V_LOADU((p) + 12 * W));   \
+        SM4_LANES_TRANSPOSE(x0, x1, x2, x3);     \
+    } while (0)
+
+/* 输出反序 (X35, X34, X33, X32) */
+#define SM4_LANES_STORE(p, x0, x1, x2, x3) do {  \
+        SM4_LANES_TRANSPOSE(x3, x2, x1, x0);     \
+        V_STOREU(p, V_BSWAP32(x3));              \
+        V_STOREU((p) + 4 * W, V_BSWAP32(x2));    \
+        V_STOREU((p) + 8 * W, V_BSWAP32(x1));    \
+        V_STOREU((p) + 12 * W, V_BSWAP32(x0));   \
+    } while (0)
+
+void SM4_LANES_FN(const uint32_t *rk, const uint8_t *in, uint8_t *out, size_t nblocks) {
+    V x0, x1, x2, x3, y0, y1, y2, y3;
+
+    /* 轮函数的依赖链很长（S 盒 + L 约十几条指令串行），两组互不相关的分组交错执行，
+       让乱序执行填满流水线 */
+    for (; nblocks >= 2 * W; nblocks -= 2 * W, in += 32 * W, out += 32 * W) {
+        SM4_LANES_LOAD(in, x0, x1, x2, x3);
+        SM4_LANES_LOAD(in + 16 * W, y0, y1, y2, y3);
+        for (int i = 0; i < 32; i += 4) {
+            SM4_LANES_ROUND(x0, x1, x2, x3, rk[i]);
+            SM4_LANES_ROUND(y0, y1, y2, y3, rk[i]);
+            SM4_LANES_ROUND(x1, x2, x3, x0, rk[i + 1]);
+            SM4_LANES_ROUND(y1, y2, y3, y0, rk[i + 1]);
+            SM4_LANES_ROUND(x2, x3, x0, x1, rk[i + 2]);
+            SM4_LANES_ROUND(y2, y3, y0, y1, rk[i + 2]);
+            SM4_LANES_ROUND(x3, x0, x1, x2, rk[i + 3]);
+            SM4_LANES_ROUND(y3, y0, y1, y2, rk[i + 3]);
+        }
+        SM4_LANES_STORE(out, x0, x1, x2, x3);
+        SM4_LANES_STORE(out + 16 * W, y0, y1, y2, y3);
+    }
+
+    if (nblocks >= W) {
+        SM4_LANES_LOAD(in, x0, x1, x2, x3);
+        for (int i = 0; i < 32; i += 4) {
+            SM4_LANES_ROUND(x0, x1, x2, x3, rk[i]);
+            SM4_LANES_ROUND(x1, x2, x3, x0, rk[i + 1]);
+            SM4_LANES_ROUND(x2, x3, x0, x1, rk[i + 2]);
+            SM4_LANES_ROUND(x3, x0, x1, x2, rk[i + 3]);
+        }
+        SM4_LANES_STORE(out, x0, x1, x2, x3);
+    }
+}
+
+/* 可选：定义了 SM4_ONE_FN 和 V1_SBOX（__m128i -> __m128i）时同时生成单分组内核 */
+#ifdef SM4_ONE_FN
+static inline uint32_t sm4_one_rol(uint32_t x, int n) {
+    return (x << n) | (x >> (32 - n));
+}
+
+static inline uint32_t sm4_one_t(uint32_t x) {
+    uint32_t b = (uint32_t)_mm_cvtsi128_si32(V1_SBOX(_mm_cvtsi32_si128((int)x)));
+    return b ^ sm4_one_rol(b, 2) ^ sm4_one_rol(b, 10) ^ sm4_one_rol(b, 18) ^ sm4_one_rol(b, 24);
+}
+
+static inline uint32_t sm4_one_load(const uint8_t *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static inline void sm4_one_store(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)(v >> 24); p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);  p[3] = (uint8_t)v;
+}
+
+void SM4_ONE_FN(const uint32_t *rk, const uint8_t *in, uint8_t *out) {
+    uint32_t x0 = sm4_one_load(in), x1 = sm4_one_load(in + 4);
+    uint32_t x2 = sm4_one_load(in + 8), x3 = sm4_one_load(in + 12);
+    for (int i = 0; i < 32; i += 4) {
+        x0 ^= sm4_one_t(x1 ^ x2 ^ x3 ^ rk[i]);
+        x1 ^= sm4_one_t(x2 ^ x3 ^ x0 ^ rk[i + 1]);
+        x2 ^= sm4_one_t(x3 ^ x0 ^ x1 ^ rk[i + 2]);
+        x3 ^= sm4_one_t(x0 ^ x1 ^ x2 ^ rk[i + 3]);
+    }
+    sm4_one_store(out, x3);
+    sm4_one_store(out + 4, x2);
+    sm4_one_store(out + 8, x1);
+    sm4_one_store(out + 12, x0);
+}
+#endif /* SM4_ONE_FN */
+
+#endif /* SM4_LANES_DEFINE_KERNEL */
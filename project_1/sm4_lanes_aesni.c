@@ -0,0 +1,30 @@
+/* SM4 批量内核：SSSE3 + AES-NI 4 路 */
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC target("ssse3,aes")
+#endif
+#include <immintrin.h>
+#include "sm4_sbox.h"
+#define SM4_LANES_DEFINE_KERNEL
+
+#define SM4_LANES_FN sm4_lanes_aesni
+#define V __m128i
+#define W 4
+#define V_LOADU(p)     _mm_loadu_si128((const __m128i *)(p))
+#define V_STOREU(p, v) _mm_storeu_si128((__m128i *)(p), v)
+#define V_XOR          _mm_xor_si128
+#define V_SET1(x)      _mm_set1_epi32((int)(x))
+#define V_ROL(v, n)    _mm_or_si128(_mm_slli_epi32(v, n), _mm_srli_epi32(v, 32 - (n)))
+#define V_ROL8(v)      _mm_shuffle_epi8(v, SM4_M128(SM4_ROL8))
+#define V_ROL16(v)     _mm_shuffle_epi8(v, SM4_M128(SM4_ROL16))
+#define V_ROL24(v)     _mm_shuffle_epi8(v, SM4_M128(SM4_ROL24))
+#define V_BSWAP32(v)   _mm_shuffle_epi8(v, SM4_M128(SM4_BSWAP32))
+#define V_SBOX         sm4_sbox_aesni
+#define V_UNPACKLO32   _mm_unpacklo_epi32
+#define V_UNPACKHI32   _mm_unpackhi_epi32
+#define V_UNPACKLO64   _mm_unpacklo_epi64
+#define V_UNPACKHI64   _mm_unpackhi_epi64
+
+#define SM4_ONE_FN sm4_one_aesni
+#define V1_SBOX    sm4_sbox_aesni
+
+#include "sm4_lanes.h"
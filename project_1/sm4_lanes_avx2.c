@@ -0,0 +1,49 @@
+/* SM4 批量内核：AVX2 8 路，S 盒用 AES-NI（aesenclast 只有 128 位，按两半分别做） */
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC target("avx2,aes")
+#endif
+#include <immintrin.h>
+#include "sm4_sbox.h"
+#define SM4_LANES_DEFINE_KERNEL
+
+#define SM4_M256(c) avx2_bcast128(c)
+static inline __m256i avx2_bcast128(unsigned long long hi, unsigned long long lo) {
+    return _mm256_set_epi64x((long long)hi, (long long)lo, (long long)hi, (long long)lo);
+}
+
+static inline __m256i avx2_affine_nibble(__m256i x, __m256i lo, __m256i hi) {
+    const __m256i mask = _mm256_set1_epi8(0x0f);
+    __m256i l = _mm256_shuffle_epi8(lo, _mm256_and_si256(x, mask));
+    __m256i h = _mm256_shuffle_epi8(hi, _mm256_and_si256(_mm256_srli_epi16(x, 4), mask));
+    return _mm256_xor_si256(l, h);
+}
+
+/* 前后仿射在 256 位上做，中间的 aesenclast 拆成两半 */
+static inline __m256i avx2_sbox(__m256i x) {
+    x = _mm256_shuffle_epi8(x, SM4_M256(SM4_INV_SHIFT_ROWS));
+    x = avx2_affine_nibble(x, SM4_M256(SM4_AESNI_PRE_LO), SM4_M256(SM4_AESNI_PRE_HI));
+    __m128i lo = _mm_aesenclast_si128(_mm256_castsi256_si128(x), _mm_setzero_si128());
+    __m128i hi = _mm_aesenclast_si128(_mm256_extracti128_si256(x, 1), _mm_setzero_si128());
+    x = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+    return avx2_affine_nibble(x, SM4_M256(SM4_AESNI_POST_LO), SM4_M256(SM4_AESNI_POST_HI));
+}
+
+#define SM4_LANES_FN sm4_lanes_avx2
+#define V __m256i
+#define W 8
+#define V_LOADU(p)     _mm256_loadu_si256((const __m256i *)(p))
+#define V_STOREU(p, v) _mm256_storeu_si256((__m256i *)(p), v)
+#define V_XOR          _mm256_xor_si256
+#define V_SET1(x)      _mm256_set1_epi32((int)(x))
+#define V_ROL(v, n)    _mm256_or_si256(_mm256_slli_epi32(v, n), _mm256_srli_epi32(v, 32 - (n)))
+#define V_ROL8(v)      _mm256_shuffle_epi8(v, SM4_M256(SM4_ROL8))
+#define V_ROL16(v)     _mm256_shuffle_epi8(v, SM4_M256(SM4_ROL16))
+#define V_ROL24(v)     _mm256_shuffle_epi8(v, SM4_M256(SM4_ROL24))
+#define V_BSWAP32(v)   _mm256_shuffle_epi8(v, SM4_M256(SM4_BSWAP32))
+#define V_SBOX         avx2_sbox
+#define V_UNPACKLO32   _mm256_unpacklo_epi32
+#define V_UNPACKHI32   _mm256_unpackhi_epi32
+#define V_UNPACKLO64   _mm256_unpacklo_epi64
+#define V_UNPACKHI64   _mm256_unpackhi_epi64
+
+#include "sm4_lanes.h"
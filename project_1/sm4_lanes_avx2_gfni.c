@@ -0,0 +1,47 @@
+/* SM4 批量内核：AVX2 + GFNI 8 路，S 盒两条仿射指令 */
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC target("avx2,gfni")
+#endif
+#include <immintrin.h>
+#include "sm4_sbox.h"
+#define SM4_LANES_DEFINE_KERNEL
+
+#define SM4_M256(c) avx2_bcast128(c)
+static inline __m256i avx2_bcast128(unsigned long long hi, unsigned long long lo) {
+    return _mm256_set_epi64x((long long)hi, (long long)lo, (long long)hi, (long long)lo);
+}
+
+static inline __m256i gfni_sbox(__m256i x) {
+    x = _mm256_gf2p8affine_epi64_epi8(x, _mm256_set1_epi64x((long long)SM4_GFNI_PRE_MAT),
+                                      SM4_GFNI_PRE_CONST);
+    return _mm256_gf2p8affineinv_epi64_epi8(x, _mm256_set1_epi64x((long long)SM4_GFNI_POST_MAT),
+                                            SM4_GFNI_POST_CONST);
+}
+
+/* 单分组内核只用 128 位的 GFNI S 盒 */
+static inline __m128i gfni_sbox128(__m128i x) {
+    return sm4_sbox_gfni(x);
+}
+
+#define SM4_LANES_FN sm4_lanes_avx2_gfni
+#define V __m256i
+#define W 8
+#define V_LOADU(p)     _mm256_loadu_si256((const __m256i *)(p))
+#define V_STOREU(p, v) _mm256_storeu_si256((__m256i *)(p), v)
+#define V_XOR          _mm256_xor_si256
+#define V_SET1(x)      _mm256_set1_epi32((int)(x))
+#define V_ROL(v, n)    _mm256_or_si256(_mm256_slli_epi32(v, n), _mm256_srli_epi32(v, 32 - (n)))
+#define V_ROL8(v)      _mm256_shuffle_epi8(v, SM4_M256(SM4_ROL8))
+#define V_ROL16(v)     _mm256_shuffle_epi8(v, SM4_M256(SM4_ROL16))
+#define V_ROL24(v)     _mm256_shuffle_epi8(v, SM4_M256(SM4_ROL24))
+#define V_BSWAP32(v)   _mm256_shuffle_epi8(v, SM4_M256(SM4_BSWAP32))
+#define V_SBOX         gfni_sbox
+#define V_UNPACKLO32   _mm256_unpacklo_epi32
+#define V_UNPACKHI32   _mm256_unpackhi_epi32
+#define V_UNPACKLO64   _mm256_unpacklo_epi64
+#define V_UNPACKHI64   _mm256_unpackhi_epi64
+
+#define SM4_ONE_FN sm4_one_gfni
+#define V1_SBOX    gfni_sbox128
+
+#include "sm4_lanes.h"
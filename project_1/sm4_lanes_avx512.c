@@ -0,0 +1,36 @@
+/* SM4 批量内核：AVX-512BW + GFNI 16 路 */
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC target("avx512f,avx512bw,gfni")
+#endif
+#include <immintrin.h>
+#include "sm4_sbox.h"
+#define SM4_LANES_DEFINE_KERNEL
+
+#define SM4_M512(c) avx512_bcast128(c)
+static inline __m512i avx512_bcast128(unsigned long long hi, unsigned long long lo) {
+    return _mm512_broadcast_i32x4(_mm_set_epi64x((long long)hi, (long long)lo));
+}
+
+static inline __m512i gfni_sbox(__m512i x) {
+    x = _mm512_gf2p8affine_epi64_epi8(x, _mm512_set1_epi64((long long)SM4_GFNI_PRE_MAT),
+                                      SM4_GFNI_PRE_CONST);
+    return _mm512_gf2p8affineinv_epi64_epi8(x, _mm512_set1_epi64((long long)SM4_GFNI_POST_MAT),
+                                            SM4_GFNI_POST_CONST);
+}
+
+#define SM4_LANES_FN sm4_lanes_avx512
+#define V __m512i
+#define W 16
+#define V_LOADU(p)     _mm512_loadu_si512((const void *)(p))
+#define V_STOREU(p, v) _mm512_storeu_si512((void *)(p), v)
+#define V_XOR          _mm512_xor_si512
+#define V_SET1(x)      _mm512_set1_epi32((int)(x))
+#define V_ROL(v, n)    _mm512_rol_epi32(v, n)
+#define V_BSWAP32(v)   _mm512_shuffle_epi8(v, SM4_M512(SM4_BSWAP32))
+#define V_SBOX         gfni_sbox
+#define V_UNPACKLO32   _mm512_unpacklo_epi32
+#define V_UNPACKHI32   _mm512_unpackhi_epi32
+#define V_UNPACKLO64   _mm512_unpacklo_epi64
+#define V_UNPACKHI64   _mm512_unpackhi_epi64
+
+#include "sm4_lanes.h"
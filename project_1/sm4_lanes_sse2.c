@@ -0,0 +1,85 @@
+/* SM4 批量内核：SSE2，位切片 S 盒（没有 SSSE3 / AES-NI 的机器）
+ * 位切片电路的开销与字节数无关，所以把 4 个 XMM 寄存器当成一个 512 位"寄存器"，
+ * 一次处理 16 个分组，每轮的 S 盒正好 64 个字节。 */
+#include <emmintrin.h>
+#include "sm4_sbox.h"
+#define SM4_LANES_DEFINE_KERNEL
+
+typedef struct {
+    __m128i r[4];
+} sse2_x4;
+
+static inline sse2_x4 sse2_loadu(const uint8_t *p) {
+    sse2_x4 v;
+    for (int k = 0; k < 4; ++k) v.r[k] = _mm_loadu_si128((const __m128i *)(p + 16 * k));
+    return v;
+}
+
+static inline void sse2_storeu(uint8_t *p, sse2_x4 v) {
+    for (int k = 0; k < 4; ++k) _mm_storeu_si128((__m128i *)(p + 16 * k), v.r[k]);
+}
+
+static inline sse2_x4 sse2_set1(uint32_t x) {
+    sse2_x4 v;
+    for (int k = 0; k < 4; ++k) v.r[k] = _mm_set1_epi32((int)x);
+    return v;
+}
+
+#define SSE2_X4_OP(name, expr)                          \
+    static inline sse2_x4 name(sse2_x4 a, sse2_x4 b) {  \
+        sse2_x4 v;                                      \
+        for (int k = 0; k < 4; ++k) {                   \
+            __m128i x = a.r[k], y = b.r[k];             \
+            v.r[k] = (expr);                            \
+        }                                               \
+        return v;                                       \
+    }
+
+SSE2_X4_OP(sse2_xor, _mm_xor_si128(x, y))
+SSE2_X4_OP(sse2_unpacklo32, _mm_unpacklo_epi32(x, y))
+SSE2_X4_OP(sse2_unpackhi32, _mm_unpackhi_epi32(x, y))
+SSE2_X4_OP(sse2_unpacklo64, _mm_unpacklo_epi64(x, y))
+SSE2_X4_OP(sse2_unpackhi64, _mm_unpackhi_epi64(x, y))
+
+static inline sse2_x4 sse2_rol(sse2_x4 a, int n) {
+    for (int k = 0; k < 4; ++k)
+        a.r[k] = _mm_or_si128(_mm_slli_epi32(a.r[k], n), _mm_srli_epi32(a.r[k], 32 - n));
+    return a;
+}
+
+static inline sse2_x4 sse2_rol16(sse2_x4 a) {
+    for (int k = 0; k < 4; ++k)
+        a.r[k] = _mm_shufflehi_epi16(_mm_shufflelo_epi16(a.r[k], 0xb1), 0xb1);
+    return a;
+}
+
+/* 没有 pshufb：先交换 16 位半字，再交换每个半字内的两个字节 */
+static inline sse2_x4 sse2_bswap32(sse2_x4 a) {
+    a = sse2_rol16(a);
+    for (int k = 0; k < 4; ++k)
+        a.r[k] = _mm_or_si128(_mm_slli_epi16(a.r[k], 8), _mm_srli_epi16(a.r[k], 8));
+    return a;
+}
+
+static inline sse2_x4 sse2_sbox(sse2_x4 a) {
+    sm4_sbox_bitsliced_x4(a.r);
+    return a;
+}
+
+#define SM4_LANES_FN sm4_lanes_sse2
+#define V sse2_x4
+#define W 16
+#define V_LOADU(p)     sse2_loadu(p)
+#define V_STOREU(p, v) sse2_storeu(p, v)
+#define V_XOR          sse2_xor
+#define V_SET1(x)      sse2_set1(x)
+#define V_ROL(v, n)    sse2_rol(v, n)
+#define V_ROL16(v)     sse2_rol16(v)
+#define V_BSWAP32(v)   sse2_bswap32(v)
+#define V_SBOX         sse2_sbox
+#define V_UNPACKLO32   sse2_unpacklo32
+#define V_UNPACKHI32   sse2_unpackhi32
+#define V_UNPACKLO64   sse2_unpacklo64
+#define V_UNPACKHI64   sse2_unpackhi64
+
+#include "sm4_lanes.h"
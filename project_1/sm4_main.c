@@ -0,0 +1,351 @@
+/* SM4 SIMD 版测试：S 盒实现自检、标准向量、批量接口、工作模式、AEAD 与轮密钥缓存自检、单分组计时
+ * 编译：gcc -O2 sm4_main.c sm4_pro.c sm4_batch.c sm4_modes.c sm4_aead.c sm4_ghash_clmul.c sm4_ttable.c
+ *       sm4_keycache.c sm4_lanes_sse2.c sm4_lanes_aesni.c sm4_lanes_avx2.c sm4_lanes_avx2_gfni.c sm4_lanes_avx512.c -o sm4_pro
+ *       或者在仓库根目录用 CMake 构建（见 README） */
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <immintrin.h>
+#include "sm4_pro.h"
+#include "sm4_sbox.h"
+#include "sm4_lanes.h"
+
+#ifdef _MSC_VER
+#define ALIGN(x) __declspec(align(x))
+#else
+#define ALIGN(x) __attribute__((aligned(x)))
+#endif
+
+/* 查表版 S 盒，用于自检 */
+static __m128i sBoxTable_SIMD(__m128i in) {
+    ALIGN(16) u8 bytes[16];
+    _mm_store_si128((__m128i*)bytes, in);
+    for (int i = 0; i < 16; ++i) bytes[i] = Sbox[bytes[i]];
+    return _mm_load_si128((__m128i*)bytes);
+}
+
+static void parseHex(const char *hex, u8 *out, size_t *len) {
+    size_t n = 0;
+    for (; hex[0] && hex[1]; hex += 2) {
+        unsigned v;
+        sscanf(hex, "%2x", &v);
+        out[n++] = (u8)v;
+    }
+    *len = n;
+}
+
+/* ===== 工作模式测试向量 =====
+ * CTR/CBC/CFB/OFB：密钥 0123456789abcdeffedcba9876543210，IV 000102...0f，
+ *   明文为 aa/bb/cc/dd/ee/ff/aa/bb 各 8 字节，结果与 OpenSSL 一致；
+ * XTS：IEEE 1619 方式的 tweak，56 字节明文覆盖密文挪用。 */
+static const struct {
+    enum sm4_mode mode;
+    const char *key, *iv, *plain, *cipher;
+} modeVectors[] = {
+    {SM4_MODE_CBC, "0123456789abcdeffedcba9876543210", "000102030405060708090a0b0c0d0e0f",
+     "aaaaaaaaaaaaaaaabbbbbbbbbbbbbbbbccccccccccccccccddddddddddddddddeeeeeeeeeeeeeeeeffffffffffffffffaaaaaaaaaaaaaaaabbbbbbbbbbbbbbbb",
+     "9554bcddf2d371452bffd93df8d461872360664050b1ae28e3e25ab2539ededbec17435cee4d9e7c413b774acf6ad12194dd5977660423ca228a140b32df68ce"},
+    {SM4_MODE_CFB, "0123456789abcdeffedcba9876543210", "000102030405060708090a0b0c0d0e0f",
+     "aaaaaaaaaaaaaaaabbbbbbbbbbbbbbbbccccccccccccccccddddddddddddddddeeeeeeeeeeeeeeeeffffffffffffffffaaaaaaaaaaaaaaaabbbbbbbbbbbbbbbb",
+     "ac3236cb970cc20791364c395a1342d12f1d1c833abb135086a6faa42f167242f3732f033642fd4ecdd75a9e634b92c308b66ef4a3a61dbf66ccc00e3ced181e"},
+    {SM4_MODE_OFB, "0123456789abcdeffedcba9876543210", "000102030405060708090a0b0c0d0e0f",
+     "aaaaaaaaaaaaaaaabbbbbbbbbbbbbbbbccccccccccccccccddddddddddddddddeeeeeeeeeeeeeeeeffffffffffffffffaaaaaaaaaaaaaaaabbbbbbbbbbbbbbbb",
+     "ac3236cb970cc20791364c395a1342d13f238e807b4f96b1bc82314900fe35fdb5a976a661e7e9c6cf11fbd9db4fa11d9db8e26fd243c191404fb13179854094"},
+    {SM4_MODE_CTR, "0123456789abcdeffedcba9876543210", "000102030405060708090a0b0c0d0e0f",
+     "aaaaaaaaaaaaaaaabbbbbbbbbbbbbbbbccccccccccccccccddddddddddddddddeeeeeeeeeeeeeeeeffffffffffffffffaaaaaaaaaaaaaaaabbbbbbbbbbbbbbbb",
+     "ac3236cb970cc20791364c395a1342d1a3cbc1878c6f30cd074cce385cdd70c7f234bc0e24c11980fd1286310ce37b926e02fcd0faa0baf38b2933851d824514"},
+    {SM4_MODE_XTS, "2b7e151628aed2a6abf7158809cf4f3c000102030405060708090a0b0c0d0e0f",
+     "f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff",
+     "6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e5130c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17",
+     "e9538251c71d7b80bbe4483fef497bd1b3db1a3e60408c575d63ff7db39f83260869f9e2585fec9f0b863bf8fd784b8627d16c0db6d2cfc7"},
+};
+
+/* 一次性与按 1..23 字节切碎、原地处理两种方式，加密与解密都要得到向量结果 */
+static int runMode(enum sm4_mode mode, int enc, const u8 *key, const u8 *iv,
+                   const u8 *in, size_t len, const u8 *expect, int split) {
+    u8 buf[128];
+    sm4_mode_ctx ctx;
+    size_t off = 0, w = 0;
+    memcpy(buf, in, len);
+    sm4_mode_init(&ctx, mode, enc, key, iv);
+    while (off < len) {
+        size_t n = split ? (off % 23) + 1 : len;
+        if (n > len - off) n = len - off;
+        w += sm4_mode_update(&ctx, buf + off, buf + w, n);
+        off += n;
+    }
+    int f = sm4_mode_final(&ctx, buf + w);
+    if (f < 0) return 0;
+    return w + (size_t)f == len && memcmp(buf, expect, len) == 0;
+}
+
+static void testModes(void) {
+    for (size_t i = 0; i < sizeof(modeVectors) / sizeof(modeVectors[0]); ++i) {
+        u8 key[32], iv[16], pt[64], ct[64];
+        size_t klen, ivlen, len, clen;
+        parseHex(modeVectors[i].key, key, &klen);
+        parseHex(modeVectors[i].iv, iv, &ivlen);
+        parseHex(modeVectors[i].plain, pt, &len);
+        parseHex(modeVectors[i].cipher, ct, &clen);
+        int ok = 1;
+        for (int split = 0; split < 2; ++split) {
+            ok &= runMode(modeVectors[i].mode, 1, key, iv, pt, len, ct, split);
+            ok &= runMode(modeVectors[i].mode, 0, key, iv, ct, len, pt, split);
+        }
+        printf("Mode %-10s: %s\n", sm4_mode_name(modeVectors[i].mode), ok ? "ok" : "MISMATCH");
+    }
+}
+
+/* 先喂 8 字节让上下文留下暂存，再以 in == out 喂跨多批的长数据：输出比输入超前，不能覆盖还没读的输入 */
+static void testModesInPlace(void) {
+    static const enum sm4_mode modes[] = {SM4_MODE_CTR, SM4_MODE_CBC, SM4_MODE_CFB, SM4_MODE_XTS};
+    static u8 pt[4112], ref[4112], buf[4112];
+    u8 key[32], iv[16];
+    int ok = 1;
+    for (int i = 0; i < 32; ++i) key[i] = (u8)(i * 13 + 1);
+    for (int i = 0; i < 16; ++i) iv[i] = (u8)(i * 7);
+    for (size_t i = 0; i < sizeof(pt); ++i) pt[i] = (u8)(i * 31 + (i >> 8));
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); ++m) {
+        for (int enc = 1; enc >= 0; --enc) {
+            sm4_mode_ctx ctx;
+            size_t w;
+            int f;
+            sm4_mode_init(&ctx, modes[m], enc, key, iv);
+            w = sm4_mode_update(&ctx, pt, ref, sizeof(pt));
+            f = sm4_mode_final(&ctx, ref + w);
+            ok &= f >= 0 && w + (size_t)f == sizeof(pt);
+
+            sm4_mode_init(&ctx, modes[m], enc, key, iv);
+            w = sm4_mode_update(&ctx, pt, buf, 8);
+            memcpy(buf + w, pt + 8, sizeof(pt) - 8);
+            w += sm4_mode_update(&ctx, buf + w, buf + w, sizeof(pt) - 8);
+            f = sm4_mode_final(&ctx, buf + w);
+            ok &= f >= 0 && w + (size_t)f == sizeof(pt) && memcmp(buf, ref, sizeof(pt)) == 0;
+        }
+    }
+    printf("Mode in-place  : %s\n", ok ? "ok" : "MISMATCH");
+}
+
+/* ===== AEAD 测试向量（RFC 8998 附录 A） ===== */
+static const char *aeadKey = "0123456789abcdeffedcba9876543210";
+static const char *aeadIv = "00001234567800000000abcd";
+static const char *aeadAad = "feedfacedeadbeeffeedfacedeadbeefabaddad2";
+static const char *aeadPlain =
+    "aaaaaaaaaaaaaaaabbbbbbbbbbbbbbbbccccccccccccccccddddddddddddddddeeeeeeeeeeeeeeeeffffffffffffffffeeeeeeeeeeeeeeeeaaaaaaaaaaaaaaaa";
+static const char *gcmCipher =
+    "17f399f08c67d5ee19d0dc9969c4bb7d5fd46fd3756489069157b282bb200735d82710ca5c22f0ccfa7cbf93d496ac15a56834cbcf98c397b4024a2691233b8d";
+static const char *gcmTag = "83de3541e4c2b58177e065a9bf7b62ec";
+static const char *ccmCipher =
+    "48af93501fa62adbcd414cce6034d895dda1bf8f132f042098661572e7483094fd12e518ce062c98acee28d95df4416bed31a2f04476c18bb40c84a74b97dc5b";
+static const char *ccmTag = "16842d4fa186f56ab33256971fa110f4";
+
+/* 加密得到向量，原地解密还原，篡改一个字节后必须拒绝 */
+static void testAead(void) {
+    u8 key[16], iv[12], aad[20], pt[64], ct[64], tag[16], buf[64], t[16];
+    size_t klen, ivlen, alen, len, clen, tlen;
+    sm4_gcm_key g;
+    sm4_key ek;
+    parseHex(aeadKey, key, &klen);
+    parseHex(aeadIv, iv, &ivlen);
+    parseHex(aeadAad, aad, &alen);
+    parseHex(aeadPlain, pt, &len);
+
+    parseHex(gcmCipher, ct, &clen);
+    parseHex(gcmTag, tag, &tlen);
+    sm4_gcm_init(&g, key);
+    for (int clmul = g.clmul; clmul >= 0; --clmul) {
+        int ok;
+        g.clmul = clmul;
+        ok = sm4_gcm_seal(&g, iv, ivlen, aad, alen, pt, len, buf, t, 16) == 0 &&
+             memcmp(buf, ct, len) == 0 && memcmp(t, tag, 16) == 0;
+        ok &= sm4_gcm_open(&g, iv, ivlen, aad, alen, buf, len, buf, tag, 16) == 0 &&
+              memcmp(buf, pt, len) == 0;
+        memcpy(buf, ct, len);
+        buf[17] ^= 1;
+        ok &= sm4_gcm_open(&g, iv, ivlen, aad, alen, buf, len, buf, tag, 16) < 0;
+        printf("GCM %-11s: %s\n", clmul ? "pclmul" : "table", ok ? "ok" : "MISMATCH");
+    }
+
+    parseHex(ccmCipher, ct, &clen);
+    parseHex(ccmTag, tag, &tlen);
+    sm4_set_encrypt_key(&ek, key);
+    {
+        int ok = sm4_ccm_seal(&ek, iv, ivlen, aad, alen, pt, len, buf, t, 16) == 0 &&
+                 memcmp(buf, ct, len) == 0 && memcmp(t, tag, 16) == 0;
+        ok &= sm4_ccm_open(&ek, iv, ivlen, aad, alen, buf, len, buf, tag, 16) == 0 &&
+              memcmp(buf, pt, len) == 0;
+        memcpy(buf, ct, len);
+        buf[40] ^= 0x80;
+        ok &= sm4_ccm_open(&ek, iv, ivlen, aad, alen, buf, len, buf, tag, 16) < 0;
+        printf("CCM            : %s\n", ok ? "ok" : "MISMATCH");
+    }
+}
+
+/* ===== 轮密钥缓存：与直接扩展的结果一致，LRU 淘汰顺序与计数正确 ===== */
+static void testKeyCache(void) {
+    u8 keys[4][16];
+    sm4_key ek, dk;
+    uint64_t hits, misses;
+    int ok = 1;
+    sm4_key_cache *cache = sm4_key_cache_new(3);
+
+    for (int k = 0; k < 4; ++k) {
+        for (int i = 0; i < 16; ++i) keys[k][i] = (u8)(k * 0x31 + i * 7);
+    }
+    for (int k = 0; k < 3; ++k) {
+        const sm4_key_pair *kp = sm4_key_cache_get(cache, keys[k]);
+        sm4_set_encrypt_key(&ek, keys[k]);
+        sm4_set_decrypt_key(&dk, keys[k]);
+        ok &= memcmp(kp->enc.rk, ek.rk, sizeof(ek.rk)) == 0 && memcmp(kp->dec.rk, dk.rk, sizeof(dk.rk)) == 0;
+        ok &= ((uintptr_t)kp & 63) == 0;
+    }
+    sm4_key_cache_get(cache, keys[0]);   /* 命中，0 变成最近使用 */
+    sm4_key_cache_get(cache, keys[3]);   /* 未命中，淘汰最久未用的 1 */
+    sm4_key_cache_get(cache, keys[2]);   /* 命中 */
+    sm4_key_cache_get(cache, keys[1]);   /* 未命中（已被淘汰），淘汰 0 */
+    sm4_key_cache_get(cache, keys[3]);   /* 命中 */
+    sm4_key_cache_stats(cache, &hits, &misses);
+    ok &= hits == 3 && misses == 5;
+
+    /* 缓存的轮密钥直接初始化 CBC 解密，结果与 sm4_mode_init 相同 */
+    {
+        const sm4_key_pair *kp = sm4_key_cache_get(cache, keys[1]);
+        u8 iv[16] = {0}, a[64], b[64];
+        sm4_mode_ctx c1, c2;
+        for (int i = 0; i < 64; ++i) a[i] = b[i] = (u8)(i * 29);
+        sm4_mode_init(&c1, SM4_MODE_CBC, 0, keys[1], iv);
+        sm4_mode_init_keys(&c2, SM4_MODE_CBC, 0, kp, NULL, iv);
+        sm4_mode_update(&c1, a, a, 64);
+        sm4_mode_update(&c2, b, b, 64);
+        ok &= memcmp(a, b, 64) == 0;
+    }
+    sm4_key_cache_free(cache);
+    printf("Key cache      : %s\n", ok ? "ok" : "MISMATCH");
+}
+
+/* ===== 测试主函数 ===== */
+int main(void) {
+    u32 plain[4] = {0xdeadbeef, 0xc0ffee00, 0xfade0fad, 0x87654321};
+    u32 key[4]        = {0x1337cafe, 0xbaadf00d, 0xdeadc0de, 0xfeedface};
+    u32 roundKey[32];
+    u32 tempK[4];
+    long long loops = 1000000;
+
+    /* S 盒自检：各个可用实现对全部 256 个输入与查表结果逐字节比较 */
+    const cpu_features_t *cpu = cpu_features();
+    struct { const char *name; sm4_sbox_fn fn; int ok; } impls[3] = {
+        {"gfni", sm4_sbox_gfni, cpu->gfni},
+        {"aesni", sm4_sbox_aesni, cpu->aesni && cpu->ssse3},
+        {"bitsliced", sm4_sbox_bitsliced, 1},
+    };
+    for (int k = 0; k < 3; ++k) {
+        if (!impls[k].ok) continue;
+        int bad = 0;
+        for (int i = 0; i < 256; i += 16) {
+            ALIGN(16) u8 a[16], b[16];
+            __m128i x = _mm_setr_epi8(i, i + 1, i + 2, i + 3, i + 4, i + 5, i + 6, i + 7,
+                                      i + 8, i + 9, i + 10, i + 11, i + 12, i + 13, i + 14, i + 15);
+            _mm_store_si128((__m128i*)a, impls[k].fn(x));
+            _mm_store_si128((__m128i*)b, sBoxTable_SIMD(x));
+            bad |= memcmp(a, b, 16);
+        }
+        printf("S-box %-10s: %s\n", impls[k].name, bad ? "MISMATCH" : "ok");
+    }
+
+    /* 标准测试向量（GB/T 32907 附录 A） */
+    u32 stdKey[4] = {0x01234567, 0x89abcdef, 0xfedcba98, 0x76543210};
+    u32 stdCipher[4] = {0x681edf34, 0xd206965e, 0x86b3e94f, 0x536e4246};
+    u32 out[4];
+    generateRoundKey(stdKey, tempK, roundKey);
+    encryptSM4_SIMD(stdKey, roundKey, out);
+    int vecOk = 1;
+    for (int i = 0; i < 4; ++i) vecOk &= (out[i] == stdCipher[i]);
+    decryptSM4_SIMD(out, roundKey, out);
+    for (int i = 0; i < 4; ++i) vecOk &= (out[i] == stdKey[i]);
+    printf("Test vector    : %s\n", vecOk ? "ok" : "MISMATCH");
+
+    /* 批量 ECB：各个可用内核与单分组接口逐块比较，再用解密密钥还原 */
+    static u8 buf[1000 * 16], enc[1000 * 16], dec[1000 * 16];
+    u8 userKey[16];
+    sm4_key ek, dk;
+    for (int i = 0; i < 16; ++i) userKey[i] = (u8)(0x10 * i + 7);
+    for (size_t i = 0; i < sizeof(buf); ++i) buf[i] = (u8)(i * 131 + 17);
+    sm4_set_encrypt_key(&ek, userKey);
+    sm4_set_decrypt_key(&dk, userKey);
+    for (int i = 0; i < 4; ++i) {
+        key[i] = ((u32)userKey[4 * i] << 24) | ((u32)userKey[4 * i + 1] << 16) |
+                 ((u32)userKey[4 * i + 2] << 8) | userKey[4 * i + 3];
+    }
+    generateRoundKey(key, tempK, roundKey);
+    for (int isa = SM4_BATCH_SSE2; isa <= SM4_BATCH_AVX512; ++isa) {
+        if (!sm4_batch_isa_supported((enum sm4_batch_isa)isa)) continue;
+        int bad = 0;
+        /* 997 个分组，覆盖补齐尾部的路径 */
+        sm4_crypt_blocks_isa((enum sm4_batch_isa)isa, &ek, buf, enc, 997);
+        sm4_crypt_blocks_isa((enum sm4_batch_isa)isa, &dk, enc, dec, 997);
+        for (int b = 0; b < 997; ++b) {
+            u32 pt[4], ct[4];
+            for (int i = 0; i < 4; ++i) {
+                const u8 *q = buf + b * 16 + i * 4;
+                pt[i] = ((u32)q[0] << 24) | ((u32)q[1] << 16) | ((u32)q[2] << 8) | q[3];
+            }
+            encryptSM4_SIMD(pt, roundKey, ct);
+            for (int i = 0; i < 4; ++i) {
+                const u8 *q = enc + b * 16 + i * 4;
+                bad |= ct[i] != (((u32)q[0] << 24) | ((u32)q[1] << 16) | ((u32)q[2] << 8) | q[3]);
+            }
+        }
+        bad |= memcmp(dec, buf, 997 * 16);
+        printf("ECB %-15s: %s\n", sm4_batch_isa_name((enum sm4_batch_isa)isa), bad ? "MISMATCH" : "ok");
+    }
+
+    /* 查表内核：与 AES-NI / 位切片批量结果比较 */
+    {
+        sm4_crypt_blocks_isa(SM4_BATCH_SSE2, &ek, buf, enc, 997);
+        sm4_ttable_blocks(ek.rk, buf, dec, 997);
+        printf("ECB %-15s: %s\n", "ttable", memcmp(enc, dec, 997 * 16) ? "MISMATCH" : "ok");
+    }
+
+    /* CTR：与手工构造计数器块后 ECB 再异或的结果比较，计数器跨越低 64 位进位 */
+    u8 iv[16], ctr[3 * 16];
+    for (int i = 0; i < 16; ++i) iv[i] = (i < 8) ? (u8)i : 0xff;
+    iv[15] = 0xfe;
+    memcpy(ctr, iv, 16);
+    memcpy(ctr + 16, iv, 16); ctr[31] = 0xff;
+    memcpy(ctr + 32, iv, 8); memset(ctr + 40, 0, 8); ctr[39] = 0x08;
+    sm4_crypt_blocks(&ek, ctr, ctr, 3);
+    sm4_ctr_blocks(&ek, iv, buf, enc, 3);
+    int ctrBad = 0;
+    for (int i = 0; i < 48; ++i) ctrBad |= enc[i] != (buf[i] ^ ctr[i]);
+    printf("CTR            : %s\n", ctrBad ? "MISMATCH" : "ok");
+
+    testModes();
+    testModesInPlace();
+    testAead();
+    testKeyCache();
+
+    /* 生成轮密钥 */
+    key[0] = 0x1337cafe; key[1] = 0xbaadf00d; key[2] = 0xdeadc0de; key[3] = 0xfeedface;
+    generateRoundKey(key, tempK, roundKey);
+
+    /* 性能计时 */
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (long long i = 0; i < loops; ++i) {
+        u32 tmp[4];
+        memcpy(tmp, plain, sizeof(u32) * 4);
+        encryptSM4_SIMD(tmp, roundKey, tmp);
+        decryptSM4_SIMD(tmp, roundKey, tmp);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    printf("SM4 SIMD Performance Test\n");
+    printf("========================\n");
+    printf("S-box impl     : %s\n", sm4_sbox_name());
+    printf("Total time     : %.3f s\n", elapsed);
+    printf("Avg per op     : %.2e s\n", elapsed / (loops * 4));
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,360 @@
+/* SM4 工作模式：CTR / CBC / CFB / OFB / XTS，流式 init / update / final
+ * 可并行的部分（CTR、XTS、CBC 解密、CFB 解密）按块凑成批次交给 sm4_crypt_blocks。 */
+#include <string.h>
+#include <emmintrin.h>
+#include "sm4_pro.h"
+#include "../common/gm_trace.h"
+
+/* 并行路径每批处理的分组数（临时缓冲在栈上，1KB） */
+#define SM4_MODE_CHUNK 64
+
+typedef void (*sm4_block_fn)(sm4_mode_ctx *ctx, const uint8_t *in, uint8_t *out, size_t nblocks);
+
+static inline void xor_block(uint8_t *out, const uint8_t *a, const uint8_t *b) {
+    __m128i x = _mm_loadu_si128((const __m128i *)a);
+    __m128i y = _mm_loadu_si128((const __m128i *)b);
+    _mm_storeu_si128((__m128i *)out, _mm_xor_si128(x, y));
+}
+
+/* 串行模式每次只加密一个分组，走按延迟优化的单分组内核 */
+static inline void encrypt_one(const sm4_key *key, const uint8_t in[16], uint8_t out[16]) {
+    sm4_crypt_block(key, in, out);
+}
+
+/* 128 位大端计数器加 n */
+static void ctr_add(uint8_t ctr[16], uint64_t n) {
+    unsigned carry = 0;
+    for (int i = 15; i >= 0; --i) {
+        unsigned v = ctr[i] + (unsigned)(n & 0xff) + carry;
+        ctr[i] = (uint8_t)v;
+        carry = v >> 8;
+        n >>= 8;
+        if (n == 0 && carry == 0) break;
+    }
+}
+
+/* XTS：tweak 乘以 GF(2^128) 的本原元 α（IEEE 1619，小端，模 x^128 + x^7 + x^2 + x + 1） */
+static inline void xts_mul_alpha(uint8_t t[16]) {
+    unsigned carry = t[15] >> 7;
+    for (int i = 15; i > 0; --i) t[i] = (uint8_t)((t[i] << 1) | (t[i - 1] >> 7));
+    t[0] = (uint8_t)((t[0] << 1) ^ (0x87 & (0u - carry)));
+}
+
+/* ===== 整块处理（in 与 out 相同或完全不重叠） ===== */
+
+static void cbc_encrypt_blocks(sm4_mode_ctx *ctx, const uint8_t *in, uint8_t *out, size_t nblocks) {
+    /* C_i = E(P_i ^ C_{i-1})，逐块串行 */
+    for (size_t i = 0; i < nblocks; ++i) {
+        xor_block(ctx->iv, ctx->iv, in + i * 16);
+        encrypt_one(&ctx->key, ctx->iv, ctx->iv);
+        memcpy(out + i * 16, ctx->iv, 16);
+    }
+}
+
+static void cbc_decrypt_blocks(sm4_mode_ctx *ctx, const uint8_t *in, uint8_t *out, size_t nblocks) {
+    /* P_i = D(C_i) ^ C_{i-1}：先批量解密，再异或；原地时先取出 C_i 再覆盖 */
+    uint8_t tmp[SM4_MODE_CHUNK * 16], prev[16], cur[16];
+    memcpy(prev, ctx->iv, 16);
+    while (nblocks > 0) {
+        size_t n = (nblocks < SM4_MODE_CHUNK) ? nblocks : SM4_MODE_CHUNK;
+        sm4_crypt_blocks(&ctx->key, in, tmp, n);
+        for (size_t i = 0; i < n; ++i) {
+            memcpy(cur, in + i * 16, 16);
+            xor_block(out + i * 16, tmp + i * 16, prev);
+            memcpy(prev, cur, 16);
+        }
+        in += n * 16;
+        out += n * 16;
+        nblocks -= n;
+    }
+    memcpy(ctx->iv, prev, 16);
+}
+
+static void xts_blocks(sm4_mode_ctx *ctx, const uint8_t *in, uint8_t *out, size_t nblocks) {
+    /* C_i = E(P_i ^ T_i) ^ T_i，T_{i+1} = T_i · α；先生成整批 tweak，再批量加解密 */
+    uint8_t tw[SM4_MODE_CHUNK * 16], tmp[SM4_MODE_CHUNK * 16];
+    while (nblocks > 0) {
+        size_t n = (nblocks < SM4_MODE_CHUNK) ? nblocks : SM4_MODE_CHUNK;
+        for (size_t i = 0; i < n; ++i) {
+            memcpy(tw + i * 16, ctx->iv, 16);
+            xts_mul_alpha(ctx->iv);
+            xor_block(tmp + i * 16, in + i * 16, tw + i * 16);
+        }
+        sm4_crypt_blocks(&ctx->key, tmp, tmp, n);
+        for (size_t i = 0; i < n; ++i) xor_block(out + i * 16, tmp + i * 16, tw + i * 16);
+        in += n * 16;
+        out += n * 16;
+        nblocks -= n;
+    }
+}
+
+/* CBC 留下不足一块的尾部；XTS 还要多留最后一个完整分组，结尾不满一块时要做密文挪用 */
+static size_t block_keep(const sm4_mode_ctx *ctx, size_t avail) {
+    size_t keep = avail % 16;
+    if (ctx->mode == SM4_MODE_XTS) {
+        keep += 16;
+        if (keep > avail) keep = avail;
+    }
+    return keep;
+}
+
+static size_t block_mode_update(sm4_mode_ctx *ctx, sm4_block_fn fn,
+                                const uint8_t *in, uint8_t *out, size_t len) {
+    if (ctx->buf_len == 0) {
+        /* 没有暂存数据，输出与输入一一对应，直接原地处理 */
+        size_t keep = block_keep(ctx, len);
+        size_t n = (len - keep) / 16;
+        fn(ctx, in, out, n);
+        memcpy(ctx->buf, in + n * 16, keep);
+        ctx->buf_len = keep;
+        return n * 16;
+    }
+
+    /* 有暂存数据时输出比输入超前 buf_len 字节：in == out 时直接写会盖掉还没读的输入。
+       每批在 stage 里原地处理，写到 out 的字节数不超过已读入的字节数，多出来的先放在 pend，
+       下一批再写；pend 里最多是开始时暂存的那 buf_len（< 32）字节。输入读完后全部写出 */
+    uint8_t stage[SM4_MODE_CHUNK * 16 + 32], pend[32];
+    size_t written = 0, consumed = 0, pend_len = 0;
+    while (len > 0) {
+        size_t c = sizeof(stage) - ctx->buf_len;
+        if (c > len) c = len;
+        memcpy(stage, ctx->buf, ctx->buf_len);
+        memcpy(stage + ctx->buf_len, in + consumed, c);
+        consumed += c;
+        len -= c;
+
+        size_t avail = ctx->buf_len + c;
+        size_t keep = block_keep(ctx, avail);
+        size_t n = (avail - keep) / 16;
+        fn(ctx, stage, stage, n);
+        memcpy(ctx->buf, stage + n * 16, keep);
+        ctx->buf_len = keep;
+
+        size_t room = len ? consumed - written : pend_len + n * 16;
+        size_t p = pend_len < room ? pend_len : room;
+        memcpy(out + written, pend, p);
+        memmove(pend, pend + p, pend_len - p);
+        pend_len -= p;
+        written += p;
+        room -= p;
+        size_t s = n * 16 < room ? n * 16 : room;
+        memcpy(out + written, stage, s);
+        memcpy(pend + pend_len, stage + s, n * 16 - s);
+        pend_len += n * 16 - s;
+        written += s;
+    }
+    return written;
+}
+
+/* ===== 流密码类模式 ===== */
+
+static size_t ctr_update(sm4_mode_ctx *ctx, const uint8_t *in, uint8_t *out, size_t len) {
+    size_t done = 0;
+    while (ctx->ks_pos < 16 && done < len) {
+        out[done] = in[done] ^ ctx->ks[ctx->ks_pos++];
+        done++;
+    }
+    size_t n = (len - done) / 16;
+    if (n > 0) {
+        sm4_ctr_blocks(&ctx->key, ctx->iv, in + done, out + done, n);
+        ctr_add(ctx->iv, n);
+        done += n * 16;
+    }
+    if (done < len) {
+        encrypt_one(&ctx->key, ctx->iv, ctx->ks);
+        ctr_add(ctx->iv, 1);
+        ctx->ks_pos = 0;
+        while (done < len) {
+            out[done] = in[done] ^ ctx->ks[ctx->ks_pos++];
+            done++;
+        }
+    }
+    return len;
+}
+
+static size_t ofb_update(sm4_mode_ctx *ctx, const uint8_t *in, uint8_t *out, size_t len) {
+    /* 密钥流 O_i = E(O_{i-1}) 与数据无关，但前后依赖，只能串行 */
+    size_t done = 0;
+    while (done < len) {
+        if (ctx->ks_pos == 16) {
+            encrypt_one(&ctx->key, ctx->ks, ctx->ks);
+            ctx->ks_pos = 0;
+            if (len - done >= 16) {
+                xor_block(out + done, in + done, ctx->ks);
+                ctx->ks_pos = 16;
+                done += 16;
+                continue;
+            }
+        }
+        out[done] = in[done] ^ ctx->ks[ctx->ks_pos++];
+        done++;
+    }
+    return len;
+}
+
+/* CFB 解密：E 的输入是上一块密文，事先已知，可以整批并行 */
+static void cfb_decrypt_blocks(sm4_mode_ctx *ctx, const uint8_t *in, uint8_t *out, size_t nblocks) {
+    uint8_t tmp[SM4_MODE_CHUNK * 16];
+    while (nblocks > 0) {
+        size_t n = (nblocks < SM4_MODE_CHUNK) ? nblocks : SM4_MODE_CHUNK;
+        memcpy(tmp, ctx->iv, 16);
+        memcpy(tmp + 16, in, (n - 1) * 16);
+        memcpy(ctx->iv, in + (n - 1) * 16, 16);
+        sm4_crypt_blocks(&ctx->key, tmp, tmp, n);
+        for (size_t i = 0; i < n; ++i) xor_block(out + i * 16, in + i * 16, tmp + i * 16);
+        in += n * 16;
+        out += n * 16;
+        nblocks -= n;
+    }
+}
+
+static size_t cfb_update(sm4_mode_ctx *ctx, const uint8_t *in, uint8_t *out, size_t len) {
+    size_t done = 0;
+    while (done < len) {
+        if (ctx->ks_pos == 16) {
+            if (!ctx->enc && len - done >= 16) {
+                size_t n = (len - done) / 16;
+                cfb_decrypt_blocks(ctx, in + done, out + done, n);
+                done += n * 16;
+                continue;
+            }
+            encrypt_one(&ctx->key, ctx->iv, ctx->ks);
+            ctx->ks_pos = 0;
+            if (ctx->enc && len - done >= 16) {
+                /* 加密：C_i = P_i ^ E(C_{i-1})，逐块串行 */
+                xor_block(out + done, in + done, ctx->ks);
+                memcpy(ctx->iv, out + done, 16);
+                ctx->ks_pos = 16;
+                done += 16;
+                continue;
+            }
+        }
+        /* 不足一块：iv 逐字节换成密文，凑满 16 字节后作为下一块的输入 */
+        uint8_t c = in[done];
+        out[done] = c ^ ctx->ks[ctx->ks_pos];
+        ctx->iv[ctx->ks_pos++] = ctx->enc ? out[done] : c;
+        done++;
+    }
+    return len;
+}
+
+/* ===== XTS 密文挪用 ===== */
+
+static void xts_steal(sm4_mode_ctx *ctx, uint8_t *out) {
+    size_t r = ctx->buf_len - 16;
+    uint8_t cc[16], pp[16], t[16];
+
+    if (ctx->enc) {
+        /* CC = E(P_{m-1}, T_{m-1})；C_m 取 CC 的前 r 字节，P_m 用 CC 的后半截补满后用 T_m 加密 */
+        xts_blocks(ctx, ctx->buf, cc, 1);
+        memcpy(out + 16, cc, r);
+        memcpy(pp, ctx->buf + 16, r);
+        memcpy(pp + r, cc + r, 16 - r);
+        xts_blocks(ctx, pp, out, 1);
+    } else {
+        /* 解密时 tweak 顺序相反：先用 T_m 解出 PP，再用 T_{m-1} 解补好的 CC */
+        memcpy(t, ctx->iv, 16);
+        xts_mul_alpha(ctx->iv);
+        xts_blocks(ctx, ctx->buf, pp, 1);
+        memcpy(cc, ctx->buf + 16, r);
+        memcpy(cc + r, pp + r, 16 - r);
+        memcpy(out + 16, pp, r);
+        memcpy(ctx->iv, t, 16);
+        xts_blocks(ctx, cc, out, 1);
+    }
+}
+
+/* ===== 对外接口 ===== */
+
+int sm4_mode_init(sm4_mode_ctx *ctx, enum sm4_mode mode, int enc,
+                  const uint8_t *key, const uint8_t iv[16]) {
+    if (!ctx || !key || !iv || mode < SM4_MODE_CTR || mode > SM4_MODE_XTS) return -1;
+
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->mode = mode;
+    ctx->enc = enc ? 1 : 0;
+    /* 只有 CBC、XTS 解密用到 SM4 解密方向，其余模式都只用加密 */
+    if (!ctx->enc && (mode == SM4_MODE_CBC || mode == SM4_MODE_XTS)) {
+        sm4_set_decrypt_key(&ctx->key, key);
+    } else {
+        sm4_set_encrypt_key(&ctx->key, key);
+    }
+    if (mode == SM4_MODE_XTS) sm4_set_encrypt_key(&ctx->tweak_key, key + 16);
+    sm4_mode_set_iv(ctx, iv);
+    return 0;
+}
+
+int sm4_mode_init_keys(sm4_mode_ctx *ctx, enum sm4_mode mode, int enc,
+                       const sm4_key_pair *key, const sm4_key_pair *tweak, const uint8_t iv[16]) {
+    if (!ctx || !key || !iv || mode < SM4_MODE_CTR || mode > SM4_MODE_XTS) return -1;
+    if (mode == SM4_MODE_XTS && !tweak) return -1;
+
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->mode = mode;
+    ctx->enc = enc ? 1 : 0;
+    ctx->key = (!ctx->enc && (mode == SM4_MODE_CBC || mode == SM4_MODE_XTS)) ? key->dec : key->enc;
+    if (mode == SM4_MODE_XTS) ctx->tweak_key = tweak->enc;
+    sm4_mode_set_iv(ctx, iv);
+    return 0;
+}
+
+void sm4_mode_set_iv(sm4_mode_ctx *ctx, const uint8_t iv[16]) {
+    memcpy(ctx->iv, iv, 16);
+    ctx->ks_pos = 16;
+    ctx->buf_len = 0;
+    if (ctx->mode == SM4_MODE_OFB) {
+        memcpy(ctx->ks, iv, 16);
+    } else if (ctx->mode == SM4_MODE_XTS) {
+        /* T_0 = E_K2(tweak) */
+        encrypt_one(&ctx->tweak_key, ctx->iv, ctx->iv);
+    }
+}
+
+size_t sm4_mode_update(sm4_mode_ctx *ctx, const uint8_t *in, uint8_t *out, size_t len) {
+    /* 区段按 enum sm4_mode 的顺序排列 */
+    GM_TRACE_ZONE((unsigned)ctx->mode <= SM4_MODE_XTS ? GMCRYPTO_ZONE_SM4_MODE_CTR + ctx->mode : GMCRYPTO_ZONE_COUNT, len);
+    switch (ctx->mode) {
+        case SM4_MODE_CTR: return ctr_update(ctx, in, out, len);
+        case SM4_MODE_OFB: return ofb_update(ctx, in, out, len);
+        case SM4_MODE_CFB: return cfb_update(ctx, in, out, len);
+        case SM4_MODE_CBC:
+            return block_mode_update(ctx, ctx->enc ? cbc_encrypt_blocks : cbc_decrypt_blocks,
+                                     in, out, len);
+        case SM4_MODE_XTS: return block_mode_update(ctx, xts_blocks, in, out, len);
+    }
+    return 0;
+}
+
+int sm4_mode_final(sm4_mode_ctx *ctx, uint8_t *out) {
+    int ret = 0;
+    if (ctx->mode == SM4_MODE_CBC) {
+        if (ctx->buf_len != 0) ret = -1;
+    } else if (ctx->mode == SM4_MODE_XTS && ctx->buf_len > 0) {
+        if (ctx->buf_len < 16) {
+            ret = -1;
+        } else if (ctx->buf_len == 16) {
+            xts_blocks(ctx, ctx->buf, out, 1);
+            ret = 16;
+        } else {
+            xts_steal(ctx, out);
+            ret = (int)ctx->buf_len;
+        }
+    }
+    /* 清掉暂存的数据和密钥流，保留轮密钥，之后可以用 sm4_mode_set_iv 开始下一条消息 */
+    memset(ctx->buf, 0, sizeof(ctx->buf));
+    memset(ctx->ks, 0, sizeof(ctx->ks));
+    ctx->buf_len = 0;
+    ctx->ks_pos = 16;
+    return ret;
+}
+
+const char *sm4_mode_name(enum sm4_mode mode) {
+    switch (mode) {
+        case SM4_MODE_CTR: return "CTR";
+        case SM4_MODE_CBC: return "CBC";
+        case SM4_MODE_CFB: return "CFB";
+        case SM4_MODE_OFB: return "OFB";
+        case SM4_MODE_XTS: return "XTS";
+    }
+    return "unknown";
+}
@@ -1,21 +1,27 @@
 #include <stdio.h>
-#include <windows.h>
 #include <string.h>
 #include <immintrin.h>
-
-#ifdef _MSC_VER
-#define ALIGN(x) __declspec(align(x))
-#else
-#define ALIGN(x) __attribute__((aligned(x)))
-#endif
-
-typedef unsigned char  u8;
-typedef unsigned long  u32;
+#include "sm4_pro.h"
+#include "sm4_sbox.h"
+#include "../common/gm_trace.h"
 
 /* ===== S 盒 ===== */
 const u8 Sbox[256] = {
     0xd6,0x90,0xe9,0xfe,0xcc,0xe1,0x3d,0xb7,0x16,0xb6,0x14,0xc2,0x28,0xfb,0x2c,0x05,
-    /* ... 其余 240 个字节与原数组相同 ... */
+    0x2b,0x67,0x9a,0x76,0x2a,0xbe,0x04,0xc3,0xaa,0x44,0x13,0x26,0x49,0x86,0x06,0x99,
+    0x9c,0x42,0x50,0xf4,0x91,0xef,0x98,0x7a,0x33,0x54,0x0b,0x43,0xed,0xcf,0xac,0x62,
+    0xe4,0xb3,0x1c,0xa9,0xc9,0x08,0xe8,0x95,0x80,0xdf,0x94,0xfa,0x75,0x8f,0x3f,0xa6,
+    0x47,0x07,0xa7,0xfc,0xf3,0x73,0x17,0xba,0x83,0x59,0x3c,0x19,0xe6,0x85,0x4f,0xa8,
+    0x68,0x6b,0x81,0xb2,0x71,0x64,0xda,0x8b,0xf8,0xeb,0x0f,0x4b,0x70,0x56,0x9d,0x35,
+    0x1e,0x24,0x0e,0x5e,0x63,0x58,0xd1,0xa2,0x25,0x22,0x7c,0x3b,0x01,0x21,0x78,0x87,
+    0xd4,0x00,0x46,0x57,0x9f,0xd3,0x27,0x52,0x4c,0x36,0x02,0xe7,0xa0,0xc4,0xc8,0x9e,
+    0xea,0xbf,0x8a,0xd2,0x40,0xc7,0x38,0xb5,0xa3,0xf7,0xf2,0xce,0xf9,0x61,0x15,0xa1,
+    0xe0,0xae,0x5d,0xa4,0x9b,0x34,0x1a,0x55,0xad,0x93,0x32,0x30,0xf5,0x8c,0xb1,0xe3,
+    0x1d,0xf6,0xe2,0x2e,0x82,0x66,0xca,0x60,0xc0,0x29,0x23,0xab,0x0d,0x53,0x4e,0x6f,
+    0xd5,0xdb,0x37,0x45,0xde,0xfd,0x8e,0x2f,0x03,0xff,0x6a,0x72,0x6d,0x6c,0x5b,0x51,
+    0x8d,0x1b,0xaf,0x92,0xbb,0xdd,0xbc,0x7f,0x11,0xd9,0x5c,0x41,0x1f,0x10,0x5a,0xd8,
+    0x0a,0xc1,0x31,0x88,0xa5,0xcd,0x7b,0xbd,0x2d,0x74,0xd0,0x12,0xb8,0xe5,0xb4,0xb0,
+    0x89,0x69,0x97,0x4a,0x0c,0x96,0x77,0x7e,0x65,0xb9,0xf1,0x09,0xc5,0x6e,0xc6,0x84,
     0x18,0xf0,0x7d,0xec,0x3a,0xdc,0x4d,0x20,0x79,0xee,0x5f,0x3e,0xd7,0xcb,0x39,0x48
 };
 
@@ -27,8 +33,13 @@ const u32 systemFK[4] = {
 /* ===== 固定参数 CK ===== */
 const u32 fixedCK[32] = {
     0x00070e15, 0x1c232a31, 0x383f464d, 0x545b6269,
-    /* ... 其余 28 个常量与原数组相同 ... */
-    0x484f565d, 0x646b7279
+    0x70777e85, 0x8c939aa1, 0xa8afb6bd, 0xc4cbd2d9,
+    0xe0e7eef5, 0xfc030a11, 0x181f262d, 0x343b4249,
+    0x50575e65, 0x6c737a81, 0x888f969d, 0xa4abb2b9,
+    0xc0c7ced5, 0xdce3eaf1, 0xf8ff060d, 0x141b2229,
+    0x30373e45, 0x4c535a61, 0x686f767d, 0x848b9299,
+    0xa0a7aeb5, 0xbcc3cad1, 0xd8dfe6ed, 0xf4fb0209,
+    0x10171e25, 0x2c333a41, 0x484f565d, 0x646b7279
 };
 
 /* ===== SIMD 工具：32 位循环左移 ===== */
@@ -39,26 +50,47 @@ static inline __m128i rotateLeft32(__m128i x, int bits) {
 
 /* ==== 线性变换 L1（用于加密） ==== */
 static inline __m128i linearL1_SIMD(__m128i a) {
-    a = _mm_xor_si128(a, rotateLeft32(a, 2));
-    a = _mm_xor_si128(a, rotateLeft32(a, 10));
-    a = _mm_xor_si128(a, rotateLeft32(a, 18));
-    a = _mm_xor_si128(a, rotateLeft32(a, 24));
-    return a;
+    /* L(B) = B ^ (B<<<2) ^ (B<<<10) ^ (B<<<18) ^ (B<<<24)，每一项都对原始 B 循环移位 */
+    __m128i r = _mm_xor_si128(a, rotateLeft32(a, 2));
+    r = _mm_xor_si128(r, rotateLeft32(a, 10));
+    r = _mm_xor_si128(r, rotateLeft32(a, 18));
+    r = _mm_xor_si128(r, rotateLeft32(a, 24));
+    return r;
 }
 
 /* ==== 线性变换 L2（用于密钥扩展） ==== */
 static inline __m128i linearL2_SIMD(__m128i a) {
-    a = _mm_xor_si128(a, rotateLeft32(a, 13));
-    a = _mm_xor_si128(a, rotateLeft32(a, 23));
-    return a;
+    /* L'(B) = B ^ (B<<<13) ^ (B<<<23) */
+    __m128i r = _mm_xor_si128(a, rotateLeft32(a, 13));
+    r = _mm_xor_si128(r, rotateLeft32(a, 23));
+    return r;
+}
+
+/* ==== S 盒变换（SIMD 版，常数时间） ====
+ * 原先拆包后按字节查 Sbox 表，访存地址依赖密钥和明文，存在缓存计时侧信道。
+ * 现在按 CPU 选择 GFNI / AES-NI / 位切片实现（见 sm4_sbox.h），结果与查表完全一致。 */
+static sm4_sbox_fn sBoxImpl = NULL;
+static const char *sBoxName = NULL;
+static long sBoxState = 0;      /* 与 cpu_features 相同的三态，实现与名字一起发布 */
+
+static void sbox_pick(void) {
+    if (cpu_state_claim(&sBoxState)) {
+        sBoxImpl = sm4_sbox_select(&sBoxName);
+        cpu_state_publish(&sBoxState);
+    } else {
+        while (cpu_state_load(&sBoxState) != 2) {
+        }
+    }
 }
 
-/* ==== S 盒变换（SIMD 版：拆包-查表-打包） ==== */
 static inline __m128i sBoxTransform_SIMD(__m128i in) {
-    ALIGN(16) u8 bytes[16];
-    _mm_store_si128((__m128i*)bytes, in);
-    for (int i = 0; i < 16; ++i) bytes[i] = Sbox[bytes[i]];
-    return _mm_load_si128((__m128i*)bytes);
+    if (cpu_state_load(&sBoxState) != 2) sbox_pick();
+    return sBoxImpl(in);
+}
+
+const char *sm4_sbox_name(void) {
+    if (cpu_state_load(&sBoxState) != 2) sbox_pick();
+    return sBoxName;
 }
 
 /* ==== 合成变换 T ==== */
@@ -68,7 +100,7 @@ static inline __m128i compositeT_SIMD(__m128i a, short mode) {
 }
 
 /* ===== 密钥扩展：第一步 ===== */
-void extendFirst(u32 masterKey[4], u32 tempK[4]) {
+static void extendFirst(u32 masterKey[4], u32 tempK[4]) {
     __m128i mk = _mm_loadu_si128((__m128i*)masterKey);
     __m128i fk = _mm_loadu_si128((__m128i*)systemFK);
     __m128i res = _mm_xor_si128(mk, fk);
@@ -76,7 +108,7 @@ void extendFirst(u32 masterKey[4], u32 tempK[4]) {
 }
 
 /* ===== 密钥扩展：第二步 ===== */
-void extendSecond(u32 roundKey[32], u32 tempK[4]) {
+static void extendSecond(u32 roundKey[32], u32 tempK[4]) {
     u32 localK[4];
     memcpy(localK, tempK, sizeof(u32) * 4);
     for (int i = 0; i < 32; ++i) {
@@ -100,15 +132,15 @@ void generateRoundKey(u32 masterKey[4], u32 tempK[4], u32 roundKey[32]) {
     extendSecond(roundKey, tempK);
 }
 
-/* ===== 32 轮迭代（SIMD 版） ===== */
-void iterate32_SIMD(u32 state[4], u32 roundKey[32]) {
+/* ===== 32 轮迭代（SIMD 版）；reverse 非 0 时倒序取轮密钥，即解密 ===== */
+static void iterateRounds_SIMD(u32 state[4], const u32 roundKey[32], int reverse) {
     u32 local[4];
     memcpy(local, state, sizeof(u32) * 4);
     for (int i = 0; i < 32; ++i) {
         u32 inputVal = local[(i + 1) % 4] ^
                        local[(i + 2) % 4] ^
                        local[(i + 3) % 4] ^
-                       roundKey[i];
+                       roundKey[reverse ? 31 - i : i];
 
         __m128i inputVec = _mm_set1_epi32(inputVal);
         __m128i resultVec = compositeT_SIMD(inputVec, 1); /* 模式1：L1 */
@@ -123,6 +155,10 @@ void iterate32_SIMD(u32 state[4], u32 roundKey[32]) {
     state[3] = local[0];
 }
 
+static void iterate32_SIMD(u32 state[4], u32 roundKey[32]) {
+    iterateRounds_SIMD(state, roundKey, 0);
+}
+
 /* ===== 加密（SIMD 版） ===== */
 void encryptSM4_SIMD(u32 plain[4], u32 roundKey[32], u32 cipher[4]) {
     u32 tmp[4];
@@ -131,46 +167,44 @@ void encryptSM4_SIMD(u32 plain[4], u32 roundKey[32], u32 cipher[4]) {
     memcpy(cipher, tmp, sizeof(u32) * 4);
 }
 
-/* ===== 解密（SIMD 版） ===== */
+/* ===== 解密（SIMD 版）：直接倒序使用加密轮密钥，不再每次复制一份反转数组 ===== */
 void decryptSM4_SIMD(u32 cipher[4], u32 roundKey[32], u32 plain[4]) {
-    u32 invKey[32];
-    for (int i = 0; i < 32; ++i) invKey[i] = roundKey[31 - i];
-
     u32 tmp[4];
     memcpy(tmp, cipher, sizeof(u32) * 4);
-    iterate32_SIMD(tmp, invKey);
+    iterateRounds_SIMD(tmp, roundKey, 1);
     memcpy(plain, tmp, sizeof(u32) * 4);
 }
 
-/* ===== 测试主函数 ===== */
-int main(void) {
-    u32 plain[4] = {0xdeadbeef, 0xc0ffee00, 0xfade0fad, 0x87654321};
-    u32 key[4]        = {0x1337cafe, 0xbaadf00d, 0xdeadc0de, 0xfeedface};
-    u32 roundKey[32];
-    u32 tempK[4];
-    long long loops = 1000000;
-
-    /* 生成轮密钥 */
-    generateRoundKey(key, tempK, roundKey);
-
-    /* 性能计时 */
-    LARGE_INTEGER freq, start, end;
-    QueryPerformanceFrequency(&freq);
-    QueryPerformanceCounter(&start);
+/* ===== 批量接口的密钥设置 =====
+ * 直接在 uint32_t 上做密钥扩展：K 用 4 个字的环形缓冲，S 盒仍走常数时间实现（只用低 32 位），
+ * L' 用标量移位，省掉 generateRoundKey 每轮的广播 / 提取与临时数组拷贝。 */
+static inline uint32_t rotl32(uint32_t x, int n) {
+    return (x << n) | (x >> (32 - n));
+}
 
-    for (long long i = 0; i < loops; ++i) {
-        u32 tmp[4];
-        memcpy(tmp, plain, sizeof(u32) * 4);
-        encryptSM4_SIMD(tmp, roundKey, tmp);
-        decryptSM4_SIMD(tmp, roundKey, tmp);
+void sm4_set_encrypt_key(sm4_key *key, const uint8_t user_key[16]) {
+    GM_TRACE_ZONE(GMCRYPTO_ZONE_SM4_KEY_SCHEDULE, 16);
+    uint32_t k[4];
+    for (int i = 0; i < 4; ++i) {
+        k[i] = (((uint32_t)user_key[4 * i] << 24) | ((uint32_t)user_key[4 * i + 1] << 16) |
+                ((uint32_t)user_key[4 * i + 2] << 8) | (uint32_t)user_key[4 * i + 3]) ^
+               (uint32_t)systemFK[i];
     }
+    for (int i = 0; i < 32; ++i) {
+        uint32_t t = k[(i + 1) & 3] ^ k[(i + 2) & 3] ^ k[(i + 3) & 3] ^ (uint32_t)fixedCK[i];
+        uint32_t b = (uint32_t)_mm_cvtsi128_si32(sBoxTransform_SIMD(_mm_cvtsi32_si128((int)t)));
+        k[i & 3] ^= b ^ rotl32(b, 13) ^ rotl32(b, 23);
+        key->rk[i] = k[i & 3];
+    }
+}
 
-    QueryPerformanceCounter(&end);
-    double elapsed = (double)(end.QuadPart - start.QuadPart) / freq.QuadPart;
-    printf("SM4 SIMD Performance Test\n");
-    printf("========================\n");
-    printf("Total time     : %.3f s\n", elapsed);
-    printf("Avg per op     : %.2e s\n", elapsed / (loops * 4));
+void sm4_set_decrypt_key(sm4_key *key, const uint8_t user_key[16]) {
+    sm4_key enc;
+    sm4_set_encrypt_key(&enc, user_key);
+    for (int i = 0; i < 32; ++i) key->rk[i] = enc.rk[31 - i];
+}
 
-    return 0;
-}
\ No newline at end of file
+void sm4_key_pair_init(sm4_key_pair *kp, const uint8_t user_key[16]) {
+    sm4_set_encrypt_key(&kp->enc, user_key);
+    for (int i = 0; i < 32; ++i) kp->dec.rk[i] = kp->enc.rk[31 - i];
+}
@@ -0,0 +1,178 @@
+#ifndef SM4_PRO_H
+#define SM4_PRO_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 旧接口沿用的类型名；u32 必须正好 32 位（LP64 上 unsigned long 是 64 位） */
+typedef uint8_t  u8;
+typedef uint32_t u32;
+
+/* ===== 常量表（sm4_pro.c） ===== */
+extern const u8 Sbox[256];
+extern const u32 systemFK[4];
+extern const u32 fixedCK[32];
+
+/* ===== 单分组接口 ===== */
+void generateRoundKey(u32 masterKey[4], u32 tempK[4], u32 roundKey[32]);
+void encryptSM4_SIMD(u32 plain[4], u32 roundKey[32], u32 cipher[4]);
+void decryptSM4_SIMD(u32 cipher[4], u32 roundKey[32], u32 plain[4]);
+
+/* 当前使用的常数时间 S 盒实现："gfni" / "aesni" / "bitsliced" */
+const char *sm4_sbox_name(void);
+
+/* ===== 批量接口：多个分组转置后在 SIMD 车道里并行跑 32 轮 ===== */
+
+/* 轮密钥；加密与解密只是轮密钥顺序相反 */
+typedef struct {
+    uint32_t rk[32];
+} sm4_key;
+
+void sm4_set_encrypt_key(sm4_key *key, const uint8_t user_key[16]);
+void sm4_set_decrypt_key(sm4_key *key, const uint8_t user_key[16]);
+
+#if defined(_MSC_VER)
+#define SM4_CACHE_ALIGN __declspec(align(64))
+#else
+#define SM4_CACHE_ALIGN __attribute__((aligned(64)))
+#endif
+
+/* 同一密钥的加密与解密轮密钥放在一起，按缓存行对齐（各 128 字节，正好两行）；
+ * 解密轮密钥由加密轮密钥倒序得到，只扩展一次。堆上分配时要用对齐分配。 */
+typedef struct SM4_CACHE_ALIGN {
+    sm4_key enc;
+    sm4_key dec;
+} sm4_key_pair;
+
+void sm4_key_pair_init(sm4_key_pair *kp, const uint8_t user_key[16]);
+
+/* ===== 轮密钥缓存：容量固定，按最近最少使用淘汰 =====
+ *
+ *   以 16 字节密钥的 64 位指纹做哈希，命中后还会比较完整密钥，不会把不同的密钥混用。
+ *   get 返回的指针在同一缓存下一次 get 之前一直有效（之后可能被淘汰复用）。
+ *   不加锁：多线程时每个线程各用一个缓存。
+ */
+typedef struct sm4_key_cache sm4_key_cache;
+
+sm4_key_cache *sm4_key_cache_new(size_t capacity);
+void sm4_key_cache_free(sm4_key_cache *cache);
+const sm4_key_pair *sm4_key_cache_get(sm4_key_cache *cache, const uint8_t user_key[16]);
+void sm4_key_cache_stats(const sm4_key_cache *cache, uint64_t *hits, uint64_t *misses);
+
+/* 批量实现：车道数 4 / 8 / 16，S 盒用位切片、AES-NI 或 GFNI
+ * 编译时定义 SM4_TTABLE，则只有 SSE2 时自动选择的路径（sm4_crypt_blocks / sm4_crypt_block / CTR）
+ * 改用合并了 S 盒与 L 的查表内核：快得多，但不是常数时间。 */
+enum sm4_batch_isa {
+    SM4_BATCH_SSE2      = 0,   /* 16 路（4 个 XMM 一组），位切片 S 盒，只需 SSE2 */
+    SM4_BATCH_AESNI     = 1,   /* 4 路，SSSE3 + AES-NI */
+    SM4_BATCH_AVX2      = 2,   /* 8 路，AVX2 + AES-NI（aesenclast 按 128 位拆开做） */
+    SM4_BATCH_AVX2_GFNI = 3,   /* 8 路，AVX2 + GFNI */
+    SM4_BATCH_AVX512    = 4    /* 16 路，AVX-512BW + GFNI */
+};
+
+enum sm4_batch_isa sm4_batch_best_isa(void);
+int sm4_batch_isa_supported(enum sm4_batch_isa isa);
+const char *sm4_batch_isa_name(enum sm4_batch_isa isa);
+unsigned sm4_batch_isa_lanes(enum sm4_batch_isa isa);
+
+/* ECB：对 nblocks 个 16 字节分组做加密或解密（取决于 key），in 与 out 可以相同 */
+void sm4_crypt_blocks_isa(enum sm4_batch_isa isa, const sm4_key *key,
+                          const uint8_t *in, uint8_t *out, size_t nblocks);
+void sm4_crypt_blocks(const sm4_key *key, const uint8_t *in, uint8_t *out, size_t nblocks);
+
+/* 单个分组，按延迟优化（串行模式用）；in 与 out 可以相同 */
+void sm4_crypt_block(const sm4_key *key, const uint8_t in[16], uint8_t out[16]);
+/* 单分组路径当前选用的实现："gfni" / "aesni" / 退回批量内核时为其名字 */
+const char *sm4_block_impl_name(void);
+
+/* CTR：计数器块为 iv（128 位大端整数），第 i 个分组用 iv + i；key 须为加密密钥 */
+void sm4_ctr_blocks(const sm4_key *key, const uint8_t iv[16],
+                    const uint8_t *in, uint8_t *out, size_t nblocks);
+
+/* ===== 工作模式：流式 init / update / final，in 与 out 可以是同一块缓冲区 =====
+ *
+ *   CTR、XTS、CBC 解密、CFB 解密走批量内核并行；CBC 加密、CFB 加密、OFB 前后分组相互依赖，逐块串行。
+ *   CTR / CFB / OFB 是流密码，update 输出与输入等长；
+ *   CBC / XTS 只输出凑满的分组，out 至少要留 len + 15 字节，剩余部分由 final 输出。
+ *   CBC 不做填充，总长必须是 16 的倍数；XTS 按 IEEE 1619 计算 tweak，
+ *   总长至少 16 字节，末尾不足一个分组时用密文挪用。
+ */
+enum sm4_mode {
+    SM4_MODE_CTR = 0,
+    SM4_MODE_CBC = 1,
+    SM4_MODE_CFB = 2,   /* CFB128 */
+    SM4_MODE_OFB = 3,
+    SM4_MODE_XTS = 4
+};
+
+typedef struct {
+    sm4_key key;        /* CBC / XTS 解密时为解密轮密钥，其余为加密轮密钥 */
+    sm4_key tweak_key;  /* XTS 的 tweak 密钥 */
+    int mode;
+    int enc;
+    uint8_t iv[16];     /* CTR 计数器 / CBC 上一个密文 / CFB、OFB 反馈寄存器 / XTS 当前 tweak */
+    uint8_t ks[16];     /* CTR / CFB / OFB 当前分组的密钥流 */
+    size_t ks_pos;      /* ks 已用掉的字节数，16 表示需要生成下一块 */
+    uint8_t buf[32];    /* CBC / XTS 暂存的未输出数据 */
+    size_t buf_len;
+} sm4_mode_ctx;
+
+/* key 为 16 字节，XTS 为 32 字节（数据密钥 || tweak 密钥）；iv 为 16 字节，XTS 为 tweak（扇区号等）
+ * 参数非法时返回 -1 */
+int sm4_mode_init(sm4_mode_ctx *ctx, enum sm4_mode mode, int enc,
+                  const uint8_t *key, const uint8_t iv[16]);
+/* 返回写入 out 的字节数 */
+size_t sm4_mode_update(sm4_mode_ctx *ctx, const uint8_t *in, uint8_t *out, size_t len);
+/* 用已扩展好的轮密钥初始化（例如来自 sm4_key_cache），不再做密钥扩展；tweak 只有 XTS 需要 */
+int sm4_mode_init_keys(sm4_mode_ctx *ctx, enum sm4_mode mode, int enc,
+                       const sm4_key_pair *key, const sm4_key_pair *tweak, const uint8_t iv[16]);
+/* 输出剩余数据并返回字节数；CBC 剩余不足一个分组、XTS 总长不足 16 字节时返回 -1 */
+int sm4_mode_final(sm4_mode_ctx *ctx, uint8_t *out);
+/* 保留密钥，换一个 IV（XTS 为下一个扇区的 tweak）开始新消息，省去重新扩展密钥 */
+void sm4_mode_set_iv(sm4_mode_ctx *ctx, const uint8_t iv[16]);
+const char *sm4_mode_name(enum sm4_mode mode);
+
+/* ===== 认证加密：GCM / CCM，一次遍历完成加密与认证，in 与 out 可以相同 =====
+ *
+ *   seal 输出与明文等长的密文和 tag_len 字节的标签；open 校验失败时返回 -1 并把 out 清零。
+ *   GCM：IV 推荐 12 字节（其他长度按规范做 GHASH），标签 4..16 字节；
+ *        GHASH 有 PCLMULQDQ 时用无进位乘法（8 个分组聚合约简），否则用 4 位查表。
+ *   CCM：nonce 7..13 字节，标签 4..16 字节且为偶数；CBC-MAC 本身是串行的。
+ */
+typedef struct {
+    sm4_key key;
+    int clmul;                  /* 1 = PCLMULQDQ；清零可强制走查表实现（测试用） */
+    uint8_t h[16];              /* H = E(0^128) */
+    uint8_t hpow[8][16];        /* PCLMULQDQ：H^1..H^8 */
+    uint64_t hh[16], hl[16];    /* 查表：H 乘 4 位多项式的 16 项 */
+} sm4_gcm_key;
+
+void sm4_gcm_init(sm4_gcm_key *g, const uint8_t key[16]);
+int sm4_gcm_seal(const sm4_gcm_key *g, const uint8_t *iv, size_t iv_len,
+                 const uint8_t *aad, size_t aad_len,
+                 const uint8_t *in, size_t len, uint8_t *out,
+                 uint8_t *tag, size_t tag_len);
+int sm4_gcm_open(const sm4_gcm_key *g, const uint8_t *iv, size_t iv_len,
+                 const uint8_t *aad, size_t aad_len,
+                 const uint8_t *in, size_t len, uint8_t *out,
+                 const uint8_t *tag, size_t tag_len);
+
+/* key 为加密轮密钥（sm4_set_encrypt_key） */
+int sm4_ccm_seal(const sm4_key *key, const uint8_t *nonce, size_t nonce_len,
+                 const uint8_t *aad, size_t aad_len,
+                 const uint8_t *in, size_t len, uint8_t *out,
+                 uint8_t *tag, size_t tag_len);
+int sm4_ccm_open(const sm4_key *key, const uint8_t *nonce, size_t nonce_len,
+                 const uint8_t *aad, size_t aad_len,
+                 const uint8_t *in, size_t len, uint8_t *out,
+                 const uint8_t *tag, size_t tag_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SM4_PRO_H */
@@ -0,0 +1,215 @@
+#ifndef SM4_SBOX_H
+#define SM4_SBOX_H
+
+/*
+ * 常数时间的 SM4 S 盒（一次处理 16 个字节）
+ *
+ * SM4 的 S 盒可以写成 S(x) = A·inv(A·x + C) + C，inv 为 GF(2^8)（模 x^8+x^7+x^6+x^5+x^4+x^2+1）
+ * 上的求逆，A 为 8x8 比特矩阵，C = 0xd3。三种实现都不做依赖于数据的访存，不泄露计时信息：
+ *
+ *   GFNI：    gf2p8affine 把 x 变到 AES 域（同构 M 并入 M·A、M·C），gf2p8affineinv
+ *             在 AES 域求逆后再做 A·M^-1 与 +C，两条指令完成；
+ *   AES-NI：  前后两次仿射变换用 pshufb 半字节查表（16 字节表在寄存器内，与数据无关），
+ *             中间借 aesenclast 的 SubBytes 完成 AES 域求逆；
+ *   位切片：  把字节拆成 8 个比特平面，用 x^254 = inv(x) 的加法链（4 次乘法）求逆，
+ *             只用 SSE2，作为没有 AES-NI 时的回退；一次最多处理 64 个字节。
+ *
+ * sm4_sbox_select() 按 CPUID 选 GFNI > AES-NI > 位切片。
+ */
+
+#include <stdint.h>
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#include <wmmintrin.h>
+#include <immintrin.h>
+#include "../common/cpu_features.h"
+
+#if defined(__GNUC__)
+#define SM4_TARGET(x) __attribute__((target(x)))
+#else
+#define SM4_TARGET(x)
+#endif
+
+typedef __m128i (*sm4_sbox_fn)(__m128i);
+
+/* ===== GFNI ===== */
+
+/* 仿射矩阵按 gf2p8affine 约定打包：qword 的第 (7-i) 字节是输出第 i 位对应的行 */
+#define SM4_GFNI_PRE_MAT   0x4c287db91a22505dULL   /* M·A */
+#define SM4_GFNI_PRE_CONST 0x3e                    /* M·C */
+#define SM4_GFNI_POST_MAT  0xf3ab34a974a6b589ULL   /* A·M^-1 */
+#define SM4_GFNI_POST_CONST 0xd3                   /* C */
+
+SM4_TARGET("gfni,sse4.1")
+static inline __m128i sm4_sbox_gfni(__m128i x) {
+    const __m128i pre = _mm_set1_epi64x((long long)SM4_GFNI_PRE_MAT);
+    const __m128i post = _mm_set1_epi64x((long long)SM4_GFNI_POST_MAT);
+    x = _mm_gf2p8affine_epi64_epi8(x, pre, SM4_GFNI_PRE_CONST);
+    return _mm_gf2p8affineinv_epi64_epi8(x, post, SM4_GFNI_POST_CONST);
+}
+
+/* ===== AES-NI ===== */
+
+/* 8 位仿射变换拆成高低两个半字节各查一次 16 项表（常数已并入低半字节表） */
+SM4_TARGET("ssse3")
+static inline __m128i sm4_affine_nibble(__m128i x, __m128i lo, __m128i hi) {
+    const __m128i mask = _mm_set1_epi8(0x0f);
+    __m128i l = _mm_shuffle_epi8(lo, _mm_and_si128(x, mask));
+    __m128i h = _mm_shuffle_epi8(hi, _mm_and_si128(_mm_srli_epi16(x, 4), mask));
+    return _mm_xor_si128(l, h);
+}
+
+/* 16 字节的 pshufb 表按 (高 8 字节, 低 8 字节) 两个 64 位常数给出，128/256/512 位内核共用 */
+#define SM4_AESNI_PRE_LO   0x9814a8241d912da1ULL, 0x078b37bb820eb23eULL  /* x -> M·A·x + M·C */
+#define SM4_AESNI_PRE_HI   0x3fe311cdfa26d408ULL, 0x37eb19c5f22edc00ULL
+#define SM4_AESNI_POST_LO  0x47ff8d3579c1b30bULL, 0x2098ea521ea6d46cULL  /* 抵消 AES 仿射，回到 SM4 域做 A·y + C */
+#define SM4_AESNI_POST_HI  0xed0dbd5d709020c0ULL, 0x2dcd7d9db050e000ULL
+#define SM4_INV_SHIFT_ROWS 0x0306090c0f020508ULL, 0x0b0e0104070a0d00ULL  /* aesenclast 会先做 ShiftRows，提前抵消 */
+
+#define SM4_M128_CONST(hi, lo) _mm_set_epi64x((long long)(hi), (long long)(lo))
+#define SM4_M128(c) SM4_M128_CONST(c)
+
+/* aesenclast 之前的部分：逆 ShiftRows + 前仿射 */
+SM4_TARGET("ssse3")
+static inline __m128i sm4_aesni_pre(__m128i x) {
+    x = _mm_shuffle_epi8(x, SM4_M128(SM4_INV_SHIFT_ROWS));
+    return sm4_affine_nibble(x, SM4_M128(SM4_AESNI_PRE_LO), SM4_M128(SM4_AESNI_PRE_HI));
+}
+
+SM4_TARGET("ssse3")
+static inline __m128i sm4_aesni_post(__m128i x) {
+    return sm4_affine_nibble(x, SM4_M128(SM4_AESNI_POST_LO), SM4_M128(SM4_AESNI_POST_HI));
+}
+
+SM4_TARGET("aes,ssse3")
+static inline __m128i sm4_sbox_aesni(__m128i x) {
+    x = sm4_aesni_pre(x);
+    x = _mm_aesenclast_si128(x, _mm_setzero_si128());
+    return sm4_aesni_post(x);
+}
+
+/* ===== 位切片（仅 SSE2） ===== */
+
+/* 一个比特平面：第 k 位对应第 k 个字节，一次最多处理 64 个字节（4 个寄存器） */
+typedef uint64_t sm4_bs_t;
+
+/* 下面三个线性变换由比特矩阵展开而来，输出第 i 位 = 矩阵第 i 行选中的输入位之和 */
+
+/* A·x + C（C = 0xd3，对应位取反） */
+static inline void sm4_bs_affine(const sm4_bs_t x[8], sm4_bs_t r[8]) {
+    r[0] = ~(x[0] ^ x[1] ^ x[2] ^ x[5] ^ x[7]);
+    r[1] = ~(x[0] ^ x[1] ^ x[2] ^ x[3] ^ x[6]);
+    r[2] = x[1] ^ x[2] ^ x[3] ^ x[4] ^ x[7];
+    r[3] = x[0] ^ x[2] ^ x[3] ^ x[4] ^ x[5];
+    r[4] = ~(x[1] ^ x[3] ^ x[4] ^ x[5] ^ x[6]);
+    r[5] = x[2] ^ x[4] ^ x[5] ^ x[6] ^ x[7];
+    r[6] = ~(x[0] ^ x[3] ^ x[5] ^ x[6] ^ x[7]);
+    r[7] = ~(x[0] ^ x[1] ^ x[4] ^ x[6] ^ x[7]);
+}
+
+/* x^2 */
+static inline void sm4_bs_sq(const sm4_bs_t x[8], sm4_bs_t r[8]) {
+    r[0] = x[0] ^ x[4];
+    r[1] = x[5] ^ x[7];
+    r[2] = x[1] ^ x[4] ^ x[5];
+    r[3] = x[5] ^ x[6] ^ x[7];
+    r[4] = x[2] ^ x[4] ^ x[5] ^ x[6];
+    r[5] = x[4] ^ x[5] ^ x[6];
+    r[6] = x[3] ^ x[4] ^ x[6];
+    r[7] = x[4] ^ x[6];
+}
+
+/* x^4 */
+static inline void sm4_bs_sq2(const sm4_bs_t x[8], sm4_bs_t r[8]) {
+    r[0] = x[0] ^ x[2] ^ x[5] ^ x[6];
+    r[1] = x[5];
+    r[2] = x[2] ^ x[5] ^ x[7];
+    r[3] = x[3] ^ x[4] ^ x[5] ^ x[6];
+    r[4] = x[1] ^ x[2] ^ x[3] ^ x[5] ^ x[6];
+    r[5] = x[2] ^ x[3] ^ x[4] ^ x[6];
+    r[6] = x[2] ^ x[3] ^ x[6] ^ x[7];
+    r[7] = x[2] ^ x[3] ^ x[5];
+}
+
+/* GF(2^8) 乘法，模 x^8 = x^7+x^6+x^5+x^4+x^2+1 */
+static inline void sm4_bs_mul(const sm4_bs_t a[8], const sm4_bs_t b[8], sm4_bs_t r[8]) {
+    sm4_bs_t t[15] = {0};
+    for (int i = 0; i < 8; ++i)
+        for (int j = 0; j < 8; ++j) t[i + j] ^= a[i] & b[j];
+    for (int k = 14; k >= 8; --k) {
+        t[k - 1] ^= t[k]; t[k - 2] ^= t[k]; t[k - 3] ^= t[k];
+        t[k - 4] ^= t[k]; t[k - 6] ^= t[k]; t[k - 8] ^= t[k];
+    }
+    for (int i = 0; i < 8; ++i) r[i] = t[i];
+}
+
+/* S(x) = A·inv(A·x + C) + C，inv(x) = x^254：x^3 -> x^15 -> x^63 -> x^127 -> 平方，0 映射到 0 */
+static inline void sm4_bs_sbox(sm4_bs_t p[8]) {
+    sm4_bs_t x[8], a2[8], a4[8], a6[8], t[8];
+    sm4_bs_affine(p, x);
+    sm4_bs_sq(x, t);   sm4_bs_mul(t, x, a2);
+    sm4_bs_sq2(a2, t); sm4_bs_mul(t, a2, a4);
+    sm4_bs_sq2(a4, t); sm4_bs_mul(t, a2, a6);
+    sm4_bs_sq(a6, t);  sm4_bs_mul(t, x, a2);
+    sm4_bs_sq(a2, t);
+    sm4_bs_affine(t, p);
+}
+
+/* n 个寄存器（n <= 4）拆成比特平面：把每个字节的第 i 位移到最高位，再用 movemask 收集 */
+static inline void sm4_bs_pack(const __m128i *v, int n, sm4_bs_t p[8]) {
+    for (int i = 0; i < 8; ++i) {
+        p[i] = 0;
+        for (int k = 0; k < n; ++k)
+            p[i] |= (sm4_bs_t)(uint32_t)_mm_movemask_epi8(_mm_slli_epi64(v[k], 7 - i)) << (16 * k);
+    }
+}
+
+/* 比特平面还原成字节：每 16 位的低/高 8 位分别广播到前/后 8 个字节，逐字节测对应位 */
+static inline void sm4_bs_unpack(const sm4_bs_t p[8], __m128i *v, int n) {
+    const __m128i bit = _mm_set1_epi64x(0x8040201008040201LL);
+    for (int k = 0; k < n; ++k) {
+        __m128i out = _mm_setzero_si128();
+        for (int i = 0; i < 8; ++i) {
+            uint64_t q = p[i] >> (16 * k);
+            __m128i b = _mm_set_epi64x((long long)(((q >> 8) & 0xff) * 0x0101010101010101ULL),
+                                       (long long)((q & 0xff) * 0x0101010101010101ULL));
+            b = _mm_cmpeq_epi8(_mm_and_si128(b, bit), bit);
+            out = _mm_or_si128(out, _mm_and_si128(b, _mm_set1_epi8((char)(1 << i))));
+        }
+        v[k] = out;
+    }
+}
+
+static inline __m128i sm4_sbox_bitsliced(__m128i x) {
+    sm4_bs_t p[8];
+    sm4_bs_pack(&x, 1, p);
+    sm4_bs_sbox(p);
+    sm4_bs_unpack(p, &x, 1);
+    return x;
+}
+
+/* 4 个寄存器共 64 字节一起做，摊薄求逆电路的开销 */
+static inline void sm4_sbox_bitsliced_x4(__m128i v[4]) {
+    sm4_bs_t p[8];
+    sm4_bs_pack(v, 4, p);
+    sm4_bs_sbox(p);
+    sm4_bs_unpack(p, v, 4);
+}
+
+/* ===== 运行时选择 ===== */
+
+static inline sm4_sbox_fn sm4_sbox_select(const char **name) {
+    const cpu_features_t *f = cpu_features();
+    if (f->gfni) {
+        if (name) *name = "gfni";
+        return sm4_sbox_gfni;
+    }
+    if (f->aesni && f->ssse3) {
+        if (name) *name = "aesni";
+        return sm4_sbox_aesni;
+    }
+    if (name) *name = "bitsliced";
+    return sm4_sbox_bitsliced;
+}
+
+#endif /* SM4_SBOX_H */
@@ -0,0 +1,61 @@
+/* SM4 查表内核：S 盒与 L 合并成 4 张 256 项的 u32 表，一轮 4 次查表 + 3 次异或
+ * 只在编译时定义 SM4_TTABLE 时由 sm4_batch.c 启用，用来替换只有 SSE2 的老 CPU 上的位切片内核。
+ * 查表下标依赖密钥与明文，不是常数时间。 */
+#include "sm4_pro.h"
+#include "sm4_lanes.h"
+#include "../common/cpu_features.h"
+
+static uint32_t ttable[4][256];
+static long ttableState = 0;    /* 与 cpu_features 相同的三态：0 未建表，1 建表中，2 已就绪 */
+
+static inline uint32_t ttable_rol(uint32_t x, int n) {
+    return (x << n) | (x >> (32 - n));
+}
+
+/* 第一个线程建表后 release 发布，同时进来的线程等它发布，读到 2 之后表内容一定可见 */
+static void ttable_init(void) {
+    if (!cpu_state_claim(&ttableState)) {
+        while (cpu_state_load(&ttableState) != 2) {
+        }
+        return;
+    }
+    for (int x = 0; x < 256; ++x) {
+        for (int k = 0; k < 4; ++k) {
+            uint32_t b = (uint32_t)Sbox[x] << (24 - 8 * k);
+            ttable[k][x] = b ^ ttable_rol(b, 2) ^ ttable_rol(b, 10) ^ ttable_rol(b, 18) ^ ttable_rol(b, 24);
+        }
+    }
+    cpu_state_publish(&ttableState);
+}
+
+static inline uint32_t ttable_t(uint32_t a) {
+    return ttable[0][a >> 24] ^ ttable[1][(a >> 16) & 0xff] ^
+           ttable[2][(a >> 8) & 0xff] ^ ttable[3][a & 0xff];
+}
+
+static inline uint32_t ttable_load(const uint8_t *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static inline void ttable_store(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)(v >> 24); p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);  p[3] = (uint8_t)v;
+}
+
+void sm4_ttable_blocks(const uint32_t *rk, const uint8_t *in, uint8_t *out, size_t nblocks) {
+    if (cpu_state_load(&ttableState) != 2) ttable_init();
+    for (; nblocks > 0; --nblocks, in += 16, out += 16) {
+        uint32_t x0 = ttable_load(in), x1 = ttable_load(in + 4);
+        uint32_t x2 = ttable_load(in + 8), x3 = ttable_load(in + 12);
+        for (int i = 0; i < 32; i += 4) {
+            x0 ^= ttable_t(x1 ^ x2 ^ x3 ^ rk[i]);
+            x1 ^= ttable_t(x2 ^ x3 ^ x0 ^ rk[i + 1]);
+            x2 ^= ttable_t(x3 ^ x0 ^ x1 ^ rk[i + 2]);
+            x3 ^= ttable_t(x0 ^ x1 ^ x2 ^ rk[i + 3]);
+        }
+        ttable_store(out, x3);
+        ttable_store(out + 4, x2);
+        ttable_store(out + 8, x1);
+        ttable_store(out + 12, x0);
+    }
+}
@@ -0,0 +1,356 @@
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+#include "wm.h"
+#include "sm3_promax.h"
+#include "../common/thread_pool.h"
+
+static const uint8_t WM_KDF_DST[] = "GMCRYPTO-WM-STDM";
+
+// 参与扩频的中频系数（行频率, 列频率），u + v 取 2..4：JPEG 量化表在这一带的步长还小，又不至于明显可见
+static const uint8_t WM_BAND[WM_COEFFS][2] = {
+    {0, 2}, {1, 1}, {2, 0}, {1, 2}, {2, 1}, {0, 3}, {3, 0}, {2, 2},
+};
+
+#define WM_SLOTS (WM_PERIOD * WM_PERIOD)
+
+// 一维 8 点正交 DCT 的第 u 个基函数在 x 处的值
+static double wm_dct_basis(int u, int x) {
+    double c = u ? 0.5 : sqrt(0.125);
+    return c * cos((2 * x + 1) * u * M_PI / 16);
+}
+
+static inline int wm_slot(int bx, int by) {
+    return (by % WM_PERIOD) * WM_PERIOD + bx % WM_PERIOD;
+}
+
+int wm_init(wm_ctx *ctx, const wm_params *params) {
+    if (params->mode != WM_DCT && params->mode != WM_DWT_DCT) return -1;
+    if (params->bits == 0 || params->bits > WM_MAX_BITS) return -1;
+    if (!(params->strength >= 0) || params->strength > 1e4f) return -1;
+    if (params->key_len && !params->key) return -1;
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->mode = params->mode;
+    ctx->block = params->mode == WM_DWT_DCT ? 16 : 8;
+    ctx->bits = params->bits;
+    ctx->step = params->strength > 0 ? params->strength : WM_DEFAULT_STEP;
+
+    // KDF 输出：槽位置换 4 × 256 字节 | 槽位的扩频向量 256 字节 | 各向量的符号 WM_PATTERNS 字节 | 抖动 4 字节
+    std::vector<uint8_t> z(sizeof(WM_KDF_DST) - 1 + params->key_len);
+    memcpy(z.data(), WM_KDF_DST, sizeof(WM_KDF_DST) - 1);
+    if (params->key_len) memcpy(z.data() + sizeof(WM_KDF_DST) - 1, params->key, params->key_len);
+    uint8_t out[4 * WM_SLOTS + WM_SLOTS + WM_PATTERNS + 4];
+    sm3_kdf(z.data(), z.size(), out, sizeof(out));
+
+    // 槽位打乱后按比特数取模，每个比特分到 floor 或 ceil(256 / bits) 个槽位
+    uint16_t perm[WM_SLOTS];
+    for (int i = 0; i < WM_SLOTS; i++) perm[i] = (uint16_t)i;
+    for (int i = WM_SLOTS - 1; i > 0; i--) {
+        const uint8_t *r = out + 4 * i;
+        uint32_t v = (uint32_t)r[0] << 24 | (uint32_t)r[1] << 16 | (uint32_t)r[2] << 8 | r[3];
+        int j = (int)(((uint64_t)v * (uint64_t)(i + 1)) >> 32);
+        std::swap(perm[i], perm[j]);
+    }
+    for (int i = 0; i < WM_SLOTS; i++) {
+        ctx->slot_bit[i] = (uint16_t)(perm[i] % params->bits);
+        ctx->slot_pat[i] = (uint8_t)(out[4 * WM_SLOTS + i] % WM_PATTERNS);
+    }
+    const uint8_t *signs = out + 5 * WM_SLOTS;
+    const uint8_t *d = signs + WM_PATTERNS;
+    uint32_t dv = (uint32_t)d[0] << 24 | (uint32_t)d[1] << 16 | (uint32_t)d[2] << 8 | d[3];
+    ctx->dither = (float)(dv / 4294967296.0 * ctx->step);
+
+    // u = Σ w_j · basis_j / sqrt(K)，各基函数正交归一，u 也是单位范数
+    for (int k = 0; k < WM_PATTERNS; k++) {
+        double u8[64] = {0};
+        for (int j = 0; j < WM_COEFFS; j++) {
+            double w = ((signs[k] >> j) & 1) ? -1.0 : 1.0;
+            for (int x = 0; x < 8; x++) {
+                for (int y = 0; y < 8; y++) {
+                    u8[x * 8 + y] += w * wm_dct_basis(WM_BAND[j][0], x) * wm_dct_basis(WM_BAND[j][1], y);
+                }
+            }
+        }
+        for (int i = 0; i < 64; i++) u8[i] /= sqrt((double)WM_COEFFS);
+        float *p = ctx->pat[k];
+        if (ctx->block == 8) {
+            for (int i = 0; i < 64; i++) p[i] = (float)u8[i];
+        } else {
+            // LL(i, j) = (四个像素之和) / 2：投影 <LL, u> 等于 <像素, u 的 2×2 展开 / 2>，逆 Haar 也是同一个展开
+            for (int y = 0; y < 16; y++) {
+                for (int x = 0; x < 16; x++) p[y * 16 + x] = (float)(u8[(y / 2) * 8 + x / 2] / 2);
+            }
+        }
+    }
+    memset(out, 0, sizeof(out));
+    return 0;
+}
+
+/* ===== 逐块运算 ===== */
+
+struct wm_view {
+    const uint8_t *pix;
+    int width, height, channels;
+    size_t stride;
+};
+
+// 模板按通道展开成每行 block * channels 个权重，块内每行是连续字节，内积与加增量都能向量化
+struct wm_tables {
+    int row;                 // 每行权重数
+    std::vector<float> wy;   // 投影：模板值乘亮度系数
+    std::vector<float> ue;   // 嵌入：模板值，各通道相同
+};
+
+static void wm_tables_init(wm_tables *t, const wm_ctx *ctx, int channels) {
+    static const float luma[3] = {0.299f, 0.587f, 0.114f};
+    const int b = ctx->block, row = b * channels;
+    t->row = row;
+    t->wy.assign((size_t)WM_PATTERNS * b * row, 0.0f);
+    t->ue.assign((size_t)WM_PATTERNS * b * row, 0.0f);
+    for (int k = 0; k < WM_PATTERNS; k++) {
+        for (int y = 0; y < b; y++) {
+            for (int x = 0; x < b; x++) {
+                float u = ctx->pat[k][y * b + x];
+                for (int c = 0; c < channels; c++) {
+                    size_t i = ((size_t)k * b + y) * row + x * channels + c;
+                    t->wy[i] = channels == 1 ? u : u * luma[c];
+                    t->ue[i] = u;
+                }
+            }
+        }
+    }
+}
+
+// 块的亮度与模板的内积；row 总是 8 的倍数，分 8 路累加让编译器展开成 SIMD
+static inline float wm_project(const uint8_t *p, size_t stride, int rows, int row, const float *w) {
+    float s[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    for (int y = 0; y < rows; y++, p += stride, w += row) {
+        for (int k = 0; k < row; k += 8) {
+            for (int j = 0; j < 8; j++) s[j] += (float)p[k + j] * w[k + j];
+        }
+    }
+    return ((s[0] + s[1]) + (s[2] + s[3])) + ((s[4] + s[5]) + (s[6] + s[7]));
+}
+
+// 同一块对全部 WM_PATTERNS 个模板的内积，像素只转换一次
+static inline void wm_project_all(const uint8_t *p, size_t stride, int rows, int row, const float *w, size_t pat_len,
+                                  float *out) {
+    float s[WM_PATTERNS][8] = {{0}};
+    for (int y = 0; y < rows; y++, p += stride) {
+        for (int k = 0; k < row; k += 8) {
+            float f[8];
+            for (int j = 0; j < 8; j++) f[j] = (float)p[k + j];
+            const float *wk = w + (size_t)y * row + k;
+            for (int m = 0; m < WM_PATTERNS; m++) {
+                for (int j = 0; j < 8; j++) s[m][j] += f[j] * wk[m * pat_len + j];
+            }
+        }
+    }
+    for (int m = 0; m < WM_PATTERNS; m++) {
+        out[m] = ((s[m][0] + s[m][1]) + (s[m][2] + s[m][3])) + ((s[m][4] + s[m][5]) + (s[m][6] + s[m][7]));
+    }
+}
+
+static inline void wm_apply(uint8_t *p, size_t stride, int rows, int row, const float *u, float a) {
+    for (int y = 0; y < rows; y++, p += stride, u += row) {
+        for (int k = 0; k < row; k += 8) {
+            for (int j = 0; j < 8; j++) {
+                float v = (float)p[k + j] + a * u[k + j] + 0.5f;
+                v = v < 0.0f ? 0.0f : (v > 255.0f ? 255.0f : v);
+                p[k + j] = (uint8_t)(int)v;
+            }
+        }
+    }
+}
+
+// 离 p 最近的 Δ·Z + off 格点
+static inline float wm_lattice(float p, float off, float step) {
+    return floorf((p - off) / step + 0.5f) * step + off;
+}
+
+// 两组格点交错，间距 Δ/2，到两组的距离之和恒为 Δ/2；返回 (e0 - e1) / (Δ/2)，正号偏向 1
+static inline float wm_soft(const wm_ctx *ctx, float p) {
+    float e0 = fabsf(p - wm_lattice(p, ctx->dither, ctx->step));
+    float e1 = fabsf(p - wm_lattice(p, ctx->dither + 0.5f * ctx->step, ctx->step));
+    return (e0 - e1) * 2.0f / ctx->step;
+}
+
+static inline int wm_payload_bit(const uint8_t *payload, size_t i) {
+    return (payload[i >> 3] >> (7 - (i & 7))) & 1;
+}
+
+int wm_embed(const wm_ctx *ctx, uint8_t *pixels, int width, int height, int channels, size_t stride,
+             const uint8_t *payload, thread_pool &pool) {
+    const int b = ctx->block;
+    if ((channels != 1 && channels != 3) || width < b || height < b) return -1;
+    wm_tables t;
+    wm_tables_init(&t, ctx, channels);
+    const int nbx = width / b, nby = height / b, tb = WM_TILE / b;
+    const int tiles_x = (nbx + tb - 1) / tb, tiles_y = (nby + tb - 1) / tb;
+    const size_t pat_len = (size_t)b * t.row;
+
+    pool.parallel_for((size_t)tiles_x * tiles_y, [&](size_t tile) {
+        const int by0 = (int)(tile / tiles_x) * tb, bx0 = (int)(tile % tiles_x) * tb;
+        for (int by = by0; by < std::min(by0 + tb, nby); by++) {
+            for (int bx = bx0; bx < std::min(bx0 + tb, nbx); bx++) {
+                const int slot = wm_slot(bx, by);
+                const int pat = ctx->slot_pat[slot];
+                const int bit = wm_payload_bit(payload, ctx->slot_bit[slot]);
+                uint8_t *p = pixels + (size_t)by * b * stride + (size_t)bx * b * channels;
+                float proj = wm_project(p, stride, b, t.row, &t.wy[pat * pat_len]);
+                float q = wm_lattice(proj, ctx->dither + (bit ? 0.5f * ctx->step : 0.0f), ctx->step);
+                wm_apply(p, stride, b, t.row, &t.ue[pat * pat_len], q - proj);
+            }
+        }
+    });
+    return 0;
+}
+
+/* ===== 提取 ===== */
+
+// 每个槽位、每个扩频向量的软判决和，以及槽位的块数
+struct wm_acc {
+    float soft[WM_SLOTS][WM_PATTERNS];
+    float count[WM_SLOTS];
+};
+
+/*
+ * 槽位周期偏移 (tx, ty) 下各比特的平均软判决，返回平均绝对值（置信度）。
+ * acc 按未平移的槽位位置累计，位置 (px, py) 实际是槽位 (px + tx, py + ty)。
+ */
+static float wm_decode(const wm_ctx *ctx, const wm_acc *acc, int tx, int ty, float *soft, size_t *blocks) {
+    float sum[WM_MAX_BITS] = {0}, cnt[WM_MAX_BITS] = {0};
+    for (int pos = 0; pos < WM_SLOTS; pos++) {
+        const int slot = wm_slot(pos % WM_PERIOD + tx, pos / WM_PERIOD + ty);
+        const int bit = ctx->slot_bit[slot];
+        sum[bit] += acc->soft[pos][ctx->slot_pat[slot]];
+        cnt[bit] += acc->count[pos];
+    }
+    float conf = 0, total = 0;
+    for (size_t i = 0; i < ctx->bits; i++) {
+        float s = cnt[i] > 0 ? sum[i] / cnt[i] : 0.0f;
+        if (soft) soft[i] = s;
+        conf += fabsf(s);
+        total += cnt[i];
+    }
+    if (blocks) *blocks = (size_t)total;
+    return conf / ctx->bits;
+}
+
+// 块网格原点 (ox, oy) 处第 [bx0, bx1) × [by0, by1) 块；all 非 0 时每个扩频向量都算一遍（搜索偏移用），
+// 否则只算槽位 (bx + tx, by + ty) 自己的那个
+static void wm_scan(const wm_ctx *ctx, const wm_view *img, const wm_tables *t, int ox, int oy, int tx, int ty,
+                    int bx0, int bx1, int by0, int by1, int all, wm_acc *acc) {
+    const int b = ctx->block;
+    const size_t pat_len = (size_t)b * t->row;
+    for (int by = by0; by < by1; by++) {
+        const uint8_t *row = img->pix + (size_t)(oy + by * b) * img->stride + (size_t)ox * img->channels;
+        for (int bx = bx0; bx < bx1; bx++) {
+            const uint8_t *p = row + (size_t)bx * b * img->channels;
+            const int pos = wm_slot(bx, by);
+            acc->count[pos] += 1;
+            if (all) {
+                float proj[WM_PATTERNS];
+                wm_project_all(p, img->stride, b, t->row, t->wy.data(), pat_len, proj);
+                for (int k = 0; k < WM_PATTERNS; k++) acc->soft[pos][k] += wm_soft(ctx, proj[k]);
+            } else {
+                const int k = ctx->slot_pat[wm_slot(bx + tx, by + ty)];
+                acc->soft[pos][k] += wm_soft(ctx, wm_project(p, img->stride, b, t->row, &t->wy[k * pat_len]));
+            }
+        }
+    }
+}
+
+struct wm_align {
+    float conf;
+    int ox, oy, tx, ty;
+};
+
+/*
+ * 裁剪后块网格原点落在 [0, B)^2 的某处，槽位周期也错开了若干块。
+ * 每个像素偏移在中部 WM_SEARCH_SPAN 见方的区域里对所有扩频向量算一遍软判决（偏移之间并行），
+ * 槽位偏移只是换一种方式把同一份累计值分给各比特，逐个试代价很小。取置信度最高的组合。
+ */
+static wm_align wm_search(const wm_ctx *ctx, const wm_view *img, const wm_tables *t, thread_pool &pool) {
+    const int b = ctx->block;
+    const int rw = std::min(img->width, WM_SEARCH_SPAN), rh = std::min(img->height, WM_SEARCH_SPAN);
+    const int rx0 = (img->width - rw) / 2, ry0 = (img->height - rh) / 2;
+    std::vector<wm_align> best((size_t)b * b);
+    pool.parallel_for((size_t)b * b, [&](size_t i) {
+        const int ox = (int)(i % b), oy = (int)(i / b);
+        wm_align &r = best[i];
+        r.conf = -1;
+        r.ox = ox;
+        r.oy = oy;
+        r.tx = r.ty = 0;
+        const int bx0 = (rx0 - ox + b - 1) / b, bx1 = (rx0 + rw - ox) / b;
+        const int by0 = (ry0 - oy + b - 1) / b, by1 = (ry0 + rh - oy) / b;
+        if (bx1 <= bx0 || by1 <= by0) return;
+        std::vector<wm_acc> acc(1);
+        memset(&acc[0], 0, sizeof(wm_acc));
+        wm_scan(ctx, img, t, ox, oy, 0, 0, bx0, bx1, by0, by1, 1, &acc[0]);
+        for (int ty = 0; ty < WM_PERIOD; ty++) {
+            for (int tx = 0; tx < WM_PERIOD; tx++) {
+                float c = wm_decode(ctx, &acc[0], tx, ty, NULL, NULL);
+                if (c > r.conf) {
+                    r.conf = c;
+                    r.tx = tx;
+                    r.ty = ty;
+                }
+            }
+        }
+    });
+    wm_align a = best[0];
+    for (size_t i = 1; i < best.size(); i++) {
+        if (best[i].conf > a.conf) a = best[i];
+    }
+    return a;
+}
+
+int wm_extract(const wm_ctx *ctx, const uint8_t *pixels, int width, int height, int channels, size_t stride,
+               int search, thread_pool &pool, uint8_t *payload, wm_result *result) {
+    const int b = ctx->block;
+    if ((channels != 1 && channels != 3) || width < b || height < b) return -1;
+    wm_view img = {pixels, width, height, channels, stride};
+    wm_tables t;
+    wm_tables_init(&t, ctx, channels);
+    wm_align a = {0, 0, 0, 0, 0};
+    if (search) a = wm_search(ctx, &img, &t, pool);
+
+    // 整幅图按瓦片并行，各线程累计到自己的 wm_acc，最后相加
+    const int nbx = (width - a.ox) / b, nby = (height - a.oy) / b, tb = WM_TILE / b;
+    const int tiles_x = (nbx + tb - 1) / tb, tiles_y = (nby + tb - 1) / tb;
+    std::vector<wm_acc> acc(pool.size());
+    memset(acc.data(), 0, acc.size() * sizeof(wm_acc));
+    pool.parallel_for((size_t)tiles_x * tiles_y, [&](size_t tile, unsigned worker) {
+        const int by0 = (int)(tile / tiles_x) * tb, bx0 = (int)(tile % tiles_x) * tb;
+        wm_scan(ctx, &img, &t, a.ox, a.oy, a.tx, a.ty, bx0, std::min(bx0 + tb, nbx), by0, std::min(by0 + tb, nby),
+                0, &acc[worker]);
+    });
+    for (size_t w = 1; w < acc.size(); w++) {
+        for (int pos = 0; pos < WM_SLOTS; pos++) {
+            for (int k = 0; k < WM_PATTERNS; k++) acc[0].soft[pos][k] += acc[w].soft[pos][k];
+            acc[0].count[pos] += acc[w].count[pos];
+        }
+    }
+
+    float soft[WM_MAX_BITS];
+    size_t blocks;
+    float conf = wm_decode(ctx, &acc[0], a.tx, a.ty, soft, &blocks);
+    memset(payload, 0, (ctx->bits + 7) / 8);
+    for (size_t i = 0; i < ctx->bits; i++) {
+        if (soft[i] > 0) payload[i >> 3] |= (uint8_t)(0x80 >> (i & 7));
+    }
+    if (result) {
+        memset(result, 0, sizeof(*result));
+        memcpy(result->soft, soft, ctx->bits * sizeof(float));
+        result->confidence = conf;
+        result->blocks = blocks;
+        result->ox = a.ox;
+        result->oy = a.oy;
+        result->tx = a.tx;
+        result->ty = a.ty;
+    }
+    return 0;
+}
@@ -0,0 +1,78 @@
+#ifndef WM_H
+#define WM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+class thread_pool;
+
+/*
+ * 盲水印：亮度通道分块，在 DCT 中频系数上做扩频量化（STDM，spread-transform dither modulation）。
+ *   每块取 WM_COEFFS 个中频系数，按 ±1 扩频向量 w 投影成一个标量 p = <C, w> / |w|，
+ *   把 p 量化到比特对应的格点 Δ·Z + d + b·Δ/2 上，再把差值沿 w 方向加回各系数。
+ * DCT 正交，"DCT -> 改 K 个系数 -> IDCT" 等价于在像素域与一个预先算好的 B×B 模板 u 做内积、再加 (q - p)·u，
+ * 所以每块只有一次点积和一次 axpy，不用做完整的变换。
+ * WM_DWT_DCT 模式先做一层 Haar，在 LL 子带的 8×8 块上做同样的事；LL 系数是 2×2 像素和的一半，
+ * 模板同样可以折回像素域（每个 LL 系数展开成 2×2 个 u/2），块大小变成 16，对缩放、低通更稳。
+ * 块按 WM_PERIOD×WM_PERIOD 的周期排成槽位，每个槽位对应负载中的一个比特，整幅图重复嵌入，提取时按槽位软判决累加。
+ * 提取只需要密钥和参数，不需要原图；search 打开时先在图像中部搜索块网格与槽位周期的偏移，能对付裁剪。
+ * 槽位到比特的映射、每个槽位用哪个扩频向量、抖动 d 都由 SM3 KDF(域分隔串 || 密钥) 导出；
+ * 不给密钥时按空密钥导出，模式是公开的，只起同步作用。
+ * 图像按行切成 WM_TILE×WM_TILE 像素的瓦片交给线程池，嵌入与提取各是一遍流式处理。
+ */
+
+#define WM_MAX_BITS 256
+#define WM_COEFFS 8        // 每块参与扩频的中频系数
+#define WM_PATTERNS 8      // 可选的扩频向量个数
+#define WM_PERIOD 16       // 槽位周期（块），共 WM_PERIOD^2 = 256 个槽位
+#define WM_TILE 64         // 线程池任务粒度（像素）
+#define WM_SEARCH_SPAN 512 // 偏移搜索使用的中部区域边长（像素）
+#define WM_DEFAULT_STEP 32.0f
+
+enum wm_mode {
+    WM_DCT = 0,      // 亮度 8×8 DCT
+    WM_DWT_DCT = 1,  // 一层 Haar 后 LL 子带的 8×8 DCT（16×16 像素块）
+};
+
+struct wm_params {
+    int mode;            // wm_mode
+    float strength;      // 量化步长 Δ（投影值单位），越大越稳、PSNR 越低；0 取默认 WM_DEFAULT_STEP
+    size_t bits;         // 负载比特数，1..WM_MAX_BITS
+    const uint8_t *key;  // 可为 NULL
+    size_t key_len;
+};
+
+struct wm_ctx {
+    int mode;
+    int block;                                  // 块边长（像素）：8 或 16
+    size_t bits;
+    float step, dither;
+    uint16_t slot_bit[WM_PERIOD * WM_PERIOD];   // 槽位 -> 比特
+    uint8_t slot_pat[WM_PERIOD * WM_PERIOD];    // 槽位 -> 扩频向量
+    float pat[WM_PATTERNS][16 * 16];            // 像素域模板，block^2 个有效元素，单位范数
+};
+
+struct wm_result {
+    float soft[WM_MAX_BITS];   // 每个比特的平均软判决，(-1, 1)，正为 1
+    float confidence;          // soft 绝对值的平均：对齐且未受攻击时接近 1，没有水印时接近 0
+    size_t blocks;             // 参与判决的块数
+    int ox, oy;                // 块网格原点（像素）
+    int tx, ty;                // 槽位周期偏移（块）
+};
+
+// 参数不合法返回 -1
+int wm_init(wm_ctx *ctx, const wm_params *params);
+
+/*
+ * 图像为 8 位交错像素：channels 为 1（灰度）或 3（RGB），stride 为每行字节数。
+ * RGB 三个分量加同一个增量，亮度 Y = 0.299R + 0.587G + 0.114B 的变化就是这个增量，色度不变。
+ * payload 为 ceil(bits / 8) 字节，高位在前。不足一块的边缘不嵌入。
+ */
+int wm_embed(const wm_ctx *ctx, uint8_t *pixels, int width, int height, int channels, size_t stride,
+             const uint8_t *payload, thread_pool &pool);
+
+// 提取到 payload（ceil(bits / 8) 字节）；result 可为 NULL。图像小于一个块返回 -1
+int wm_extract(const wm_ctx *ctx, const uint8_t *pixels, int width, int height, int channels, size_t stride,
+               int search, thread_pool &pool, uint8_t *payload, wm_result *result);
+
+#endif // WM_H
@@ -0,0 +1,311 @@
+#include <math.h>
+#include <string.h>
+#include <vector>
+#include "wm_attack.h"
+
+static inline uint8_t clamp_u8(float v) {
+    return (uint8_t)(v < 0.0f ? 0 : (v > 255.0f ? 255 : (int)(v + 0.5f)));
+}
+
+static inline float luma_at(const wm_bitmap *bm, size_t i) {
+    const uint8_t *p = &bm->data[i * bm->channels];
+    return bm->channels == 1 ? p[0] : 0.299f * p[0] + 0.587f * p[1] + 0.114f * p[2];
+}
+
+static void same_shape(const wm_bitmap *in, wm_bitmap *out) {
+    out->width = in->width;
+    out->height = in->height;
+    out->channels = in->channels;
+    out->data.resize(in->data.size());
+}
+
+/* ===== JPEG ===== */
+
+// ITU-T T.81 附录 K 的量化表（按行排列，不是 zigzag 顺序）
+static const uint8_t JPEG_LUMA_Q[64] = {
+    16, 11, 10, 16, 24,  40,  51,  61,
+    12, 12, 14, 19, 26,  58,  60,  55,
+    14, 13, 16, 24, 40,  57,  69,  56,
+    14, 17, 22, 29, 51,  87,  80,  62,
+    18, 22, 37, 56, 68,  109, 103, 77,
+    24, 35, 55, 64, 81,  104, 113, 92,
+    49, 64, 78, 87, 103, 121, 120, 101,
+    72, 92, 95, 98, 112, 100, 103, 99,
+};
+
+static const uint8_t JPEG_CHROMA_Q[64] = {
+    17, 18, 24, 47, 99, 99, 99, 99,
+    18, 21, 26, 66, 99, 99, 99, 99,
+    24, 26, 56, 99, 99, 99, 99, 99,
+    47, 66, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,
+};
+
+// IJG 的质量缩放：50 为原表，低于 50 按 5000 / q 放大，高于 50 按 200 - 2q 缩小
+static void jpeg_table(const uint8_t *base, int quality, float *q) {
+    if (quality < 1) quality = 1;
+    if (quality > 100) quality = 100;
+    int scale = quality < 50 ? 5000 / quality : 200 - 2 * quality;
+    for (int i = 0; i < 64; i++) {
+        int v = (base[i] * scale + 50) / 100;
+        q[i] = (float)(v < 1 ? 1 : (v > 255 ? 255 : v));
+    }
+}
+
+struct jpeg_dct {
+    float c[8][8];   // c[u][x] = c(u) cos((2x + 1) u π / 16)
+    jpeg_dct() {
+        for (int u = 0; u < 8; u++) {
+            for (int x = 0; x < 8; x++) c[u][x] = (float)((u ? 0.5 : sqrt(0.125)) * cos((2 * x + 1) * u * M_PI / 16));
+        }
+    }
+};
+
+// 平面上 (x0, y0) 处的 8×8 块：电平平移、DCT、量化再反量化、IDCT，结果取整写回
+static void jpeg_block(const jpeg_dct *d, float *plane, size_t stride, const float *q) {
+    float x[8][8], t[8][8], f[8][8];
+    for (int i = 0; i < 8; i++) {
+        for (int j = 0; j < 8; j++) x[i][j] = plane[i * stride + j] - 128.0f;
+    }
+    for (int u = 0; u < 8; u++) {
+        for (int j = 0; j < 8; j++) {
+            float s = 0;
+            for (int i = 0; i < 8; i++) s += d->c[u][i] * x[i][j];
+            t[u][j] = s;
+        }
+    }
+    for (int u = 0; u < 8; u++) {
+        for (int v = 0; v < 8; v++) {
+            float s = 0;
+            for (int j = 0; j < 8; j++) s += t[u][j] * d->c[v][j];
+            f[u][v] = roundf(s / q[u * 8 + v]) * q[u * 8 + v];
+        }
+    }
+    for (int i = 0; i < 8; i++) {
+        for (int v = 0; v < 8; v++) {
+            float s = 0;
+            for (int u = 0; u < 8; u++) s += d->c[u][i] * f[u][v];
+            t[i][v] = s;
+        }
+    }
+    for (int i = 0; i < 8; i++) {
+        for (int j = 0; j < 8; j++) {
+            float s = 0;
+            for (int v = 0; v < 8; v++) s += t[i][v] * d->c[v][j];
+            plane[i * stride + j] = clamp_u8(s + 128.0f);
+        }
+    }
+}
+
+static void jpeg_plane(const jpeg_dct *d, std::vector<float> &plane, int w, int h, const float *q) {
+    for (int by = 0; by < h; by += 8) {
+        for (int bx = 0; bx < w; bx += 8) jpeg_block(d, &plane[(size_t)by * w + bx], (size_t)w, q);
+    }
+}
+
+void wm_attack_jpeg(const wm_bitmap *in, wm_bitmap *out, int quality) {
+    static const jpeg_dct d;
+    float qy[64], qc[64];
+    jpeg_table(JPEG_LUMA_Q, quality, qy);
+    jpeg_table(JPEG_CHROMA_Q, quality, qc);
+    const int w = in->width, h = in->height, ch = in->channels;
+    // MCU 为 16×16（4:2:0），右下按边缘像素补齐
+    const int pw = (w + 15) & ~15, ph = (h + 15) & ~15, cw = pw / 2, chh = ph / 2;
+    std::vector<float> y((size_t)pw * ph), cb, cr;
+    if (ch == 3) {
+        cb.assign((size_t)cw * chh, 0.0f);
+        cr.assign((size_t)cw * chh, 0.0f);
+    }
+    for (int py = 0; py < ph; py++) {
+        const int sy = py < h ? py : h - 1;
+        for (int px = 0; px < pw; px++) {
+            const int sx = px < w ? px : w - 1;
+            const uint8_t *p = &in->data[((size_t)sy * w + sx) * ch];
+            if (ch == 1) {
+                y[(size_t)py * pw + px] = p[0];
+                continue;
+            }
+            float r = p[0], g = p[1], b = p[2];
+            y[(size_t)py * pw + px] = (float)clamp_u8(0.299f * r + 0.587f * g + 0.114f * b);
+            size_t ci = (size_t)(py / 2) * cw + px / 2;
+            cb[ci] += 0.25f * (-0.168736f * r - 0.331264f * g + 0.5f * b + 128.0f);
+            cr[ci] += 0.25f * (0.5f * r - 0.418688f * g - 0.081312f * b + 128.0f);
+        }
+    }
+    for (size_t i = 0; i < cb.size(); i++) {
+        cb[i] = clamp_u8(cb[i]);
+        cr[i] = clamp_u8(cr[i]);
+    }
+    jpeg_plane(&d, y, pw, ph, qy);
+    if (ch == 3) {
+        jpeg_plane(&d, cb, cw, chh, qc);
+        jpeg_plane(&d, cr, cw, chh, qc);
+    }
+
+    same_shape(in, out);
+    for (int py = 0; py < h; py++) {
+        for (int px = 0; px < w; px++) {
+            uint8_t *o = &out->data[((size_t)py * w + px) * ch];
+            float yy = y[(size_t)py * pw + px];
+            if (ch == 1) {
+                o[0] = clamp_u8(yy);
+                continue;
+            }
+            size_t ci = (size_t)(py / 2) * cw + px / 2;
+            float u = cb[ci] - 128.0f, v = cr[ci] - 128.0f;
+            o[0] = clamp_u8(yy + 1.402f * v);
+            o[1] = clamp_u8(yy - 0.344136f * u - 0.714136f * v);
+            o[2] = clamp_u8(yy + 1.772f * u);
+        }
+    }
+}
+
+/* ===== 几何攻击 ===== */
+
+// 双线性取样，坐标超出范围时夹到边缘
+static inline void sample(const wm_bitmap *in, float fx, float fy, uint8_t *o) {
+    const int w = in->width, h = in->height, ch = in->channels;
+    fx = fx < 0 ? 0 : (fx > w - 1 ? (float)(w - 1) : fx);
+    fy = fy < 0 ? 0 : (fy > h - 1 ? (float)(h - 1) : fy);
+    int x0 = (int)fx, y0 = (int)fy;
+    int x1 = x0 + 1 < w ? x0 + 1 : x0, y1 = y0 + 1 < h ? y0 + 1 : y0;
+    float ax = fx - x0, ay = fy - y0;
+    const uint8_t *p00 = &in->data[((size_t)y0 * w + x0) * ch], *p01 = &in->data[((size_t)y0 * w + x1) * ch];
+    const uint8_t *p10 = &in->data[((size_t)y1 * w + x0) * ch], *p11 = &in->data[((size_t)y1 * w + x1) * ch];
+    for (int c = 0; c < ch; c++) {
+        float top = p00[c] + (p01[c] - p00[c]) * ax, bottom = p10[c] + (p11[c] - p10[c]) * ax;
+        o[c] = clamp_u8(top + (bottom - top) * ay);
+    }
+}
+
+static void resize(const wm_bitmap *in, wm_bitmap *out, int w, int h) {
+    out->width = w;
+    out->height = h;
+    out->channels = in->channels;
+    out->data.resize((size_t)w * h * in->channels);
+    const float sx = (float)in->width / w, sy = (float)in->height / h;
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            sample(in, (x + 0.5f) * sx - 0.5f, (y + 0.5f) * sy - 0.5f, &out->data[((size_t)y * w + x) * in->channels]);
+        }
+    }
+}
+
+void wm_attack_rotate(const wm_bitmap *in, wm_bitmap *out, double degrees) {
+    same_shape(in, out);
+    const float cx = (in->width - 1) / 2.0f, cy = (in->height - 1) / 2.0f;
+    const float cs = (float)cos(degrees * M_PI / 180), sn = (float)sin(degrees * M_PI / 180);
+    for (int y = 0; y < in->height; y++) {
+        for (int x = 0; x < in->width; x++) {
+            // 输出像素反转回原图坐标
+            float dx = x - cx, dy = y - cy;
+            sample(in, cx + cs * dx + sn * dy, cy - sn * dx + cs * dy,
+                   &out->data[((size_t)y * in->width + x) * in->channels]);
+        }
+    }
+}
+
+void wm_attack_scale(const wm_bitmap *in, wm_bitmap *out, double factor) {
+    wm_bitmap mid;
+    int w = (int)(in->width * factor + 0.5), h = (int)(in->height * factor + 0.5);
+    resize(in, &mid, w < 1 ? 1 : w, h < 1 ? 1 : h);
+    resize(&mid, out, in->width, in->height);
+}
+
+void wm_attack_crop(const wm_bitmap *in, wm_bitmap *out, double fraction) {
+    const int cut_x = (int)(in->width * fraction), cut_y = (int)(in->height * fraction);
+    const int x0 = (int)(cut_x * 0.6), y0 = (int)(cut_y * 0.6);
+    out->width = in->width - cut_x;
+    out->height = in->height - cut_y;
+    out->channels = in->channels;
+    out->data.resize((size_t)out->width * out->height * in->channels);
+    for (int y = 0; y < out->height; y++) {
+        memcpy(&out->data[(size_t)y * wm_bitmap_stride(out)],
+               &in->data[(size_t)(y0 + y) * wm_bitmap_stride(in) + (size_t)x0 * in->channels], wm_bitmap_stride(out));
+    }
+}
+
+/* ===== 像素值攻击 ===== */
+
+static inline uint64_t splitmix64(uint64_t *s) {
+    uint64_t z = (*s += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+void wm_attack_noise(const wm_bitmap *in, wm_bitmap *out, double sigma, uint32_t seed) {
+    same_shape(in, out);
+    uint64_t s = seed;
+    // Box-Muller 每次产生两个独立的正态样本
+    for (size_t i = 0; i < in->data.size(); i += 2) {
+        double u1 = ((splitmix64(&s) >> 11) + 1) * (1.0 / 9007199254740993.0);
+        double u2 = (splitmix64(&s) >> 11) * (1.0 / 9007199254740992.0);
+        double r = sigma * sqrt(-2 * log(u1));
+        out->data[i] = clamp_u8((float)(in->data[i] + r * cos(2 * M_PI * u2)));
+        if (i + 1 < in->data.size()) out->data[i + 1] = clamp_u8((float)(in->data[i + 1] + r * sin(2 * M_PI * u2)));
+    }
+}
+
+void wm_attack_contrast(const wm_bitmap *in, wm_bitmap *out, double factor) {
+    same_shape(in, out);
+    const size_t n = (size_t)in->width * in->height;
+    double sum = 0;
+    for (size_t i = 0; i < n; i++) {
+        const uint8_t *p = &in->data[i * in->channels];
+        // PIL 的 "L" 转换：L = R·299/1000 + G·587/1000 + B·114/1000
+        sum += in->channels == 1 ? p[0] : (p[0] * 299 + p[1] * 587 + p[2] * 114) / 1000;
+    }
+    const float mean = (float)(int)(sum / n + 0.5), f = (float)factor;
+    for (size_t i = 0; i < in->data.size(); i++) out->data[i] = clamp_u8(mean + f * (in->data[i] - mean));
+}
+
+/* ===== 指标 ===== */
+
+double wm_psnr(const wm_bitmap *a, const wm_bitmap *b) {
+    if (a->width != b->width || a->height != b->height || a->channels != b->channels) return NAN;
+    double se = 0;
+    for (size_t i = 0; i < a->data.size(); i++) {
+        double d = (double)a->data[i] - b->data[i];
+        se += d * d;
+    }
+    if (se == 0) return INFINITY;
+    return 10 * log10(255.0 * 255.0 * a->data.size() / se);
+}
+
+double wm_ssim(const wm_bitmap *a, const wm_bitmap *b) {
+    if (a->width != b->width || a->height != b->height || a->channels != b->channels) return NAN;
+    const int w = a->width, h = a->height;
+    if (w < 8 || h < 8) return NAN;
+    std::vector<float> la((size_t)w * h), lb((size_t)w * h);
+    for (size_t i = 0; i < la.size(); i++) {
+        la[i] = luma_at(a, i);
+        lb[i] = luma_at(b, i);
+    }
+    const double c1 = (0.01 * 255) * (0.01 * 255), c2 = (0.03 * 255) * (0.03 * 255);
+    double total = 0;
+    long windows = 0;
+    for (int y = 0; y + 8 <= h; y += 4) {
+        for (int x = 0; x + 8 <= w; x += 4) {
+            double sa = 0, sb = 0, saa = 0, sbb = 0, sab = 0;
+            for (int i = 0; i < 8; i++) {
+                const float *pa = &la[(size_t)(y + i) * w + x], *pb = &lb[(size_t)(y + i) * w + x];
+                for (int j = 0; j < 8; j++) {
+                    sa += pa[j];
+                    sb += pb[j];
+                    saa += (double)pa[j] * pa[j];
+                    sbb += (double)pb[j] * pb[j];
+                    sab += (double)pa[j] * pb[j];
+                }
+            }
+            const double ma = sa / 64, mb = sb / 64;
+            const double va = saa / 64 - ma * ma, vb = sbb / 64 - mb * mb, cov = sab / 64 - ma * mb;
+            total += ((2 * ma * mb + c1) * (2 * cov + c2)) / ((ma * ma + mb * mb + c1) * (va + vb + c2));
+            windows++;
+        }
+    }
+    return total / windows;
+}
@@ -0,0 +1,31 @@
+#ifndef WM_ATTACK_H
+#define WM_ATTACK_H
+
+#include <stdint.h>
+#include "wm_io.h"
+
+/*
+ * 鲁棒性测试用的图像攻击与质量指标，全部在内存里完成，不落盘。
+ * 每个函数只读 in、写 out（大小可能变化），单线程，可以在不同线程上同时处理不同的图。
+ */
+
+// JPEG 的有损部分：JFIF YCbCr、4:2:0 色度下采样、8×8 DCT、按 IJG 质量系数缩放的标准量化表，再按解码器的顺序还原。
+// 熵编码是无损的，省掉之后像素结果与真正编解码一致（上采样用复制，不做平滑）
+void wm_attack_jpeg(const wm_bitmap *in, wm_bitmap *out, int quality);
+// 绕中心旋转 degrees 度，双线性插值，尺寸不变，超出原图的地方取最近的边缘像素
+void wm_attack_rotate(const wm_bitmap *in, wm_bitmap *out, double degrees);
+// 双线性缩放到 factor 倍再缩放回原尺寸（检测端按已知尺寸归一化的情形）
+void wm_attack_scale(const wm_bitmap *in, wm_bitmap *out, double factor);
+// 四边共裁掉 fraction 的宽和高：左上各裁 fraction * 0.6，右下裁其余，偏移一般不与块网格对齐
+void wm_attack_crop(const wm_bitmap *in, wm_bitmap *out, double fraction);
+// 加标准差 sigma 的高斯噪声，各通道独立，由 seed 决定
+void wm_attack_noise(const wm_bitmap *in, wm_bitmap *out, double sigma, uint32_t seed);
+// 与 PIL ImageEnhance.Contrast 相同：以灰度均值为中心把各分量拉伸 factor 倍
+void wm_attack_contrast(const wm_bitmap *in, wm_bitmap *out, double factor);
+
+// 尺寸或通道数不同返回 NAN；完全相同时返回 INFINITY
+double wm_psnr(const wm_bitmap *a, const wm_bitmap *b);
+// 亮度上的平均 SSIM：8×8 窗口、步长 4，C1 = (0.01·255)^2，C2 = (0.03·255)^2；尺寸不同返回 NAN
+double wm_ssim(const wm_bitmap *a, const wm_bitmap *b);
+
+#endif // WM_ATTACK_H
@@ -0,0 +1,109 @@
+#include <stdio.h>
+#include <ctype.h>
+#include <math.h>
+#include "wm_io.h"
+
+// 读一个头部整数，跳过空白与 # 注释
+static int wm_pnm_int(FILE *f, int *v) {
+    int c = fgetc(f);
+    for (;;) {
+        while (c != EOF && isspace(c)) c = fgetc(f);
+        if (c != '#') break;
+        while (c != EOF && c != '\n') c = fgetc(f);
+    }
+    if (c == EOF || !isdigit(c)) return -1;
+    long x = 0;
+    while (c != EOF && isdigit(c)) {
+        x = x * 10 + (c - '0');
+        if (x > (1 << 20)) return -1;
+        c = fgetc(f);
+    }
+    // 最后一个头部字段之后恰好一个空白字符，随后是像素
+    if (c != EOF && !isspace(c)) return -1;
+    *v = (int)x;
+    return 0;
+}
+
+// 单幅图的像素上限（2^28，RGB 约 768MB），宽高各自的上限是 2^20
+static const size_t WM_PNM_MAX_PIXELS = (size_t)1 << 28;
+
+// 像素数据从当前位置到文件尾至少要有 need 字节；不能 seek 的输入（管道）只靠像素上限
+static int wm_pnm_room(FILE *f, size_t need) {
+    long pos = ftell(f);
+    if (pos < 0 || fseek(f, 0, SEEK_END) != 0) return 0;
+    long end = ftell(f);
+    if (fseek(f, pos, SEEK_SET) != 0) return -1;
+    return end >= pos && (unsigned long)(end - pos) >= need ? 0 : -1;
+}
+
+int wm_bitmap_load(wm_bitmap *bm, const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return -1;
+    int rc = -1, maxval;
+    char magic[2];
+    if (fread(magic, 1, 2, f) == 2 && magic[0] == 'P' && (magic[1] == '5' || magic[1] == '6') &&
+        wm_pnm_int(f, &bm->width) == 0 && wm_pnm_int(f, &bm->height) == 0 && wm_pnm_int(f, &maxval) == 0 &&
+        bm->width > 0 && bm->height > 0 && maxval == 255 &&
+        (size_t)bm->width * (size_t)bm->height <= WM_PNM_MAX_PIXELS) {
+        bm->channels = magic[1] == '6' ? 3 : 1;
+        // 先确认文件里真有这么多像素再分配，截断或伪造的头不会触发大块分配
+        size_t need = (size_t)bm->height * wm_bitmap_stride(bm);
+        if (wm_pnm_room(f, need) == 0) {
+            bm->data.resize(need);
+            if (fread(bm->data.data(), 1, need, f) == need) rc = 0;
+        }
+    }
+    fclose(f);
+    return rc;
+}
+
+int wm_bitmap_save(const wm_bitmap *bm, const char *path) {
+    if (bm->channels != 1 && bm->channels != 3) return -1;
+    FILE *f = fopen(path, "wb");
+    if (!f) return -1;
+    fprintf(f, "P%c\n%d %d\n255\n", bm->channels == 3 ? '6' : '5', bm->width, bm->height);
+    int rc = fwrite(bm->data.data(), 1, bm->data.size(), f) == bm->data.size() ? 0 : -1;
+    if (fclose(f) != 0) rc = -1;
+    return rc;
+}
+
+static inline uint32_t wm_mix(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352dU;
+    x ^= x >> 15;
+    x *= 0x846ca68bU;
+    x ^= x >> 16;
+    return x;
+}
+
+// 每 16 像素一个格点的值噪声，双线性插值，范围 [-1, 1]
+static float wm_value_noise(int x, int y, uint32_t seed) {
+    int gx = x >> 4, gy = y >> 4;
+    float fx = (x & 15) / 16.0f, fy = (y & 15) / 16.0f;
+    float v[4];
+    for (int i = 0; i < 4; i++) {
+        uint32_t h = wm_mix(seed ^ wm_mix((uint32_t)(gx + (i & 1)) * 0x9e3779b9U ^ (uint32_t)(gy + (i >> 1))));
+        v[i] = h / 2147483648.0f - 1.0f;
+    }
+    float top = v[0] + (v[1] - v[0]) * fx, bottom = v[2] + (v[3] - v[2]) * fx;
+    return top + (bottom - top) * fy;
+}
+
+void wm_bitmap_synthetic(wm_bitmap *bm, int width, int height, int channels, uint32_t seed) {
+    bm->width = width;
+    bm->height = height;
+    bm->channels = channels;
+    bm->data.resize((size_t)height * wm_bitmap_stride(bm));
+    for (int y = 0; y < height; y++) {
+        uint8_t *row = &bm->data[(size_t)y * wm_bitmap_stride(bm)];
+        for (int x = 0; x < width; x++) {
+            float base = 60.0f * sinf(x / 37.0f) * cosf(y / 53.0f) + 35.0f * sinf((x + 2 * y) / 91.0f) +
+                         30.0f * wm_value_noise(x, y, seed);
+            for (int c = 0; c < channels; c++) {
+                float v = 128.0f + base + 20.0f * sinf((x - y) / (29.0f + 11 * c)) +
+                          4.0f * (wm_mix((seed + 0x51ed27U * (uint32_t)c) ^ (uint32_t)(y * width + x)) / 2147483648.0f - 1.0f);
+                row[x * channels + c] = (uint8_t)(v < 0 ? 0 : (v > 255 ? 255 : (int)(v + 0.5f)));
+            }
+        }
+    }
+}
@@ -0,0 +1,28 @@
+#ifndef WM_IO_H
+#define WM_IO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+/*
+ * 图像读写：二进制 PGM（P5，灰度）与 PPM（P6，RGB），最大值 255。
+ * 不依赖图像库；PNG / JPEG 先转换，例如 convert a.png a.ppm。
+ */
+
+struct wm_bitmap {
+    int width, height, channels;   // channels 为 1 或 3
+    std::vector<uint8_t> data;     // 逐行紧密排列，每行 width * channels 字节
+};
+
+// 格式不支持或文件不完整返回 -1
+int wm_bitmap_load(wm_bitmap *bm, const char *path);
+// channels 为 1 写 P5，为 3 写 P6
+int wm_bitmap_save(const wm_bitmap *bm, const char *path);
+
+// 自检与基准用的合成图：几组低频正弦叠加平滑噪声与少量细噪声，近似自然图像的频谱；由 seed 决定
+void wm_bitmap_synthetic(wm_bitmap *bm, int width, int height, int channels, uint32_t seed);
+
+static inline size_t wm_bitmap_stride(const wm_bitmap *bm) { return (size_t)bm->width * bm->channels; }
+
+#endif // WM_IO_H
@@ -97,9 +97,9 @@ void sm3_one_block(uint32_t *hash, const uint32_t *block) {
 }
 
 // 完整的SM3哈希计算函数
-void sm3_get_hash(uint32_t *src, uint32_t *hash, uint32_t len) {
+void sm3_get_hash(uint32_t *src, uint32_t *hash, uint64_t len) {
     uint8_t last_block[64] = {0};  // 存储最后一个数据块
-    uint32_t i = 0;
+    uint64_t i = 0;  // 64 位长度，超过 512MB 时比特长度不再溢出
     
     // 初始化哈希值为IV
     for (i = 0; i < 8; i++) {
@@ -109,11 +109,11 @@ void sm3_get_hash(uint32_t *src, uint32_t *hash, uint32_t len) {
     // 处理完整的数据块
     for (i = 0; i < len; i = i + 64) {
         if (len - i < 64) break;  // 剩余数据不足一个完整块
-        sm3_one_block(hash, src + i);  // 处理单个块
+        sm3_one_block(hash, src + i / 4);  // 处理单个块（src 按字寻址）
     }
     
     // 处理最后一个不完整的数据块
-    uint32_t last_block_len = len - i;
+    uint32_t last_block_len = (uint32_t)(len - i);
     uint32_t word_len = ((last_block_len + 3) >> 2) << 2;  // 对齐到4字节边界
     uint32_t last_word_len = last_block_len & 3;  // 最后一个字中的字节数
     
@@ -145,8 +145,12 @@ void sm3_get_hash(uint32_t *src, uint32_t *hash, uint32_t len) {
     // 处理填充和消息长度
     if (last_block_len < 56) {
         // 情况1: 当前块有足够空间添加长度信息
-        uint32_t bit_len = len << 3;  // 计算消息的比特长度
+        uint64_t bit_len = len << 3;  // 计算消息的比特长度
         // 在块末尾添加64位长度信息（大端序）
+        last_block[59] = (bit_len >> 56) & 0xff;
+        last_block[58] = (bit_len >> 48) & 0xff;
+        last_block[57] = (bit_len >> 40) & 0xff;
+        last_block[56] = (bit_len >> 32) & 0xff;
         last_block[63] = (bit_len >> 24) & 0xff;
         last_block[62] = (bit_len >> 16) & 0xff;
         last_block[61] = (bit_len >> 8) & 0xff;
@@ -156,8 +160,12 @@ void sm3_get_hash(uint32_t *src, uint32_t *hash, uint32_t len) {
         // 情况2: 需要额外的块存放长度信息
         sm3_one_block(hash, (uint32_t *) last_block);
         unsigned char lblock[64] = {0};
-        uint32_t bit_len = len << 3;  // 计算消息的比特长度
+        uint64_t bit_len = len << 3;  // 计算消息的比特长度
         // 在第二个填充块中添加长度信息
+        lblock[59] = (bit_len >> 56) & 0xff;
+        lblock[58] = (bit_len >> 48) & 0xff;
+        lblock[57] = (bit_len >> 40) & 0xff;
+        lblock[56] = (bit_len >> 32) & 0xff;
         lblock[63] = (bit_len >> 24) & 0xff;
         lblock[62] = (bit_len >> 16) & 0xff;
         lblock[61] = (bit_len >> 8) & 0xff;
@@ -0,0 +1,65 @@
+#include <stdint.h>
+#include <string.h>
+#include "sm3_promax.h"
+#include "sm3_rounds.h"
+
+/*
+ * 全展开的 SM3 压缩函数（标量）
+ * 轮函数见 sm3_rounds.h；消息扩展按需计算，只保留 16 字的滚动窗口，不再存 132 个字
+ */
+
+namespace {
+
+inline uint32_t load_be32(const uint8_t *p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+#if defined(_MSC_VER)
+    return _byteswap_ulong(v);
+#else
+    return __builtin_bswap32(v);
+#endif
+}
+
+// W 是 16 字滚动窗口：W[i & 15] 在第 i-4 轮算出，覆盖已经不再需要的 W[i-16]
+template <int I>
+inline void sm3_expand(uint32_t *W) {
+    uint32_t t = W[(I - 16) & 15] ^ W[(I - 9) & 15] ^ rl(W[(I - 3) & 15], 15);
+    W[I & 15] = p1(t) ^ rl(W[(I - 13) & 15], 7) ^ W[(I - 6) & 15];
+}
+
+// 第 12 轮起每轮顺带算出 W[J + 4]，前 12 轮实例化为空函数
+template <int J, bool NEED = (J >= 12)>
+struct sm3_sched {
+    static inline void run(uint32_t *) {}
+};
+
+template <int J>
+struct sm3_sched<J, true> {
+    static inline void run(uint32_t *W) { sm3_expand<J + 4>(W); }
+};
+
+template <int J>
+inline void sm3_step(uint32_t A, uint32_t &B, uint32_t C, uint32_t &D,
+                     uint32_t E, uint32_t &F, uint32_t G, uint32_t &H, uint32_t *W) {
+    sm3_sched<J>::run(W);
+    sm3_round<J>(A, B, C, D, E, F, G, H, W[J & 15], W[J & 15] ^ W[(J + 4) & 15]);
+}
+
+} // namespace
+
+void sm3_compress_unrolled(uint32_t *hash, const uint8_t *data, size_t nblocks) {
+    uint32_t A = hash[0], B = hash[1], C = hash[2], D = hash[3];
+    uint32_t E = hash[4], F = hash[5], G = hash[6], H = hash[7];
+
+    for (; nblocks > 0; nblocks--, data += 64) {
+        uint32_t W[16];
+        for (int i = 0; i < 16; i++) {
+            W[i] = load_be32(data + i * 4);
+        }
+
+        SM3_ROUNDS_64(sm3_step, W);
+
+        A = hash[0] ^= A; B = hash[1] ^= B; C = hash[2] ^= C; D = hash[3] ^= D;
+        E = hash[4] ^= E; F = hash[5] ^= F; G = hash[6] ^= G; H = hash[7] ^= H;
+    }
+}
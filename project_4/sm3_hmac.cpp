@@ -0,0 +1,211 @@
+#include <stdint.h>
+#include <string.h>
+#include "sm3_promax.h"
+#include "sm3_mb_lanes.h"
+
+/*
+ * HMAC-SM3 与 SM2 KDF
+ * HMAC 的内层从 istate 继续、外层从 ostate 继续，两者之前都已压缩过一个 64 字节块，
+ * 填充里的总长度要把这 64 字节算进去。批量接口按 SM3_HMAC_CHUNK 条一组交给多缓冲内核。
+ */
+
+#define SM3_HMAC_CHUNK 64
+
+static inline void sm3_store_digest(uint8_t out[32], const uint32_t h[8]) {
+    for (int i = 0; i < 8; i++) {
+        out[4 * i]     = (uint8_t)(h[i] >> 24);
+        out[4 * i + 1] = (uint8_t)(h[i] >> 16);
+        out[4 * i + 2] = (uint8_t)(h[i] >> 8);
+        out[4 * i + 3] = (uint8_t)h[i];
+    }
+}
+
+// 清除栈上的密钥材料，volatile 防止被优化掉
+static void sm3_wipe(void *p, size_t len) {
+    volatile uint8_t *v = (volatile uint8_t *)p;
+    while (len--) *v++ = 0;
+}
+
+void sm3_hmac_key_init(sm3_hmac_key *key, const uint8_t *k, size_t k_len) {
+    uint8_t block[64];
+    memset(block, 0, sizeof(block));
+    if (k_len > 64) {
+        uint32_t h[8];
+        sm3_hash(k, k_len, h);
+        sm3_store_digest(block, h);
+        sm3_wipe(h, sizeof(h));
+    } else if (k_len > 0) {
+        memcpy(block, k, k_len);
+    }
+
+    for (int i = 0; i < 64; i++) block[i] ^= 0x36;
+    memcpy(key->istate, SM3_IV, sizeof(key->istate));
+    sm3_compress_blocks(key->istate, block, 1);
+
+    for (int i = 0; i < 64; i++) block[i] ^= 0x36 ^ 0x5c;
+    memcpy(key->ostate, SM3_IV, sizeof(key->ostate));
+    sm3_compress_blocks(key->ostate, block, 1);
+
+    sm3_wipe(block, sizeof(block));
+}
+
+// 外层：ostate 之后只剩内层摘要这 32 字节，填充后正好一块（总长 96 字节）
+static void sm3_hmac_outer(const uint32_t ostate[8], const uint32_t inner[8], uint8_t mac[32]) {
+    uint8_t digest[32], block[128];
+    uint32_t h[8];
+    sm3_store_digest(digest, inner);
+    size_t nb = sm3_pad_tail(digest, 64 + 32, block);
+    memcpy(h, ostate, sizeof(h));
+    sm3_compress_blocks(h, block, nb);
+    sm3_store_digest(mac, h);
+}
+
+void sm3_hmac_init(sm3_hmac_ctx *ctx, const sm3_hmac_key *key) {
+    memcpy(ctx->inner.hash, key->istate, sizeof(key->istate));
+    ctx->inner.total = 64;
+    ctx->inner.buf_len = 0;
+    memcpy(ctx->ostate, key->ostate, sizeof(key->ostate));
+}
+
+void sm3_hmac_update(sm3_hmac_ctx *ctx, const uint8_t *data, size_t len) {
+    sm3_update(&ctx->inner, data, len);
+}
+
+void sm3_hmac_final(sm3_hmac_ctx *ctx, uint8_t mac[32]) {
+    uint32_t inner[8];
+    sm3_final(&ctx->inner, inner);
+    sm3_hmac_outer(ctx->ostate, inner, mac);
+}
+
+void sm3_hmac(const sm3_hmac_key *key, const uint8_t *data, size_t len, uint8_t mac[32]) {
+    sm3_hmac_ctx ctx;
+    sm3_hmac_init(&ctx, key);
+    sm3_hmac_update(&ctx, data, len);
+    sm3_hmac_final(&ctx, mac);
+}
+
+void sm3_hmac_many(const sm3_hmac_key *const *keys, const uint8_t *const *msgs,
+                   const size_t *lens, uint8_t (*macs)[32], size_t n) {
+    const uint32_t *init[SM3_HMAC_CHUNK];
+    const uint8_t *outer_msgs[SM3_HMAC_CHUNK];
+    uint64_t prefix[SM3_HMAC_CHUNK];
+    size_t outer_lens[SM3_HMAC_CHUNK];
+    uint8_t digests[SM3_HMAC_CHUNK][32];
+    uint32_t h[SM3_HMAC_CHUNK][8];
+
+    for (size_t base = 0; base < n; base += SM3_HMAC_CHUNK) {
+        size_t m = n - base < SM3_HMAC_CHUNK ? n - base : SM3_HMAC_CHUNK;
+
+        // 内层：各消息从各自密钥的 istate 开始
+        for (size_t i = 0; i < m; i++) {
+            init[i] = keys[base + i]->istate;
+            prefix[i] = 64;
+        }
+        sm3_hash_many_from(msgs + base, lens + base, init, prefix, h, m);
+
+        // 外层：32 字节内层摘要，从 ostate 开始
+        for (size_t i = 0; i < m; i++) {
+            sm3_store_digest(digests[i], h[i]);
+            outer_msgs[i] = digests[i];
+            outer_lens[i] = 32;
+            init[i] = keys[base + i]->ostate;
+        }
+        sm3_hash_many_from(outer_msgs, outer_lens, init, prefix, h, m);
+
+        for (size_t i = 0; i < m; i++) sm3_store_digest(macs[base + i], h[i]);
+    }
+}
+
+int sm3_ct_equal(const uint8_t *a, const uint8_t *b, size_t len) {
+    uint32_t diff = 0;
+    for (size_t i = 0; i < len; i++) diff |= (uint32_t)(a[i] ^ b[i]);
+    return (int)(((diff - 1) >> 8) & 1);
+}
+
+size_t sm3_hmac_verify_many(const sm3_hmac_key *const *keys, const uint8_t *const *msgs,
+                            const size_t *lens, const uint8_t *const *tags, size_t tag_len,
+                            int *ok, size_t n) {
+    uint8_t macs[SM3_HMAC_CHUNK][32];
+    size_t passed = 0;
+    if (tag_len == 0 || tag_len > 32) {
+        for (size_t i = 0; i < n; i++) ok[i] = 0;
+        return 0;
+    }
+    for (size_t base = 0; base < n; base += SM3_HMAC_CHUNK) {
+        size_t m = n - base < SM3_HMAC_CHUNK ? n - base : SM3_HMAC_CHUNK;
+        sm3_hmac_many(keys + base, msgs + base, lens + base, macs, m);
+        for (size_t i = 0; i < m; i++) {
+            ok[base + i] = sm3_ct_equal(macs[i], tags[base + i], tag_len);
+            passed += (size_t)ok[base + i];
+        }
+    }
+    sm3_wipe(macs, sizeof(macs));
+    return passed;
+}
+
+/*
+ * KDF：每个 (输入, 计数器) 是一条独立消息 Z || ct。Z 的完整块先压缩成中间状态，
+ * 多缓冲内核只处理 Z 的尾巴加 4 字节计数器（1~2 块）。
+ * 一个输入的计数器跨两组时，在新的一组里重新压缩一次它的完整块。
+ */
+void sm3_kdf_many(const uint8_t *const *z, const size_t *z_lens,
+                  uint8_t *const *out, size_t klen, size_t n) {
+    uint8_t bufs[SM3_HMAC_CHUNK][64 + 4];
+    uint32_t states[SM3_HMAC_CHUNK][8];
+    uint32_t h[SM3_HMAC_CHUNK][8];
+    const uint32_t *init[SM3_HMAC_CHUNK];
+    const uint8_t *msgs[SM3_HMAC_CHUNK];
+    uint64_t prefix[SM3_HMAC_CHUNK];
+    size_t lens[SM3_HMAC_CHUNK], owner[SM3_HMAC_CHUNK], ctr[SM3_HMAC_CHUNK];
+    size_t per = (klen + 31) / 32;
+    size_t in = 0, c = 0;
+
+    if (klen == 0) return;
+    while (in < n) {
+        size_t m = 0, ns = 0;
+        size_t state_for = (size_t)-1;
+        while (m < SM3_HMAC_CHUNK && in < n) {
+            size_t full = z_lens[in] / 64, tail = z_lens[in] % 64;
+            if (state_for != in) {
+                memcpy(states[ns], SM3_IV, sizeof(states[ns]));
+                sm3_compress_blocks(states[ns], z[in], full);
+                ns++;
+                state_for = in;
+            }
+            uint32_t ct = (uint32_t)(c + 1);
+            memcpy(bufs[m], z[in] + full * 64, tail);
+            bufs[m][tail]     = (uint8_t)(ct >> 24);
+            bufs[m][tail + 1] = (uint8_t)(ct >> 16);
+            bufs[m][tail + 2] = (uint8_t)(ct >> 8);
+            bufs[m][tail + 3] = (uint8_t)ct;
+            msgs[m] = bufs[m];
+            lens[m] = tail + 4;
+            init[m] = states[ns - 1];
+            prefix[m] = (uint64_t)full * 64;
+            owner[m] = in;
+            ctr[m] = c;
+            m++;
+            if (++c == per) {
+                c = 0;
+                in++;
+            }
+        }
+
+        sm3_hash_many_from(msgs, lens, init, prefix, h, m);
+
+        for (size_t i = 0; i < m; i++) {
+            uint8_t digest[32];
+            size_t off = ctr[i] * 32;
+            size_t take = klen - off < 32 ? klen - off : 32;
+            sm3_store_digest(digest, h[i]);
+            memcpy(out[owner[i]] + off, digest, take);
+        }
+    }
+    sm3_wipe(bufs, sizeof(bufs));
+    sm3_wipe(states, sizeof(states));
+    sm3_wipe(h, sizeof(h));
+}
+
+void sm3_kdf(const uint8_t *z, size_t z_len, uint8_t *out, size_t klen) {
+    sm3_kdf_many(&z, &z_len, &out, klen, 1);
+}
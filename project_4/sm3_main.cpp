@@ -0,0 +1,366 @@
+// SM3 测试程序
+// 编译：g++ -O2 sm3_main.cpp sm3_promax.cpp sm3_fast.cpp sm3_simd_ssse3.cpp sm3_simd_avx2.cpp sm3_mb.cpp sm3_mb_ssse3.cpp sm3_mb_avx2.cpp sm3_mb_avx512.cpp sm3_tree.cpp sm3_hmac.cpp sm3_merkle.cpp -o sm3_promax -lpthread
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>    // 添加clock_t和clock()所需头文件
+#include <stdlib.h>  // 添加malloc和free所需头文件
+#include "sm3_promax.h"
+
+// 测试函数
+void test_case(const char *test_name, const uint8_t *data, size_t len) {
+    uint32_t hash[8];
+    
+    // 计时开始
+    clock_t start = clock();
+    sm3_hash(data, len, hash);
+    clock_t end = clock();
+    
+    printf("%s: ", test_name);
+    for (int i = 0; i < 8; i++) {
+        printf("%08x ", hash[i]);
+    }
+    printf("\nTime: %.2f ms\n", (double)(end - start) * 1000 / CLOCKS_PER_SEC);
+}
+
+// 流式接口测试：按不规则分片输入，结果应与一次性计算相同
+void test_streaming(const uint8_t *data, size_t len) {
+    uint32_t ref[8], out[8];
+    sm3_hash(data, len, ref);
+
+    sm3_ctx ctx;
+    sm3_init(&ctx);
+    size_t off = 0, step = 1;
+    while (off < len) {
+        size_t n = (len - off < step) ? len - off : step;
+        sm3_update(&ctx, data + off, n);
+        off += n;
+        step = step * 3 + 1;
+        if (step > 100000) step = 1;
+    }
+    sm3_final(&ctx, out);
+    printf("Streaming (%zu bytes): %s\n", len, memcmp(out, ref, sizeof(ref)) == 0 ? "OK" : "MISMATCH");
+
+    // 超过 512MB 的长度：比特长度需要 64 位
+    uint8_t pad[128];
+    uint64_t big = (uint64_t)600 * 1024 * 1024;
+    sm3_pad_tail(NULL, big, pad);
+    uint64_t bits = 0;
+    for (int i = 56; i < 64; i++) bits = (bits << 8) | pad[i];
+    printf("Length field (600MB): %s\n", bits == big * 8 ? "OK" : "OVERFLOW");
+}
+
+// 树模式测试：不同线程数结果一致，且与标准摘要不同
+void test_tree() {
+    size_t len = 16 * 1024 * 1024 + 123;
+    uint8_t *data = (uint8_t *)malloc(len);
+    if (!data) return;
+    for (size_t i = 0; i < len; i++) data[i] = (uint8_t)(i * 131 + (i >> 12));
+
+    uint32_t plain[8];
+    clock_t start = clock();
+    sm3_hash(data, len, plain);
+    double base = (double)(clock() - start) / CLOCKS_PER_SEC;
+    printf("Tree mode (16MB): sm3_hash %.2f ms\n", base * 1000);
+
+    sm3_tree_params params;
+    sm3_tree_default_params(&params);
+    uint32_t first[8];
+    unsigned threads[] = {1, 2, 4, 0};
+    for (int t = 0; t < 4; t++) {
+        uint32_t h[8];
+        params.threads = threads[t];
+        // clock() 统计的是进程 CPU 时间，多线程下用墙钟时间
+        struct timespec a, b;
+        timespec_get(&a, TIME_UTC);
+        sm3_tree_hash(data, len, &params, h);
+        timespec_get(&b, TIME_UTC);
+        double ms = (b.tv_sec - a.tv_sec) * 1e3 + (b.tv_nsec - a.tv_nsec) / 1e6;
+        if (t == 0) memcpy(first, h, sizeof(h));
+        printf("  threads=%u: %08x %08x ... %.2f ms %s\n", threads[t], h[0], h[1], ms,
+               memcmp(h, first, sizeof(h)) == 0 ? "OK" : "MISMATCH");
+    }
+    printf("  differs from sm3_hash: %s\n", memcmp(first, plain, sizeof(plain)) ? "OK" : "NO");
+    free(data);
+}
+
+// 多缓冲测试：随机长度的消息逐一与 sm3_hash 比对，并比较吞吐
+void test_multi_buffer() {
+    const size_t n = 4096;
+    const uint8_t **msgs = (const uint8_t **)malloc(n * sizeof(*msgs));
+    size_t *lens = (size_t *)malloc(n * sizeof(*lens));
+    uint32_t (*ref)[8] = (uint32_t (*)[8])malloc(n * sizeof(*ref));
+    uint32_t (*out)[8] = (uint32_t (*)[8])malloc(n * sizeof(*out));
+    uint8_t *pool = (uint8_t *)malloc(n * 4096);
+    if (!msgs || !lens || !ref || !out || !pool) {
+        free(msgs); free(lens); free(ref); free(out); free(pool);
+        return;
+    }
+
+    srand(12345);
+    size_t total = 0;
+    for (size_t i = 0; i < n; i++) {
+        lens[i] = (i < 130) ? i : (64 + rand() % (4096 - 64 + 1)); // 覆盖 0..129 字节的所有填充情况
+        msgs[i] = pool + i * 4096;
+        for (size_t k = 0; k < lens[i]; k++) pool[i * 4096 + k] = (uint8_t)rand();
+        total += lens[i];
+    }
+
+    clock_t start = clock();
+    for (size_t i = 0; i < n; i++) sm3_hash(msgs[i], lens[i], ref[i]);
+    double base = (double)(clock() - start) / CLOCKS_PER_SEC;
+    printf("Multi-buffer (%zu msgs, %.1f MB): single %.2f ms\n", n, total / 1e6, base * 1000);
+
+    for (int isa = SM3_MB_SCALAR; isa <= SM3_MB_AVX512; isa++) {
+        if (!sm3_mb_isa_supported((sm3_mb_isa)isa)) continue;
+        memset(out, 0, n * sizeof(*out));
+        start = clock();
+        sm3_hash_many_isa((sm3_mb_isa)isa, msgs, lens, out, n);
+        double t = (double)(clock() - start) / CLOCKS_PER_SEC;
+        int ok = memcmp(out, ref, n * sizeof(*out)) == 0;
+        printf("  %-10s %8.2f ms  %s\n", sm3_mb_isa_name((sm3_mb_isa)isa), t * 1000,
+               ok ? "OK" : "MISMATCH");
+    }
+
+    // 固定宽度接口
+    uint32_t x8[8][8];
+    sm3_hash_x8(msgs, lens, x8);
+    printf("  sm3_hash_x8: %s\n", memcmp(x8, ref, sizeof(x8)) == 0 ? "OK" : "MISMATCH");
+
+    free(msgs); free(lens); free(ref); free(out); free(pool);
+}
+
+static int hex_equal(const uint8_t *bytes, const char *hex, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        unsigned v;
+        if (sscanf(hex + 2 * i, "%2x", &v) != 1 || bytes[i] != v) return 0;
+    }
+    return 1;
+}
+
+// HMAC / KDF 测试：已知向量、批量与逐条一致、批量校验能找出被篡改的标签
+void test_hmac_kdf() {
+    const char *fox = "The quick brown fox jumps over the lazy dog";
+    uint8_t mac[32];
+    sm3_hmac_key key;
+    sm3_hmac_key_init(&key, (const uint8_t *)"key", 3);
+    sm3_hmac(&key, (const uint8_t *)fox, strlen(fox), mac);
+    printf("HMAC-SM3 vector: %s\n",
+           hex_equal(mac, "bd4a34077888162b210645b8ebf74b9af357303789357a27c7fc457244ebd398", 32) ? "OK" : "MISMATCH");
+
+    // 长于一个块的密钥先做哈希
+    uint8_t longKey[100], abc[150];
+    for (int i = 0; i < 100; i++) longKey[i] = (uint8_t)(i * 7);
+    for (int i = 0; i < 150; i++) abc[i] = (uint8_t)("abc"[i % 3]);
+    sm3_hmac_key_init(&key, longKey, sizeof(longKey));
+    sm3_hmac(&key, abc, sizeof(abc), mac);
+    printf("HMAC-SM3 long key: %s\n",
+           hex_equal(mac, "059b20e1502e64d9d58a7d3f69159624c2e912798f783feabfebb2147509b428", 32) ? "OK" : "MISMATCH");
+
+    // 批量：4 个密钥轮流使用，消息长度覆盖各种填充情况
+    const size_t n = 16384;
+    sm3_hmac_key keys[4];
+    const sm3_hmac_key **kp = (const sm3_hmac_key **)malloc(n * sizeof(*kp));
+    const uint8_t **msgs = (const uint8_t **)malloc(n * sizeof(*msgs));
+    const uint8_t **tags = (const uint8_t **)malloc(n * sizeof(*tags));
+    size_t *lens = (size_t *)malloc(n * sizeof(*lens));
+    uint8_t (*ref)[32] = (uint8_t (*)[32])malloc(n * sizeof(*ref));
+    uint8_t (*out)[32] = (uint8_t (*)[32])malloc(n * sizeof(*out));
+    int *ok = (int *)malloc(n * sizeof(*ok));
+    uint8_t *pool = (uint8_t *)malloc(n * 160);
+    if (!kp || !msgs || !tags || !lens || !ref || !out || !ok || !pool) return;
+
+    srand(777);
+    for (int k = 0; k < 4; k++) {
+        uint8_t kb[32];
+        for (int i = 0; i < 32; i++) kb[i] = (uint8_t)rand();
+        sm3_hmac_key_init(&keys[k], kb, 16 + 16 * (k & 1));
+    }
+    for (size_t i = 0; i < n; i++) {
+        kp[i] = &keys[i % 4];
+        msgs[i] = pool + i * 160;
+        lens[i] = i < 160 ? i : 64 + rand() % 64;
+        for (size_t j = 0; j < lens[i]; j++) pool[i * 160 + j] = (uint8_t)rand();
+    }
+
+    clock_t start = clock();
+    for (size_t i = 0; i < n; i++) sm3_hmac(kp[i], msgs[i], lens[i], ref[i]);
+    double single = (double)(clock() - start) / CLOCKS_PER_SEC;
+    start = clock();
+    sm3_hmac_many(kp, msgs, lens, out, n);
+    double batch = (double)(clock() - start) / CLOCKS_PER_SEC;
+    printf("HMAC batch (%zu tokens): %s  single %.2f ms, batch %.2f ms\n", n,
+           memcmp(out, ref, n * 32) == 0 ? "OK" : "MISMATCH", single * 1000, batch * 1000);
+
+    // 篡改第 5 条与最后一条，按 16 字节截断标签校验
+    ref[5][3] ^= 1;
+    ref[n - 1][15] ^= 0x80;
+    for (size_t i = 0; i < n; i++) tags[i] = ref[i];
+    size_t passed = sm3_hmac_verify_many(kp, msgs, lens, tags, 16, ok, n);
+    printf("HMAC verify: %s\n", passed == n - 2 && !ok[5] && !ok[n - 1] && ok[0] ? "OK" : "MISMATCH");
+
+    // KDF：Z 跨越块边界，输出不是 32 的整数倍
+    uint8_t z[100], k1[100];
+    for (int i = 0; i < 100; i++) z[i] = (uint8_t)i;
+    sm3_kdf(z, sizeof(z), k1, sizeof(k1));
+    printf("SM2 KDF vector: %s\n", hex_equal(k1,
+           "7256be0931ee006a0c2abf0f301fb3d16be504ed417238dae0bdb3fdfa90a934"
+           "21191b6a9a887b460789f30e9bbeb322289ed0f5900df20d3bb23ca40c6b844d"
+           "2aa736a520a953e7ff9fc85481c32459df2032e1f3f756d658d054dd28dffa19"
+           "c9b864a4", 100) ? "OK" : "MISMATCH");
+
+    // 批量 KDF 与逐条一致（每条 3 个计数器，会跨越分组边界）
+    const size_t kn = 100;
+    uint8_t *kout = (uint8_t *)malloc(kn * 70 * 2);
+    uint8_t **outs = (uint8_t **)malloc(kn * sizeof(*outs));
+    if (kout && outs) {
+        int same = 1;
+        for (size_t i = 0; i < kn; i++) outs[i] = kout + i * 70;
+        sm3_kdf_many(msgs, lens, outs, 70, kn);
+        for (size_t i = 0; i < kn; i++) {
+            sm3_kdf(msgs[i], lens[i], kout + kn * 70 + i * 70, 70);
+            same &= memcmp(kout + i * 70, kout + kn * 70 + i * 70, 70) == 0;
+        }
+        printf("SM2 KDF batch: %s\n", same ? "OK" : "MISMATCH");
+    }
+    free(kout); free(outs);
+    free(kp); free(msgs); free(tags); free(lens); free(ref); free(out); free(ok); free(pool);
+}
+
+// Merkle 测试用的参照实现：直接按 RFC 6962 的递归定义从叶子算 MTH
+static void merkle_ref(const uint8_t (*leaves)[32], size_t n, uint8_t out[32]) {
+    if (n == 1) {
+        memcpy(out, leaves[0], 32);
+        return;
+    }
+    size_t k = 1;
+    while (k * 2 < n) k *= 2;
+    uint8_t msg[65];
+    uint32_t h[8];
+    msg[0] = 0x01;
+    merkle_ref(leaves, k, msg + 1);
+    merkle_ref(leaves + k, n - k, msg + 33);
+    sm3_hash(msg, sizeof(msg), h);
+    for (int i = 0; i < 8; i++) {
+        out[4 * i] = (uint8_t)(h[i] >> 24); out[4 * i + 1] = (uint8_t)(h[i] >> 16);
+        out[4 * i + 2] = (uint8_t)(h[i] >> 8); out[4 * i + 3] = (uint8_t)h[i];
+    }
+}
+
+// Merkle 累加器测试：逐条与批量追加一致、各历史大小的根与参照实现一致、
+// 包含证明与一致性证明通过且篡改后失败、文件重开后继续追加
+void test_merkle() {
+    const size_t n = 300;
+    uint8_t entries[300][24];
+    uint8_t (*leaves)[32] = (uint8_t (*)[32])malloc(n * 32);
+    const uint8_t *ptrs[300];
+    size_t lens[300];
+    if (!leaves) return;
+    for (size_t i = 0; i < n; i++) {
+        lens[i] = i % 24;
+        for (size_t k = 0; k < lens[i]; k++) entries[i][k] = (uint8_t)(i * 31 + k);
+        ptrs[i] = entries[i];
+        sm3_merkle_leaf_hash(entries[i], lens[i], leaves[i]);
+    }
+
+    const char *path = "sm3_merkle_test.bin";
+    remove(path);
+    sm3_merkle *a = sm3_merkle_open(NULL);
+    sm3_merkle *b = sm3_merkle_open(path);
+    if (!a || !b) {
+        printf("Merkle: open FAILED\n");
+        return;
+    }
+    for (size_t i = 0; i < n; i++) sm3_merkle_append(a, entries[i], lens[i]);
+    sm3_merkle_append_many(b, ptrs, lens, 100);     // 分两次批量追加，中间关闭重开
+    sm3_merkle_close(b);
+    b = sm3_merkle_open(path);
+    int ok = b && sm3_merkle_size(b) == 100 &&
+             sm3_merkle_append_many(b, ptrs + 100, lens + 100, n - 100) == 0;
+
+    uint8_t proof[SM3_MERKLE_MAX_PROOF][32];
+    uint8_t ra[32], rb[32], ref[32], old_root[32];
+    for (size_t size = 1; ok && size <= n; size++) {
+        merkle_ref(leaves, size, ref);
+        sm3_merkle_root_at(a, size, ra);
+        sm3_merkle_root_at(b, size, rb);
+        ok &= memcmp(ra, ref, 32) == 0 && memcmp(rb, ref, 32) == 0;
+
+        for (size_t idx = 0; idx < size; idx += 1 + size / 7) {
+            size_t cnt = sm3_merkle_inclusion_proof(b, idx, size, proof);
+            ok &= sm3_merkle_verify_inclusion(leaves[idx], idx, size, proof, cnt, ref);
+            ok &= !sm3_merkle_verify_inclusion(leaves[(idx + 1) % n], idx, size, proof, cnt, ref) || size == 1;
+        }
+        for (size_t old = 1; old <= size; old += 1 + size / 5) {
+            size_t cnt = sm3_merkle_consistency_proof(b, old, size, proof);
+            sm3_merkle_root_at(b, old, old_root);
+            ok &= sm3_merkle_verify_consistency(old, size, old_root, ref, proof, cnt);
+            if (cnt > 0) {
+                proof[cnt - 1][0] ^= 1;
+                ok &= !sm3_merkle_verify_consistency(old, size, old_root, ref, proof, cnt);
+            }
+        }
+    }
+    printf("Merkle (%zu leaves, reopen + proofs): %s\n", n, ok ? "OK" : "MISMATCH");
+    sm3_merkle_close(a);
+    sm3_merkle_close(b);
+    remove(path);
+    free(leaves);
+
+    // 吞吐：100 万条 64 字节日志，逐条与按 1024 条一批追加
+    const size_t big = 1 << 20;
+    uint8_t *log = (uint8_t *)malloc(big * 64);
+    const uint8_t **lp = (const uint8_t **)malloc(1024 * sizeof(*lp));
+    size_t *ll = (size_t *)malloc(1024 * sizeof(*ll));
+    if (!log || !lp || !ll) return;
+    for (size_t i = 0; i < big * 64; i++) log[i] = (uint8_t)(i * 131 + (i >> 9));
+    a = sm3_merkle_open(NULL);
+    b = sm3_merkle_open(NULL);
+    clock_t start = clock();
+    for (size_t i = 0; i < big; i++) sm3_merkle_append(a, log + i * 64, 64);
+    double single = (double)(clock() - start) / CLOCKS_PER_SEC;
+    start = clock();
+    for (size_t i = 0; i < big; i += 1024) {
+        for (size_t k = 0; k < 1024; k++) {
+            lp[k] = log + (i + k) * 64;
+            ll[k] = 64;
+        }
+        sm3_merkle_append_many(b, lp, ll, 1024);
+    }
+    double batch = (double)(clock() - start) / CLOCKS_PER_SEC;
+    sm3_merkle_root(a, ra);
+    sm3_merkle_root(b, rb);
+    printf("Merkle append (%zu x 64B): single %.0f ms, batch %.0f ms  %s\n", big,
+           single * 1000, batch * 1000, memcmp(ra, rb, 32) == 0 ? "OK" : "MISMATCH");
+    sm3_merkle_close(a);
+    sm3_merkle_close(b);
+    free(log); free(lp); free(ll);
+}
+
+int main() {
+    // 测试用例1: "abc"
+    const uint8_t test1[] = {'a', 'b', 'c'};
+    test_case("Test 1 (\"abc\")", test1, sizeof(test1));
+    
+    // 测试用例2: 64字节消息
+    uint8_t test2[64];
+    for (int i = 0; i < 64; i++) test2[i] = 'a' + (i % 26);
+    test_case("Test 2 (64-byte)", test2, sizeof(test2));
+    
+    // 测试用例3: 长消息 (1MB)
+    size_t long_len = 1024 * 1024;
+    uint8_t *long_data = (uint8_t*)malloc(long_len);
+    if (long_data) {
+        memset(long_data, 0x61, long_len); // 全部填充'a'
+        test_case("Test 3 (1MB)", long_data, long_len);
+        test_streaming(long_data, long_len);
+        free(long_data);
+    }
+    
+    test_multi_buffer();
+    test_hmac_kdf();
+    test_merkle();
+    test_tree();
+    
+    return 0;
+}
@@ -0,0 +1,195 @@
+#include <stdint.h>
+#include <string.h>
+#include "sm3_promax.h"
+#include "sm3_mb_lanes.h"
+#include "../common/cpu_features.h"
+#include "../common/gm_trace.h"
+
+/*
+ * 多缓冲 SM3 调度
+ * 每个车道持有一条消息：完整块直接从调用者缓冲区读取，尾部填充块放在车道私有的 tail 中。
+ * 某条消息结束后立即写出摘要并装入下一条，车道在不同长度的消息之间不会空转；
+ * 没有消息可装的车道指向全零块并由内核掩码保持状态不变。
+ */
+
+typedef void (*sm3_mb_kernel)(uint32_t *st, const uint8_t *const *blocks, const uint32_t *active);
+
+struct sm3_mb_lane {
+    const uint8_t *msg;
+    size_t full;    // 可直接读取的完整块数
+    size_t total;   // 含填充的总块数
+    size_t next;    // 下一个待压缩块的序号
+    size_t idx;     // 对应的输出下标
+    uint8_t tail[128];
+};
+
+static const uint8_t sm3_mb_zero_block[64] = {0};
+
+// init / prefix 为空时从 IV 开始；否则第 i 条消息从 init[i] 继续，前面已压缩过 prefix[i] 字节（64 的倍数）
+static void sm3_mb_run(sm3_mb_kernel kernel, int L, const uint8_t *const *msgs,
+                       const size_t *lens, const uint32_t *const *init,
+                       const uint64_t *prefix, uint32_t (*out)[8], size_t n) {
+    sm3_mb_lane lanes[16];
+    uint32_t st[8 * 16];
+    uint32_t active[16];
+    const uint8_t *blocks[16];
+    size_t next_job = 0;
+    int busy = 0;
+
+    for (int i = 0; i < L; i++) {
+        active[i] = 0;
+    }
+
+    for (;;) {
+        // 空闲车道装入新消息
+        for (int i = 0; i < L && next_job < n; i++) {
+            if (active[i]) continue;
+            sm3_mb_lane &ln = lanes[i];
+            size_t len = lens[next_job];
+            const uint32_t *iv = init ? init[next_job] : SM3_IV;
+            ln.msg = msgs[next_job];
+            ln.full = len / 64;
+            ln.total = ln.full + sm3_pad_tail(ln.msg + ln.full * 64,
+                                              len + (prefix ? prefix[next_job] : 0), ln.tail);
+            ln.next = 0;
+            ln.idx = next_job++;
+            for (int k = 0; k < 8; k++) {
+                st[k * L + i] = iv[k];
+            }
+            active[i] = 0xffffffffu;
+            busy++;
+        }
+        if (busy == 0) break;
+
+        for (int i = 0; i < L; i++) {
+            const sm3_mb_lane &ln = lanes[i];
+            if (!active[i]) {
+                blocks[i] = sm3_mb_zero_block;
+            } else if (ln.next < ln.full) {
+                blocks[i] = ln.msg + ln.next * 64;
+            } else {
+                blocks[i] = ln.tail + (ln.next - ln.full) * 64;
+            }
+        }
+
+        kernel(st, blocks, active);
+
+        for (int i = 0; i < L; i++) {
+            if (!active[i]) continue;
+            sm3_mb_lane &ln = lanes[i];
+            if (++ln.next == ln.total) {
+                for (int k = 0; k < 8; k++) {
+                    out[ln.idx][k] = st[k * L + i];
+                }
+                active[i] = 0;
+                busy--;
+            }
+        }
+    }
+}
+
+int sm3_mb_isa_supported(sm3_mb_isa isa) {
+    const cpu_features_t *f = cpu_features();
+    switch (isa) {
+        case SM3_MB_SCALAR: return 1;
+        case SM3_MB_SSSE3:  return f->ssse3;
+        case SM3_MB_AVX2:   return f->avx2;
+        case SM3_MB_AVX512: return f->avx512f && f->avx512bw;
+    }
+    return 0;
+}
+
+sm3_mb_isa sm3_mb_best_isa(void) {
+    static const sm3_mb_isa best =
+        sm3_mb_isa_supported(SM3_MB_AVX512) ? SM3_MB_AVX512 :
+        sm3_mb_isa_supported(SM3_MB_AVX2)   ? SM3_MB_AVX2 :
+        sm3_mb_isa_supported(SM3_MB_SSSE3)  ? SM3_MB_SSSE3 : SM3_MB_SCALAR;
+    return best;
+}
+
+const char *sm3_mb_isa_name(sm3_mb_isa isa) {
+    switch (isa) {
+        case SM3_MB_SCALAR: return "scalar";
+        case SM3_MB_SSSE3:  return "ssse3x4";
+        case SM3_MB_AVX2:   return "avx2x8";
+        case SM3_MB_AVX512: return "avx512x16";
+    }
+    return "unknown";
+}
+
+// 计时区段记的字节数
+static inline uint64_t sm3_mb_total(const size_t *lens, size_t n) {
+    uint64_t total = 0;
+    for (size_t i = 0; i < n; i++) total += lens[i];
+    return total;
+}
+
+static void sm3_hash_many_run(sm3_mb_isa isa, const uint8_t *const *msgs, const size_t *lens,
+                              const uint32_t *const *init, const uint64_t *prefix,
+                              uint32_t (*out)[8], size_t n) {
+    GM_TRACE_ZONE(GMCRYPTO_ZONE_SM3_MB, sm3_mb_total(lens, n));
+    switch (isa) {
+        case SM3_MB_SSSE3:
+            sm3_mb_run(sm3_mb_compress_ssse3, 4, msgs, lens, init, prefix, out, n);
+            return;
+        case SM3_MB_AVX2:
+            sm3_mb_run(sm3_mb_compress_avx2, 8, msgs, lens, init, prefix, out, n);
+            return;
+        case SM3_MB_AVX512:
+            sm3_mb_run(sm3_mb_compress_avx512, 16, msgs, lens, init, prefix, out, n);
+            return;
+        default:
+            break;
+    }
+    // 标量回退：逐条压缩完整块，再压缩填充块
+    for (size_t i = 0; i < n; i++) {
+        if (!init) {
+            sm3_hash(msgs[i], lens[i], out[i]);
+            continue;
+        }
+        uint8_t tail[128];
+        size_t full = lens[i] / 64;
+        memcpy(out[i], init[i], 32);
+        sm3_compress_blocks(out[i], msgs[i], full);
+        size_t nt = sm3_pad_tail(msgs[i] + full * 64, lens[i] + (prefix ? prefix[i] : 0), tail);
+        sm3_compress_blocks(out[i], tail, nt);
+    }
+}
+
+// 消息条数不足以填满宽车道时退到窄一档，避免大半车道空转
+static sm3_mb_isa sm3_mb_pick(size_t n) {
+    sm3_mb_isa isa = sm3_mb_best_isa();
+    while (isa > SM3_MB_SSSE3 && n < ((size_t)2 << isa)) {
+        isa = (sm3_mb_isa)(isa - 1);
+    }
+    if (n == 1) isa = SM3_MB_SCALAR;
+    return isa;
+}
+
+void sm3_hash_many_isa(sm3_mb_isa isa, const uint8_t *const *msgs,
+                       const size_t *lens, uint32_t (*out)[8], size_t n) {
+    sm3_hash_many_run(isa, msgs, lens, NULL, NULL, out, n);
+}
+
+void sm3_hash_many(const uint8_t *const *msgs, const size_t *lens,
+                   uint32_t (*out)[8], size_t n) {
+    sm3_hash_many_run(sm3_mb_pick(n), msgs, lens, NULL, NULL, out, n);
+}
+
+void sm3_hash_many_from(const uint8_t *const *msgs, const size_t *lens,
+                        const uint32_t *const *init, const uint64_t *prefix,
+                        uint32_t (*out)[8], size_t n) {
+    sm3_hash_many_run(sm3_mb_pick(n), msgs, lens, init, prefix, out, n);
+}
+
+void sm3_hash_x4(const uint8_t *msgs[4], const size_t lens[4], uint32_t out[4][8]) {
+    sm3_hash_many(msgs, lens, out, 4);
+}
+
+void sm3_hash_x8(const uint8_t *msgs[8], const size_t lens[8], uint32_t out[8][8]) {
+    sm3_hash_many(msgs, lens, out, 8);
+}
+
+void sm3_hash_x16(const uint8_t *msgs[16], const size_t lens[16], uint32_t out[16][8]) {
+    sm3_hash_many(msgs, lens, out, 16);
+}
@@ -0,0 +1,47 @@
+// 多缓冲 SM3：AVX2 8 路内核
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC target("avx2")
+#endif
+#include <immintrin.h>
+#define SM3_MB_DEFINE_KERNEL
+#include "sm3_mb_lanes.h"
+
+namespace {
+
+struct vec_avx2 {
+    typedef __m256i reg;
+    static const int lanes = 8;
+
+    static inline reg set1(uint32_t x) { return _mm256_set1_epi32((int)x); }
+    static inline reg load_u(const uint32_t *p) { return _mm256_loadu_si256((const __m256i *)p); }
+    static inline void store_u(uint32_t *p, reg x) { _mm256_storeu_si256((__m256i *)p, x); }
+    static inline reg xor_(reg a, reg b) { return _mm256_xor_si256(a, b); }
+    static inline reg and_(reg a, reg b) { return _mm256_and_si256(a, b); }
+    static inline reg or_(reg a, reg b) { return _mm256_or_si256(a, b); }
+    static inline reg andnot(reg a, reg b) { return _mm256_andnot_si256(a, b); }
+    static inline reg add(reg a, reg b) { return _mm256_add_epi32(a, b); }
+    template <int k> static inline reg rotl(reg x) {
+        return _mm256_or_si256(_mm256_slli_epi32(x, k), _mm256_srli_epi32(x, 32 - k));
+    }
+    static inline reg bswap32(reg x) {
+        const __m256i m = _mm256_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
+                                          12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+        return _mm256_shuffle_epi8(x, m);
+    }
+    static inline reg unpacklo32(reg a, reg b) { return _mm256_unpacklo_epi32(a, b); }
+    static inline reg unpackhi32(reg a, reg b) { return _mm256_unpackhi_epi32(a, b); }
+    static inline reg unpacklo64(reg a, reg b) { return _mm256_unpacklo_epi64(a, b); }
+    static inline reg unpackhi64(reg a, reg b) { return _mm256_unpackhi_epi64(a, b); }
+    // 低 128 位放车道 r，高 128 位放车道 r+4
+    static inline reg load_row(const uint8_t *const *blocks, int off, int r) {
+        __m128i lo = _mm_loadu_si128((const __m128i *)(blocks[r] + off));
+        __m128i hi = _mm_loadu_si128((const __m128i *)(blocks[r + 4] + off));
+        return _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+    }
+};
+
+} // namespace
+
+void sm3_mb_compress_avx2(uint32_t *st, const uint8_t *const *blocks, const uint32_t *active) {
+    sm3_mb_compress_lanes<vec_avx2>(st, blocks, active);
+}
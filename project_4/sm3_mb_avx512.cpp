@@ -0,0 +1,47 @@
+// 多缓冲 SM3：AVX-512 16 路内核（vprold 代替移位+或）
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC target("avx512f,avx512bw")
+#endif
+#include <immintrin.h>
+#define SM3_MB_DEFINE_KERNEL
+#include "sm3_mb_lanes.h"
+
+namespace {
+
+struct vec_avx512 {
+    typedef __m512i reg;
+    static const int lanes = 16;
+
+    static inline reg set1(uint32_t x) { return _mm512_set1_epi32((int)x); }
+    static inline reg load_u(const uint32_t *p) { return _mm512_loadu_si512((const void *)p); }
+    static inline void store_u(uint32_t *p, reg x) { _mm512_storeu_si512((void *)p, x); }
+    static inline reg xor_(reg a, reg b) { return _mm512_xor_si512(a, b); }
+    static inline reg and_(reg a, reg b) { return _mm512_and_si512(a, b); }
+    static inline reg or_(reg a, reg b) { return _mm512_or_si512(a, b); }
+    static inline reg andnot(reg a, reg b) { return _mm512_andnot_si512(a, b); }
+    static inline reg add(reg a, reg b) { return _mm512_add_epi32(a, b); }
+    template <int k> static inline reg rotl(reg x) { return _mm512_rol_epi32(x, k); }
+    static inline reg bswap32(reg x) {
+        const __m512i m = _mm512_broadcast_i32x4(
+            _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3));
+        return _mm512_shuffle_epi8(x, m);
+    }
+    static inline reg unpacklo32(reg a, reg b) { return _mm512_unpacklo_epi32(a, b); }
+    static inline reg unpackhi32(reg a, reg b) { return _mm512_unpackhi_epi32(a, b); }
+    static inline reg unpacklo64(reg a, reg b) { return _mm512_unpacklo_epi64(a, b); }
+    static inline reg unpackhi64(reg a, reg b) { return _mm512_unpackhi_epi64(a, b); }
+    // 4 个 128 位分区依次放车道 r、r+4、r+8、r+12
+    static inline reg load_row(const uint8_t *const *blocks, int off, int r) {
+        __m512i v = _mm512_castsi128_si512(_mm_loadu_si128((const __m128i *)(blocks[r] + off)));
+        v = _mm512_inserti32x4(v, _mm_loadu_si128((const __m128i *)(blocks[r + 4] + off)), 1);
+        v = _mm512_inserti32x4(v, _mm_loadu_si128((const __m128i *)(blocks[r + 8] + off)), 2);
+        v = _mm512_inserti32x4(v, _mm_loadu_si128((const __m128i *)(blocks[r + 12] + off)), 3);
+        return v;
+    }
+};
+
+} // namespace
+
+void sm3_mb_compress_avx512(uint32_t *st, const uint8_t *const *blocks, const uint32_t *active) {
+    sm3_mb_compress_lanes<vec_avx512>(st, blocks, active);
+}
@@ -0,0 +1,148 @@
+#ifndef SM3_MB_LANES_H
+#define SM3_MB_LANES_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * 多缓冲 SM3 车道内核
+ * st 为转置后的状态：st[k * L + i] 是第 i 条消息的第 k 个状态字；
+ * blocks[i] 指向第 i 条消息当前的 64 字节块；active[i] 为 0 的车道状态保持不变。
+ */
+void sm3_mb_compress_ssse3(uint32_t *st, const uint8_t *const *blocks, const uint32_t *active);
+void sm3_mb_compress_avx2(uint32_t *st, const uint8_t *const *blocks, const uint32_t *active);
+void sm3_mb_compress_avx512(uint32_t *st, const uint8_t *const *blocks, const uint32_t *active);
+
+/*
+ * 从中间状态继续的多缓冲哈希（HMAC、KDF 用）：第 i 条消息从 init[i] 开始，
+ * 之前已压缩过 prefix[i] 字节（64 的倍数，计入填充里的总长度）；init 为空时同 sm3_hash_many。
+ */
+void sm3_hash_many_from(const uint8_t *const *msgs, const size_t *lens,
+                        const uint32_t *const *init, const uint64_t *prefix,
+                        uint32_t (*out)[8], size_t n);
+
+#endif // SM3_MB_LANES_H
+
+/*
+ * 以下模板由各 ISA 翻译单元在 #pragma GCC target 下定义 SM3_MB_DEFINE_KERNEL 后包含。
+ * 放在匿名命名空间里，保证不同指令集编译出的同名函数不会被链接器合并。
+ *
+ * V 需要提供：
+ *   reg、lanes、set1、load_u、store_u、xor_、and_、or_、andnot（~a & b）、add、
+ *   rotl<k>、bswap32、unpack 系列，以及 load_row(blocks, off, r)：
+ *   把车道 r, r+4, r+8, ... 在偏移 off 处的 16 字节依次放进各 128 位分区。
+ */
+#ifdef SM3_MB_DEFINE_KERNEL
+namespace {
+
+// T_j <<< (j mod 32) 预先算好，轮内只需广播
+static const uint32_t sm3_mb_tj[64] = {
+    0x79cc4519, 0xf3988a32, 0xe7311465, 0xce6228cb,
+    0x9cc45197, 0x3988a32f, 0x7311465e, 0xe6228cbc,
+    0xcc451979, 0x988a32f3, 0x311465e7, 0x6228cbce,
+    0xc451979c, 0x88a32f39, 0x11465e73, 0x228cbce6,
+    0x9d8a7a87, 0x3b14f50f, 0x7629ea1e, 0xec53d43c,
+    0xd8a7a879, 0xb14f50f3, 0x629ea1e7, 0xc53d43ce,
+    0x8a7a879d, 0x14f50f3b, 0x29ea1e76, 0x53d43cec,
+    0xa7a879d8, 0x4f50f3b1, 0x9ea1e762, 0x3d43cec5,
+    0x7a879d8a, 0xf50f3b14, 0xea1e7629, 0xd43cec53,
+    0xa879d8a7, 0x50f3b14f, 0xa1e7629e, 0x43cec53d,
+    0x879d8a7a, 0x0f3b14f5, 0x1e7629ea, 0x3cec53d4,
+    0x79d8a7a8, 0xf3b14f50, 0xe7629ea1, 0xcec53d43,
+    0x9d8a7a87, 0x3b14f50f, 0x7629ea1e, 0xec53d43c,
+    0xd8a7a879, 0xb14f50f3, 0x629ea1e7, 0xc53d43ce,
+    0x8a7a879d, 0x14f50f3b, 0x29ea1e76, 0x53d43cec,
+    0xa7a879d8, 0x4f50f3b1, 0x9ea1e762, 0x3d43cec5
+};
+
+template <class V>
+static inline typename V::reg mb_p0(typename V::reg x) {
+    return V::xor_(x, V::xor_(V::template rotl<9>(x), V::template rotl<17>(x)));
+}
+
+template <class V>
+static inline typename V::reg mb_p1(typename V::reg x) {
+    return V::xor_(x, V::xor_(V::template rotl<15>(x), V::template rotl<23>(x)));
+}
+
+// 一轮压缩；j < 16 与 j >= 16 的布尔函数由模板参数区分，循环内无分支
+template <class V, bool LATE>
+static inline void mb_round(typename V::reg s[8], typename V::reg w0,
+                            typename V::reg w1, uint32_t tj) {
+    typedef typename V::reg R;
+    R &A = s[0], &B = s[1], &C = s[2], &D = s[3];
+    R &E = s[4], &F = s[5], &G = s[6], &H = s[7];
+
+    R a12 = V::template rotl<12>(A);
+    R SS1 = V::template rotl<7>(V::add(V::add(a12, E), V::set1(tj)));
+    R SS2 = V::xor_(SS1, a12);
+    R ff, gg;
+    if (LATE) {
+        ff = V::or_(V::and_(A, B), V::and_(C, V::or_(A, B)));
+        gg = V::or_(V::and_(E, F), V::andnot(E, G));
+    } else {
+        ff = V::xor_(A, V::xor_(B, C));
+        gg = V::xor_(E, V::xor_(F, G));
+    }
+    R TT1 = V::add(V::add(ff, D), V::add(SS2, w1));
+    R TT2 = V::add(V::add(gg, H), V::add(SS1, w0));
+
+    D = C;
+    C = V::template rotl<9>(B);
+    B = A;
+    A = TT1;
+    H = G;
+    G = V::template rotl<19>(F);
+    F = E;
+    E = mb_p0<V>(TT2);
+}
+
+template <class V>
+static inline void sm3_mb_compress_lanes(uint32_t *st, const uint8_t *const *blocks,
+                                         const uint32_t *active) {
+    typedef typename V::reg R;
+    const int L = V::lanes;
+    R W[68];
+
+    // 每次取各车道 16 字节，4x4 转置后得到 4 个消息字向量
+    for (int g = 0; g < 4; g++) {
+        R r0 = V::load_row(blocks, g * 16, 0);
+        R r1 = V::load_row(blocks, g * 16, 1);
+        R r2 = V::load_row(blocks, g * 16, 2);
+        R r3 = V::load_row(blocks, g * 16, 3);
+        R t0 = V::unpacklo32(r0, r1), t1 = V::unpacklo32(r2, r3);
+        R t2 = V::unpackhi32(r0, r1), t3 = V::unpackhi32(r2, r3);
+        W[g * 4 + 0] = V::bswap32(V::unpacklo64(t0, t1));
+        W[g * 4 + 1] = V::bswap32(V::unpackhi64(t0, t1));
+        W[g * 4 + 2] = V::bswap32(V::unpacklo64(t2, t3));
+        W[g * 4 + 3] = V::bswap32(V::unpackhi64(t2, t3));
+    }
+
+    // 消息扩展（各车道并行）
+    for (int i = 16; i < 68; i++) {
+        R tmp = V::xor_(V::xor_(W[i - 16], W[i - 9]), V::template rotl<15>(W[i - 3]));
+        W[i] = V::xor_(V::xor_(mb_p1<V>(tmp), V::template rotl<7>(W[i - 13])), W[i - 6]);
+    }
+
+    R s[8], old[8];
+    for (int k = 0; k < 8; k++) {
+        old[k] = s[k] = V::load_u(st + k * L);
+    }
+
+    for (int j = 0; j < 16; j++) {
+        mb_round<V, false>(s, W[j], V::xor_(W[j], W[j + 4]), sm3_mb_tj[j]);
+    }
+    for (int j = 16; j < 64; j++) {
+        mb_round<V, true>(s, W[j], V::xor_(W[j], W[j + 4]), sm3_mb_tj[j]);
+    }
+
+    // 已结束的车道保持原状态
+    R m = V::load_u(active);
+    for (int k = 0; k < 8; k++) {
+        R nv = V::xor_(s[k], old[k]);
+        V::store_u(st + k * L, V::or_(V::and_(m, nv), V::andnot(m, old[k])));
+    }
+}
+
+} // namespace
+#endif // SM3_MB_DEFINE_KERNEL
@@ -0,0 +1,43 @@
+// 多缓冲 SM3：SSSE3 4 路内核
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC target("ssse3")
+#endif
+#include <immintrin.h>
+#define SM3_MB_DEFINE_KERNEL
+#include "sm3_mb_lanes.h"
+
+namespace {
+
+struct vec_ssse3 {
+    typedef __m128i reg;
+    static const int lanes = 4;
+
+    static inline reg set1(uint32_t x) { return _mm_set1_epi32((int)x); }
+    static inline reg load_u(const uint32_t *p) { return _mm_loadu_si128((const __m128i *)p); }
+    static inline void store_u(uint32_t *p, reg x) { _mm_storeu_si128((__m128i *)p, x); }
+    static inline reg xor_(reg a, reg b) { return _mm_xor_si128(a, b); }
+    static inline reg and_(reg a, reg b) { return _mm_and_si128(a, b); }
+    static inline reg or_(reg a, reg b) { return _mm_or_si128(a, b); }
+    static inline reg andnot(reg a, reg b) { return _mm_andnot_si128(a, b); }
+    static inline reg add(reg a, reg b) { return _mm_add_epi32(a, b); }
+    template <int k> static inline reg rotl(reg x) {
+        return _mm_or_si128(_mm_slli_epi32(x, k), _mm_srli_epi32(x, 32 - k));
+    }
+    static inline reg bswap32(reg x) {
+        const __m128i m = _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+        return _mm_shuffle_epi8(x, m);
+    }
+    static inline reg unpacklo32(reg a, reg b) { return _mm_unpacklo_epi32(a, b); }
+    static inline reg unpackhi32(reg a, reg b) { return _mm_unpackhi_epi32(a, b); }
+    static inline reg unpacklo64(reg a, reg b) { return _mm_unpacklo_epi64(a, b); }
+    static inline reg unpackhi64(reg a, reg b) { return _mm_unpackhi_epi64(a, b); }
+    static inline reg load_row(const uint8_t *const *blocks, int off, int r) {
+        return _mm_loadu_si128((const __m128i *)(blocks[r] + off));
+    }
+};
+
+} // namespace
+
+void sm3_mb_compress_ssse3(uint32_t *st, const uint8_t *const *blocks, const uint32_t *active) {
+    sm3_mb_compress_lanes<vec_ssse3>(st, blocks, active);
+}
@@ -0,0 +1,425 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "sm3_promax.h"
+
+/*
+ * 增量 Merkle 累加器，树形与证明格式同 RFC 6962 / RFC 9162，哈希换成 SM3：
+ *   叶子 = SM3(0x00 || data)，内部节点 = SM3(0x01 || left || right)，
+ *   n 个叶子的树在小于 n 的最大 2 的幂 k 处分成左 k 个、右 n - k 个。
+ *
+ * 只保存完整子树的节点（左右孩子都已存在的节点），按后序排在一段连续数组里：
+ *   第 m 个叶子在 2m - popcount(m)，第 l 层第 j 个节点紧跟在它最右叶子之后的第 l 个位置，
+ *   n 个叶子共 2n - popcount(n) 个节点。追加只会往数组末尾写，文件只增长不重排。
+ * 任意历史大小的根、证明里用到的子树哈希，都能由这些完整节点沿右边界 O(log n) 次合并得到。
+ *
+ * 文件 = 64 字节头 + 节点数组；每次追加先把新节点所在的页 msync 落盘，再更新头里的叶子数，
+ * 系统在任何时刻崩溃，盘上的头都不会指向没写到盘上的节点，重开时是某一次追加之后的一致状态
+ * （头本身等 sm3_merkle_sync / close 或内核回写时落盘）。每次追加都要等一次落盘，成批追加更划算。
+ * 头里的整数按本机字节序存放。
+ */
+
+static const char SM3_MERKLE_MAGIC[8] = {'S', 'M', '3', 'M', 'E', 'R', 'K', '1'};
+static const size_t SM3_MERKLE_HEADER = 64;
+static const size_t SM3_MERKLE_BATCH = 64;      // 每次交给多缓冲内核的消息条数
+
+struct sm3_merkle {
+    int fd;             // -1 表示只在内存中
+    uint8_t *map;       // 头 + 节点数组
+    size_t map_size;
+    uint64_t leaves;
+};
+
+static inline uint8_t *node_at(const sm3_merkle *t, uint64_t pos) {
+    return t->map + SM3_MERKLE_HEADER + pos * 32;
+}
+
+static inline uint64_t popcount64(uint64_t x) {
+    return (uint64_t)__builtin_popcountll(x);
+}
+
+static inline uint64_t node_count(uint64_t leaves) {
+    return 2 * leaves - popcount64(leaves);
+}
+
+// 第 level 层第 j 个完整节点的后序位置
+static inline uint64_t node_pos(unsigned level, uint64_t j) {
+    uint64_t last = ((j + 1) << level) - 1;
+    return 2 * last - popcount64(last) + level;
+}
+
+static void digest_bytes(const uint32_t *hash, uint8_t *out) {
+    for (int i = 0; i < 8; i++) {
+        out[4 * i]     = (uint8_t)(hash[i] >> 24);
+        out[4 * i + 1] = (uint8_t)(hash[i] >> 16);
+        out[4 * i + 2] = (uint8_t)(hash[i] >> 8);
+        out[4 * i + 3] = (uint8_t)hash[i];
+    }
+}
+
+void sm3_merkle_leaf_hash(const uint8_t *data, size_t len, uint8_t out[32]) {
+    static const uint8_t prefix = 0x00;
+    sm3_ctx ctx;
+    uint32_t h[8];
+    sm3_init(&ctx);
+    sm3_update(&ctx, &prefix, 1);
+    sm3_update(&ctx, data, len);
+    sm3_final(&ctx, h);
+    digest_bytes(h, out);
+}
+
+static void node_hash(const uint8_t left[32], const uint8_t right[32], uint8_t out[32]) {
+    uint8_t msg[65];
+    uint32_t h[8];
+    msg[0] = 0x01;
+    memcpy(msg + 1, left, 32);
+    memcpy(msg + 33, right, 32);
+    sm3_hash(msg, sizeof(msg), h);
+    digest_bytes(h, out);
+}
+
+static void store_leaves(sm3_merkle *t) {
+    memcpy(t->map + 8, &t->leaves, sizeof(t->leaves));
+}
+
+/* ===== 存储 ===== */
+
+// 保证能放下 nodes 个节点；容量按 2 倍增长，至少 4096 个节点（128KB）
+static int merkle_reserve(sm3_merkle *t, uint64_t nodes) {
+    size_t need = SM3_MERKLE_HEADER + (size_t)nodes * 32;
+    if (need <= t->map_size) return 0;
+    size_t size = t->map_size ? t->map_size : SM3_MERKLE_HEADER + 4096 * 32;
+    while (size < need) size = SM3_MERKLE_HEADER + (size - SM3_MERKLE_HEADER) * 2;
+
+    uint8_t *p;
+    if (t->fd >= 0) {
+        if (ftruncate(t->fd, (off_t)size) != 0) return -1;
+        p = (uint8_t *)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, t->fd, 0);
+        if (p == MAP_FAILED) return -1;
+    } else {
+        p = (uint8_t *)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) return -1;
+        if (t->map) memcpy(p, t->map, t->map_size);
+    }
+    if (t->map) munmap(t->map, t->map_size);
+    t->map = p;
+    t->map_size = size;
+    return 0;
+}
+
+sm3_merkle *sm3_merkle_open(const char *path) {
+    sm3_merkle *t = (sm3_merkle *)calloc(1, sizeof(*t));
+    if (!t) return NULL;
+    t->fd = -1;
+
+    if (path) {
+        t->fd = open(path, O_RDWR | O_CREAT, 0644);
+        if (t->fd < 0) {
+            free(t);
+            return NULL;
+        }
+        struct stat st;
+        if (fstat(t->fd, &st) != 0) goto fail;
+        if (st.st_size > 0) {
+            // 已有文件：校验头，直接映射，不重建任何节点
+            if ((size_t)st.st_size < SM3_MERKLE_HEADER) goto fail;
+            t->map_size = (size_t)st.st_size;
+            t->map = (uint8_t *)mmap(NULL, t->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, t->fd, 0);
+            if (t->map == MAP_FAILED) {
+                t->map = NULL;
+                goto fail;
+            }
+            memcpy(&t->leaves, t->map + 8, sizeof(t->leaves));
+            if (memcmp(t->map, SM3_MERKLE_MAGIC, 8) != 0 ||
+                t->leaves > (t->map_size - SM3_MERKLE_HEADER) / 32 ||
+                SM3_MERKLE_HEADER + node_count(t->leaves) * 32 > t->map_size) {
+                goto fail;
+            }
+            return t;
+        }
+    }
+
+    if (merkle_reserve(t, 1) != 0) goto fail;
+    memcpy(t->map, SM3_MERKLE_MAGIC, 8);
+    store_leaves(t);
+    return t;
+
+fail:
+    sm3_merkle_close(t);
+    return NULL;
+}
+
+int sm3_merkle_sync(sm3_merkle *t) {
+    if (t->fd < 0) return 0;
+    return msync(t->map, t->map_size, MS_SYNC);
+}
+
+void sm3_merkle_close(sm3_merkle *t) {
+    if (!t) return;
+    if (t->map) {
+        sm3_merkle_sync(t);
+        munmap(t->map, t->map_size);
+    }
+    if (t->fd >= 0) close(t->fd);
+    free(t);
+}
+
+uint64_t sm3_merkle_size(const sm3_merkle *t) {
+    return t->leaves;
+}
+
+/* ===== 追加 ===== */
+
+// 文件模式下把第 [from, to) 个节点所在的页同步写盘；msync 的起点要按页对齐
+static int flush_nodes(sm3_merkle *t, uint64_t from, uint64_t to) {
+    if (t->fd < 0 || from == to) return 0;
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t lo = (SM3_MERKLE_HEADER + (size_t)from * 32) & ~(page - 1);
+    size_t hi = SM3_MERKLE_HEADER + (size_t)to * 32;
+    return msync(t->map + lo, hi - lo, MS_SYNC);
+}
+
+// 按批把消息交给多缓冲内核，摘要写到各自的节点位置
+static void hash_batch(sm3_merkle *t, const std::vector<const uint8_t *> &msgs,
+                       const std::vector<size_t> &lens, const std::vector<uint64_t> &pos) {
+    uint32_t h[SM3_MERKLE_BATCH][8];
+    sm3_hash_many(msgs.data(), lens.data(), h, msgs.size());
+    for (size_t i = 0; i < msgs.size(); i++) digest_bytes(h[i], node_at(t, pos[i]));
+}
+
+int sm3_merkle_append_many(sm3_merkle *t, const uint8_t *const *data, const size_t *lens, size_t n) {
+    uint64_t old = t->leaves, total = old + n;
+    if (n == 0) return 0;
+    if (merkle_reserve(t, node_count(total)) != 0) return -1;
+
+    std::vector<uint8_t> scratch;
+    std::vector<const uint8_t *> msgs;
+    std::vector<size_t> mlens;
+    std::vector<uint64_t> pos;
+    msgs.reserve(SM3_MERKLE_BATCH);
+    mlens.reserve(SM3_MERKLE_BATCH);
+    pos.reserve(SM3_MERKLE_BATCH);
+
+    // 叶子：0x00 || data 拼到暂存区，每批 SM3_MERKLE_BATCH 条
+    for (size_t base = 0; base < n; base += SM3_MERKLE_BATCH) {
+        size_t m = n - base < SM3_MERKLE_BATCH ? n - base : SM3_MERKLE_BATCH;
+        size_t bytes = 0;
+        for (size_t i = 0; i < m; i++) bytes += lens[base + i] + 1;
+        scratch.resize(bytes);
+        msgs.clear();
+        mlens.clear();
+        pos.clear();
+        uint8_t *p = scratch.data();
+        for (size_t i = 0; i < m; i++) {
+            uint64_t leaf = old + base + i;
+            p[0] = 0x00;
+            if (lens[base + i]) memcpy(p + 1, data[base + i], lens[base + i]);
+            msgs.push_back(p);
+            mlens.push_back(lens[base + i] + 1);
+            pos.push_back(2 * leaf - popcount64(leaf));
+            p += lens[base + i] + 1;
+        }
+        hash_batch(t, msgs, mlens, pos);
+    }
+
+    // 逐层补齐新变完整的父节点：第 l+1 层下标 [old >> (l+1), total >> (l+1))，同层一起批量哈希
+    scratch.resize(SM3_MERKLE_BATCH * 65);
+    for (unsigned level = 0; (total >> (level + 1)) > 0; level++) {
+        uint64_t lo = old >> (level + 1), hi = total >> (level + 1);
+        for (uint64_t j = lo; j < hi; ) {
+            msgs.clear();
+            mlens.clear();
+            pos.clear();
+            for (size_t i = 0; i < SM3_MERKLE_BATCH && j < hi; i++, j++) {
+                uint8_t *p = scratch.data() + i * 65;
+                p[0] = 0x01;
+                memcpy(p + 1, node_at(t, node_pos(level, 2 * j)), 32);
+                memcpy(p + 33, node_at(t, node_pos(level, 2 * j + 1)), 32);
+                msgs.push_back(p);
+                mlens.push_back(65);
+                pos.push_back(node_pos(level + 1, j));
+            }
+            hash_batch(t, msgs, mlens, pos);
+        }
+    }
+
+    // 节点先落盘，再发布新的叶子数
+    if (flush_nodes(t, node_count(old), node_count(total)) != 0) return -1;
+    t->leaves = total;
+    store_leaves(t);
+    return 0;
+}
+
+int sm3_merkle_append(sm3_merkle *t, const uint8_t *data, size_t len) {
+    return sm3_merkle_append_many(t, &data, &len, 1);
+}
+
+/* ===== 根与证明 ===== */
+
+static inline uint64_t split_point(uint64_t n) {
+    // 小于 n 的最大 2 的幂（n >= 2）
+    uint64_t k = 1;
+    while (k << 1 < n) k <<= 1;
+    return k;
+}
+
+// 叶子区间 [start, end) 的子树哈希 MTH(D[start:end])；start 总是按区间内最大 2 的幂对齐
+static void subtree_hash(const sm3_merkle *t, uint64_t start, uint64_t end, uint8_t out[32]) {
+    uint64_t size = end - start;
+    if ((size & (size - 1)) == 0 && start % size == 0) {
+        unsigned level = (unsigned)__builtin_ctzll(size);
+        memcpy(out, node_at(t, node_pos(level, start >> level)), 32);
+        return;
+    }
+    uint8_t left[32], right[32];
+    uint64_t k = split_point(size);
+    subtree_hash(t, start, start + k, left);
+    subtree_hash(t, start + k, end, right);
+    node_hash(left, right, out);
+}
+
+int sm3_merkle_root_at(const sm3_merkle *t, uint64_t size, uint8_t root[32]) {
+    if (size > t->leaves) return -1;
+    if (size == 0) {
+        // 空树的根为空串的哈希
+        uint32_t h[8];
+        sm3_hash(NULL, 0, h);
+        digest_bytes(h, root);
+        return 0;
+    }
+    subtree_hash(t, 0, size, root);
+    return 0;
+}
+
+int sm3_merkle_root(const sm3_merkle *t, uint8_t root[32]) {
+    return sm3_merkle_root_at(t, t->leaves, root);
+}
+
+int sm3_merkle_leaf(const sm3_merkle *t, uint64_t index, uint8_t out[32]) {
+    if (index >= t->leaves) return -1;
+    memcpy(out, node_at(t, 2 * index - popcount64(index)), 32);
+    return 0;
+}
+
+// PATH(m, D[start:end])，从叶子一侧向上依次输出
+static void inclusion_path(const sm3_merkle *t, uint64_t m, uint64_t start, uint64_t end,
+                           uint8_t (*proof)[32], size_t *count) {
+    uint64_t size = end - start;
+    if (size <= 1) return;
+    uint64_t k = split_point(size);
+    if (m < k) {
+        inclusion_path(t, m, start, start + k, proof, count);
+        subtree_hash(t, start + k, end, proof[(*count)++]);
+    } else {
+        inclusion_path(t, m - k, start + k, end, proof, count);
+        subtree_hash(t, start, start + k, proof[(*count)++]);
+    }
+}
+
+size_t sm3_merkle_inclusion_proof(const sm3_merkle *t, uint64_t index, uint64_t size,
+                                  uint8_t (*proof)[32]) {
+    size_t count = 0;
+    if (size > t->leaves || index >= size) return (size_t)-1;
+    inclusion_path(t, index, 0, size, proof, &count);
+    return count;
+}
+
+// SUBPROOF(m, D[start:end], b)
+static void consistency_path(const sm3_merkle *t, uint64_t m, uint64_t start, uint64_t end,
+                             int complete, uint8_t (*proof)[32], size_t *count) {
+    uint64_t size = end - start;
+    if (m == size) {
+        if (!complete) subtree_hash(t, start, end, proof[(*count)++]);
+        return;
+    }
+    uint64_t k = split_point(size);
+    if (m <= k) {
+        consistency_path(t, m, start, start + k, complete, proof, count);
+        subtree_hash(t, start + k, end, proof[(*count)++]);
+    } else {
+        consistency_path(t, m - k, start + k, end, 0, proof, count);
+        subtree_hash(t, start, start + k, proof[(*count)++]);
+    }
+}
+
+size_t sm3_merkle_consistency_proof(const sm3_merkle *t, uint64_t old_size, uint64_t new_size,
+                                    uint8_t (*proof)[32]) {
+    size_t count = 0;
+    if (new_size > t->leaves || old_size > new_size) return (size_t)-1;
+    if (old_size == 0 || old_size == new_size) return 0;
+    consistency_path(t, old_size, 0, new_size, 1, proof, &count);
+    return count;
+}
+
+/* ===== 校验（RFC 9162 2.1.3.2 / 2.1.4.2），不需要树本身 ===== */
+
+int sm3_merkle_verify_inclusion(const uint8_t leaf_hash[32], uint64_t index, uint64_t size,
+                                const uint8_t (*proof)[32], size_t count, const uint8_t root[32]) {
+    uint8_t r[32];
+    uint64_t fn = index, sn = size - 1;
+    if (index >= size) return 0;
+    memcpy(r, leaf_hash, 32);
+    for (size_t i = 0; i < count; i++) {
+        if (sn == 0) return 0;
+        if ((fn & 1) || fn == sn) {
+            node_hash(proof[i], r, r);
+            while (!(fn & 1) && fn != 0) {
+                fn >>= 1;
+                sn >>= 1;
+            }
+        } else {
+            node_hash(r, proof[i], r);
+        }
+        fn >>= 1;
+        sn >>= 1;
+    }
+    return sn == 0 && sm3_ct_equal(r, root, 32);
+}
+
+int sm3_merkle_verify_consistency(uint64_t old_size, uint64_t new_size,
+                                  const uint8_t old_root[32], const uint8_t new_root[32],
+                                  const uint8_t (*proof)[32], size_t count) {
+    if (old_size > new_size) return 0;
+    if (old_size == new_size) return count == 0 && sm3_ct_equal(old_root, new_root, 32);
+    if (old_size == 0) return count == 0;
+
+    // old_size 为 2 的幂时旧根本身就是新树里的一个完整节点，证明里省略了它
+    const uint8_t *first;
+    size_t i = 0;
+    if ((old_size & (old_size - 1)) == 0) {
+        first = old_root;
+    } else {
+        if (count == 0) return 0;
+        first = proof[i++];
+    }
+
+    uint64_t fn = old_size - 1, sn = new_size - 1;
+    while (fn & 1) {
+        fn >>= 1;
+        sn >>= 1;
+    }
+    uint8_t fr[32], sr[32];
+    memcpy(fr, first, 32);
+    memcpy(sr, first, 32);
+    for (; i < count; i++) {
+        if (sn == 0) return 0;
+        if ((fn & 1) || fn == sn) {
+            node_hash(proof[i], fr, fr);
+            node_hash(proof[i], sr, sr);
+            while (!(fn & 1) && fn != 0) {
+                fn >>= 1;
+                sn >>= 1;
+            }
+        } else {
+            node_hash(sr, proof[i], sr);
+        }
+        fn >>= 1;
+        sn >>= 1;
+    }
+    return sn == 0 && sm3_ct_equal(fr, old_root, 32) && sm3_ct_equal(sr, new_root, 32);
+}
@@ -1,11 +1,12 @@
-#include <stdio.h>
 #include <stdint.h>
 #include <string.h>
-#include <time.h>    // 添加clock_t和clock()所需头文件
-#include <stdlib.h>  // 添加malloc和free所需头文件
+#include "sm3_promax.h"
+#include "sm3_simd_sched.h"
+#include "../common/cpu_features.h"
+#include "../common/gm_trace.h"
 
 // SM3算法的初始向量(IV)
-static const uint32_t IV[8] = {
+const uint32_t SM3_IV[8] = {
     0x7380166f, 0x4914b2b9, 0x172442d7, 0xda8a0600,
     0xa96f30bc, 0x163138aa, 0xe38dee4d, 0xb0fb0e4e
 };
@@ -62,7 +63,7 @@ void sm3_one_block(uint32_t *hash, const uint8_t *block) {
     
     // 优化压缩函数：减少临时变量，展开关键路径
     for (int j = 0; j < 64; j++) {
-        uint32_t T = TJ_CONST[j >> 4]; // 使用预计算常量表
+        uint32_t T = TJ_CONST[j >= 16]; // 使用预计算常量表（前16轮/后48轮）
         uint32_t SS1 = RL(RL(A, 12) + E + RL(T, j % 32), 7);
         uint32_t SS2 = SS1 ^ RL(A, 12);
         uint32_t TT1 = FF(A, B, C, j) + D + SS2 + Wj1[j];
@@ -90,96 +91,109 @@ void sm3_one_block(uint32_t *hash, const uint8_t *block) {
     hash[7] ^= H;
 }
 
+// 多块压缩：按 CPUID 选择消息扩展的实现，sm3_one_block 保留作参照实现
+struct sm3_compress_impl {
+    void (*fn)(uint32_t *hash, const uint8_t *data, size_t nblocks);
+    const char *name;
+};
+
+static sm3_compress_impl sm3_pick_compress(void) {
+    const cpu_features_t *f = cpu_features();
+    if (f->avx2) return {sm3_compress_avx2, "avx2-sched"};
+    if (f->ssse3) return {sm3_compress_ssse3, "ssse3-sched"};
+    return {sm3_compress_unrolled, "unrolled"};
+}
+
+// 首次调用时选定，之后不再检测
+static const sm3_compress_impl &sm3_selected(void) {
+    static const sm3_compress_impl impl = sm3_pick_compress();
+    return impl;
+}
+
+void sm3_compress_blocks(uint32_t *hash, const uint8_t *data, size_t nblocks) {
+    GM_TRACE_ZONE(GMCRYPTO_ZONE_SM3_COMPRESS, nblocks * 64);
+    sm3_selected().fn(hash, data, nblocks);
+}
+
+const char *sm3_compress_name(void) {
+    return sm3_selected().name;
+}
+
+// 生成尾部填充：剩余数据 + 0x80 + 若干 0 + 64 位大端比特长度
+size_t sm3_pad_tail(const uint8_t *tail, uint64_t len, uint8_t out[128]) {
+    size_t remaining = (size_t)(len % 64);
+    memset(out, 0, 128);
+    if (remaining > 0) {
+        memcpy(out, tail, remaining);
+    }
+    out[remaining] = 0x80;
+
+    // 如果剩余空间不足8字节（长度字段），需要额外块
+    size_t blocks = (remaining < 56) ? 1 : 2;
+    uint64_t total_bits = len * 8;
+    uint8_t *p = out + blocks * 64 - 8;
+    for (int i = 0; i < 8; i++) {
+        p[i] = (uint8_t)(total_bits >> (56 - 8 * i));
+    }
+    return blocks;
+}
+
 // 优化后的完整哈希计算
 void sm3_hash(const uint8_t *data, size_t len, uint32_t *hash) {
     // 初始化哈希值
-    memcpy(hash, IV, sizeof(IV));
+    memcpy(hash, SM3_IV, sizeof(SM3_IV));
     
     // 处理完整块
     size_t block_count = len / 64;
-    for (size_t i = 0; i < block_count; i++) {
-        sm3_one_block(hash, data + i * 64);
-    }
+    sm3_compress_blocks(hash, data, block_count);
     
-    // 处理最后一个块
-    size_t remaining = len % 64;
-    uint8_t last_block[128] = {0}; // 最多需要两个块的空间
-    size_t padding_start = remaining;
-    
-    // 复制剩余数据
-    if (remaining > 0) {
-        memcpy(last_block, data + block_count * 64, remaining);
-    }
-    
-    // 添加填充位
-    last_block[padding_start] = 0x80;
-    padding_start++;
-    
-    // 如果剩余空间不足8字节（长度字段），需要额外块
-    size_t total_bits = len * 8;
-    if (remaining < 56) {
-        // 当前块有足够空间
-        last_block[63] = (uint8_t)(total_bits);
-        last_block[62] = (uint8_t)(total_bits >> 8);
-        last_block[61] = (uint8_t)(total_bits >> 16);
-        last_block[60] = (uint8_t)(total_bits >> 24);
-        last_block[59] = (uint8_t)(total_bits >> 32);
-        last_block[58] = (uint8_t)(total_bits >> 40);
-        last_block[57] = (uint8_t)(total_bits >> 48);
-        last_block[56] = (uint8_t)(total_bits >> 56);
-        sm3_one_block(hash, last_block);
-    } else {
-        // 需要两个块：填充块和长度块
-        last_block[63] = 0; // 确保长度字段在第二个块
-        sm3_one_block(hash, last_block);
-        
-        uint8_t length_block[64] = {0};
-        length_block[63] = (uint8_t)(total_bits);
-        length_block[62] = (uint8_t)(total_bits >> 8);
-        length_block[61] = (uint8_t)(total_bits >> 16);
-        length_block[60] = (uint8_t)(total_bits >> 24);
-        length_block[59] = (uint8_t)(total_bits >> 32);
-        length_block[58] = (uint8_t)(total_bits >> 40);
-        length_block[57] = (uint8_t)(total_bits >> 48);
-        length_block[56] = (uint8_t)(total_bits >> 56);
-        sm3_one_block(hash, length_block);
-    }
+    // 处理最后一个块（最多需要两个块的空间）
+    uint8_t last_block[128];
+    size_t tail_blocks = sm3_pad_tail(data + block_count * 64, len, last_block);
+    sm3_compress_blocks(hash, last_block, tail_blocks);
 }
 
-// 测试函数
-void test_case(const char *test_name, const uint8_t *data, size_t len) {
-    uint32_t hash[8];
-    
-    // 计时开始
-    clock_t start = clock();
-    sm3_hash(data, len, hash);
-    clock_t end = clock();
-    
-    printf("%s: ", test_name);
-    for (int i = 0; i < 8; i++) {
-        printf("%08x ", hash[i]);
-    }
-    printf("\nTime: %.2f ms\n", (double)(end - start) * 1000 / CLOCKS_PER_SEC);
+// 流式接口：初始化上下文
+void sm3_init(sm3_ctx *ctx) {
+    memcpy(ctx->hash, SM3_IV, sizeof(SM3_IV));
+    ctx->total = 0;
+    ctx->buf_len = 0;
 }
 
-int main() {
-    // 测试用例1: "abc"
-    const uint8_t test1[] = {'a', 'b', 'c'};
-    test_case("Test 1 (\"abc\")", test1, sizeof(test1));
-    
-    // 测试用例2: 64字节消息
-    uint8_t test2[64];
-    for (int i = 0; i < 64; i++) test2[i] = 'a' + (i % 26);
-    test_case("Test 2 (64-byte)", test2, sizeof(test2));
-    
-    // 测试用例3: 长消息 (1MB)
-    size_t long_len = 1024 * 1024;
-    uint8_t *long_data = (uint8_t*)malloc(long_len);
-    if (long_data) {
-        memset(long_data, 0x61, long_len); // 全部填充'a'
-        test_case("Test 3 (1MB)", long_data, long_len);
-        free(long_data);
+// 流式接口：追加数据
+// 先补齐缓冲区中的残块，之后的完整块直接在调用者缓冲区上压缩，不做拷贝，只留不足 64 字节的尾巴
+void sm3_update(sm3_ctx *ctx, const uint8_t *data, size_t len) {
+    ctx->total += len;
+
+    if (ctx->buf_len > 0) {
+        size_t need = 64 - ctx->buf_len;
+        if (len < need) {
+            memcpy(ctx->buf + ctx->buf_len, data, len);
+            ctx->buf_len += len;
+            return;
+        }
+        memcpy(ctx->buf + ctx->buf_len, data, need);
+        sm3_compress_blocks(ctx->hash, ctx->buf, 1);
+        ctx->buf_len = 0;
+        data += need;
+        len -= need;
     }
-    
-    return 0;
-}
\ No newline at end of file
+
+    size_t blocks = len / 64;
+    sm3_compress_blocks(ctx->hash, data, blocks);
+    data += blocks * 64;
+    len -= blocks * 64;
+
+    if (len > 0) {
+        memcpy(ctx->buf, data, len);
+        ctx->buf_len = len;
+    }
+}
+
+// 流式接口：填充并输出摘要，长度按 64 位累计
+void sm3_final(sm3_ctx *ctx, uint32_t *hash) {
+    uint8_t last_block[128];
+    size_t tail_blocks = sm3_pad_tail(ctx->buf, ctx->total, last_block);
+    sm3_compress_blocks(ctx->hash, last_block, tail_blocks);
+    memcpy(hash, ctx->hash, sizeof(ctx->hash));
+}
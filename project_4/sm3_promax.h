@@ -0,0 +1,189 @@
+#ifndef SM3_PROMAX_H
+#define SM3_PROMAX_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// 接口按 C 链接导出，C 与 C++ 调用方共用同一个库
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// SM3算法的初始向量(IV)
+extern const uint32_t SM3_IV[8];
+
+// 单块压缩：hash 为 8 字状态，block 为 64 字节消息块
+void sm3_one_block(uint32_t *hash, const uint8_t *block);
+
+// 连续压缩 nblocks 个块，sm3_hash / 流式接口都走这里；实现在加载时按 CPUID 选定
+void sm3_compress_blocks(uint32_t *hash, const uint8_t *data, size_t nblocks);
+const char *sm3_compress_name(void);
+
+// 全展开内核：编译期轮常量、前后两段轮函数分别实例化、16 字滚动消息窗口
+void sm3_compress_unrolled(uint32_t *hash, const uint8_t *data, size_t nblocks);
+
+// 一次性计算完整消息的哈希
+void sm3_hash(const uint8_t *data, size_t len, uint32_t *hash);
+
+// 生成消息尾部的填充块（剩余字节 + 0x80 + 0 + 64 位比特长度），返回块数（1 或 2）
+// tail 指向最后不足 64 字节的数据，len 为消息总字节数
+size_t sm3_pad_tail(const uint8_t *tail, uint64_t len, uint8_t out[128]);
+
+/* ===== 流式 SM3：数据可分多次输入，内存占用与消息长度无关 ===== */
+
+typedef struct {
+    uint32_t hash[8];   // 当前压缩状态
+    uint64_t total;     // 已输入的总字节数（64 位，不会在 512MB 处溢出）
+    uint8_t buf[64];    // 未凑满一块的尾部数据
+    size_t buf_len;
+} sm3_ctx;
+
+void sm3_init(sm3_ctx *ctx);
+void sm3_update(sm3_ctx *ctx, const uint8_t *data, size_t len);
+void sm3_final(sm3_ctx *ctx, uint32_t *hash);
+
+/* ===== 树模式 SM3（可选，多核并行，结果与标准 SM3 摘要不同） =====
+ *
+ * 构造（所有整数均为大端）：
+ *   前缀块 P(type) 为 64 字节：byte0 = type（0 叶子、1 内部节点、2 根），
+ *   byte1..7 = "SM3TREE"，byte8..15 = chunk_size，byte16..19 = fanout，其余为 0。
+ *   叶子：   L_i  = SM3(P(0) || 第 i 个 chunk)，最后一个 chunk 可以不满，空输入视为一个空 chunk
+ *   内部节点：N    = SM3(P(1) || 最多 fanout 个子节点摘要依次拼接)，每层从左到右分组
+ *   根：     root = SM3(P(2) || 64 位输入总长度 || 顶层节点摘要)
+ * 输出只由输入数据、chunk_size、fanout 决定，与线程数无关。
+ */
+typedef struct {
+    size_t chunk_size;  // 叶子大小，64 的倍数，默认 1MB
+    unsigned fanout;    // 内部节点的子节点数，>= 2，默认 16
+    unsigned threads;   // 线程数，0 表示全部核心
+} sm3_tree_params;
+
+void sm3_tree_default_params(sm3_tree_params *params);
+
+// 参数非法时返回 -1，成功返回 0
+int sm3_tree_hash(const uint8_t *data, size_t len, const sm3_tree_params *params,
+                  uint32_t *hash);
+
+/* ===== 多缓冲 SM3：一次并行处理多条独立消息 ===== */
+
+// 多缓冲实现：标量 / SSSE3(4路) / AVX2(8路) / AVX-512(16路)
+typedef enum sm3_mb_isa {
+    SM3_MB_SCALAR = 0,
+    SM3_MB_SSSE3  = 1,
+    SM3_MB_AVX2   = 2,
+    SM3_MB_AVX512 = 3
+} sm3_mb_isa;
+
+// 当前 CPU 支持的最宽实现（CPUID 检测）
+sm3_mb_isa sm3_mb_best_isa(void);
+int sm3_mb_isa_supported(sm3_mb_isa isa);
+const char *sm3_mb_isa_name(sm3_mb_isa isa);
+
+// 用指定实现哈希 n 条消息，out[i] 与 sm3_hash(msgs[i], lens[i]) 结果相同
+void sm3_hash_many_isa(sm3_mb_isa isa, const uint8_t *const *msgs,
+                       const size_t *lens, uint32_t (*out)[8], size_t n);
+
+// 自动选择实现，消息条数不限，短消息结束后车道立即装入下一条
+void sm3_hash_many(const uint8_t *const *msgs, const size_t *lens,
+                   uint32_t (*out)[8], size_t n);
+
+void sm3_hash_x4(const uint8_t *msgs[4], const size_t lens[4], uint32_t out[4][8]);
+void sm3_hash_x8(const uint8_t *msgs[8], const size_t lens[8], uint32_t out[8][8]);
+void sm3_hash_x16(const uint8_t *msgs[16], const size_t lens[16], uint32_t out[16][8]);
+
+/* ===== HMAC-SM3 与 SM2 密钥派生函数（GB/T 32918 的 KDF） =====
+ *
+ * 每个密钥预先压缩好 (K ^ ipad)、(K ^ opad) 两个块，保存压缩后的中间状态；
+ * 之后每次计算 MAC 少做两次压缩，也不用把消息拷贝到 ipad 后面。
+ * 批量接口把所有消息的内层哈希、再把所有外层哈希分别交给多缓冲内核并行压缩，
+ * 每条消息可以用不同的密钥。MAC 与 KDF 输出为字节串（摘要按大端序列化）。
+ */
+typedef struct {
+    uint32_t istate[8];   // IV 压缩 K ^ ipad 之后的状态
+    uint32_t ostate[8];   // IV 压缩 K ^ opad 之后的状态
+} sm3_hmac_key;
+
+// 密钥长于 64 字节时先取 SM3(K)
+void sm3_hmac_key_init(sm3_hmac_key *key, const uint8_t *k, size_t k_len);
+
+// 流式 HMAC：内层就是从 istate 继续的 sm3_ctx
+typedef struct {
+    sm3_ctx inner;
+    uint32_t ostate[8];
+} sm3_hmac_ctx;
+
+void sm3_hmac_init(sm3_hmac_ctx *ctx, const sm3_hmac_key *key);
+void sm3_hmac_update(sm3_hmac_ctx *ctx, const uint8_t *data, size_t len);
+void sm3_hmac_final(sm3_hmac_ctx *ctx, uint8_t mac[32]);
+
+void sm3_hmac(const sm3_hmac_key *key, const uint8_t *data, size_t len, uint8_t mac[32]);
+
+// 批量：macs[i] = HMAC(keys[i], msgs[i])
+void sm3_hmac_many(const sm3_hmac_key *const *keys, const uint8_t *const *msgs,
+                   const size_t *lens, uint8_t (*macs)[32], size_t n);
+
+// 批量校验：tags[i] 为 tag_len（1..32）字节的（可截断）标签，比较按常数时间进行；
+// ok[i] 写 1 或 0，返回通过的条数
+size_t sm3_hmac_verify_many(const sm3_hmac_key *const *keys, const uint8_t *const *msgs,
+                            const size_t *lens, const uint8_t *const *tags, size_t tag_len,
+                            int *ok, size_t n);
+
+// 常数时间比较：耗时只与 len 有关，相等返回 1
+int sm3_ct_equal(const uint8_t *a, const uint8_t *b, size_t len);
+
+// KDF(Z, klen) = SM3(Z || 1) || SM3(Z || 2) || ... 取前 klen 字节，计数器为 32 位大端
+// Z 的完整块只压缩一次，各计数器的尾块走多缓冲内核
+void sm3_kdf(const uint8_t *z, size_t z_len, uint8_t *out, size_t klen);
+
+// 批量：out[i] = KDF(z[i], klen)
+void sm3_kdf_many(const uint8_t *const *z, const size_t *z_lens,
+                  uint8_t *const *out, size_t klen, size_t n);
+
+/* ===== 增量 Merkle 累加器（仅追加日志） =====
+ *
+ * 树形与证明格式同 RFC 6962 / RFC 9162，哈希为 SM3：
+ *   叶子 = SM3(0x00 || data)，内部节点 = SM3(0x01 || left || right)，空树的根 = SM3("")。
+ * 追加均摊 O(1) 次压缩，根与证明 O(log n)；节点按后序连续存放在 mmap 的文件里，
+ * 关闭后重新打开不需要重建。同一层新出现的内部节点一起交给多缓冲内核哈希。
+ * 不加锁：同一棵树不能在多个线程里同时修改。
+ */
+typedef struct sm3_merkle sm3_merkle;
+
+// 证明最多包含的哈希个数（2^64 个叶子的一致性证明不超过 2 * 64 个）
+#define SM3_MERKLE_MAX_PROOF 128
+
+// path 为 NULL 时只在内存中；文件已存在则校验后直接映射，不存在则创建。失败返回 NULL
+sm3_merkle *sm3_merkle_open(const char *path);
+int sm3_merkle_sync(sm3_merkle *tree);
+void sm3_merkle_close(sm3_merkle *tree);
+uint64_t sm3_merkle_size(const sm3_merkle *tree);
+
+// 成功返回 0；文件扩展失败返回 -1，树保持原状
+int sm3_merkle_append(sm3_merkle *tree, const uint8_t *data, size_t len);
+int sm3_merkle_append_many(sm3_merkle *tree, const uint8_t *const *data, const size_t *lens, size_t n);
+
+void sm3_merkle_leaf_hash(const uint8_t *data, size_t len, uint8_t out[32]);
+int sm3_merkle_leaf(const sm3_merkle *tree, uint64_t index, uint8_t out[32]);
+
+// 当前的根，或者前 size 个叶子构成的历史树的根
+int sm3_merkle_root(const sm3_merkle *tree, uint8_t root[32]);
+int sm3_merkle_root_at(const sm3_merkle *tree, uint64_t size, uint8_t root[32]);
+
+// proof 至少 SM3_MERKLE_MAX_PROOF 项，返回写入的个数，参数非法返回 (size_t)-1
+size_t sm3_merkle_inclusion_proof(const sm3_merkle *tree, uint64_t index, uint64_t size,
+                                  uint8_t (*proof)[32]);
+size_t sm3_merkle_consistency_proof(const sm3_merkle *tree, uint64_t old_size, uint64_t new_size,
+                                    uint8_t (*proof)[32]);
+
+// 校验只需要证明与根，通过返回 1
+int sm3_merkle_verify_inclusion(const uint8_t leaf_hash[32], uint64_t index, uint64_t size,
+                                const uint8_t (*proof)[32], size_t count, const uint8_t root[32]);
+int sm3_merkle_verify_consistency(uint64_t old_size, uint64_t new_size,
+                                  const uint8_t old_root[32], const uint8_t new_root[32],
+                                  const uint8_t (*proof)[32], size_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SM3_PROMAX_H
@@ -0,0 +1,84 @@
+#ifndef SM3_ROUNDS_H
+#define SM3_ROUNDS_H
+
+#include <stdint.h>
+
+/*
+ * 全展开 SM3 压缩函数共用的轮函数模板
+ * - T_j <<< j 在编译期算好，轮内不再取模、移位
+ * - 前 16 轮与后 48 轮的布尔函数由模板参数选定，轮内无分支
+ * - 寄存器不做 8 次轮换赋值，而是每 4 轮循环一次变量角色（见 SM3_R4 宏）
+ * 放在匿名命名空间里：各 ISA 翻译单元按各自的 target 编译出私有副本。
+ */
+namespace {
+
+constexpr uint32_t rotl_c(uint32_t x, int k) {
+    return k ? ((x << k) | (x >> (32 - k))) : x;
+}
+
+struct sm3_tj_table {
+    uint32_t t[64];
+    constexpr sm3_tj_table() : t() {
+        for (int j = 0; j < 64; j++) {
+            t[j] = rotl_c(j < 16 ? 0x79cc4519u : 0x7a879d8au, j % 32);
+        }
+    }
+};
+
+constexpr sm3_tj_table SM3_TJ;
+
+inline uint32_t rl(uint32_t x, int k) {
+    return (x << k) | (x >> (32 - k));
+}
+
+inline uint32_t p0(uint32_t x) { return x ^ rl(x, 9) ^ rl(x, 17); }
+inline uint32_t p1(uint32_t x) { return x ^ rl(x, 15) ^ rl(x, 23); }
+
+template <bool LATE> struct sm3_bool;
+
+template <> struct sm3_bool<false> {
+    static inline uint32_t ff(uint32_t x, uint32_t y, uint32_t z) { return x ^ y ^ z; }
+    static inline uint32_t gg(uint32_t x, uint32_t y, uint32_t z) { return x ^ y ^ z; }
+};
+
+template <> struct sm3_bool<true> {
+    static inline uint32_t ff(uint32_t x, uint32_t y, uint32_t z) { return (x & y) | (z & (x | y)); }
+    static inline uint32_t gg(uint32_t x, uint32_t y, uint32_t z) { return z ^ (x & (y ^ z)); }
+};
+
+// 第 J 轮：就地更新 B、D、F、H，调用方轮换参数顺序代替寄存器搬移
+template <int J>
+inline void sm3_round(uint32_t A, uint32_t &B, uint32_t C, uint32_t &D,
+                      uint32_t E, uint32_t &F, uint32_t G, uint32_t &H,
+                      uint32_t wj, uint32_t wj1) {
+    const uint32_t a12 = rl(A, 12);
+    const uint32_t ss1 = rl(a12 + E + SM3_TJ.t[J], 7);
+    const uint32_t ss2 = ss1 ^ a12;
+    const uint32_t tt1 = sm3_bool<(J >= 16)>::ff(A, B, C) + D + ss2 + wj1;
+    const uint32_t tt2 = sm3_bool<(J >= 16)>::gg(E, F, G) + H + ss1 + wj;
+    B = rl(B, 9);
+    D = tt1;
+    F = rl(F, 19);
+    H = p0(tt2);
+}
+
+} // namespace
+
+// STEP<J>(A..H, ...) 为一轮；4 轮后变量角色回到原位，64 轮共 16 组
+#define SM3_R4(STEP, J, ...)                                   \
+    STEP<(J) + 0>(A, B, C, D, E, F, G, H, __VA_ARGS__);        \
+    STEP<(J) + 1>(D, A, B, C, H, E, F, G, __VA_ARGS__);        \
+    STEP<(J) + 2>(C, D, A, B, G, H, E, F, __VA_ARGS__);        \
+    STEP<(J) + 3>(B, C, D, A, F, G, H, E, __VA_ARGS__)
+
+#define SM3_ROUNDS_64(STEP, ...)                                                          \
+    SM3_R4(STEP, 0, __VA_ARGS__);  SM3_R4(STEP, 4, __VA_ARGS__);                          \
+    SM3_R4(STEP, 8, __VA_ARGS__);  SM3_R4(STEP, 12, __VA_ARGS__);                         \
+    SM3_R4(STEP, 16, __VA_ARGS__); SM3_R4(STEP, 20, __VA_ARGS__);                         \
+    SM3_R4(STEP, 24, __VA_ARGS__); SM3_R4(STEP, 28, __VA_ARGS__);                         \
+    SM3_R4(STEP, 32, __VA_ARGS__); SM3_R4(STEP, 36, __VA_ARGS__);                         \
+    SM3_R4(STEP, 40, __VA_ARGS__); SM3_R4(STEP, 44, __VA_ARGS__);                         \
+    SM3_R4(STEP, 48, __VA_ARGS__); SM3_R4(STEP, 52, __VA_ARGS__);                         \
+    SM3_R4(STEP, 56, __VA_ARGS__); SM3_R4(STEP, 60, __VA_ARGS__)
+
+#endif // SM3_ROUNDS_H
@@ -0,0 +1,36 @@
+// 单消息 SM3：AVX2 消息扩展（W1 每次 8 个字）
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC target("avx2")
+#endif
+#define SM3_SIMD_DEFINE_KERNEL
+#include "sm3_simd_sched.h"
+
+namespace {
+
+template <int J, bool EVEN = (J % 8 == 0)>
+struct w1_avx2_at {
+    static inline void run(sm3_vsched &) {}
+};
+
+template <int J>
+struct w1_avx2_at<J, true> {
+    static inline void run(sm3_vsched &s) {
+        __m256i lo = _mm256_inserti128_si256(_mm256_castsi128_si256(s.X0), s.X1, 1);
+        __m256i hi = _mm256_inserti128_si256(_mm256_castsi128_si256(s.X1), s.X2, 1);
+        _mm256_store_si256((__m256i *)(s.W1 + J), _mm256_xor_si256(lo, hi));
+    }
+};
+
+// 每 8 轮一次写 8 个 W1
+struct w1_avx2 {
+    template <int J>
+    static inline void w1(sm3_vsched &s) {
+        w1_avx2_at<J>::run(s);
+    }
+};
+
+} // namespace
+
+void sm3_compress_avx2(uint32_t *hash, const uint8_t *data, size_t nblocks) {
+    sm3_compress_simd<w1_avx2>(hash, data, nblocks);
+}
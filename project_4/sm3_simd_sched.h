@@ -0,0 +1,119 @@
+#ifndef SM3_SIMD_SCHED_H
+#define SM3_SIMD_SCHED_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// 单消息 SM3：消息扩展用 SIMD 计算，轮函数仍为全展开标量
+void sm3_compress_ssse3(uint32_t *hash, const uint8_t *data, size_t nblocks);
+void sm3_compress_avx2(uint32_t *hash, const uint8_t *data, size_t nblocks);
+
+#endif // SM3_SIMD_SCHED_H
+
+/*
+ * 以下模板由各 ISA 翻译单元在 #pragma GCC target 下定义 SM3_SIMD_DEFINE_KERNEL 后包含。
+ * S::w1<J>(s) 负责写出 W1[J ..] = W[J ..] ^ W[J + 4 ..]：SSSE3 每 4 轮写 4 个字，AVX2 每 8 轮写 8 个字。
+ */
+#ifdef SM3_SIMD_DEFINE_KERNEL
+#include <immintrin.h>
+#include "sm3_rounds.h"
+
+namespace {
+
+template <int k>
+inline __m128i rotl_epi32(__m128i x) {
+    return _mm_or_si128(_mm_slli_epi32(x, k), _mm_srli_epi32(x, 32 - k));
+}
+
+inline __m128i sm3_p1_epi32(__m128i x) {
+    return _mm_xor_si128(x, _mm_xor_si128(rotl_epi32<15>(x), rotl_epi32<23>(x)));
+}
+
+/*
+ * 消息扩展状态：窗口 X0..X3 = W[j-16 .. j-1] 全程留在寄存器里，用 palignr 拼出错位的字。
+ * W[j+3] 依赖本步的 W[j]：先令该项为 0 并行算出 4 个字，再利用 P1 的线性补上
+ * P1(W[j] <<< 15)，所以每步 3 个字直接得到、1 个字经修正得到。
+ * 扩展穿插在轮函数之间，其延迟被轮函数的依赖链掩盖。
+ */
+struct sm3_vsched {
+    __m128i X0, X1, X2, X3;
+    alignas(32) uint32_t W[68];
+    alignas(32) uint32_t W1[64];
+
+    // 大端加载：pshufb 一次翻转 4 个字的字节序
+    inline void load(const uint8_t *data) {
+        const __m128i bswap = _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+        X0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 0)), bswap);
+        X1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 16)), bswap);
+        X2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 32)), bswap);
+        X3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 48)), bswap);
+        _mm_store_si128((__m128i *)(W + 0), X0);
+        _mm_store_si128((__m128i *)(W + 4), X1);
+        _mm_store_si128((__m128i *)(W + 8), X2);
+        _mm_store_si128((__m128i *)(W + 12), X3);
+    }
+
+    // 算出 W[j .. j+3] 并滑动窗口
+    inline void next(int j) {
+        __m128i b = _mm_alignr_epi8(X2, X1, 12);   // W[j-9 .. j-6]
+        __m128i c = _mm_srli_si128(X3, 4);         // W[j-3 .. j-1], 0
+        __m128i d = _mm_alignr_epi8(X1, X0, 12);   // W[j-13 .. j-10]
+        __m128i e = _mm_alignr_epi8(X3, X2, 8);    // W[j-6 .. j-3]
+        __m128i t = _mm_xor_si128(_mm_xor_si128(X0, b), rotl_epi32<15>(c));
+        __m128i w = _mm_xor_si128(_mm_xor_si128(sm3_p1_epi32(t), rotl_epi32<7>(d)), e);
+        __m128i f = rotl_epi32<15>(_mm_slli_si128(w, 12));
+        w = _mm_xor_si128(w, sm3_p1_epi32(f));
+        _mm_store_si128((__m128i *)(W + j), w);
+        X0 = X1; X1 = X2; X2 = X3; X3 = w;
+    }
+
+    // W 已算完，最后几轮只滑动窗口（X3 不再使用）
+    inline void slide() {
+        X0 = X1; X1 = X2; X2 = X3;
+    }
+};
+
+// 每 4 轮推进一步扩展，领先两步：第 J 轮算出 W[J+12 .. J+15]，此时窗口 X0..X3 = W[J .. J+15]，
+// 随后由 S 写出本组（或本两组）轮要用的 W1
+template <int J, bool NEED = (J % 4 == 0)>
+struct sm3_vsched_hook {
+    template <class S> static inline void run(sm3_vsched &) {}
+};
+
+template <int J>
+struct sm3_vsched_hook<J, true> {
+    template <class S> static inline void run(sm3_vsched &s) {
+        if (J >= 4 && J <= 52) s.next(J + 12);
+        if (J > 52) s.slide();
+        S::template w1<J>(s);
+    }
+};
+
+template <class S>
+struct sm3_vstep {
+    template <int J>
+    static inline void step(uint32_t A, uint32_t &B, uint32_t C, uint32_t &D,
+                            uint32_t E, uint32_t &F, uint32_t G, uint32_t &H, sm3_vsched &s) {
+        sm3_vsched_hook<J>::template run<S>(s);
+        sm3_round<J>(A, B, C, D, E, F, G, H, s.W[J], s.W1[J]);
+    }
+};
+
+template <class S>
+inline void sm3_compress_simd(uint32_t *hash, const uint8_t *data, size_t nblocks) {
+    sm3_vsched s;
+    uint32_t A = hash[0], B = hash[1], C = hash[2], D = hash[3];
+    uint32_t E = hash[4], F = hash[5], G = hash[6], H = hash[7];
+
+    for (; nblocks > 0; nblocks--, data += 64) {
+        s.load(data);
+
+        SM3_ROUNDS_64(sm3_vstep<S>::template step, s);
+
+        A = hash[0] ^= A; B = hash[1] ^= B; C = hash[2] ^= C; D = hash[3] ^= D;
+        E = hash[4] ^= E; F = hash[5] ^= F; G = hash[6] ^= G; H = hash[7] ^= H;
+    }
+}
+
+} // namespace
+#endif // SM3_SIMD_DEFINE_KERNEL
@@ -0,0 +1,21 @@
+// 单消息 SM3：SSSE3 消息扩展
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC target("ssse3")
+#endif
+#define SM3_SIMD_DEFINE_KERNEL
+#include "sm3_simd_sched.h"
+
+namespace {
+
+struct w1_sse {
+    template <int J>
+    static inline void w1(sm3_vsched &s) {
+        _mm_store_si128((__m128i *)(s.W1 + J), _mm_xor_si128(s.X0, s.X1));
+    }
+};
+
+} // namespace
+
+void sm3_compress_ssse3(uint32_t *hash, const uint8_t *data, size_t nblocks) {
+    sm3_compress_simd<w1_sse>(hash, data, nblocks);
+}
@@ -0,0 +1,95 @@
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include "sm3_promax.h"
+#include "../common/thread_pool.h"
+
+/*
+ * 树模式 SM3，构造见 sm3_promax.h。
+ * 三种前缀块的压缩结果各算一次作为中间状态，叶子的 chunk 随后直接在输入缓冲区上压缩。
+ */
+
+enum { SM3_TREE_LEAF = 0, SM3_TREE_NODE = 1, SM3_TREE_ROOT = 2 };
+
+static void put_be64(uint8_t *p, uint64_t v) {
+    for (int i = 0; i < 8; i++) p[i] = (uint8_t)(v >> (56 - 8 * i));
+}
+
+static void put_be32(uint8_t *p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (24 - 8 * i));
+}
+
+// 压缩前缀块后的上下文
+static void sm3_tree_prefix(sm3_ctx *ctx, int type, const sm3_tree_params *params) {
+    uint8_t block[64] = {0};
+    block[0] = (uint8_t)type;
+    memcpy(block + 1, "SM3TREE", 7);
+    put_be64(block + 8, params->chunk_size);
+    put_be32(block + 16, params->fanout);
+    sm3_init(ctx);
+    sm3_update(ctx, block, sizeof(block));
+}
+
+// 摘要转成大端字节，作为上层节点的输入
+static void digest_bytes(const uint32_t *hash, uint8_t *out) {
+    for (int i = 0; i < 8; i++) put_be32(out + i * 4, hash[i]);
+}
+
+void sm3_tree_default_params(sm3_tree_params *params) {
+    params->chunk_size = 1 << 20;
+    params->fanout = 16;
+    params->threads = 0;
+}
+
+int sm3_tree_hash(const uint8_t *data, size_t len, const sm3_tree_params *params,
+                  uint32_t *hash) {
+    if (params->chunk_size < 64 || params->chunk_size % 64 != 0 || params->fanout < 2) {
+        return -1;
+    }
+
+    sm3_ctx leaf_mid, node_mid, root_ctx;
+    sm3_tree_prefix(&leaf_mid, SM3_TREE_LEAF, params);
+    sm3_tree_prefix(&node_mid, SM3_TREE_NODE, params);
+    sm3_tree_prefix(&root_ctx, SM3_TREE_ROOT, params);
+
+    const size_t chunk = params->chunk_size;
+    const size_t fanout = params->fanout;
+    size_t count = (len == 0) ? 1 : (len + chunk - 1) / chunk;
+    std::vector<uint8_t> level(count * 32);
+    thread_pool pool(params->threads);
+
+    // 叶子层
+    pool.parallel_for(count, [&](size_t i) {
+        size_t off = i * chunk;
+        size_t n = (len - off < chunk) ? len - off : chunk;
+        sm3_ctx ctx = leaf_mid;
+        uint32_t h[8];
+        sm3_update(&ctx, data + off, n);
+        sm3_final(&ctx, h);
+        digest_bytes(h, &level[i * 32]);
+    });
+
+    // 逐层向上合并，直到只剩一个节点
+    while (count > 1) {
+        size_t parents = (count + fanout - 1) / fanout;
+        std::vector<uint8_t> up(parents * 32);
+        pool.parallel_for(parents, [&](size_t i) {
+            size_t first = i * fanout;
+            size_t kids = (count - first < fanout) ? count - first : fanout;
+            sm3_ctx ctx = node_mid;
+            uint32_t h[8];
+            sm3_update(&ctx, &level[first * 32], kids * 32);
+            sm3_final(&ctx, h);
+            digest_bytes(h, &up[i * 32]);
+        });
+        level.swap(up);
+        count = parents;
+    }
+
+    uint8_t total[8];
+    put_be64(total, len);
+    sm3_update(&root_ctx, total, sizeof(total));
+    sm3_update(&root_ctx, &level[0], 32);
+    sm3_final(&root_ctx, hash);
+    return 0;
+}
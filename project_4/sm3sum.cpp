@@ -0,0 +1,212 @@
+// sm3sum：计算文件的 SM3 摘要并报告吞吐
+// 编译：g++ -O2 sm3sum.cpp sm3_promax.cpp sm3_fast.cpp sm3_simd_ssse3.cpp sm3_simd_avx2.cpp sm3_tree.cpp -o sm3sum -lpthread
+// 用法：sm3sum [-q] [-t] [文件...]    无文件或文件名为 "-" 时读标准输入
+//   -q  只输出摘要，不输出吞吐
+//   -t  树模式（仅对普通文件，结果与标准 SM3 不同；管道等输入给出警告并改用标准 SM3）
+//
+// 普通文件用 mmap + MADV_SEQUENTIAL，按窗口预读、处理完即释放，页面直接送入压缩函数；
+// 管道、终端等不能 mmap 的输入用页对齐的大缓冲区 read()。
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <x86intrin.h>
+#include "sm3_promax.h"
+
+static const size_t WINDOW = 8u << 20;     // mmap 每次处理的窗口
+static const size_t READ_BUF = 1u << 20;   // read() 缓冲区大小
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void hash_tree(const uint8_t *p, size_t size, uint32_t *hash) {
+    sm3_tree_params params;
+    sm3_tree_default_params(&params);
+    sm3_tree_hash(p, size, &params, hash);
+}
+
+// mmap 路径：成功返回 0，无法映射返回 1（交给 read 路径），出错返回 -1
+static int hash_mapped(int fd, size_t size, int tree, uint32_t *hash) {
+    uint8_t *p = (uint8_t *)mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED) return 1;
+    madvise(p, size, MADV_SEQUENTIAL);
+
+    if (tree) {
+        // 树模式需要整段数据，多线程并行读取时交给内核按需调页
+        madvise(p, size, MADV_WILLNEED);
+        hash_tree(p, size, hash);
+        munmap(p, size);
+        return 0;
+    }
+
+    sm3_ctx ctx;
+    sm3_init(&ctx);
+    for (size_t off = 0; off < size; off += WINDOW) {
+        size_t n = (size - off < WINDOW) ? size - off : WINDOW;
+        // 提前预读下一个窗口，处理完的窗口立即释放，常驻内存不随文件大小增长
+        if (off + n < size) {
+            size_t ahead = (size - off - n < WINDOW) ? size - off - n : WINDOW;
+            madvise(p + off + n, ahead, MADV_WILLNEED);
+        }
+        sm3_update(&ctx, p + off, n);
+        madvise(p + off, n, MADV_DONTNEED);
+    }
+    sm3_final(&ctx, hash);
+    munmap(p, size);
+    return 0;
+}
+
+// read 路径：管道、标准输入等；出错返回 -1，errno 为出错原因
+static int hash_stream(int fd, uint64_t *total, uint32_t *hash) {
+    void *mem = NULL;
+    int err = posix_memalign(&mem, 4096, READ_BUF);
+    if (err != 0) {
+        errno = err;
+        return -1;
+    }
+    uint8_t *buf = (uint8_t *)mem;
+
+    sm3_ctx ctx;
+    sm3_init(&ctx);
+    *total = 0;
+    for (;;) {
+        ssize_t n = read(fd, buf, READ_BUF);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            err = errno;
+            free(mem);
+            errno = err;
+            return -1;
+        }
+        if (n == 0) break;
+        sm3_update(&ctx, buf, (size_t)n);
+        *total += (uint64_t)n;
+    }
+    sm3_final(&ctx, hash);
+    free(mem);
+    return 0;
+}
+
+// 树模式下不能 mmap 的普通文件（长度报告为 0 的 /proc 文件、mmap 失败等）：整个读进内存再算树哈希，
+// 摘要类型不随读取方式变化；出错返回 -1，errno 为出错原因
+static int hash_stream_tree(int fd, uint64_t *total, uint32_t *hash) {
+    uint8_t *data = NULL;
+    size_t len = 0, cap = 0;
+    for (;;) {
+        if (cap - len < READ_BUF) {
+            cap = cap ? cap * 2 : READ_BUF;
+            uint8_t *p = (uint8_t *)realloc(data, cap);
+            if (!p) {
+                free(data);
+                errno = ENOMEM;
+                return -1;
+            }
+            data = p;
+        }
+        ssize_t n = read(fd, data + len, cap - len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            int err = errno;
+            free(data);
+            errno = err;
+            return -1;
+        }
+        if (n == 0) break;
+        len += (size_t)n;
+    }
+    hash_tree(data, len, hash);
+    *total = len;
+    free(data);
+    return 0;
+}
+
+static int sm3sum_file(const char *path, int tree, int quiet) {
+    int fd = (strcmp(path, "-") == 0) ? STDIN_FILENO : open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "sm3sum: %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    struct stat st;
+    uint32_t hash[8];
+    uint64_t total = 0;
+    int ret = 1, err = 0;
+
+    double t0 = now_sec();
+    unsigned long long c0 = __rdtsc();
+    // 长度为 0 的普通文件不能 mmap，走 read 路径：真正的空文件读到 0 字节，
+    // /proc 下报告长度 0 但有内容的文件也能读全；普通文件在树模式下无论走哪条路径都给出树哈希
+    int regular = fstat(fd, &st) == 0 && S_ISREG(st.st_mode);
+    if (regular && st.st_size > 0) {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        total = (uint64_t)st.st_size;
+        ret = hash_mapped(fd, (size_t)st.st_size, tree, hash);
+    }
+    if (ret == 1 && tree && regular) {
+        ret = hash_stream_tree(fd, &total, hash);
+    } else if (ret == 1) {
+        ret = hash_stream(fd, &total, hash);
+        if (ret == 0 && tree) {
+            fprintf(stderr, "sm3sum: %s: tree mode needs a regular file, using plain SM3\n", path);
+            tree = 0;
+        }
+    }
+    if (ret != 0) err = errno;   // 后面的计时和 close 可能改掉 errno
+    unsigned long long c1 = __rdtsc();
+    double t1 = now_sec();
+
+    if (fd != STDIN_FILENO) close(fd);
+    if (ret != 0) {
+        fprintf(stderr, "sm3sum: %s: %s\n", path, strerror(err));
+        return -1;
+    }
+
+    for (int i = 0; i < 8; i++) {
+        printf("%08x", hash[i]);
+    }
+    printf("  %s\n", path);
+    fflush(stdout);
+
+    // 统计信息走 stderr，stdout 保持与 sha256sum 相同的格式
+    if (!quiet) {
+        double sec = t1 - t0;
+        double gbps = (sec > 0) ? total / sec / 1e9 : 0.0;
+        double cpb = (total > 0) ? (double)(c1 - c0) / total : 0.0;
+        fprintf(stderr, "%s: %llu bytes, %.3f s, %.3f GB/s, %.2f cycles/byte%s\n", path,
+                (unsigned long long)total, sec, gbps, cpb, tree ? " (tree)" : "");
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    int quiet = 0, tree = 0, files = 0, failed = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-q") == 0) {
+            quiet = 1;
+        } else if (strcmp(argv[i], "-t") == 0) {
+            tree = 1;
+        } else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            printf("usage: %s [-q] [-t] [file...]\n", argv[0]);
+            return 0;
+        }
+    }
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-q") == 0 || strcmp(argv[i], "-t") == 0) continue;
+        files++;
+        if (sm3sum_file(argv[i], tree, quiet) != 0) failed = 1;
+    }
+    if (files == 0 && sm3sum_file("-", tree, quiet) != 0) failed = 1;
+
+    return failed;
+}
@@ -0,0 +1,104 @@
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include "sm2_pro.h"
+#include "sm2_ec.h"
+#include "../common/thread_pool.h"
+
+/*
+ * SM2 批量验签
+ * 单条验签的主要开销是两次点乘加一次求逆（结果转仿射）。批量时按组处理：
+ *   1. 检查 r、s 范围，算 t = r + s；
+ *   2. 每个公钥生成 P, 3P, ..., 15P，整组 8m 个点一次求逆转成仿射，后面全用混合加法；
+ *   3. Straus 交错计算 sG + tP；
+ *   4. 整组结果点一次求逆转仿射，逐条比较 (e + x1) mod n 与 r。
+ * 每条签名的结果独立得出，整批不通过时也能直接给出是哪几条。
+ */
+
+static void sm2_verify_chunk(const sm2_pubkey *const *keys, const uint8_t (*e)[32],
+                             const uint8_t (*sigs)[64], int *ok, size_t n) {
+    uint64_t r[SM2_BATCH_CHUNK][4], s[SM2_BATCH_CHUNK][4], t[SM2_BATCH_CHUNK][4];
+    size_t idx[SM2_BATCH_CHUNK], m = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        ok[i] = 0;
+        sm2_from_bytes(r[m], sigs[i]);
+        sm2_from_bytes(s[m], sigs[i] + 32);
+        if (sm2_is_zero(r[m]) || !sm2_lt(r[m], SM2_N) || sm2_is_zero(s[m]) || !sm2_lt(s[m], SM2_N)) continue;
+        fn_add(t[m], r[m], s[m]);
+        if (sm2_is_zero(t[m])) continue;
+        idx[m++] = i;
+    }
+    if (m == 0) return;
+
+    std::vector<sm2_jac> jac(m * SM2_ODD_MULTIPLES);
+    std::vector<sm2_aff> tab(m * SM2_ODD_MULTIPLES);
+    for (size_t j = 0; j < m; j++) {
+        sm2_aff p;
+        sm2_copy(p.x, keys[idx[j]]->x);
+        sm2_copy(p.y, keys[idx[j]]->y);
+        ec_odd_multiples(&jac[j * SM2_ODD_MULTIPLES], &p);
+    }
+    ec_batch_to_affine(tab.data(), jac.data(), jac.size());
+
+    // 结果点复用 jac 的前 m 项
+    for (size_t j = 0; j < m; j++) {
+        ec_mul2_vartime(&jac[j], s[j], &tab[j * SM2_ODD_MULTIPLES], t[j]);
+    }
+    ec_batch_to_affine(tab.data(), jac.data(), m);
+
+    for (size_t j = 0; j < m; j++) {
+        if (sm2_is_zero(jac[j].Z)) continue;    // 无穷远点
+        uint64_t x[4], ev[4];
+        fn_reduce(x, tab[j].x);
+        sm2_from_bytes(ev, e[idx[j]]);
+        fn_reduce(ev, ev);
+        fn_add(x, ev, x);
+        ok[idx[j]] = sm2_equal(x, r[j]);
+    }
+}
+
+size_t sm2_verify_digest_many(const sm2_pubkey *const *keys, const uint8_t (*e)[32],
+                              const uint8_t (*sigs)[64], int *ok, size_t n, unsigned threads) {
+    size_t chunks = (n + SM2_BATCH_CHUNK - 1) / SM2_BATCH_CHUNK;
+    if (chunks <= 1) {
+        sm2_verify_chunk(keys, e, sigs, ok, n);
+    } else {
+        thread_pool pool(threads);
+        pool.parallel_for_stealing(chunks, [&](size_t c) {
+            size_t off = c * SM2_BATCH_CHUNK;
+            size_t cnt = (n - off < SM2_BATCH_CHUNK) ? n - off : SM2_BATCH_CHUNK;
+            sm2_verify_chunk(keys + off, e + off, sigs + off, ok + off, cnt);
+        });
+    }
+    size_t passed = 0;
+    for (size_t i = 0; i < n; i++) passed += ok[i] != 0;
+    return passed;
+}
+
+size_t sm2_verify_many(const sm2_pubkey *const *keys, const uint8_t *const *ids, const size_t *id_lens,
+                       const uint8_t *const *msgs, const size_t *lens, const uint8_t (*sigs)[64],
+                       int *ok, size_t n, unsigned threads) {
+    // Z_A 与 e 只依赖公开数据，先算好再交给批量验签；ID 过长的条目记为不通过
+    std::vector<uint8_t> e(n * 32);
+    std::vector<char> bad(n, 0);
+    for (size_t i = 0; i < n; i++) {
+        const uint8_t *id = ids ? ids[i] : NULL;
+        size_t id_len = id ? id_lens[i] : 0;
+        uint8_t z[32];
+        if (sm2_compute_z(keys[i], id, id_len, z) != 0) {
+            bad[i] = 1;
+            memset(&e[i * 32], 0, 32);
+            continue;
+        }
+        sm2_msg_digest(z, msgs[i], lens[i], &e[i * 32]);
+    }
+    size_t passed = sm2_verify_digest_many(keys, (const uint8_t (*)[32])e.data(), sigs, ok, n, threads);
+    for (size_t i = 0; i < n; i++) {
+        if (bad[i] && ok[i]) {
+            ok[i] = 0;
+            passed--;
+        }
+    }
+    return passed;
+}
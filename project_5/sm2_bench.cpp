@@ -0,0 +1,135 @@
+// SM2 基准：各操作每秒次数（单线程）
+// 编译：g++ -O2 -I../project_4 sm2_bench.cpp sm2_field.cpp sm2_field_adx.cpp sm2_ec.cpp sm2_sign.cpp sm2_batch.cpp ../project_4/sm3_*.cpp -o sm2_bench -lpthread
+// 用法：sm2_bench [每项秒数，默认 0.5]
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include "sm2_pro.h"
+#include "sm2_ec.h"
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+#define NKEYS 64
+
+static sm2_privkey keys[NKEYS];
+static uint8_t digests[NKEYS][32];
+static uint8_t sigs[NKEYS][64];
+static uint8_t msgs[NKEYS][32];
+static uint8_t cts[NKEYS][32 + 97];
+static uint64_t scalars[NKEYS][4];
+static volatile int sink;
+
+typedef void (*op_fn)(int i);
+
+static void op_keygen(int i) { sink += sm2_keygen(&keys[i]); }
+static void op_sign(int i) { sink += sm2_sign_digest(&keys[i], digests[i], NULL, sigs[i]); }
+static void op_sign_msg(int i) { sink += sm2_sign(&keys[i], NULL, 0, msgs[i], 32, sigs[i]); }
+static void op_verify(int i) { sink += sm2_verify_digest(&keys[i].pub, digests[i], sigs[i]); }
+static void op_verify_msg(int i) { sink += sm2_verify(&keys[i].pub, NULL, 0, msgs[i], 32, sigs[i]); }
+static void op_encrypt(int i) { sink += (int)sm2_encrypt(&keys[i].pub, msgs[i], 32, NULL, cts[i]); }
+static void op_decrypt(int i) { uint8_t out[32]; sink += (int)sm2_decrypt(&keys[i], cts[i], sizeof(cts[i]), out); }
+
+static void op_mul_g(int i) { sm2_jac r; ec_mul_g(&r, scalars[i]); sink += (int)r.X[0]; }
+static void op_mul_g_vt(int i) { sm2_jac r; ec_mul_g_vartime(&r, scalars[i]); sink += (int)r.X[0]; }
+static void op_mul_ct(int i) {
+    sm2_jac r;
+    sm2_aff p = {{0}, {0}};
+    sm2_copy(p.x, keys[i].pub.x);
+    sm2_copy(p.y, keys[i].pub.y);
+    ec_mul_ct(&r, &p, scalars[i]);
+    sink += (int)r.X[0];
+}
+static void op_mul_wnaf(int i) {
+    sm2_jac r;
+    sm2_aff p = {{0}, {0}};
+    sm2_copy(p.x, keys[i].pub.x);
+    sm2_copy(p.y, keys[i].pub.y);
+    ec_mul_wnaf(&r, &p, scalars[i]);
+    sink += (int)r.X[0];
+}
+static void op_fp_inv(int i) { uint64_t r[4]; fp_inv(r, keys[i].pub.x); sink += (int)r[0]; }
+
+// 按批运行直到超过时间预算，返回每秒次数
+static double bench(const char *name, op_fn fn, double budget) {
+    long ops = 0;
+    double t0 = now_sec(), t1;
+    do {
+        for (int i = 0; i < NKEYS; i++) fn(i);
+        ops += NKEYS;
+        t1 = now_sec();
+    } while (t1 - t0 < budget);
+    double rate = ops / (t1 - t0);
+    printf("%-22s %12.0f ops/s %10.2f us/op\n", name, rate, 1e6 / rate);
+    return rate;
+}
+
+// 批量验签：4096 条签名，密钥轮流使用
+static void bench_batch(unsigned threads, double budget) {
+    const size_t n = 4096;
+    static const sm2_pubkey *pubs[n];
+    static uint8_t e[n][32], s[n][64];
+    static int ok[n];
+    for (size_t i = 0; i < n; i++) {
+        pubs[i] = &keys[i % NKEYS].pub;
+        memcpy(e[i], digests[i % NKEYS], 32);
+        sm2_sign_digest(&keys[i % NKEYS], e[i], NULL, s[i]);
+    }
+    long ops = 0;
+    size_t passed = 0;
+    double t0 = now_sec(), t1;
+    do {
+        passed = sm2_verify_digest_many(pubs, e, s, ok, n, threads);
+        ops += n;
+        t1 = now_sec();
+    } while (t1 - t0 < budget);
+    double rate = ops / (t1 - t0);
+    char name[40];
+    snprintf(name, sizeof(name), "verify batch (%s)", threads == 1 ? "1T" : "all T");
+    printf("%-22s %12.0f ops/s %10.2f us/op%s\n", name, rate, 1e6 / rate, passed == n ? "" : "  MISMATCH");
+}
+
+int main(int argc, char **argv) {
+    double budget = argc > 1 ? atof(argv[1]) : 0.5;
+    if (budget <= 0) budget = 0.5;
+
+    srand(12345);
+    for (int i = 0; i < NKEYS; i++) {
+        if (sm2_keygen(&keys[i]) != 0) {
+            fprintf(stderr, "random source unavailable\n");
+            return 1;
+        }
+        for (int j = 0; j < 32; j++) {
+            msgs[i][j] = (uint8_t)rand();
+            digests[i][j] = (uint8_t)rand();
+        }
+        for (int j = 0; j < 4; j++) scalars[i][j] = ((uint64_t)rand() << 40) ^ ((uint64_t)rand() << 20) ^ (uint64_t)rand();
+        fn_reduce(scalars[i], scalars[i]);
+        sm2_sign_digest(&keys[i], digests[i], NULL, sigs[i]);
+        sm2_encrypt(&keys[i].pub, msgs[i], 32, NULL, cts[i]);
+    }
+    op_mul_g(0);   // 首次调用生成定点表，不计入时间
+
+    printf("SM2, single thread, %.2f s per case\n", budget);
+    bench("kG (ct, comb)", op_mul_g, budget);
+    bench("kG (vartime)", op_mul_g_vt, budget);
+    bench("kP (ct, booth w5)", op_mul_ct, budget);
+    bench("kP (wNAF w5)", op_mul_wnaf, budget);
+    bench("fp_inv", op_fp_inv, budget);
+    // 验签用前一项刚产生的签名；keygen 会换掉密钥，放在最后
+    bench("sign (digest)", op_sign, budget);
+    bench("verify (digest)", op_verify, budget);
+    bench("sign (Z_A + 32 B)", op_sign_msg, budget);
+    bench("verify (Z_A + 32 B)", op_verify_msg, budget);
+    bench("decrypt (32 B)", op_decrypt, budget);
+    bench("encrypt (32 B)", op_encrypt, budget);
+    bench_batch(1, budget);
+    bench_batch(0, budget);
+    bench("keygen", op_keygen, budget);
+    return 0;
+}
@@ -0,0 +1,447 @@
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include "sm2_ec.h"
+
+/*
+ * SM2 点运算
+ * 倍点用 a = -3 的 dbl-2001-b（3M + 5S），加法用 add-2007-bl（11M + 5S），混合加法 7M + 4S。
+ * 常数时间的标量乘对查表结果做全表扫描加掩码选择，负数窗口用掩码取 -y；
+ * 只有累加值恰好与待加点相等（概率可忽略）时才会走倍点分支。
+ */
+
+const sm2_aff SM2_G = {
+    {0x715a4589334c74c7ULL, 0x8fe30bbff2660be1ULL, 0x5f9904466a39c994ULL, 0x32c4ae2c1f198119ULL},
+    {0x02df32e52139f0a0ULL, 0xd0a9877cc62a4740ULL, 0x59bdcee36b692153ULL, 0xbc3736a2f4f6779cULL},
+};
+
+const uint64_t SM2_B[4] = {
+    0xddbcbd414d940e93ULL, 0xf39789f515ab8f92ULL, 0x4d5a9e4bcf6509a7ULL, 0x28e9fa9e9d9f5e34ULL
+};
+
+void ec_set_infinity(sm2_jac *r) {
+    memset(r, 0, sizeof(*r));
+}
+
+void ec_from_affine(sm2_jac *r, const sm2_aff *a) {
+    sm2_copy(r->X, a->x);
+    sm2_copy(r->Y, a->y);
+    sm2_copy(r->Z, SM2_P_ONE);
+}
+
+int ec_to_affine(sm2_aff *r, const sm2_jac *a) {
+    uint64_t zinv[4], z2[4];
+    if (sm2_is_zero(a->Z)) {
+        memset(r, 0, sizeof(*r));
+        return 0;
+    }
+    fp_inv(zinv, a->Z);
+    fp_sqr(z2, zinv);
+    fp_mul(r->x, a->X, z2);
+    fp_mul(z2, z2, zinv);
+    fp_mul(r->y, a->Y, z2);
+    return 1;
+}
+
+void ec_batch_to_affine(sm2_aff *r, const sm2_jac *a, size_t n) {
+    if (n == 0) return;
+    std::vector<uint64_t> prefix(4 * n);
+    uint64_t acc[4], inv[4], t[4], z2[4];
+
+    // prefix[i] = Z_0 * ... * Z_i（无穷远点的 Z 按 1 计）
+    sm2_copy(acc, SM2_P_ONE);
+    for (size_t i = 0; i < n; i++) {
+        if (!sm2_is_zero(a[i].Z)) fp_mul(acc, acc, a[i].Z);
+        sm2_copy(&prefix[4 * i], acc);
+    }
+    fp_inv(inv, acc);
+
+    for (size_t i = n; i-- > 0; ) {
+        if (sm2_is_zero(a[i].Z)) {
+            memset(&r[i], 0, sizeof(r[i]));
+            continue;
+        }
+        // inv 目前是 (Z_0 ... Z_i)^-1，乘上前缀 (Z_0 ... Z_{i-1}) 得到 Z_i^-1
+        if (i > 0) fp_mul(t, inv, &prefix[4 * (i - 1)]);
+        else sm2_copy(t, inv);
+        fp_mul(inv, inv, a[i].Z);
+
+        fp_sqr(z2, t);
+        fp_mul(r[i].x, a[i].X, z2);
+        fp_mul(z2, z2, t);
+        fp_mul(r[i].y, a[i].Y, z2);
+    }
+}
+
+int ec_on_curve(const sm2_aff *a) {
+    uint64_t lhs[4], rhs[4], t[4];
+    fp_sqr(lhs, a->y);
+    fp_sqr(rhs, a->x);
+    fp_mul(rhs, rhs, a->x);        // x^3
+    fp_add(t, a->x, a->x);
+    fp_add(t, t, a->x);            // 3x
+    fp_sub(rhs, rhs, t);
+    fp_add(rhs, rhs, SM2_B);
+    return sm2_equal(lhs, rhs);
+}
+
+void ec_double(sm2_jac *r, const sm2_jac *a) {
+    uint64_t delta[4], gamma[4], beta[4], alpha[4], t1[4], t2[4];
+    fp_sqr(delta, a->Z);
+    fp_sqr(gamma, a->Y);
+    fp_mul(beta, a->X, gamma);
+
+    fp_sub(t1, a->X, delta);
+    fp_add(t2, a->X, delta);
+    fp_mul(t1, t1, t2);
+    fp_add(alpha, t1, t1);
+    fp_add(alpha, alpha, t1);      // alpha = 3 (X - delta)(X + delta)
+
+    fp_add(t1, a->Y, a->Z);
+    fp_sqr(t1, t1);
+    fp_sub(t1, t1, gamma);
+    fp_sub(r->Z, t1, delta);       // Z3 = (Y + Z)^2 - gamma - delta
+
+    fp_add(beta, beta, beta);
+    fp_add(beta, beta, beta);      // 4 beta
+    fp_sqr(t1, alpha);
+    fp_add(t2, beta, beta);
+    fp_sub(r->X, t1, t2);          // X3 = alpha^2 - 8 beta
+
+    fp_sub(t1, beta, r->X);
+    fp_mul(t1, alpha, t1);
+    fp_sqr(gamma, gamma);
+    fp_add(gamma, gamma, gamma);
+    fp_add(gamma, gamma, gamma);
+    fp_add(gamma, gamma, gamma);   // 8 gamma^2
+    fp_sub(r->Y, t1, gamma);
+}
+
+// 通用加法公式；H = R = 0（相等点）时返回 1，由调用方改做倍点
+static int ec_add_formula(sm2_jac *r, const sm2_jac *a, const sm2_jac *b) {
+    uint64_t z1z1[4], z2z2[4], u1[4], u2[4], s1[4], s2[4], h[4], rr[4], hh[4], hhh[4], v[4], t[4];
+    fp_sqr(z1z1, a->Z);
+    fp_sqr(z2z2, b->Z);
+    fp_mul(u1, a->X, z2z2);
+    fp_mul(u2, b->X, z1z1);
+    fp_mul(s1, a->Y, b->Z);
+    fp_mul(s1, s1, z2z2);
+    fp_mul(s2, b->Y, a->Z);
+    fp_mul(s2, s2, z1z1);
+    fp_sub(h, u2, u1);
+    fp_sub(rr, s2, s1);
+    int same = sm2_is_zero(h) & sm2_is_zero(rr);
+
+    fp_sqr(hh, h);
+    fp_mul(hhh, h, hh);
+    fp_mul(v, u1, hh);
+    sm2_jac out;
+    fp_sqr(out.X, rr);
+    fp_sub(out.X, out.X, hhh);
+    fp_sub(out.X, out.X, v);
+    fp_sub(out.X, out.X, v);
+    fp_sub(t, v, out.X);
+    fp_mul(t, rr, t);
+    fp_mul(s1, s1, hhh);
+    fp_sub(out.Y, t, s1);
+    fp_mul(out.Z, a->Z, b->Z);
+    fp_mul(out.Z, out.Z, h);
+    *r = out;
+    return same;
+}
+
+// 混合加法：b 为仿射点（Z = 1）
+static int ec_add_affine_formula(sm2_jac *r, const sm2_jac *a, const sm2_aff *b) {
+    uint64_t z1z1[4], u2[4], s2[4], h[4], rr[4], hh[4], hhh[4], v[4], t[4];
+    fp_sqr(z1z1, a->Z);
+    fp_mul(u2, b->x, z1z1);
+    fp_mul(s2, b->y, a->Z);
+    fp_mul(s2, s2, z1z1);
+    fp_sub(h, u2, a->X);
+    fp_sub(rr, s2, a->Y);
+    int same = sm2_is_zero(h) & sm2_is_zero(rr);
+
+    fp_sqr(hh, h);
+    fp_mul(hhh, h, hh);
+    fp_mul(v, a->X, hh);
+    sm2_jac out;
+    fp_sqr(out.X, rr);
+    fp_sub(out.X, out.X, hhh);
+    fp_sub(out.X, out.X, v);
+    fp_sub(out.X, out.X, v);
+    fp_sub(t, v, out.X);
+    fp_mul(t, rr, t);
+    fp_mul(hhh, a->Y, hhh);
+    fp_sub(out.Y, t, hhh);
+    fp_mul(out.Z, a->Z, h);
+    *r = out;
+    return same;
+}
+
+void ec_add(sm2_jac *r, const sm2_jac *a, const sm2_jac *b) {
+    if (sm2_is_zero(a->Z)) { *r = *b; return; }
+    if (sm2_is_zero(b->Z)) { *r = *a; return; }
+    sm2_jac sa = *a;
+    if (ec_add_formula(r, a, b)) ec_double(r, &sa);
+}
+
+void ec_add_affine(sm2_jac *r, const sm2_jac *a, const sm2_aff *b) {
+    if (sm2_is_zero(a->Z)) { ec_from_affine(r, b); return; }
+    sm2_jac sa = *a;
+    if (ec_add_affine_formula(r, a, b)) ec_double(r, &sa);
+}
+
+// 常数时间加法：两边是否为无穷远点用掩码处理
+static void ec_add_ct(sm2_jac *r, const sm2_jac *a, const sm2_jac *b) {
+    uint64_t a_inf = 0 - (uint64_t)sm2_is_zero(a->Z);
+    uint64_t b_inf = 0 - (uint64_t)sm2_is_zero(b->Z);
+    sm2_jac out, sa = *a, sb = *b;
+    if (ec_add_formula(&out, &sa, &sb) & !(a_inf | b_inf)) ec_double(&out, &sa);
+    sm2_cmov(out.X, sb.X, a_inf); sm2_cmov(out.Y, sb.Y, a_inf); sm2_cmov(out.Z, sb.Z, a_inf);
+    sm2_cmov(out.X, sa.X, b_inf); sm2_cmov(out.Y, sa.Y, b_inf); sm2_cmov(out.Z, sa.Z, b_inf);
+    *r = out;
+}
+
+// 常数时间混合加法：b_inf 为全 1 表示 b 是无穷远点（窗口值为 0）
+static void ec_add_affine_ct(sm2_jac *r, const sm2_jac *a, const sm2_aff *b, uint64_t b_inf) {
+    uint64_t a_inf = 0 - (uint64_t)sm2_is_zero(a->Z);
+    sm2_jac out, sa = *a;
+    if (ec_add_affine_formula(&out, &sa, b) & !(a_inf | b_inf)) ec_double(&out, &sa);
+    sm2_cmov(out.X, b->x, a_inf); sm2_cmov(out.Y, b->y, a_inf); sm2_cmov(out.Z, SM2_P_ONE, a_inf);
+    sm2_cmov(out.X, sa.X, b_inf); sm2_cmov(out.Y, sa.Y, b_inf); sm2_cmov(out.Z, sa.Z, b_inf);
+    *r = out;
+}
+
+/* ===== 标量编码 ===== */
+
+// 取从第 start 位开始的 width 位（start 可以是 -1，此时最低位补 0）
+static inline unsigned scalar_bits(const uint64_t k[4], int start, int width) {
+    uint64_t mask = ((uint64_t)1 << width) - 1;
+    if (start < 0) return (unsigned)((k[0] << 1) & mask);
+    int word = start / 64, shift = start % 64;
+    if (word >= 4) return 0;
+    uint64_t v = k[word] >> shift;
+    if (shift + width > 64 && word + 1 < 4) v |= k[word + 1] << (64 - shift);
+    return (unsigned)(v & mask);
+}
+
+// Booth 编码：w+1 位窗口 -> (|d| << 1) | 符号，d 在 [-2^(w-1), 2^(w-1)]
+static inline unsigned booth_recode(unsigned in, int w) {
+    unsigned s = ~((in >> w) - 1);
+    unsigned d = (1u << (w + 1)) - in - 1;
+    d = (d & s) | (in & ~s);
+    d = (d >> 1) + (d & 1);
+    return (d << 1) + (s & 1);
+}
+
+/* ===== k * G ===== */
+
+#define SM2_G_WINDOWS 37    // ceil(257 / 7)
+#define SM2_G_ENTRIES 64
+
+struct sm2_g_table {
+    sm2_aff t[SM2_G_WINDOWS][SM2_G_ENTRIES];   // t[i][j] = (j + 1) * 2^(7i) * G
+
+    sm2_g_table() {
+        std::vector<sm2_jac> pts(SM2_G_WINDOWS * SM2_G_ENTRIES);
+        sm2_jac base;
+        ec_from_affine(&base, &SM2_G);
+        for (int i = 0; i < SM2_G_WINDOWS; i++) {
+            sm2_jac *row = &pts[i * SM2_G_ENTRIES];
+            row[0] = base;
+            ec_double(&row[1], &base);
+            for (int j = 2; j < SM2_G_ENTRIES; j++) ec_add(&row[j], &row[j - 1], &base);
+            ec_double(&base, &row[SM2_G_ENTRIES - 1]);   // 128 * base
+        }
+        ec_batch_to_affine(&t[0][0], pts.data(), pts.size());
+    }
+};
+
+// C++11 保证函数内静态对象只构造一次且线程安全
+static const sm2_g_table &sm2_g_precomp(void) {
+    static const sm2_g_table table;
+    return table;
+}
+
+void ec_mul_g(sm2_jac *r, const uint64_t k[4]) {
+    const sm2_g_table &tab = sm2_g_precomp();
+    sm2_jac acc;
+    ec_set_infinity(&acc);
+    for (int i = 0; i < SM2_G_WINDOWS; i++) {
+        unsigned rec = booth_recode(scalar_bits(k, 7 * i - 1, 8), 7);
+        unsigned mag = rec >> 1;
+        uint64_t neg = 0 - (uint64_t)(rec & 1);
+        sm2_aff sel;
+        memset(&sel, 0, sizeof(sel));
+        for (unsigned j = 0; j < SM2_G_ENTRIES; j++) {
+            uint64_t m = 0 - (uint64_t)(j + 1 == mag);
+            sm2_cmov(sel.x, tab.t[i][j].x, m);
+            sm2_cmov(sel.y, tab.t[i][j].y, m);
+        }
+        uint64_t ny[4];
+        fp_neg(ny, sel.y);
+        sm2_cmov(sel.y, ny, neg);
+        ec_add_affine_ct(&acc, &acc, &sel, 0 - (uint64_t)(mag == 0));
+    }
+    *r = acc;
+}
+
+void ec_mul_g_vartime(sm2_jac *r, const uint64_t k[4]) {
+    const sm2_g_table &tab = sm2_g_precomp();
+    sm2_jac acc;
+    ec_set_infinity(&acc);
+    for (int i = 0; i < SM2_G_WINDOWS; i++) {
+        unsigned rec = booth_recode(scalar_bits(k, 7 * i - 1, 8), 7);
+        unsigned mag = rec >> 1;
+        if (mag == 0) continue;
+        sm2_aff sel = tab.t[i][mag - 1];
+        if (rec & 1) fp_neg(sel.y, sel.y);
+        ec_add_affine(&acc, &acc, &sel);
+    }
+    *r = acc;
+}
+
+/* ===== k * P ===== */
+
+#define SM2_CT_WINDOWS 52   // ceil(257 / 5)
+
+void ec_mul_ct(sm2_jac *r, const sm2_aff *p, const uint64_t k[4]) {
+    // 1P .. 16P；P 是公开的点，预计算可以用普通加法
+    sm2_jac tab[16], acc;
+    ec_from_affine(&tab[0], p);
+    ec_double(&tab[1], &tab[0]);
+    for (int j = 2; j < 16; j++) ec_add(&tab[j], &tab[j - 1], &tab[0]);
+
+    ec_set_infinity(&acc);
+    for (int i = SM2_CT_WINDOWS - 1; i >= 0; i--) {
+        for (int d = 0; d < 5 && i != SM2_CT_WINDOWS - 1; d++) ec_double(&acc, &acc);
+        unsigned rec = booth_recode(scalar_bits(k, 5 * i - 1, 6), 5);
+        unsigned mag = rec >> 1;
+        uint64_t neg = 0 - (uint64_t)(rec & 1);
+        sm2_jac sel;
+        ec_set_infinity(&sel);
+        for (unsigned j = 0; j < 16; j++) {
+            uint64_t m = 0 - (uint64_t)(j + 1 == mag);
+            sm2_cmov(sel.X, tab[j].X, m);
+            sm2_cmov(sel.Y, tab[j].Y, m);
+            sm2_cmov(sel.Z, tab[j].Z, m);
+        }
+        uint64_t ny[4];
+        fp_neg(ny, sel.Y);
+        sm2_cmov(sel.Y, ny, neg);
+        ec_add_ct(&acc, &acc, &sel);
+    }
+    *r = acc;
+}
+
+// 宽度 w 的 NAF：非零位都是奇数，|d| < 2^(w-1)，任意 w 个相邻位至多一个非零
+static int wnaf_recode(int8_t naf[258], const uint64_t k[4], int w) {
+    uint64_t v[5] = {k[0], k[1], k[2], k[3], 0};
+    int len = 0;
+    while (v[0] | v[1] | v[2] | v[3] | v[4]) {
+        int d = 0;
+        if (v[0] & 1) {
+            d = (int)(v[0] & ((1u << w) - 1));
+            if (d >= (1 << (w - 1))) d -= 1 << w;
+            // v -= d
+            if (d > 0) {
+                uint64_t borrow = (uint64_t)d;
+                for (int i = 0; i < 5 && borrow; i++) {
+                    uint64_t old = v[i];
+                    v[i] -= borrow;
+                    borrow = old < borrow;
+                }
+            } else {
+                uint64_t carry = (uint64_t)(-d);
+                for (int i = 0; i < 5 && carry; i++) {
+                    v[i] += carry;
+                    carry = v[i] < carry;
+                }
+            }
+        }
+        naf[len++] = (int8_t)d;
+        for (int i = 0; i < 4; i++) v[i] = (v[i] >> 1) | (v[i + 1] << 63);
+        v[4] >>= 1;
+    }
+    return len;
+}
+
+void ec_mul_wnaf(sm2_jac *r, const sm2_aff *p, const uint64_t k[4]) {
+    int8_t naf[258];
+    int len = wnaf_recode(naf, k, 5);
+
+    // 奇数倍 P, 3P, ..., 15P
+    sm2_jac tab[8], p2, acc;
+    ec_from_affine(&tab[0], p);
+    ec_double(&p2, &tab[0]);
+    for (int j = 1; j < 8; j++) ec_add(&tab[j], &tab[j - 1], &p2);
+
+    ec_set_infinity(&acc);
+    for (int i = len - 1; i >= 0; i--) {
+        ec_double(&acc, &acc);
+        int d = naf[i];
+        if (d > 0) {
+            ec_add(&acc, &acc, &tab[d >> 1]);
+        } else if (d < 0) {
+            sm2_jac neg = tab[(-d) >> 1];
+            fp_neg(neg.Y, neg.Y);
+            ec_add(&acc, &acc, &neg);
+        }
+    }
+    *r = acc;
+}
+
+/* ===== s * G + t * P ===== */
+
+#define SM2_G_ODD 64    // G, 3G, ..., 127G
+
+struct sm2_g_odd_table {
+    sm2_aff t[SM2_G_ODD];
+
+    sm2_g_odd_table() {
+        sm2_jac pts[SM2_G_ODD], g2;
+        ec_from_affine(&pts[0], &SM2_G);
+        ec_double(&g2, &pts[0]);
+        for (int j = 1; j < SM2_G_ODD; j++) ec_add(&pts[j], &pts[j - 1], &g2);
+        ec_batch_to_affine(t, pts, SM2_G_ODD);
+    }
+};
+
+static const sm2_g_odd_table &sm2_g_odd_precomp(void) {
+    static const sm2_g_odd_table table;
+    return table;
+}
+
+void ec_odd_multiples(sm2_jac t[SM2_ODD_MULTIPLES], const sm2_aff *p) {
+    sm2_jac p2;
+    ec_from_affine(&t[0], p);
+    ec_double(&p2, &t[0]);
+    for (int j = 1; j < SM2_ODD_MULTIPLES; j++) ec_add(&t[j], &t[j - 1], &p2);
+}
+
+static inline void ec_add_signed(sm2_jac *acc, const sm2_aff *tab, int d) {
+    if (d > 0) {
+        ec_add_affine(acc, acc, &tab[d >> 1]);
+    } else if (d < 0) {
+        sm2_aff neg = tab[(-d) >> 1];
+        fp_neg(neg.y, neg.y);
+        ec_add_affine(acc, acc, &neg);
+    }
+}
+
+void ec_mul2_vartime(sm2_jac *r, const uint64_t s[4], const sm2_aff ptab[SM2_ODD_MULTIPLES],
+                     const uint64_t t[4]) {
+    const sm2_aff *gtab = sm2_g_odd_precomp().t;
+    int8_t ns[258], nt[258];
+    int ls = wnaf_recode(ns, s, 8), lt = wnaf_recode(nt, t, 5);
+    int len = ls > lt ? ls : lt;
+
+    sm2_jac acc;
+    ec_set_infinity(&acc);
+    for (int i = len - 1; i >= 0; i--) {
+        if (!sm2_is_zero(acc.Z)) ec_double(&acc, &acc);
+        if (i < ls) ec_add_signed(&acc, gtab, ns[i]);
+        if (i < lt) ec_add_signed(&acc, ptab, nt[i]);
+    }
+    *r = acc;
+}
@@ -0,0 +1,55 @@
+#ifndef SM2_EC_H
+#define SM2_EC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "sm2_field.h"
+
+/*
+ * SM2 曲线 y^2 = x^3 - 3x + b 上的点运算（内部头文件）
+ * 坐标为 Fp 元素；Jacobian 坐标 (X, Y, Z) 对应仿射 (X/Z^2, Y/Z^3)，Z = 0 为无穷远点。
+ * 标量为普通表示的 4 个 64 位字。
+ *   ct     常数时间，标量是私钥或临时私钥时使用
+ *   vartime 运行时间与标量有关，只用于公开的标量（验签）
+ */
+
+struct sm2_jac {
+    uint64_t X[4], Y[4], Z[4];
+};
+
+struct sm2_aff {
+    uint64_t x[4], y[4];
+};
+
+extern const sm2_aff SM2_G;    // 基点
+extern const uint64_t SM2_B[4];  // 曲线参数 b
+
+void ec_set_infinity(sm2_jac *r);
+void ec_from_affine(sm2_jac *r, const sm2_aff *a);
+// 无穷远点返回 0
+int ec_to_affine(sm2_aff *r, const sm2_jac *a);
+// n 个点一起转仿射，只做一次求逆（Montgomery 批量求逆技巧）；无穷远点输出 (0, 0)
+void ec_batch_to_affine(sm2_aff *r, const sm2_jac *a, size_t n);
+int ec_on_curve(const sm2_aff *a);
+
+void ec_double(sm2_jac *r, const sm2_jac *a);
+// 完整加法，处理无穷远点与相等点（vartime）
+void ec_add(sm2_jac *r, const sm2_jac *a, const sm2_jac *b);
+void ec_add_affine(sm2_jac *r, const sm2_jac *a, const sm2_aff *b);
+
+// k * G：Booth 编码 7 位窗口，37 张 64 项仿射点表（约 150KB，首次使用时生成）
+void ec_mul_g(sm2_jac *r, const uint64_t k[4]);
+void ec_mul_g_vartime(sm2_jac *r, const uint64_t k[4]);
+// k * P：常数时间版为 Booth 编码 5 位窗口，公开标量用 5 位宽 wNAF
+void ec_mul_ct(sm2_jac *r, const sm2_aff *p, const uint64_t k[4]);
+void ec_mul_wnaf(sm2_jac *r, const sm2_aff *p, const uint64_t k[4]);
+
+// P 的奇数倍 P, 3P, ..., 15P（Jacobian）；批量验签时多个点的表一起转仿射
+#define SM2_ODD_MULTIPLES 8
+void ec_odd_multiples(sm2_jac t[SM2_ODD_MULTIPLES], const sm2_aff *p);
+// s * G + t * P，Straus 交错：两个标量共用一串倍点，G 用 8 位宽 wNAF 的静态仿射表，
+// P 用 5 位宽 wNAF、ptab 为 ec_odd_multiples 转成的仿射表，全部是混合加法（vartime）
+void ec_mul2_vartime(sm2_jac *r, const uint64_t s[4], const sm2_aff ptab[SM2_ODD_MULTIPLES],
+                     const uint64_t t[4]);
+
+#endif // SM2_EC_H
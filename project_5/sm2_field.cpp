@@ -0,0 +1,136 @@
+#include "sm2_field.h"
+#include "../common/cpu_features.h"
+
+/*
+ * Fp 乘法的可移植内核、内核选择，以及求逆 / 开方 / 标量求逆
+ * 求逆与开方用针对 p 的固定加法链，标量求逆用费马小定理按位平方-乘；
+ * 指数都是公开常数，运行时间与输入无关。
+ */
+
+// 4x4 字乘积（教科书式，128 位累加）
+static inline void sm2_mul_4x4(uint64_t t[8], const uint64_t a[4], const uint64_t b[4]) {
+    for (int i = 0; i < 8; i++) t[i] = 0;
+    for (int i = 0; i < 4; i++) {
+        uint64_t carry = 0;
+        for (int j = 0; j < 4; j++) {
+            sm2_u128 acc = (sm2_u128)a[j] * b[i] + t[i + j] + carry;
+            t[i + j] = (uint64_t)acc;
+            carry = (uint64_t)(acc >> 64);
+        }
+        t[i + 4] = carry;
+    }
+}
+
+void sm2_fp_mul_portable(uint64_t r[4], const uint64_t a[4], const uint64_t b[4]) {
+    uint64_t t[8];
+    sm2_mul_4x4(t, a, b);
+    sm2_fp_reduce(r, t);
+}
+
+// 可移植版本单独写平方并不更快：省下的 6 次乘法被乘 2 与 128 位进位链抵掉了
+void sm2_fp_sqr_portable(uint64_t r[4], const uint64_t a[4]) {
+    uint64_t t[8];
+    sm2_mul_4x4(t, a, a);
+    sm2_fp_reduce(r, t);
+}
+
+sm2_fp_impl sm2_fp_kernels = {sm2_fp_mul_portable, sm2_fp_sqr_portable, "portable"};
+
+static sm2_fp_impl sm2_fp_pick(void) {
+    const cpu_features_t *f = cpu_features();
+    if (f->bmi2 && f->adx) return {sm2_fp_mul_adx, sm2_fp_sqr_adx, "mulx-adx"};
+    return {sm2_fp_mul_portable, sm2_fp_sqr_portable, "portable"};
+}
+
+// 动态初始化在库加载时执行；在此之前的调用仍可用可移植内核
+static const bool sm2_fp_selected = (sm2_fp_kernels = sm2_fp_pick(), true);
+
+extern "C" const char *sm2_fp_impl_name(void) {
+    (void)sm2_fp_selected;
+    return sm2_fp_kernels.name;
+}
+
+static inline void fp_sqr_n(uint64_t r[4], const uint64_t a[4], int n) {
+    fp_sqr(r, a);
+    while (--n > 0) fp_sqr(r, r);
+}
+
+// x_k = a^(2^k - 1)，求逆和开方共用
+struct sm2_fp_chain {
+    uint64_t x1[4], x2[4], x30[4], x31[4], x32[4];
+};
+
+static void sm2_fp_chain_init(sm2_fp_chain *c, const uint64_t a[4]) {
+    uint64_t x4[4], x6[4], x7[4], x14[4], x15[4];
+    sm2_copy(c->x1, a);
+    fp_sqr(c->x2, a);            fp_mul(c->x2, c->x2, a);
+    fp_sqr_n(x4, c->x2, 2);      fp_mul(x4, x4, c->x2);
+    fp_sqr_n(x6, x4, 2);         fp_mul(x6, x6, c->x2);
+    fp_sqr(x7, x6);              fp_mul(x7, x7, a);
+    fp_sqr_n(x14, x7, 7);        fp_mul(x14, x14, x7);
+    fp_sqr(x15, x14);            fp_mul(x15, x15, a);
+    fp_sqr_n(c->x30, x15, 15);   fp_mul(c->x30, c->x30, x15);
+    fp_sqr(c->x31, c->x30);      fp_mul(c->x31, c->x31, a);
+    fp_sqr(c->x32, c->x31);      fp_mul(c->x32, c->x32, a);
+}
+
+// 高位公共部分：[31 个 1] 0 [128 个 1]
+static void sm2_fp_chain_head(uint64_t t[4], const sm2_fp_chain *c) {
+    fp_sqr_n(t, c->x31, 33);
+    fp_mul(t, t, c->x32);
+    for (int i = 0; i < 3; i++) {
+        fp_sqr_n(t, t, 32);
+        fp_mul(t, t, c->x32);
+    }
+}
+
+void fp_inv(uint64_t r[4], const uint64_t a[4]) {
+    // p - 2 = [31 个 1] 0 [128 个 1] [32 个 0] [62 个 1] 0 1
+    sm2_fp_chain c;
+    uint64_t t[4];
+    sm2_fp_chain_init(&c, a);
+    sm2_fp_chain_head(t, &c);
+    fp_sqr_n(t, t, 64);
+    fp_mul(t, t, c.x32);
+    fp_sqr_n(t, t, 30);
+    fp_mul(t, t, c.x30);
+    fp_sqr_n(t, t, 2);
+    fp_mul(r, t, c.x1);
+}
+
+int fp_sqrt(uint64_t r[4], const uint64_t a[4]) {
+    // (p + 1) / 4 = [31 个 1] 0 [128 个 1] [31 个 0] 1 [62 个 0]
+    sm2_fp_chain c;
+    uint64_t t[4], chk[4];
+    sm2_fp_chain_init(&c, a);
+    sm2_fp_chain_head(t, &c);
+    fp_sqr_n(t, t, 32);
+    fp_mul(t, t, c.x1);
+    fp_sqr_n(t, t, 62);
+    fp_sqr(chk, t);
+    sm2_copy(r, t);
+    return sm2_equal(chk, a);
+}
+
+// Montgomery 域上的模幂，指数按位从高到低平方-乘
+static void sm2_mont_pow(uint64_t r[4], const uint64_t a[4], const uint64_t e[4],
+                         const uint64_t one[4], const uint64_t m[4], uint64_t m0) {
+    uint64_t acc[4];
+    sm2_copy(acc, one);
+    for (int i = 255; i >= 0; i--) {
+        sm2_mont_mul(acc, acc, acc, m, m0);
+        if ((e[i / 64] >> (i % 64)) & 1) sm2_mont_mul(acc, acc, a, m, m0);
+    }
+    sm2_copy(r, acc);
+}
+
+void fn_inv(uint64_t r[4], const uint64_t a[4]) {
+    static const uint64_t e[4] = {   // n - 2
+        0x53bbf40939d54121ULL, 0x7203df6b21c6052bULL, 0xffffffffffffffffULL, 0xfffffffeffffffffULL
+    };
+    uint64_t t[4];
+    sm2_mont_mul(t, a, SM2_N_RR, SM2_N, SM2_N0);       // 转入 Montgomery 表示
+    sm2_mont_pow(t, t, e, SM2_N_ONE, SM2_N, SM2_N0);
+    static const uint64_t one[4] = {1, 0, 0, 0};
+    sm2_mont_mul(r, t, one, SM2_N, SM2_N0);            // 转回普通表示
+}
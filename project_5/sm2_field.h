@@ -0,0 +1,271 @@
+#ifndef SM2_FIELD_H
+#define SM2_FIELD_H
+
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * SM2 的素域 Fp 与标量域 Fn 运算（内部头文件）
+ * 元素为 4 个 64 位字，小端字序。Fp 元素用普通表示，乘法先算出 512 位乘积，
+ * 再按 p = 2^256 - 2^224 - 2^96 + 2^64 - 1 的特殊形式做 Solinas 约简（只有加减与移位）；
+ * 乘积内核有 MULX/ADCX/ADOX 与可移植两个版本，加载时按 CPUID 选定。
+ * 标量保持普通表示，乘法在内部转一次 Montgomery。
+ * 所有运算都不含依赖数据的分支，求逆与开方的指数是公开常数，可用于私钥相关的计算。
+ */
+
+typedef unsigned __int128 sm2_u128;
+typedef __int128 sm2_i128;
+
+static const uint64_t SM2_P[4] = {
+    0xffffffffffffffffULL, 0xffffffff00000000ULL, 0xffffffffffffffffULL, 0xfffffffeffffffffULL
+};
+static const uint64_t SM2_N[4] = {
+    0x53bbf40939d54123ULL, 0x7203df6b21c6052bULL, 0xffffffffffffffffULL, 0xfffffffeffffffffULL
+};
+static const uint64_t SM2_P_ONE[4] = {1, 0, 0, 0};
+// R^2 mod n（R = 2^256），用于转入 Montgomery 表示
+static const uint64_t SM2_N_RR[4] = {
+    0x901192af7c114f20ULL, 0x3464504ade6fa2faULL, 0x620fc84c3affe0d4ULL, 0x1eb5e412a22b3d3bULL
+};
+// R mod n（Montgomery 表示的 1）
+static const uint64_t SM2_N_ONE[4] = {
+    0xac440bf6c62abeddULL, 0x8dfc2094de39fad4ULL, 0x0000000000000000ULL, 0x0000000100000000ULL
+};
+static const uint64_t SM2_N0 = 0x327f9e8872350975ULL;   // -n^-1 mod 2^64
+
+/* ===== 通用 4 字运算 ===== */
+
+static inline void sm2_copy(uint64_t r[4], const uint64_t a[4]) {
+    r[0] = a[0]; r[1] = a[1]; r[2] = a[2]; r[3] = a[3];
+}
+
+static inline int sm2_is_zero(const uint64_t a[4]) {
+    return (a[0] | a[1] | a[2] | a[3]) == 0;
+}
+
+static inline int sm2_equal(const uint64_t a[4], const uint64_t b[4]) {
+    return ((a[0] ^ b[0]) | (a[1] ^ b[1]) | (a[2] ^ b[2]) | (a[3] ^ b[3])) == 0;
+}
+
+// mask 为全 1 时 r = a，为 0 时不变
+static inline void sm2_cmov(uint64_t r[4], const uint64_t a[4], uint64_t mask) {
+    for (int i = 0; i < 4; i++) r[i] ^= (r[i] ^ a[i]) & mask;
+}
+
+// a < m 时返回 1
+static inline int sm2_lt(const uint64_t a[4], const uint64_t m[4]) {
+    uint64_t borrow = 0;
+    for (int i = 0; i < 4; i++) {
+        sm2_u128 d = (sm2_u128)a[i] - m[i] - borrow;
+        borrow = (uint64_t)(d >> 64) & 1;
+    }
+    return (int)borrow;
+}
+
+// (hi:t) - m，够减时取差，否则保留原值；要求 (hi:t) < 2m
+static inline void sm2_reduce_once(uint64_t r[4], const uint64_t t[4], uint64_t hi, const uint64_t m[4]) {
+    uint64_t s[4], borrow = 0;
+    for (int i = 0; i < 4; i++) {
+        sm2_u128 d = (sm2_u128)t[i] - m[i] - borrow;
+        s[i] = (uint64_t)d;
+        borrow = (uint64_t)(d >> 64) & 1;
+    }
+    uint64_t keep = 0 - (uint64_t)(hi < borrow);   // 借位超过了第 5 个字：原值小于 m
+    for (int i = 0; i < 4; i++) r[i] = (t[i] & keep) | (s[i] & ~keep);
+}
+
+static inline void sm2_mod_add(uint64_t r[4], const uint64_t a[4], const uint64_t b[4], const uint64_t m[4]) {
+    uint64_t t[4], carry = 0;
+    for (int i = 0; i < 4; i++) {
+        sm2_u128 s = (sm2_u128)a[i] + b[i] + carry;
+        t[i] = (uint64_t)s;
+        carry = (uint64_t)(s >> 64);
+    }
+    sm2_reduce_once(r, t, carry, m);
+}
+
+static inline void sm2_mod_sub(uint64_t r[4], const uint64_t a[4], const uint64_t b[4], const uint64_t m[4]) {
+    uint64_t t[4], borrow = 0, carry = 0;
+    for (int i = 0; i < 4; i++) {
+        sm2_u128 d = (sm2_u128)a[i] - b[i] - borrow;
+        t[i] = (uint64_t)d;
+        borrow = (uint64_t)(d >> 64) & 1;
+    }
+    uint64_t mask = 0 - borrow;   // 不够减时加回 m
+    for (int i = 0; i < 4; i++) {
+        sm2_u128 s = (sm2_u128)t[i] + (m[i] & mask) + carry;
+        r[i] = (uint64_t)s;
+        carry = (uint64_t)(s >> 64);
+    }
+}
+
+// Montgomery 乘法（CIOS）：r = a * b * 2^-256 mod m，m0 = -m^-1 mod 2^64
+static inline void sm2_mont_mul(uint64_t r[4], const uint64_t a[4], const uint64_t b[4],
+                                const uint64_t m[4], uint64_t m0) {
+    uint64_t t0 = 0, t1 = 0, t2 = 0, t3 = 0, t4 = 0;
+    for (int i = 0; i < 4; i++) {
+        uint64_t bi = b[i], c, t5, u;
+        sm2_u128 acc;
+        acc = (sm2_u128)a[0] * bi + t0;     t0 = (uint64_t)acc; c = (uint64_t)(acc >> 64);
+        acc = (sm2_u128)a[1] * bi + t1 + c; t1 = (uint64_t)acc; c = (uint64_t)(acc >> 64);
+        acc = (sm2_u128)a[2] * bi + t2 + c; t2 = (uint64_t)acc; c = (uint64_t)(acc >> 64);
+        acc = (sm2_u128)a[3] * bi + t3 + c; t3 = (uint64_t)acc; c = (uint64_t)(acc >> 64);
+        acc = (sm2_u128)t4 + c;             t4 = (uint64_t)acc; t5 = (uint64_t)(acc >> 64);
+
+        u = t0 * m0;
+        acc = (sm2_u128)u * m[0] + t0;      c = (uint64_t)(acc >> 64);
+        acc = (sm2_u128)u * m[1] + t1 + c;  t0 = (uint64_t)acc; c = (uint64_t)(acc >> 64);
+        acc = (sm2_u128)u * m[2] + t2 + c;  t1 = (uint64_t)acc; c = (uint64_t)(acc >> 64);
+        acc = (sm2_u128)u * m[3] + t3 + c;  t2 = (uint64_t)acc; c = (uint64_t)(acc >> 64);
+        acc = (sm2_u128)t4 + c;             t3 = (uint64_t)acc; t4 = t5 + (uint64_t)(acc >> 64);
+    }
+    uint64_t t[4] = {t0, t1, t2, t3};
+    sm2_reduce_once(r, t, t4, m);
+}
+
+/* ===== Fp ===== */
+
+/*
+ * Solinas 约简：t 为 512 位乘积，按 32 位字 c0..c15 记。
+ * 2^256 ≡ 2^224 + 2^96 - 2^64 + 1，把 c8..c15 各自的 2^(32k) 都化到低 8 个字上，
+ * 得到每一列的系数（下面各 s_j 的展开），有符号 64 位累加不会溢出。
+ * 进位传完后剩下的 c * 2^256 再按同一个式子折回一次，最后最多差一个 p。
+ */
+static inline void sm2_fp_reduce(uint64_t r[4], const uint64_t t[8]) {
+    // 逐个写成标量，避免编译器把拆字向量化后经内存中转
+    const int64_t c0 = (uint32_t)t[0], c1 = (int64_t)(t[0] >> 32);
+    const int64_t c2 = (uint32_t)t[1], c3 = (int64_t)(t[1] >> 32);
+    const int64_t c4 = (uint32_t)t[2], c5 = (int64_t)(t[2] >> 32);
+    const int64_t c6 = (uint32_t)t[3], c7 = (int64_t)(t[3] >> 32);
+    const int64_t c8 = (uint32_t)t[4], c9 = (int64_t)(t[4] >> 32);
+    const int64_t c10 = (uint32_t)t[5], c11 = (int64_t)(t[5] >> 32);
+    const int64_t c12 = (uint32_t)t[6], c13 = (int64_t)(t[6] >> 32);
+    const int64_t c14 = (uint32_t)t[7], c15 = (int64_t)(t[7] >> 32);
+    const int64_t d = c13 + c14 + c15;
+    int64_t s0 = c0 + c8 + c9 + c10 + c11 + c12 + 2 * d;
+    int64_t s1 = c1 + c9 + c10 + c11 + c12 + c13 + 2 * (c14 + c15);
+    int64_t s2 = c2 - c8 - c9 - c13 - c14;
+    int64_t s3 = c3 + c8 + c11 + c12 + c13 + d;
+    int64_t s4 = c4 + c9 + c12 + c14 + d;
+    int64_t s5 = c5 + c10 + c15 + d;
+    int64_t s6 = c6 + c11 + c14 + c15;
+    int64_t s7 = c7 + c8 + c9 + c10 + c11 + 2 * (c12 + d) + c15;
+
+    // 相邻两列合成一个 64 位字，按 128 位有符号数传进位
+    uint64_t w[4];
+    sm2_i128 acc = (sm2_i128)s0 + ((sm2_i128)s1 << 32);
+    w[0] = (uint64_t)acc; acc >>= 64;
+    acc += (sm2_i128)s2 + ((sm2_i128)s3 << 32);
+    w[1] = (uint64_t)acc; acc >>= 64;
+    acc += (sm2_i128)s4 + ((sm2_i128)s5 << 32);
+    w[2] = (uint64_t)acc; acc >>= 64;
+    acc += (sm2_i128)s6 + ((sm2_i128)s7 << 32);
+    w[3] = (uint64_t)acc;
+    int64_t top = (int64_t)(acc >> 64);
+
+    // w + top * (2^224 + 2^96 - 2^64 + 1)，|top| 很小，结果在 (-p, 2p) 内
+    acc = (sm2_i128)w[0] + top;
+    w[0] = (uint64_t)acc; acc >>= 64;
+    acc += (sm2_i128)w[1] - top + ((sm2_i128)top << 32);
+    w[1] = (uint64_t)acc; acc >>= 64;
+    acc += (sm2_i128)w[2];
+    w[2] = (uint64_t)acc; acc >>= 64;
+    acc += (sm2_i128)w[3] + ((sm2_i128)top << 32);
+    w[3] = (uint64_t)acc; acc >>= 64;
+    int64_t hi = (int64_t)acc;   // -1、0 或 1
+
+    // 负数时加一个 p，之后 (hi:w) < 2p，再减一次
+    uint64_t neg = 0 - (uint64_t)(hi < 0), carry = 0;
+    for (int i = 0; i < 4; i++) {
+        sm2_u128 sum = (sm2_u128)w[i] + (SM2_P[i] & neg) + carry;
+        w[i] = (uint64_t)sum;
+        carry = (uint64_t)(sum >> 64);
+    }
+    sm2_reduce_once(r, w, (uint64_t)(hi + (int64_t)carry), SM2_P);
+}
+
+// 域乘法内核：r = a * b mod p、r = a^2 mod p
+typedef void (*sm2_fp_mul_fn)(uint64_t r[4], const uint64_t a[4], const uint64_t b[4]);
+typedef void (*sm2_fp_sqr_fn)(uint64_t r[4], const uint64_t a[4]);
+
+struct sm2_fp_impl {
+    sm2_fp_mul_fn mul;
+    sm2_fp_sqr_fn sqr;
+    const char *name;
+};
+
+void sm2_fp_mul_portable(uint64_t r[4], const uint64_t a[4], const uint64_t b[4]);
+void sm2_fp_sqr_portable(uint64_t r[4], const uint64_t a[4]);
+void sm2_fp_mul_adx(uint64_t r[4], const uint64_t a[4], const uint64_t b[4]);   // 需要 BMI2 + ADX
+void sm2_fp_sqr_adx(uint64_t r[4], const uint64_t a[4]);
+
+// 初始为可移植内核，库加载时换成 CPU 支持的最快内核
+extern sm2_fp_impl sm2_fp_kernels;
+
+static inline void fp_add(uint64_t r[4], const uint64_t a[4], const uint64_t b[4]) {
+    sm2_mod_add(r, a, b, SM2_P);
+}
+
+static inline void fp_sub(uint64_t r[4], const uint64_t a[4], const uint64_t b[4]) {
+    sm2_mod_sub(r, a, b, SM2_P);
+}
+
+static inline void fp_neg(uint64_t r[4], const uint64_t a[4]) {
+    static const uint64_t zero[4] = {0, 0, 0, 0};
+    sm2_mod_sub(r, zero, a, SM2_P);
+}
+
+static inline void fp_mul(uint64_t r[4], const uint64_t a[4], const uint64_t b[4]) {
+    sm2_fp_kernels.mul(r, a, b);
+}
+
+static inline void fp_sqr(uint64_t r[4], const uint64_t a[4]) {
+    sm2_fp_kernels.sqr(r, a);
+}
+
+// r = a^-1（a 为 0 时结果为 0），加法链：256 次平方 + 16 次乘法
+void fp_inv(uint64_t r[4], const uint64_t a[4]);
+// r = a^((p+1)/4)（p ≡ 3 mod 4），a 是二次剩余时返回 1；不论结果如何运算量相同
+int fp_sqrt(uint64_t r[4], const uint64_t a[4]);
+
+/* ===== Fn（标量，普通表示） ===== */
+
+static inline void fn_add(uint64_t r[4], const uint64_t a[4], const uint64_t b[4]) {
+    sm2_mod_add(r, a, b, SM2_N);
+}
+
+static inline void fn_sub(uint64_t r[4], const uint64_t a[4], const uint64_t b[4]) {
+    sm2_mod_sub(r, a, b, SM2_N);
+}
+
+// 两次 Montgomery 乘法：a * b * R^-1，再乘 R^2 * R^-1
+static inline void fn_mul(uint64_t r[4], const uint64_t a[4], const uint64_t b[4]) {
+    uint64_t t[4];
+    sm2_mont_mul(t, a, b, SM2_N, SM2_N0);
+    sm2_mont_mul(r, t, SM2_N_RR, SM2_N, SM2_N0);
+}
+
+// 把小于 2^256 的数约简到 [0, n)；2^256 < 2n，减一次就够
+static inline void fn_reduce(uint64_t r[4], const uint64_t a[4]) {
+    sm2_reduce_once(r, a, 0, SM2_N);
+}
+
+void fn_inv(uint64_t r[4], const uint64_t a[4]);
+
+/* ===== 字节序转换（大端 32 字节） ===== */
+
+static inline void sm2_from_bytes(uint64_t r[4], const uint8_t in[32]) {
+    for (int i = 0; i < 4; i++) {
+        uint64_t v = 0;
+        for (int k = 0; k < 8; k++) v = (v << 8) | in[(3 - i) * 8 + k];
+        r[i] = v;
+    }
+}
+
+static inline void sm2_to_bytes(uint8_t out[32], const uint64_t a[4]) {
+    for (int i = 0; i < 4; i++) {
+        for (int k = 0; k < 8; k++) out[(3 - i) * 8 + k] = (uint8_t)(a[i] >> (56 - 8 * k));
+    }
+}
+
+#endif // SM2_FIELD_H
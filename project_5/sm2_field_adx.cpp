@@ -0,0 +1,154 @@
+// SM2 域乘法：MULX/ADCX/ADOX 内核
+// MULX 不改标志位，ADCX 只用 CF、ADOX 只用 OF，每一行的低半部分与高半部分走两条独立的进位链。
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC target("bmi2,adx")
+#endif
+#include "sm2_field.h"
+
+// a、b 只以基址寄存器传入，汇编里按偏移取字：10 个输出加 2 个指针，去掉 rdx、rsp、rbp 后正好够用。
+// 不能把每个字写成 "m" 操作数，-O0 下它们各占一个地址寄存器，会报 impossible constraints
+
+// t = a * b（512 位）
+static inline void sm2_mul_4x4_adx(uint64_t t[8], const uint64_t a[4], const uint64_t b[4]) {
+    uint64_t t0, t1, t2, t3, t4, t5, t6, t7, lo, hi;
+    __asm__(
+        // b0 * a：普通 ADD/ADC 链
+        "movq   (%[pb]), %%rdx\n\t"
+        "mulxq  (%[pa]), %[t0], %[t1]\n\t"
+        "mulxq  8(%[pa]), %[lo], %[t2]\n\t"
+        "addq   %[lo], %[t1]\n\t"
+        "mulxq  16(%[pa]), %[lo], %[t3]\n\t"
+        "adcq   %[lo], %[t2]\n\t"
+        "mulxq  24(%[pa]), %[lo], %[t4]\n\t"
+        "adcq   %[lo], %[t3]\n\t"
+        "adcq   $0, %[t4]\n\t"
+        // b1 * a 加到 t1..t5（xor 同时清 CF 与 OF）
+        "movq   8(%[pb]), %%rdx\n\t"
+        "xorl   %k[t5], %k[t5]\n\t"
+        "mulxq  (%[pa]), %[lo], %[hi]\n\t"
+        "adcxq  %[lo], %[t1]\n\t"
+        "adoxq  %[hi], %[t2]\n\t"
+        "mulxq  8(%[pa]), %[lo], %[hi]\n\t"
+        "adcxq  %[lo], %[t2]\n\t"
+        "adoxq  %[hi], %[t3]\n\t"
+        "mulxq  16(%[pa]), %[lo], %[hi]\n\t"
+        "adcxq  %[lo], %[t3]\n\t"
+        "adoxq  %[hi], %[t4]\n\t"
+        "mulxq  24(%[pa]), %[lo], %[hi]\n\t"
+        "adcxq  %[lo], %[t4]\n\t"
+        "adoxq  %[hi], %[t5]\n\t"
+        "movl   $0, %k[lo]\n\t"
+        "adcxq  %[lo], %[t5]\n\t"
+        // b2 * a 加到 t2..t6
+        "movq   16(%[pb]), %%rdx\n\t"
+        "xorl   %k[t6], %k[t6]\n\t"
+        "mulxq  (%[pa]), %[lo], %[hi]\n\t"
+        "adcxq  %[lo], %[t2]\n\t"
+        "adoxq  %[hi], %[t3]\n\t"
+        "mulxq  8(%[pa]), %[lo], %[hi]\n\t"
+        "adcxq  %[lo], %[t3]\n\t"
+        "adoxq  %[hi], %[t4]\n\t"
+        "mulxq  16(%[pa]), %[lo], %[hi]\n\t"
+        "adcxq  %[lo], %[t4]\n\t"
+        "adoxq  %[hi], %[t5]\n\t"
+        "mulxq  24(%[pa]), %[lo], %[hi]\n\t"
+        "adcxq  %[lo], %[t5]\n\t"
+        "adoxq  %[hi], %[t6]\n\t"
+        "movl   $0, %k[lo]\n\t"
+        "adcxq  %[lo], %[t6]\n\t"
+        // b3 * a 加到 t3..t7
+        "movq   24(%[pb]), %%rdx\n\t"
+        "xorl   %k[t7], %k[t7]\n\t"
+        "mulxq  (%[pa]), %[lo], %[hi]\n\t"
+        "adcxq  %[lo], %[t3]\n\t"
+        "adoxq  %[hi], %[t4]\n\t"
+        "mulxq  8(%[pa]), %[lo], %[hi]\n\t"
+        "adcxq  %[lo], %[t4]\n\t"
+        "adoxq  %[hi], %[t5]\n\t"
+        "mulxq  16(%[pa]), %[lo], %[hi]\n\t"
+        "adcxq  %[lo], %[t5]\n\t"
+        "adoxq  %[hi], %[t6]\n\t"
+        "mulxq  24(%[pa]), %[lo], %[hi]\n\t"
+        "adcxq  %[lo], %[t6]\n\t"
+        "adoxq  %[hi], %[t7]\n\t"
+        "movl   $0, %k[lo]\n\t"
+        "adcxq  %[lo], %[t7]\n\t"
+        : [t0] "=&r"(t0), [t1] "=&r"(t1), [t2] "=&r"(t2), [t3] "=&r"(t3),
+          [t4] "=&r"(t4), [t5] "=&r"(t5), [t6] "=&r"(t6), [t7] "=&r"(t7),
+          [lo] "=&r"(lo), [hi] "=&r"(hi)
+        : [pa] "r"(a), [pb] "r"(b)
+        : "rdx", "cc", "memory");
+    t[0] = t0; t[1] = t1; t[2] = t2; t[3] = t3;
+    t[4] = t4; t[5] = t5; t[6] = t6; t[7] = t7;
+}
+
+// t = a^2：6 个交叉项、整体乘 2、再加 4 个平方项
+static inline void sm2_sqr_4x4_adx(uint64_t t[8], const uint64_t a[4]) {
+    uint64_t t0, t1, t2, t3, t4, t5, t6, t7, lo, hi;
+    __asm__(
+        "movq   (%[pa]), %%rdx\n\t"
+        "mulxq  8(%[pa]), %[t1], %[t2]\n\t"
+        "mulxq  16(%[pa]), %[lo], %[t3]\n\t"
+        "addq   %[lo], %[t2]\n\t"
+        "mulxq  24(%[pa]), %[lo], %[t4]\n\t"
+        "adcq   %[lo], %[t3]\n\t"
+        "adcq   $0, %[t4]\n\t"
+        "movq   8(%[pa]), %%rdx\n\t"
+        "xorl   %k[t5], %k[t5]\n\t"
+        "mulxq  16(%[pa]), %[lo], %[hi]\n\t"
+        "adcxq  %[lo], %[t3]\n\t"
+        "adoxq  %[hi], %[t4]\n\t"
+        "mulxq  24(%[pa]), %[lo], %[hi]\n\t"
+        "adcxq  %[lo], %[t4]\n\t"
+        "adoxq  %[hi], %[t5]\n\t"
+        "movl   $0, %k[lo]\n\t"
+        "adcxq  %[lo], %[t5]\n\t"
+        "movq   16(%[pa]), %%rdx\n\t"
+        "mulxq  24(%[pa]), %[lo], %[t6]\n\t"
+        "addq   %[lo], %[t5]\n\t"
+        "adcq   $0, %[t6]\n\t"
+        // 交叉项乘 2
+        "xorl   %k[t7], %k[t7]\n\t"
+        "addq   %[t1], %[t1]\n\t"
+        "adcq   %[t2], %[t2]\n\t"
+        "adcq   %[t3], %[t3]\n\t"
+        "adcq   %[t4], %[t4]\n\t"
+        "adcq   %[t5], %[t5]\n\t"
+        "adcq   %[t6], %[t6]\n\t"
+        "adcq   $0, %[t7]\n\t"
+        // 平方项，一条 ADC 链（MOV 与 MULX 不改标志位）
+        "movq   (%[pa]), %%rdx\n\t"
+        "mulxq  %%rdx, %[t0], %[hi]\n\t"
+        "addq   %[hi], %[t1]\n\t"
+        "movq   8(%[pa]), %%rdx\n\t"
+        "mulxq  %%rdx, %[lo], %[hi]\n\t"
+        "adcq   %[lo], %[t2]\n\t"
+        "adcq   %[hi], %[t3]\n\t"
+        "movq   16(%[pa]), %%rdx\n\t"
+        "mulxq  %%rdx, %[lo], %[hi]\n\t"
+        "adcq   %[lo], %[t4]\n\t"
+        "adcq   %[hi], %[t5]\n\t"
+        "movq   24(%[pa]), %%rdx\n\t"
+        "mulxq  %%rdx, %[lo], %[hi]\n\t"
+        "adcq   %[lo], %[t6]\n\t"
+        "adcq   %[hi], %[t7]\n\t"
+        : [t0] "=&r"(t0), [t1] "=&r"(t1), [t2] "=&r"(t2), [t3] "=&r"(t3),
+          [t4] "=&r"(t4), [t5] "=&r"(t5), [t6] "=&r"(t6), [t7] "=&r"(t7),
+          [lo] "=&r"(lo), [hi] "=&r"(hi)
+        : [pa] "r"(a)
+        : "rdx", "cc", "memory");
+    t[0] = t0; t[1] = t1; t[2] = t2; t[3] = t3;
+    t[4] = t4; t[5] = t5; t[6] = t6; t[7] = t7;
+}
+
+void sm2_fp_mul_adx(uint64_t r[4], const uint64_t a[4], const uint64_t b[4]) {
+    uint64_t t[8];
+    sm2_mul_4x4_adx(t, a, b);
+    sm2_fp_reduce(r, t);
+}
+
+void sm2_fp_sqr_adx(uint64_t r[4], const uint64_t a[4]) {
+    uint64_t t[8];
+    sm2_sqr_4x4_adx(t, a);
+    sm2_fp_reduce(r, t);
+}
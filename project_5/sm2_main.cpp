@@ -0,0 +1,293 @@
+// SM2 自检：GB/T 32918 示例向量、各种点乘实现互相对照、签名/加密往返与篡改检测
+// 编译：g++ -O2 -I../project_4 sm2_main.cpp sm2_field.cpp sm2_field_adx.cpp sm2_ec.cpp sm2_sign.cpp sm2_batch.cpp ../project_4/sm3_*.cpp -o sm2_pro -lpthread
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <vector>
+#include "sm2_pro.h"
+#include "sm2_ec.h"
+
+static int failures = 0;
+
+static void check(const char *name, int ok) {
+    printf("%-40s %s\n", name, ok ? "OK" : "FAIL");
+    if (!ok) failures++;
+}
+
+static void from_hex(uint8_t *out, const char *hex) {
+    size_t n = strlen(hex) / 2;
+    for (size_t i = 0; i < n; i++) {
+        unsigned v;
+        sscanf(hex + 2 * i, "%2x", &v);
+        out[i] = (uint8_t)v;
+    }
+}
+
+// 简单的可复现伪随机数，测试数据不需要密码学强度
+static uint64_t rng_state = 0x9e3779b97f4a7c15ULL;
+static uint64_t rng_next(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static void rng_fill(uint8_t *p, size_t len) {
+    for (size_t i = 0; i < len; i++) p[i] = (uint8_t)(rng_next() >> 32);
+}
+
+static int same_point(const sm2_jac *a, const sm2_jac *b) {
+    sm2_aff pa, pb;
+    int ia = ec_to_affine(&pa, a), ib = ec_to_affine(&pb, b);
+    if (ia != ib) return 0;
+    return !ia || (sm2_equal(pa.x, pb.x) && sm2_equal(pa.y, pb.y));
+}
+
+// 域运算：ADX 与可移植内核一致，求逆、开方的加法链正确
+static void test_field(void) {
+    int ok = 1, roots = 0;
+    uint64_t a[4], b[4], r1[4], r2[4], t[4];
+    for (int i = 0; i < 2000; i++) {
+        for (int k = 0; k < 4; k++) { a[k] = rng_next(); b[k] = rng_next(); }
+        if (i == 0) { sm2_copy(a, SM2_P); a[0]--; sm2_copy(b, a); }   // p - 1
+        if (i == 1) memset(b, 0, sizeof(b));
+        if (!sm2_lt(a, SM2_P)) a[3] >>= 1;    // 保证小于 p
+        if (!sm2_lt(b, SM2_P)) b[3] >>= 1;
+        sm2_fp_mul_portable(r1, a, b);
+        if (strcmp(sm2_fp_impl_name(), "mulx-adx") == 0) {
+            sm2_fp_mul_adx(r2, a, b);
+            ok &= sm2_equal(r1, r2);
+            sm2_fp_sqr_adx(r2, a);
+            sm2_fp_sqr_portable(t, a);
+            ok &= sm2_equal(t, r2);
+        }
+        sm2_fp_mul_portable(t, a, a);
+        sm2_fp_sqr_portable(r2, a);
+        ok &= sm2_equal(t, r2) && sm2_lt(r1, SM2_P);
+
+        fp_inv(t, a);
+        fp_mul(t, t, a);
+        ok &= sm2_is_zero(a) || sm2_equal(t, SM2_P_ONE);
+
+        fp_sqr(t, a);
+        ok &= fp_sqrt(r2, t);
+        fp_sqr(r2, r2);
+        ok &= sm2_equal(r2, t);
+        roots += fp_sqrt(r2, a);
+    }
+    // (p-1)^2 = 1
+    sm2_copy(a, SM2_P);
+    a[0]--;
+    fp_sqr(t, a);
+    ok &= sm2_equal(t, SM2_P_ONE);
+    // 大约一半的元素是二次剩余
+    check("Fp mul / sqr / inv / sqrt", ok && roots > 900 && roots < 1100);
+}
+
+// 标准附录里的示例（默认 ID，消息 "message digest"）
+static void test_vectors(void) {
+    uint8_t d[32], k[32], expect[160], buf[160], z[32], e[32], sig[64];
+    sm2_privkey key;
+    const uint8_t msg[] = "message digest";
+    size_t mlen = sizeof(msg) - 1;
+
+    from_hex(d, "3945208F7B2144B13F36E38AC6D39F95889393692860B51A42FB81EF4DF7C5B8");
+    check("privkey init", sm2_privkey_init(&key, d) == 0);
+    from_hex(expect, "09f9df311e5421a150dd7d161e4bc5c672179fad1833fc076bb08ff356f35020"
+                     "ccea490ce26775a52dc6ea718cc1aa600aed05fbf35e084a6632f6072da9ad13");
+    check("public key = dG", memcmp(key.pub.bytes, expect, 64) == 0);
+
+    sm2_compute_z(&key.pub, NULL, 0, z);
+    from_hex(expect, "b2e14c5c79c6df5b85f4fe7ed8db7a262b9da7e07ccb0ea9f4747b8ccda8a4f3");
+    check("Z_A (default ID)", memcmp(z, expect, 32) == 0);
+
+    sm2_msg_digest(z, msg, mlen, e);
+    from_hex(k, "59276E27D506861A16680F3AD9C02DCCEF3CC1FA3CDBE4CE6D54B80DEAC1BC21");
+    sm2_sign_digest(&key, e, k, sig);
+    from_hex(expect, "f5a03b0648d2c4630eeac513e1bb81a15944da3827d5b74143ac7eaceee720b3"
+                     "b1b6aa29df212fd8763182bc0d421ca1bb9038fd1f7f42d4840b69c485bbc1aa");
+    check("signature (fixed k)", memcmp(sig, expect, 64) == 0);
+    check("verify", sm2_verify(&key.pub, NULL, 0, msg, mlen, sig) == 1);
+    sig[63] ^= 1;
+    check("verify rejects modified s", sm2_verify(&key.pub, NULL, 0, msg, mlen, sig) == 0);
+    sig[63] ^= 1;
+    check("verify rejects other message", sm2_verify(&key.pub, NULL, 0, msg, mlen - 1, sig) == 0);
+
+    from_hex(k, "4C62EEFD6ECFC2B95B92FD6C3D9575148AFA17425546D49018E5388D49DD7B4F");
+    long clen = sm2_encrypt(&key.pub, msg, mlen, k, buf);
+    from_hex(expect, "0411c88ae04cec1ba554d03d5b5970333a83585826c2a985de5520d9e934389efb"
+                     "84b52d344fb21aa8ea38a4940c8332692b8d4da2393549212eafdc0f11ca5c9ce8"
+                     "7a882b2a46101b6e045df76dffbb67d06f7e00857441ac8ccd7cc6c8746469f2a4"
+                     "04ac9d594568189d55a06937");
+    check("ciphertext (fixed k)", clen == (long)mlen + 97 && memcmp(buf, expect, clen) == 0);
+    uint8_t plain[64];
+    long plen = sm2_decrypt(&key, buf, clen, plain);
+    check("decrypt", plen == (long)mlen && memcmp(plain, msg, mlen) == 0);
+}
+
+// 定点表、变时间定点、常数时间变点、wNAF 四条路径结果必须一致
+static void test_scalar_mul(void) {
+    int ok = 1;
+    uint64_t k[4];
+    sm2_jac a, b, c, d;
+    for (int i = 0; i < 300; i++) {
+        uint8_t buf[32];
+        rng_fill(buf, 32);
+        if (i < 4) memset(buf, 0, 32);
+        if (i == 1) buf[31] = 1;
+        if (i == 2) buf[31] = 2;
+        if (i == 3) memcpy(buf, "\xff\xff\xff\xfe\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff"
+                                 "\x72\x03\xdf\x6b\x21\xc6\x05\x2b\x53\xbb\xf4\x09\x39\xd5\x41\x22", 32);
+        sm2_from_bytes(k, buf);
+        fn_reduce(k, k);
+        ec_mul_g(&a, k);
+        ec_mul_g_vartime(&b, k);
+        ec_mul_ct(&c, &SM2_G, k);
+        ec_mul_wnaf(&d, &SM2_G, k);
+        ok &= same_point(&a, &b) && same_point(&a, &c) && same_point(&a, &d);
+        sm2_aff pa;
+        if (ec_to_affine(&pa, &a)) ok &= ec_on_curve(&pa);
+    }
+    check("kG: comb / vartime / ct / wNAF agree", ok);
+
+    // (n-1)G = -G，nG 为无穷远点
+    static const uint64_t one[4] = {1, 0, 0, 0};
+    sm2_aff pa;
+    fn_sub(k, SM2_N, one);
+    ec_mul_g(&a, k);
+    ec_to_affine(&pa, &a);
+    uint64_t ny[4];
+    fp_neg(ny, SM2_G.y);
+    check("(n-1)G = -G", sm2_equal(pa.x, SM2_G.x) && sm2_equal(pa.y, ny));
+    sm2_copy(k, SM2_N);
+    ec_mul_wnaf(&d, &SM2_G, k);
+    check("nG = O (wNAF)", sm2_is_zero(d.Z));
+
+    // 任意点上 ct 与 wNAF 一致，批量转仿射与逐个转换一致
+    sm2_jac pts[8];
+    sm2_aff aff[8];
+    ok = 1;
+    for (int i = 0; i < 8; i++) {
+        uint8_t buf[32];
+        rng_fill(buf, 32);
+        sm2_from_bytes(k, buf);
+        fn_reduce(k, k);
+        ec_mul_g(&pts[i], k);
+    }
+    ec_set_infinity(&pts[3]);
+    ec_batch_to_affine(aff, pts, 8);
+    for (int i = 0; i < 8; i++) {
+        if (i == 3) { ok &= sm2_is_zero(aff[i].x) && sm2_is_zero(aff[i].y); continue; }
+        ec_to_affine(&pa, &pts[i]);
+        ok &= sm2_equal(pa.x, aff[i].x) && sm2_equal(pa.y, aff[i].y);
+        uint8_t buf[32];
+        rng_fill(buf, 32);
+        sm2_from_bytes(k, buf);
+        ec_mul_ct(&a, &pa, k);
+        ec_mul_wnaf(&b, &pa, k);
+        ok &= same_point(&a, &b);
+    }
+    check("kP: ct / wNAF agree, batch affine", ok);
+}
+
+static void test_roundtrip(void) {
+    int sign_ok = 1, enc_ok = 1, tamper_ok = 1;
+    uint8_t msg[300], ct[300 + 97], pt[300], sig[64];
+    for (int i = 0; i < 40; i++) {
+        sm2_privkey key;
+        if (sm2_keygen(&key) != 0) { sign_ok = 0; break; }
+        size_t len = (size_t)(rng_next() % sizeof(msg));
+        if (i == 0) len = 0;
+        rng_fill(msg, len);
+
+        sm2_sign(&key, (const uint8_t *)"alice@example.com", 17, msg, len, sig);
+        sign_ok &= sm2_verify(&key.pub, (const uint8_t *)"alice@example.com", 17, msg, len, sig) == 1;
+        sign_ok &= sm2_verify(&key.pub, NULL, 0, msg, len, sig) == 0;
+
+        // 公钥经字节串导入后应完全等价
+        sm2_pubkey pub;
+        sign_ok &= sm2_pubkey_init(&pub, key.pub.bytes) == 0;
+        sign_ok &= sm2_verify(&pub, (const uint8_t *)"alice@example.com", 17, msg, len, sig) == 1;
+
+        long clen = sm2_encrypt(&pub, msg, len, NULL, ct);
+        enc_ok &= clen == (long)len + 97;
+        enc_ok &= sm2_decrypt(&key, ct, clen, pt) == (long)len && memcmp(pt, msg, len) == 0;
+
+        size_t pos = (size_t)(rng_next() % clen);
+        if (pos == 0) pos = 1;
+        ct[pos] ^= 0x10;
+        tamper_ok &= sm2_decrypt(&key, ct, clen, pt) == -1;
+    }
+    check("sign / verify round trip", sign_ok);
+    check("encrypt / decrypt round trip", enc_ok);
+    check("decrypt rejects tampered ciphertext", tamper_ok);
+
+    uint8_t bad[64];
+    memset(bad, 0, sizeof(bad));
+    sm2_pubkey pub;
+    check("pubkey init rejects off-curve point", sm2_pubkey_init(&pub, bad) == -1);
+    uint8_t d[32];
+    memset(d, 0, sizeof(d));
+    sm2_privkey key;
+    check("privkey init rejects d = 0", sm2_privkey_init(&key, d) == -1);
+}
+
+// 批量验签：混入各种无效签名，ok[] 必须与逐条验签一致
+static void test_batch_verify(void) {
+    const size_t n = 300;
+    std::vector<sm2_privkey> keys(8);
+    std::vector<const sm2_pubkey *> pubs(n);
+    std::vector<uint8_t> e(n * 32), sigs(n * 64), msgs(n * 40);
+    std::vector<const uint8_t *> mp(n);
+    std::vector<size_t> lens(n, 40);
+    std::vector<int> ok(n), expect(n);
+    for (size_t k = 0; k < keys.size(); k++) sm2_keygen(&keys[k]);
+
+    for (size_t i = 0; i < n; i++) {
+        const sm2_privkey *key = &keys[i % keys.size()];
+        pubs[i] = &key->pub;
+        uint8_t *sig = &sigs[i * 64];
+        rng_fill(&e[i * 32], 32);
+        sm2_sign_digest(key, &e[i * 32], NULL, sig);
+        switch (i % 7) {
+        case 1: sig[5] ^= 0x40; break;                 // r 被改
+        case 3: e[i * 32] ^= 1; break;                 // 摘要不符
+        case 5: memset(sig + 32, 0, 32); break;        // s = 0
+        default: break;
+        }
+        if (i == 100) pubs[i] = &keys[(i + 1) % keys.size()].pub;   // 公钥不符
+        expect[i] = sm2_verify_digest(pubs[i], &e[i * 32], sig);
+    }
+    size_t want = 0;
+    for (size_t i = 0; i < n; i++) want += expect[i];
+
+    const uint8_t (*ev)[32] = (const uint8_t (*)[32])e.data();
+    const uint8_t (*sv)[64] = (const uint8_t (*)[64])sigs.data();
+    size_t got1 = sm2_verify_digest_many(pubs.data(), ev, sv, ok.data(), n, 1);
+    int same = got1 == want && ok == expect;
+    size_t got4 = sm2_verify_digest_many(pubs.data(), ev, sv, ok.data(), n, 4);
+    same &= got4 == want && ok == expect;
+    check("batch verify flags match single verify", same && want < n && want > n / 2);
+
+    // 带 Z_A 的接口：消息签名后批量验证，改一条消息
+    for (size_t i = 0; i < n; i++) {
+        rng_fill(&msgs[i * 40], 40);
+        mp[i] = &msgs[i * 40];
+        pubs[i] = &keys[i % keys.size()].pub;
+        sm2_sign(&keys[i % keys.size()], NULL, 0, mp[i], 40, &sigs[i * 64]);
+    }
+    msgs[77 * 40 + 3] ^= 1;
+    size_t got = sm2_verify_many(pubs.data(), NULL, NULL, mp.data(), lens.data(), sv, ok.data(), n, 0);
+    check("batch verify (Z_A) reports the bad index", got == n - 1 && ok[77] == 0 && ok[76] == 1);
+}
+
+int main() {
+    test_field();
+    test_vectors();
+    test_scalar_mul();
+    test_roundtrip();
+    test_batch_verify();
+    printf("%s\n", failures ? "SOME TESTS FAILED" : "all SM2 tests passed");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,82 @@
+#ifndef SM2_PRO_H
+#define SM2_PRO_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * SM2 数字签名与公钥加密（GB/T 32918），杂凑一律用本库的 SM3。
+ * 点与标量都以大端字节串进出：公钥 64 字节 x || y，签名 64 字节 r || s，
+ * 密文为 C1 || C3 || C2（C1 = 04 || x1 || y1，65 字节；C3 为 32 字节摘要），比明文长 97 字节。
+ * 私钥相关的点乘与标量运算是常数时间的；验签只处理公开数据，走更快的变时间路径。
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 选用的 Fp 乘法内核："mulx-adx" 或 "portable"
+const char *sm2_fp_impl_name(void);
+
+#define SM2_SIG_BYTES 64
+#define SM2_CIPHER_OVERHEAD 97
+
+// 坐标为内部表示，初始化后只读，可在线程间共享
+typedef struct {
+    uint64_t x[4], y[4];   // 仿射坐标，小端 64 位字
+    uint8_t bytes[64];     // x || y，算 Z_A 时直接用
+} sm2_pubkey;
+
+typedef struct {
+    uint64_t d[4];
+    uint64_t dinv[4];      // (1 + d)^-1 mod n，签名时省掉一次求逆
+    sm2_pubkey pub;
+} sm2_privkey;
+
+// d 必须在 [1, n-2] 内，否则返回 -1
+int sm2_privkey_init(sm2_privkey *key, const uint8_t d[32]);
+// 随机生成密钥对；随机源读取失败时返回 -1
+int sm2_keygen(sm2_privkey *key);
+void sm2_privkey_export(const sm2_privkey *key, uint8_t d[32]);
+// 坐标超出 [0, p) 或点不在曲线上时返回 -1
+int sm2_pubkey_init(sm2_pubkey *key, const uint8_t xy[64]);
+
+// Z_A = SM3(ENTL || ID || a || b || xG || yG || xA || yA)；id 为 NULL 时用默认 ID "1234567812345678"
+// ID 超过 8191 字节（ENTL 放不下）时返回 -1
+int sm2_compute_z(const sm2_pubkey *key, const uint8_t *id, size_t id_len, uint8_t z[32]);
+// e = SM3(Z_A || M)；同一身份签多条消息时可以只算一次 Z_A
+void sm2_msg_digest(const uint8_t z[32], const uint8_t *msg, size_t len, uint8_t e[32]);
+
+// k 为 NULL 时取随机数；给定 k（只用于测试向量）且 k 不合法时返回 -1
+int sm2_sign_digest(const sm2_privkey *key, const uint8_t e[32], const uint8_t *k, uint8_t sig[64]);
+int sm2_sign(const sm2_privkey *key, const uint8_t *id, size_t id_len,
+             const uint8_t *msg, size_t len, uint8_t sig[64]);
+// 通过返回 1
+int sm2_verify_digest(const sm2_pubkey *key, const uint8_t e[32], const uint8_t sig[64]);
+int sm2_verify(const sm2_pubkey *key, const uint8_t *id, size_t id_len,
+               const uint8_t *msg, size_t len, const uint8_t sig[64]);
+
+/*
+ * 批量验签：ok[i] 写 1 或 0，返回通过的条数；返回值小于 n 时按 ok[] 找出无效的签名。
+ * 每 SM2_BATCH_CHUNK 条一组：各公钥的奇数倍表一起转仿射、各组结果点一起转仿射，
+ * 两次都只做一次域求逆；sG + tP 用 Straus 交错点乘。各组由工作窃取线程池分发，
+ * threads 为 0 时用全部硬件线程。
+ */
+#define SM2_BATCH_CHUNK 64
+size_t sm2_verify_digest_many(const sm2_pubkey *const *keys, const uint8_t (*e)[32],
+                              const uint8_t (*sigs)[64], int *ok, size_t n, unsigned threads);
+// ids 为 NULL 或 ids[i] 为 NULL 时用默认 ID
+size_t sm2_verify_many(const sm2_pubkey *const *keys, const uint8_t *const *ids, const size_t *id_lens,
+                       const uint8_t *const *msgs, const size_t *lens, const uint8_t (*sigs)[64],
+                       int *ok, size_t n, unsigned threads);
+
+// out 至少 len + 97 字节；返回密文长度，失败返回 -1。k 的约定同签名
+long sm2_encrypt(const sm2_pubkey *key, const uint8_t *msg, size_t len, const uint8_t *k, uint8_t *out);
+// out 至少 len - 97 字节；返回明文长度，密文格式错误或 C3 校验失败返回 -1（此时 out 内容无意义）
+long sm2_decrypt(const sm2_privkey *key, const uint8_t *in, size_t len, uint8_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SM2_PRO_H
@@ -0,0 +1,338 @@
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/random.h>
+#include "sm2_pro.h"
+#include "sm2_ec.h"
+#include "sm3_promax.h"
+
+/*
+ * SM2 签名、验签、加密、解密
+ * 签名 s = (1 + d)^-1 (k - r d) mod n，其中 (1 + d)^-1 在密钥初始化时就算好；
+ * 验签 sG + tP 的两个点乘分别走定点表和 wNAF，最后只做一次求逆转仿射。
+ */
+
+// a || b || xG || yG，计算 Z_A 时依次接在 ID 后面
+static const uint8_t SM2_CURVE_BYTES[128] = {
+    0xFF, 0xFF, 0xFF, 0xFE, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFC,
+    0x28, 0xE9, 0xFA, 0x9E, 0x9D, 0x9F, 0x5E, 0x34, 0x4D, 0x5A, 0x9E, 0x4B, 0xCF, 0x65, 0x09, 0xA7,
+    0xF3, 0x97, 0x89, 0xF5, 0x15, 0xAB, 0x8F, 0x92, 0xDD, 0xBC, 0xBD, 0x41, 0x4D, 0x94, 0x0E, 0x93,
+    0x32, 0xC4, 0xAE, 0x2C, 0x1F, 0x19, 0x81, 0x19, 0x5F, 0x99, 0x04, 0x46, 0x6A, 0x39, 0xC9, 0x94,
+    0x8F, 0xE3, 0x0B, 0xBF, 0xF2, 0x66, 0x0B, 0xE1, 0x71, 0x5A, 0x45, 0x89, 0x33, 0x4C, 0x74, 0xC7,
+    0xBC, 0x37, 0x36, 0xA2, 0xF4, 0xF6, 0x77, 0x9C, 0x59, 0xBD, 0xCE, 0xE3, 0x6B, 0x69, 0x21, 0x53,
+    0xD0, 0xA9, 0x87, 0x7C, 0xC6, 0x2A, 0x47, 0x40, 0x02, 0xDF, 0x32, 0xE5, 0x21, 0x39, 0xF0, 0xA0,
+};
+
+static const uint8_t SM2_DEFAULT_ID[16] = {
+    '1', '2', '3', '4', '5', '6', '7', '8', '1', '2', '3', '4', '5', '6', '7', '8'
+};
+
+static inline void sm2_store_digest(uint8_t out[32], const uint32_t h[8]) {
+    for (int i = 0; i < 8; i++) {
+        out[4 * i]     = (uint8_t)(h[i] >> 24);
+        out[4 * i + 1] = (uint8_t)(h[i] >> 16);
+        out[4 * i + 2] = (uint8_t)(h[i] >> 8);
+        out[4 * i + 3] = (uint8_t)h[i];
+    }
+}
+
+static void sm2_wipe(void *p, size_t len) {
+    volatile uint8_t *v = (volatile uint8_t *)p;
+    while (len--) *v++ = 0;
+}
+
+static int sm2_random_bytes(uint8_t *buf, size_t len) {
+    while (len > 0) {
+        ssize_t got = getrandom(buf, len, 0);
+        if (got < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        buf += got;
+        len -= (size_t)got;
+    }
+    return 0;
+}
+
+// 均匀取 [1, n-1] 内的随机数（拒绝采样，n 接近 2^256，几乎不会重试）
+static int sm2_random_scalar(uint64_t k[4]) {
+    uint8_t buf[32];
+    for (;;) {
+        if (sm2_random_bytes(buf, sizeof(buf)) != 0) return -1;
+        sm2_from_bytes(k, buf);
+        if (!sm2_is_zero(k) && sm2_lt(k, SM2_N)) break;
+    }
+    sm2_wipe(buf, sizeof(buf));
+    return 0;
+}
+
+// 给定 k 时检查范围，否则随机生成
+static int sm2_load_k(uint64_t k[4], const uint8_t *given) {
+    if (given == NULL) return sm2_random_scalar(k);
+    sm2_from_bytes(k, given);
+    return (!sm2_is_zero(k) && sm2_lt(k, SM2_N)) ? 0 : -1;
+}
+
+// 仿射点 -> 大端 x || y
+static void sm2_point_bytes(uint8_t out[64], const sm2_aff *p) {
+    sm2_to_bytes(out, p->x);
+    sm2_to_bytes(out + 32, p->y);
+}
+
+// 大端 x || y -> 仿射点，坐标越界或不在曲线上返回 -1
+static int sm2_point_load(sm2_aff *p, const uint8_t in[64]) {
+    sm2_from_bytes(p->x, in);
+    sm2_from_bytes(p->y, in + 32);
+    if (!sm2_lt(p->x, SM2_P) || !sm2_lt(p->y, SM2_P)) return -1;
+    return ec_on_curve(p) ? 0 : -1;
+}
+
+static void sm2_pubkey_set(sm2_pubkey *key, const sm2_aff *p) {
+    sm2_copy(key->x, p->x);
+    sm2_copy(key->y, p->y);
+    sm2_point_bytes(key->bytes, p);
+}
+
+/* ===== 密钥 ===== */
+
+int sm2_privkey_init(sm2_privkey *key, const uint8_t d[32]) {
+    static const uint64_t one[4] = {1, 0, 0, 0};
+    uint64_t v[4], n1[4];
+    sm2_from_bytes(v, d);
+    fn_sub(n1, SM2_N, one);
+    if (sm2_is_zero(v) || !sm2_lt(v, n1)) return -1;
+
+    sm2_jac pj;
+    sm2_aff pa;
+    ec_mul_g(&pj, v);
+    ec_to_affine(&pa, &pj);
+    sm2_pubkey_set(&key->pub, &pa);
+
+    sm2_copy(key->d, v);
+    fn_add(v, v, one);
+    fn_inv(key->dinv, v);
+    sm2_wipe(v, sizeof(v));
+    return 0;
+}
+
+int sm2_keygen(sm2_privkey *key) {
+    uint8_t d[32];
+    for (;;) {
+        uint64_t v[4];
+        if (sm2_random_scalar(v) != 0) return -1;
+        sm2_to_bytes(d, v);
+        sm2_wipe(v, sizeof(v));
+        if (sm2_privkey_init(key, d) == 0) break;   // 只有 d = n - 1 会被拒绝
+    }
+    sm2_wipe(d, sizeof(d));
+    return 0;
+}
+
+void sm2_privkey_export(const sm2_privkey *key, uint8_t d[32]) {
+    sm2_to_bytes(d, key->d);
+}
+
+int sm2_pubkey_init(sm2_pubkey *key, const uint8_t xy[64]) {
+    sm2_aff p;
+    if (sm2_point_load(&p, xy) != 0) return -1;
+    sm2_copy(key->x, p.x);
+    sm2_copy(key->y, p.y);
+    memcpy(key->bytes, xy, 64);
+    return 0;
+}
+
+/* ===== 杂凑 ===== */
+
+int sm2_compute_z(const sm2_pubkey *key, const uint8_t *id, size_t id_len, uint8_t z[32]) {
+    if (id == NULL) {
+        id = SM2_DEFAULT_ID;
+        id_len = sizeof(SM2_DEFAULT_ID);
+    }
+    if (id_len > 8191) return -1;
+    uint8_t entl[2] = {(uint8_t)((id_len * 8) >> 8), (uint8_t)(id_len * 8)};
+    sm3_ctx ctx;
+    uint32_t h[8];
+    sm3_init(&ctx);
+    sm3_update(&ctx, entl, 2);
+    sm3_update(&ctx, id, id_len);
+    sm3_update(&ctx, SM2_CURVE_BYTES, sizeof(SM2_CURVE_BYTES));
+    sm3_update(&ctx, key->bytes, 64);
+    sm3_final(&ctx, h);
+    sm2_store_digest(z, h);
+    return 0;
+}
+
+void sm2_msg_digest(const uint8_t z[32], const uint8_t *msg, size_t len, uint8_t e[32]) {
+    sm3_ctx ctx;
+    uint32_t h[8];
+    sm3_init(&ctx);
+    sm3_update(&ctx, z, 32);
+    sm3_update(&ctx, msg, len);
+    sm3_final(&ctx, h);
+    sm2_store_digest(e, h);
+}
+
+/* ===== 签名 ===== */
+
+int sm2_sign_digest(const sm2_privkey *key, const uint8_t e[32], const uint8_t *k_in, uint8_t sig[64]) {
+    uint64_t ev[4], k[4], r[4], s[4], t[4];
+    sm2_from_bytes(ev, e);
+    fn_reduce(ev, ev);
+
+    for (;;) {
+        if (sm2_load_k(k, k_in) != 0) return -1;
+
+        sm2_jac pj;
+        sm2_aff pa;
+        ec_mul_g(&pj, k);
+        ec_to_affine(&pa, &pj);
+        fn_reduce(t, pa.x);
+        fn_add(r, ev, t);                  // r = (e + x1) mod n
+
+        fn_add(t, r, k);
+        if (sm2_is_zero(r) || sm2_is_zero(t)) {   // r = 0 或 r + k = n
+            if (k_in) return -1;
+            continue;
+        }
+
+        fn_mul(t, r, key->d);
+        fn_sub(t, k, t);
+        fn_mul(s, key->dinv, t);           // s = (1 + d)^-1 (k - r d)
+        if (sm2_is_zero(s)) {
+            if (k_in) return -1;
+            continue;
+        }
+        break;
+    }
+    sm2_to_bytes(sig, r);
+    sm2_to_bytes(sig + 32, s);
+    sm2_wipe(k, sizeof(k));
+    sm2_wipe(t, sizeof(t));
+    return 0;
+}
+
+int sm2_sign(const sm2_privkey *key, const uint8_t *id, size_t id_len,
+             const uint8_t *msg, size_t len, uint8_t sig[64]) {
+    uint8_t z[32], e[32];
+    if (sm2_compute_z(&key->pub, id, id_len, z) != 0) return -1;
+    sm2_msg_digest(z, msg, len, e);
+    return sm2_sign_digest(key, e, NULL, sig);
+}
+
+int sm2_verify_digest(const sm2_pubkey *key, const uint8_t e[32], const uint8_t sig[64]) {
+    uint64_t r[4], s[4], t[4], ev[4];
+    sm2_from_bytes(r, sig);
+    sm2_from_bytes(s, sig + 32);
+    if (sm2_is_zero(r) || !sm2_lt(r, SM2_N) || sm2_is_zero(s) || !sm2_lt(s, SM2_N)) return 0;
+    fn_add(t, r, s);
+    if (sm2_is_zero(t)) return 0;
+
+    // (x1, y1) = sG + tP，标量都是公开的
+    sm2_aff pub, pa;
+    sm2_jac sg, tp;
+    sm2_copy(pub.x, key->x);
+    sm2_copy(pub.y, key->y);
+    ec_mul_g_vartime(&sg, s);
+    ec_mul_wnaf(&tp, &pub, t);
+    ec_add(&sg, &sg, &tp);
+    if (!ec_to_affine(&pa, &sg)) return 0;
+
+    fn_reduce(t, pa.x);
+    sm2_from_bytes(ev, e);
+    fn_reduce(ev, ev);
+    fn_add(t, ev, t);
+    return sm2_equal(t, r);
+}
+
+int sm2_verify(const sm2_pubkey *key, const uint8_t *id, size_t id_len,
+               const uint8_t *msg, size_t len, const uint8_t sig[64]) {
+    uint8_t z[32], e[32];
+    if (sm2_compute_z(key, id, id_len, z) != 0) return 0;
+    sm2_msg_digest(z, msg, len, e);
+    return sm2_verify_digest(key, e, sig);
+}
+
+/* ===== 加密 ===== */
+
+// C3 = SM3(x2 || M || y2)
+static void sm2_c3(uint8_t out[32], const uint8_t xy[64], const uint8_t *msg, size_t len) {
+    sm3_ctx ctx;
+    uint32_t h[8];
+    sm3_init(&ctx);
+    sm3_update(&ctx, xy, 32);
+    sm3_update(&ctx, msg, len);
+    sm3_update(&ctx, xy + 32, 32);
+    sm3_final(&ctx, h);
+    sm2_store_digest(out, h);
+}
+
+// KDF 输出全 0 时返回 1（标准要求此时重选 k / 判定解密失败）
+static int sm2_all_zero(const uint8_t *p, size_t len) {
+    uint8_t acc = 0;
+    for (size_t i = 0; i < len; i++) acc |= p[i];
+    return acc == 0;
+}
+
+long sm2_encrypt(const sm2_pubkey *key, const uint8_t *msg, size_t len, const uint8_t *k_in, uint8_t *out) {
+    uint8_t *c3 = out + 65, *c2 = out + 97;
+    uint8_t xy[64];
+    uint64_t k[4];
+    sm2_aff pub;
+    sm2_copy(pub.x, key->x);
+    sm2_copy(pub.y, key->y);
+
+    for (;;) {
+        if (sm2_load_k(k, k_in) != 0) return -1;
+
+        sm2_jac pj;
+        sm2_aff pa;
+        ec_mul_g(&pj, k);                  // C1 = kG
+        ec_to_affine(&pa, &pj);
+        out[0] = 0x04;
+        sm2_point_bytes(out + 1, &pa);
+
+        ec_mul_ct(&pj, &pub, k);           // (x2, y2) = kP（余因子 h = 1）
+        ec_to_affine(&pa, &pj);
+        sm2_point_bytes(xy, &pa);
+
+        sm3_kdf(xy, 64, c2, len);
+        if (len > 0 && sm2_all_zero(c2, len)) {
+            if (k_in) return -1;
+            continue;
+        }
+        break;
+    }
+    for (size_t i = 0; i < len; i++) c2[i] ^= msg[i];
+    sm2_c3(c3, xy, msg, len);
+    sm2_wipe(k, sizeof(k));
+    sm2_wipe(xy, sizeof(xy));
+    return (long)(len + SM2_CIPHER_OVERHEAD);
+}
+
+long sm2_decrypt(const sm2_privkey *key, const uint8_t *in, size_t len, uint8_t *out) {
+    if (len < SM2_CIPHER_OVERHEAD || in[0] != 0x04) return -1;
+    size_t mlen = len - SM2_CIPHER_OVERHEAD;
+    const uint8_t *c3 = in + 65, *c2 = in + 97;
+
+    sm2_aff c1;
+    if (sm2_point_load(&c1, in + 1) != 0) return -1;
+
+    sm2_jac pj;
+    sm2_aff pa;
+    uint8_t xy[64], u[32];
+    ec_mul_ct(&pj, &c1, key->d);           // (x2, y2) = d C1
+    if (!ec_to_affine(&pa, &pj)) return -1;
+    sm2_point_bytes(xy, &pa);
+
+    sm3_kdf(xy, 64, out, mlen);
+    if (mlen > 0 && sm2_all_zero(out, mlen)) return -1;
+    for (size_t i = 0; i < mlen; i++) out[i] ^= c2[i];
+    sm2_c3(u, xy, out, mlen);
+    sm2_wipe(xy, sizeof(xy));
+    if (!sm3_ct_equal(u, c3, 32)) {
+        sm2_wipe(out, mlen);
+        return -1;
+    }
+    return (long)mlen;
+}
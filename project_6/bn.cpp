@@ -0,0 +1,422 @@
+#include <string.h>
+#include <errno.h>
+#include <stdio.h>
+#include <sys/random.h>
+#include "bn.h"
+
+/* ===== 普通整数运算 ===== */
+
+size_t bn_bits(const uint64_t *a, size_t k) {
+    while (k > 0 && a[k - 1] == 0) k--;
+    if (k == 0) return 0;
+    return (k - 1) * 64 + (64 - (size_t)__builtin_clzll(a[k - 1]));
+}
+
+int bn_is_zero(const uint64_t *a, size_t k) {
+    uint64_t acc = 0;
+    for (size_t i = 0; i < k; i++) acc |= a[i];
+    return acc == 0;
+}
+
+int bn_cmp(const uint64_t *a, const uint64_t *b, size_t k) {
+    for (size_t i = k; i-- > 0;) {
+        if (a[i] != b[i]) return a[i] < b[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+uint64_t bn_add(uint64_t *r, const uint64_t *a, const uint64_t *b, size_t k) {
+    uint64_t carry = 0;
+    for (size_t i = 0; i < k; i++) {
+        bn_u128 s = (bn_u128)a[i] + b[i] + carry;
+        r[i] = (uint64_t)s;
+        carry = (uint64_t)(s >> 64);
+    }
+    return carry;
+}
+
+uint64_t bn_sub(uint64_t *r, const uint64_t *a, const uint64_t *b, size_t k) {
+    uint64_t borrow = 0;
+    for (size_t i = 0; i < k; i++) {
+        bn_u128 d = (bn_u128)a[i] - b[i] - borrow;
+        r[i] = (uint64_t)d;
+        borrow = (uint64_t)(d >> 64) & 1;
+    }
+    return borrow;
+}
+
+uint64_t bn_sub_word(uint64_t *r, const uint64_t *a, size_t k, uint64_t w) {
+    uint64_t borrow = w;
+    for (size_t i = 0; i < k; i++) {
+        bn_u128 d = (bn_u128)a[i] - borrow;
+        r[i] = (uint64_t)d;
+        borrow = (uint64_t)(d >> 64) & 1;
+    }
+    return borrow;
+}
+
+void bn_mul(uint64_t *r, const uint64_t *a, size_t ka, const uint64_t *b, size_t kb) {
+    memset(r, 0, (ka + kb) * sizeof(uint64_t));
+    for (size_t i = 0; i < kb; i++) {
+        uint64_t bi = b[i], c = 0;
+        for (size_t j = 0; j < ka; j++) {
+            bn_u128 acc = (bn_u128)a[j] * bi + r[i + j] + c;
+            r[i + j] = (uint64_t)acc;
+            c = (uint64_t)(acc >> 64);
+        }
+        r[i + ka] = c;
+    }
+}
+
+uint64_t bn_div_word(uint64_t *q, const uint64_t *a, size_t k, uint64_t d) {
+    uint64_t rem = 0;
+    for (size_t i = k; i-- > 0;) {
+        bn_u128 cur = ((bn_u128)rem << 64) | a[i];
+        q[i] = (uint64_t)(cur / d);
+        rem = (uint64_t)(cur % d);
+    }
+    return rem;
+}
+
+// 从低位起每一步选 q_i 使当前最低字归零，减去 q_i * n * 2^(64 i)；整除时最后余数为 0
+void bn_divexact(uint64_t *q, const uint64_t *a, size_t ka, const uint64_t *n, size_t kn, uint64_t ninv) {
+    bn_t t(a, a + ka);
+    for (size_t i = 0; i + kn <= ka; i++) {
+        uint64_t qi = t[i] * ninv, mulc = 0, borrow = 0;
+        for (size_t j = 0; j < kn; j++) {
+            bn_u128 p = (bn_u128)qi * n[j] + mulc;
+            mulc = (uint64_t)(p >> 64);
+            bn_u128 d = (bn_u128)t[i + j] - (uint64_t)p - borrow;
+            t[i + j] = (uint64_t)d;
+            borrow = (uint64_t)(d >> 64) & 1;
+        }
+        for (size_t j = i + kn; j < ka && (mulc | borrow); j++) {
+            bn_u128 d = (bn_u128)t[j] - mulc - borrow;
+            t[j] = (uint64_t)d;
+            borrow = (uint64_t)(d >> 64) & 1;
+            mulc = 0;
+        }
+        q[i] = qi;
+    }
+}
+
+void bn_from_bytes(uint64_t *r, size_t k, const uint8_t *in, size_t len) {
+    memset(r, 0, k * sizeof(uint64_t));
+    for (size_t i = 0; i < len && i < k * 8; i++) {
+        r[i / 8] |= (uint64_t)in[len - 1 - i] << (8 * (i % 8));
+    }
+}
+
+void bn_to_bytes(uint8_t *out, size_t len, const uint64_t *a, size_t k) {
+    for (size_t i = 0; i < len; i++) {
+        out[len - 1 - i] = i < k * 8 ? (uint8_t)(a[i / 8] >> (8 * (i % 8))) : 0;
+    }
+}
+
+// 反复除以 10^19，每段 19 位十进制
+std::string bn_to_dec(const uint64_t *a, size_t k) {
+    const uint64_t chunk = 10000000000000000000ULL;
+    bn_t t(a, a + k);
+    std::vector<uint64_t> parts;
+    while (!bn_is_zero(t.data(), k)) parts.push_back(bn_div_word(t.data(), t.data(), k, chunk));
+    if (parts.empty()) return "0";
+    char buf[24];
+    snprintf(buf, sizeof(buf), "%llu", (unsigned long long)parts.back());
+    std::string s = buf;
+    for (size_t i = parts.size() - 1; i-- > 0;) {
+        snprintf(buf, sizeof(buf), "%019llu", (unsigned long long)parts[i]);
+        s += buf;
+    }
+    return s;
+}
+
+int bn_random_bytes(uint8_t *buf, size_t len) {
+    while (len > 0) {
+        ssize_t got = getrandom(buf, len, 0);
+        if (got < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        buf += got;
+        len -= (size_t)got;
+    }
+    return 0;
+}
+
+int bn_random_bits(uint64_t *r, size_t k, size_t bits) {
+    memset(r, 0, k * sizeof(uint64_t));
+    size_t words = (bits + 63) / 64;
+    if (bn_random_bytes((uint8_t *)r, words * sizeof(uint64_t)) != 0) return -1;
+    if (bits % 64) r[words - 1] &= ((uint64_t)1 << (bits % 64)) - 1;
+    return 0;
+}
+
+int bn_random_below(uint64_t *r, const uint64_t *m, size_t k) {
+    size_t bits = bn_bits(m, k);
+    do {
+        if (bn_random_bits(r, k, bits) != 0) return -1;
+    } while (bn_is_zero(r, k) || bn_cmp(r, m, k) >= 0);
+    return 0;
+}
+
+/* ===== Montgomery 模运算 ===== */
+
+// (hi:t) - m，够减时取差；要求 (hi:t) < 2m
+static void bn_reduce_once(uint64_t *r, const uint64_t *t, uint64_t hi, const uint64_t *m, size_t k) {
+    uint64_t s[BN_MAX_WORDS];
+    uint64_t borrow = bn_sub(s, t, m, k);
+    uint64_t keep = 0 - (uint64_t)(hi < borrow);
+    for (size_t i = 0; i < k; i++) r[i] = (t[i] & keep) | (s[i] & ~keep);
+}
+
+// 取 e 从第 pos 位起的 w 位
+static inline unsigned bn_window(const uint64_t *e, size_t ke, size_t pos, unsigned w) {
+    size_t word = pos / 64, sh = pos % 64;
+    uint64_t v = word < ke ? e[word] >> sh : 0;
+    if (sh + w > 64 && word + 1 < ke) v |= e[word + 1] << (64 - sh);
+    return (unsigned)(v & (((uint64_t)1 << w) - 1));
+}
+
+// 从 table 的 count 项（每项 k 字）里取第 idx 项，逐项读一遍用掩码选出
+static void bn_select(uint64_t *r, const uint64_t *table, size_t count, size_t k, size_t idx) {
+    memset(r, 0, k * sizeof(uint64_t));
+    for (size_t i = 0; i < count; i++) {
+        uint64_t diff = (uint64_t)(i ^ idx);
+        uint64_t mask = ((diff | (0 - diff)) >> 63) - 1;
+        const uint64_t *row = table + i * k;
+        for (size_t j = 0; j < k; j++) r[j] |= row[j] & mask;
+    }
+}
+
+int bn_mont_init(bn_mont *ctx, const uint64_t *m, size_t k) {
+    if (k == 0 || k > BN_MAX_WORDS || (m[0] & 1) == 0 || m[k - 1] == 0) return -1;
+    ctx->k = k;
+    ctx->m.assign(m, m + k);
+    // Newton 迭代求 m^-1 mod 2^64，每次精度翻倍
+    uint64_t inv = m[0];
+    for (int i = 0; i < 5; i++) inv *= 2 - m[0] * inv;
+    ctx->m0 = 0 - inv;
+    // 从 1 开始反复加倍：64k 次得 R mod m，再 64k 次得 R^2 mod m
+    bn_t x(k, 0);
+    x[0] = 1;
+    for (size_t i = 0; i < 128 * k; i++) {
+        uint64_t carry = bn_add(x.data(), x.data(), x.data(), k);
+        bn_reduce_once(x.data(), x.data(), carry, m, k);
+        if (i + 1 == 64 * k) ctx->one = x;
+    }
+    ctx->rr = x;
+    return 0;
+}
+
+// CIOS：乘 b[i] 与约简合并在同一个内层循环里，t 始终小于 2m
+void bn_mont_mul(const bn_mont *ctx, uint64_t *r, const uint64_t *a, const uint64_t *b) {
+    const size_t k = ctx->k;
+    const uint64_t *m = ctx->m.data();
+    const uint64_t m0 = ctx->m0;
+    uint64_t t[BN_MAX_WORDS + 1];
+    memset(t, 0, (k + 1) * sizeof(uint64_t));
+    for (size_t i = 0; i < k; i++) {
+        uint64_t bi = b[i];
+        bn_u128 acc = (bn_u128)a[0] * bi + t[0];
+        uint64_t c1 = (uint64_t)(acc >> 64), lo = (uint64_t)acc;
+        uint64_t u = lo * m0;
+        bn_u128 red = (bn_u128)u * m[0] + lo;
+        uint64_t c2 = (uint64_t)(red >> 64);
+        for (size_t j = 1; j < k; j++) {
+            acc = (bn_u128)a[j] * bi + t[j] + c1;
+            c1 = (uint64_t)(acc >> 64);
+            red = (bn_u128)u * m[j] + (uint64_t)acc + c2;
+            t[j - 1] = (uint64_t)red;
+            c2 = (uint64_t)(red >> 64);
+        }
+        bn_u128 s = (bn_u128)t[k] + c1 + c2;
+        t[k - 1] = (uint64_t)s;
+        t[k] = (uint64_t)(s >> 64);
+    }
+    bn_reduce_once(r, t, t[k], m, k);
+}
+
+void bn_mont_redc(const bn_mont *ctx, uint64_t *r, uint64_t *t) {
+    const size_t k = ctx->k;
+    const uint64_t *m = ctx->m.data();
+    uint64_t top = 0;
+    for (size_t i = 0; i < k; i++) {
+        uint64_t u = t[i] * ctx->m0, c = 0;
+        for (size_t j = 0; j < k; j++) {
+            bn_u128 acc = (bn_u128)u * m[j] + t[i + j] + c;
+            t[i + j] = (uint64_t)acc;
+            c = (uint64_t)(acc >> 64);
+        }
+        bn_u128 s = (bn_u128)t[i + k] + c + top;
+        t[i + k] = (uint64_t)s;
+        top = (uint64_t)(s >> 64);
+    }
+    bn_reduce_once(r, t + k, top, m, k);
+}
+
+void bn_to_mont(const bn_mont *ctx, uint64_t *r, const uint64_t *a) {
+    bn_mont_mul(ctx, r, a, ctx->rr.data());
+}
+
+void bn_from_mont(const bn_mont *ctx, uint64_t *r, const uint64_t *a) {
+    uint64_t t[2 * BN_MAX_WORDS];
+    memcpy(t, a, ctx->k * sizeof(uint64_t));
+    memset(t + ctx->k, 0, ctx->k * sizeof(uint64_t));
+    bn_mont_redc(ctx, r, t);
+}
+
+// a * R^-1 再乘 R^2 * R^-1
+void bn_mod(const bn_mont *ctx, uint64_t *r, const uint64_t *a, size_t ka) {
+    uint64_t t[2 * BN_MAX_WORDS];
+    memcpy(t, a, ka * sizeof(uint64_t));
+    memset(t + ka, 0, (2 * ctx->k - ka) * sizeof(uint64_t));
+    bn_mont_redc(ctx, r, t);
+    bn_mont_mul(ctx, r, r, ctx->rr.data());
+}
+
+void bn_mod_mul(const bn_mont *ctx, uint64_t *r, const uint64_t *a, const uint64_t *b) {
+    uint64_t t[BN_MAX_WORDS];
+    bn_mont_mul(ctx, t, a, b);
+    bn_mont_mul(ctx, r, t, ctx->rr.data());
+}
+
+void bn_mont_exp(const bn_mont *ctx, uint64_t *r, const uint64_t *a, const uint64_t *e, size_t ke) {
+    const size_t k = ctx->k;
+    const unsigned w = 5;
+    bn_t table((size_t)32 * k);
+    memcpy(&table[0], ctx->one.data(), k * sizeof(uint64_t));
+    memcpy(&table[k], a, k * sizeof(uint64_t));
+    for (size_t i = 2; i < 32; i++) bn_mont_mul(ctx, &table[i * k], &table[(i - 1) * k], a);
+
+    uint64_t acc[BN_MAX_WORDS], sel[BN_MAX_WORDS];
+    memcpy(acc, ctx->one.data(), k * sizeof(uint64_t));
+    size_t bits = bn_bits(e, ke);
+    size_t windows = (bits + w - 1) / w;
+    for (size_t i = windows; i-- > 0;) {
+        if (i + 1 != windows) {
+            for (unsigned s = 0; s < w; s++) bn_mont_mul(ctx, acc, acc, acc);
+        }
+        bn_select(sel, table.data(), 32, k, bn_window(e, ke, i * w, w));
+        bn_mont_mul(ctx, acc, acc, sel);
+    }
+    memcpy(r, acc, k * sizeof(uint64_t));
+}
+
+void bn_mod_exp(const bn_mont *ctx, uint64_t *r, const uint64_t *a, const uint64_t *e, size_t ke) {
+    uint64_t t[BN_MAX_WORDS];
+    bn_to_mont(ctx, t, a);
+    bn_mont_exp(ctx, t, t, e, ke);
+    bn_from_mont(ctx, r, t);
+}
+
+void bn_fixed_base_init(bn_fixed_base *fb, const bn_mont *ctx, const uint64_t *g, size_t max_bits, unsigned w) {
+    const size_t k = ctx->k;
+    const size_t per = ((size_t)1 << w) - 1;
+    fb->ctx = ctx;
+    fb->w = w;
+    fb->windows = (max_bits + w - 1) / w;
+    fb->table.assign(fb->windows * per * k, 0);
+    uint64_t base[BN_MAX_WORDS];
+    memcpy(base, g, k * sizeof(uint64_t));
+    for (size_t i = 0; i < fb->windows; i++) {
+        uint64_t *row = &fb->table[i * per * k];
+        memcpy(row, base, k * sizeof(uint64_t));
+        for (size_t d = 1; d < per; d++) bn_mont_mul(ctx, row + d * k, row + (d - 1) * k, base);
+        bn_mont_mul(ctx, base, row + (per - 1) * k, base);   // g^(2^(w (i + 1)))
+    }
+}
+
+void bn_fixed_base_exp(const bn_fixed_base *fb, uint64_t *r, const uint64_t *e, size_t ke) {
+    const bn_mont *ctx = fb->ctx;
+    const size_t k = ctx->k;
+    const size_t per = ((size_t)1 << fb->w) - 1;
+    uint64_t acc[BN_MAX_WORDS], sel[BN_MAX_WORDS];
+    memcpy(acc, ctx->one.data(), k * sizeof(uint64_t));
+    for (size_t i = 0; i < fb->windows; i++) {
+        unsigned d = bn_window(e, ke, i * fb->w, fb->w);
+        // 数字为 0 时选出全 0，再用掩码换成 1
+        bn_select(sel, &fb->table[i * per * k], per, k, (size_t)d - 1);
+        uint64_t zero = 0 - (uint64_t)(d == 0);
+        for (size_t j = 0; j < k; j++) sel[j] |= ctx->one[j] & zero;
+        bn_mont_mul(ctx, acc, acc, sel);
+    }
+    memcpy(r, acc, k * sizeof(uint64_t));
+}
+
+/* ===== 素数 ===== */
+
+// 8192 以内的奇素数，试除筛掉大部分候选
+static const std::vector<uint32_t> &bn_small_primes(void) {
+    static const std::vector<uint32_t> primes = [] {
+        std::vector<uint32_t> v;
+        std::vector<char> comp(8192, 0);
+        for (uint32_t i = 3; i < 8192; i += 2) {
+            if (comp[i]) continue;
+            v.push_back(i);
+            for (uint32_t j = i * i; j < 8192; j += 2 * i) comp[j] = 1;
+        }
+        return v;
+    }();
+    return primes;
+}
+
+int bn_is_probable_prime(const uint64_t *p, size_t k, int rounds) {
+    bn_mont ctx;
+    if (bn_mont_init(&ctx, p, k) != 0) return 0;
+    // p - 1 = d * 2^s
+    bn_t d(p, p + k), pm1(p, p + k), a(k), x(k), minus1(k);
+    bn_sub_word(pm1.data(), p, k, 1);
+    d = pm1;
+    size_t s = 0;
+    while ((d[0] & 1) == 0) {
+        for (size_t i = 0; i < k; i++) d[i] = (d[i] >> 1) | (i + 1 < k ? d[i + 1] << 63 : 0);
+        s++;
+    }
+    bn_sub(minus1.data(), p, ctx.one.data(), k);   // -1 的 Montgomery 表示 m - R
+    for (int round = 0; round < rounds; round++) {
+        do {
+            if (bn_random_below(a.data(), p, k) != 0) return 0;
+        } while ((a[0] == 1 && bn_bits(a.data(), k) == 1) || bn_cmp(a.data(), pm1.data(), k) == 0);
+        bn_to_mont(&ctx, x.data(), a.data());
+        bn_mont_exp(&ctx, x.data(), x.data(), d.data(), k);
+        if (bn_cmp(x.data(), ctx.one.data(), k) == 0 || bn_cmp(x.data(), minus1.data(), k) == 0) continue;
+        size_t i;
+        for (i = 1; i < s; i++) {
+            bn_mont_mul(&ctx, x.data(), x.data(), x.data());
+            if (bn_cmp(x.data(), minus1.data(), k) == 0) break;
+        }
+        if (i == s) return 0;
+    }
+    return 1;
+}
+
+// 随机起点向上逐个奇数试：小素数余数增量更新，全部非 0 时再做 Miller-Rabin
+int bn_gen_prime(uint64_t *p, size_t k, size_t bits) {
+    const std::vector<uint32_t> &primes = bn_small_primes();
+    std::vector<uint32_t> rem(primes.size());
+    bn_t q(k), cand(k);
+    int rounds = bits >= 1024 ? 8 : 16;
+    for (;;) {
+        if (bn_random_bits(p, k, bits) != 0) return -1;
+        p[(bits - 1) / 64] |= (uint64_t)1 << ((bits - 1) % 64);
+        p[(bits - 2) / 64] |= (uint64_t)1 << ((bits - 2) % 64);
+        p[0] |= 1;
+        for (size_t i = 0; i < primes.size(); i++) rem[i] = (uint32_t)bn_div_word(q.data(), p, k, primes[i]);
+        for (uint64_t delta = 0; delta < ((uint64_t)1 << 20); delta += 2) {
+            size_t i = 0;
+            while (i < primes.size() && (rem[i] + delta) % primes[i] != 0) i++;
+            if (i < primes.size()) continue;
+            cand.assign(p, p + k);
+            uint64_t carry = delta;
+            for (size_t j = 0; j < k && carry; j++) {
+                cand[j] += carry;
+                carry = cand[j] < carry;
+            }
+            if (bn_bits(cand.data(), k) != bits) break;
+            if (bn_is_probable_prime(cand.data(), k, rounds)) {
+                memcpy(p, cand.data(), k * sizeof(uint64_t));
+                return 0;
+            }
+        }
+    }
+}
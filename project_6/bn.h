@@ -0,0 +1,103 @@
+#ifndef BN_H
+#define BN_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+/*
+ * 多精度整数与 Montgomery 模运算（Paillier 用，内部头文件）
+ * 数为小端 64 位字数组，字数由调用方给定；模数必须是奇数，最多 BN_MAX_WORDS 个字。
+ * 模乘为 CIOS，两层循环合并成一遍；最后的条件减法与查表都不含依赖数据的分支，
+ * 指数或底数是私钥、随机数时也能用（模数本身的初始化不要求常数时间）。
+ */
+
+#define BN_MAX_WORDS 128   // 8192 位，n^2 最大到 4096 位的 n
+
+typedef unsigned __int128 bn_u128;
+typedef std::vector<uint64_t> bn_t;
+
+/* ===== 普通整数运算（k 个字） ===== */
+
+size_t bn_bits(const uint64_t *a, size_t k);
+int bn_is_zero(const uint64_t *a, size_t k);
+// 返回 -1 / 0 / 1（变时间，只用于公开数据）
+int bn_cmp(const uint64_t *a, const uint64_t *b, size_t k);
+// 返回进位 / 借位；r 可以与 a、b 相同
+uint64_t bn_add(uint64_t *r, const uint64_t *a, const uint64_t *b, size_t k);
+uint64_t bn_sub(uint64_t *r, const uint64_t *a, const uint64_t *b, size_t k);
+uint64_t bn_sub_word(uint64_t *r, const uint64_t *a, size_t k, uint64_t w);
+// r[0 .. ka + kb) = a * b，r 不能与 a、b 重叠
+void bn_mul(uint64_t *r, const uint64_t *a, size_t ka, const uint64_t *b, size_t kb);
+// q = a / d，返回余数；q 可以与 a 相同
+uint64_t bn_div_word(uint64_t *q, const uint64_t *a, size_t k, uint64_t d);
+// 已知 n | a 时 q = a / n（Jebelean 精确除法，不需要长除法）：a 为 ka 个字，q 为 ka - kn + 1 个字。
+// ninv = n^-1 mod 2^64
+void bn_divexact(uint64_t *q, const uint64_t *a, size_t ka, const uint64_t *n, size_t kn, uint64_t ninv);
+
+// 大端字节串与字数组互转；输入比 k 个字长时只取低位，输出不足 len 字节时高位补 0
+void bn_from_bytes(uint64_t *r, size_t k, const uint8_t *in, size_t len);
+void bn_to_bytes(uint8_t *out, size_t len, const uint64_t *a, size_t k);
+std::string bn_to_dec(const uint64_t *a, size_t k);
+
+// getrandom 取随机数；失败返回 -1
+int bn_random_bytes(uint8_t *buf, size_t len);
+// r 为 [0, 2^bits) 内的均匀随机数
+int bn_random_bits(uint64_t *r, size_t k, size_t bits);
+// r 为 [1, m) 内的均匀随机数（拒绝采样）
+int bn_random_below(uint64_t *r, const uint64_t *m, size_t k);
+
+/* ===== Montgomery 模运算 ===== */
+
+struct bn_mont {
+    size_t k;        // 模数的字数
+    uint64_t m0;     // -m^-1 mod 2^64
+    bn_t m;
+    bn_t one;        // R mod m（R = 2^(64k)），Montgomery 表示的 1
+    bn_t rr;         // R^2 mod m
+};
+
+// m 必须是奇数且最高字非 0；k 超过 BN_MAX_WORDS 时返回 -1
+int bn_mont_init(bn_mont *ctx, const uint64_t *m, size_t k);
+// r = a * b * R^-1 mod m；a、b < m，r 可以与 a、b 相同
+void bn_mont_mul(const bn_mont *ctx, uint64_t *r, const uint64_t *a, const uint64_t *b);
+// 2k 个字的 t 约简为 t * R^-1 mod m，要求 t < m * R；t 会被改写
+void bn_mont_redc(const bn_mont *ctx, uint64_t *r, uint64_t *t);
+void bn_to_mont(const bn_mont *ctx, uint64_t *r, const uint64_t *a);
+void bn_from_mont(const bn_mont *ctx, uint64_t *r, const uint64_t *a);
+// r = a mod m，a 为 ka <= 2k 个字且 a < m * R
+void bn_mod(const bn_mont *ctx, uint64_t *r, const uint64_t *a, size_t ka);
+// r = a * b mod m（普通表示）
+void bn_mod_mul(const bn_mont *ctx, uint64_t *r, const uint64_t *a, const uint64_t *b);
+// r = a^e（Montgomery 表示进出）：5 位固定窗口，每个窗口扫描整张表取值，运算序列只与 e 的位数有关
+void bn_mont_exp(const bn_mont *ctx, uint64_t *r, const uint64_t *a, const uint64_t *e, size_t ke);
+// r = a^e mod m（普通表示）
+void bn_mod_exp(const bn_mont *ctx, uint64_t *r, const uint64_t *a, const uint64_t *e, size_t ke);
+
+/*
+ * 定点窗口表：底数固定、指数每次不同时，预先算好 T[i][d] = g^(d * 2^(w i))，
+ * 之后 g^e 只需要每个 w 位窗口一次乘法，不用做平方。
+ * 2048 位指数、w = 5 时为 410 次乘法（普通窗口法约 2048 次平方 + 410 次乘法），
+ * 表大小 windows * (2^w - 1) * k * 8 字节。表只读，可在线程间共享。
+ */
+struct bn_fixed_base {
+    const bn_mont *ctx;
+    unsigned w;
+    size_t windows;
+    bn_t table;
+};
+
+// g 为 Montgomery 表示，指数不超过 max_bits 位
+void bn_fixed_base_init(bn_fixed_base *fb, const bn_mont *ctx, const uint64_t *g, size_t max_bits, unsigned w);
+// r = g^e（Montgomery 表示）；e 的位数不能超过 max_bits。每个窗口都乘一次、整行扫描取值，常数时间
+void bn_fixed_base_exp(const bn_fixed_base *fb, uint64_t *r, const uint64_t *e, size_t ke);
+
+/* ===== 素数 ===== */
+
+// Miller-Rabin，rounds 个随机底数；p 为奇数
+int bn_is_probable_prime(const uint64_t *p, size_t k, int rounds);
+// 生成 bits 位素数（最高两位为 1，两个这样的素数相乘正好 2 * bits 位）；随机源失败返回 -1
+int bn_gen_prime(uint64_t *p, size_t k, size_t bits);
+
+#endif // BN_H
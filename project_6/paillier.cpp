@@ -0,0 +1,402 @@
+#include <string.h>
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "paillier.h"
+#include "../common/thread_pool.h"
+
+static void pai_wipe(void *p, size_t len) {
+    volatile uint8_t *v = (volatile uint8_t *)p;
+    while (len--) *v++ = 0;
+}
+
+static inline void pai_put_len(uint8_t *out, size_t len) {
+    out[0] = (uint8_t)(len >> 24);
+    out[1] = (uint8_t)(len >> 16);
+    out[2] = (uint8_t)(len >> 8);
+    out[3] = (uint8_t)len;
+}
+
+// 由 n 建立 n^2 的模运算上下文；h 另行设置
+static int pai_pub_setup(paillier_pub *pub, size_t bits, const uint64_t *n) {
+    if (bits < 512 || bits > 4096 || bits % 128 != 0) return -1;
+    pub->bits = bits;
+    pub->kn = bits / 64;
+    pub->kn2 = bits / 32;
+    if (bn_bits(n, pub->kn) != bits || (n[0] & 1) == 0) return -1;
+    pub->n.assign(n, n + pub->kn);
+    bn_t n2(pub->kn2);
+    bn_mul(n2.data(), n, pub->kn, n, pub->kn);
+    return bn_mont_init(&pub->mn2, n2.data(), pub->kn2);
+}
+
+static void pai_pub_set_h(paillier_pub *pub, const uint64_t *h_mont) {
+    pub->h.assign(h_mont, h_mont + pub->kn2);
+    bn_fixed_base_init(&pub->hfb, &pub->mn2, pub->h.data(), pub->bits, PAILLIER_WINDOW);
+}
+
+/* ===== 密钥 ===== */
+
+// a^-1 mod p（p 为素数，费马小定理）
+static void pai_inv_prime(const bn_mont *mp, uint64_t *r, const uint64_t *a) {
+    uint64_t e[BN_MAX_WORDS];
+    bn_sub_word(e, mp->m.data(), mp->k, 2);
+    bn_mod_exp(mp, r, a, e, mp->k);
+}
+
+// 解密的一半：L_p(c^(p-1) mod p^2) * hp mod p；c 为 kc 个字，结果为 kp 个字
+static void pai_decrypt_half(const bn_mont *m2, const bn_mont *m1, const uint64_t *e, const uint64_t *h,
+                             const uint64_t *c, size_t kc, uint64_t *out) {
+    const size_t kp = m1->k;
+    uint64_t x[BN_MAX_WORDS], l[BN_MAX_WORDS];
+    bn_mod(m2, x, c, kc);
+    bn_mod_exp(m2, x, x, e, kp);
+    bn_sub_word(x, x, 2 * kp, 1);
+    bn_divexact(l, x, 2 * kp, m1->m.data(), kp, 0 - m1->m0);   // 商为 kp + 1 个字，最高字为 0
+    if (h != NULL) bn_mod_mul(m1, out, l, h);
+    else memcpy(out, l, kp * sizeof(uint64_t));
+    pai_wipe(x, 2 * kp * 8);
+    pai_wipe(l, kp * 8);
+}
+
+// CRT 合并：r ≡ xp (mod p)，r ≡ xq (mod q)，r = xq + q * ((xp - xq) * q^-1 mod p)
+static void pai_crt(const paillier_priv *key, const uint64_t *xp, const uint64_t *xq, uint64_t *r) {
+    const size_t kp = key->kp;
+    uint64_t t[BN_MAX_WORDS], d[BN_MAX_WORDS], pm[BN_MAX_WORDS];
+    bn_mod(&key->mp, t, xq, kp);
+    uint64_t mask = 0 - bn_sub(d, xp, t, kp);
+    for (size_t i = 0; i < kp; i++) pm[i] = key->p[i] & mask;
+    bn_add(d, d, pm, kp);
+    bn_mod_mul(&key->mp, t, d, key->qinv.data());
+    bn_mul(r, key->q.data(), kp, t, kp);
+    memset(d, 0, 2 * kp * sizeof(uint64_t));
+    memcpy(d, xq, kp * sizeof(uint64_t));
+    bn_add(r, r, d, 2 * kp);
+    pai_wipe(t, kp * 8);
+    pai_wipe(d, 2 * kp * 8);
+}
+
+// 模 p 一侧的预计算：p^2 的上下文与 hp = L_p((n + 1)^(p-1) mod p^2)^-1 mod p
+static void pai_prime_setup(bn_mont *m1, bn_mont *m2, bn_t *pm1, bn_t *h, const uint64_t *p,
+                            const uint64_t *n1, size_t kp) {
+    bn_t p2(2 * kp), t(kp);
+    bn_mont_init(m1, p, kp);
+    bn_mul(p2.data(), p, kp, p, kp);
+    bn_mont_init(m2, p2.data(), 2 * kp);
+    pm1->assign(kp, 0);
+    bn_sub_word(pm1->data(), p, kp, 1);
+    pai_decrypt_half(m2, m1, pm1->data(), NULL, n1, 2 * kp, t.data());
+    h->assign(kp, 0);
+    pai_inv_prime(m1, h->data(), t.data());
+}
+
+int paillier_keygen(paillier_priv *key, size_t bits) {
+    if (bits < 512 || bits > 4096 || bits % 128 != 0) return -1;
+    const size_t kp = bits / 128, kn = bits / 64;
+    bn_t p(kp), q(kp), n(kn), n1(kn), t(kp);
+    if (bn_gen_prime(p.data(), kp, bits / 2) != 0) return -1;
+    do {
+        if (bn_gen_prime(q.data(), kp, bits / 2) != 0) return -1;
+    } while (bn_cmp(p.data(), q.data(), kp) == 0);
+    bn_mul(n.data(), p.data(), kp, q.data(), kp);
+    if (pai_pub_setup(&key->pub, bits, n.data()) != 0) return -1;
+
+    key->kp = kp;
+    key->p = p;
+    key->q = q;
+    n1 = n;
+    n1[0] += 1;   // n 为奇数，加 1 不进位
+    pai_prime_setup(&key->mp, &key->mp2, &key->pm1, &key->hp, p.data(), n1.data(), kp);
+    pai_prime_setup(&key->mq, &key->mq2, &key->qm1, &key->hq, q.data(), n1.data(), kp);
+    bn_mod(&key->mp, t.data(), q.data(), kp);
+    key->qinv.assign(kp, 0);
+    pai_inv_prime(&key->mp, key->qinv.data(), t.data());
+
+    // h = x^n mod n^2，x 取 [1, n) 内的随机数
+    paillier_pub *pub = &key->pub;
+    bn_t x(pub->kn2, 0), h(pub->kn2);
+    if (bn_random_below(x.data(), n.data(), kn) != 0) return -1;
+    bn_to_mont(&pub->mn2, h.data(), x.data());
+    bn_mont_exp(&pub->mn2, h.data(), h.data(), n.data(), kn);
+    pai_pub_set_h(pub, h.data());
+
+    pai_wipe(p.data(), kp * 8);
+    pai_wipe(q.data(), kp * 8);
+    pai_wipe(x.data(), kn * 8);
+    return 0;
+}
+
+int paillier_pub_init(paillier_pub *pub, size_t bits, const uint8_t *n_bytes, const uint8_t *h_bytes) {
+    if (bits < 512 || bits > 4096 || bits % 128 != 0) return -1;
+    bn_t n(bits / 64);
+    bn_from_bytes(n.data(), n.size(), n_bytes, bits / 8);
+    if (pai_pub_setup(pub, bits, n.data()) != 0) return -1;
+    bn_t h(pub->kn2);
+    if (paillier_ct_load(pub, h.data(), h_bytes) != 0) return -1;
+    if (bn_is_zero(h.data(), pub->kn2)) return -1;
+    pai_pub_set_h(pub, h.data());
+    return 0;
+}
+
+void paillier_pub_export(const paillier_pub *pub, uint8_t *n, uint8_t *h) {
+    bn_to_bytes(n, paillier_n_bytes(pub), pub->n.data(), pub->kn);
+    paillier_ct_store(pub, h, pub->h.data());
+}
+
+/* ===== 加密与同态运算 ===== */
+
+// h^s 的 Montgomery 表示
+static int pai_random_factor(const paillier_pub *pub, uint64_t *r) {
+    uint64_t s[BN_MAX_WORDS];
+    if (bn_random_bits(s, pub->kn, pub->bits) != 0) return -1;
+    bn_fixed_base_exp(&pub->hfb, r, s, pub->kn);
+    pai_wipe(s, pub->kn * 8);
+    return 0;
+}
+
+// c = (1 + m n) * r，r 为 Montgomery 表示的 h^s；输出线路格式
+static void pai_encrypt_with(const paillier_pub *pub, uint64_t m, uint64_t *r, uint8_t *out) {
+    const size_t kn = pub->kn, kn2 = pub->kn2;
+    uint64_t g[BN_MAX_WORDS];
+    // g^m = 1 + m n（m < 2^64 < n，不会超过 n^2）
+    memset(g, 0, kn2 * sizeof(uint64_t));
+    uint64_t c = 1;
+    for (size_t i = 0; i < kn; i++) {
+        bn_u128 acc = (bn_u128)pub->n[i] * m + c;
+        g[i] = (uint64_t)acc;
+        c = (uint64_t)(acc >> 64);
+    }
+    g[kn] = c;
+    // 普通表示乘 Montgomery 表示，结果直接是普通表示
+    bn_mont_mul(&pub->mn2, r, g, r);
+    pai_put_len(out, paillier_ct_bytes(pub));
+    bn_to_bytes(out + 4, paillier_ct_bytes(pub), r, kn2);
+    pai_wipe(r, kn2 * 8);
+}
+
+int paillier_encrypt(const paillier_pub *pub, uint64_t m, uint8_t *out) {
+    uint64_t r[BN_MAX_WORDS];
+    if (pai_random_factor(pub, r) != 0) return -1;
+    pai_encrypt_with(pub, m, r, out);
+    return 0;
+}
+
+void paillier_ct_write(const paillier_pub *pub, uint8_t *out, const uint64_t *c) {
+    pai_put_len(out, paillier_ct_bytes(pub));
+    paillier_ct_store(pub, out + 4, c);
+}
+
+int paillier_ct_read(const paillier_pub *pub, uint64_t *c, const uint8_t *in, size_t len) {
+    if (len < paillier_ct_wire_bytes(pub)) return -1;
+    uint32_t n = ((uint32_t)in[0] << 24) | ((uint32_t)in[1] << 16) | ((uint32_t)in[2] << 8) | in[3];
+    if (n != paillier_ct_bytes(pub)) return -1;
+    return paillier_ct_load(pub, c, in + 4);
+}
+
+int paillier_ct_load(const paillier_pub *pub, uint64_t *c, const uint8_t *in) {
+    uint64_t t[BN_MAX_WORDS];
+    bn_from_bytes(t, pub->kn2, in, paillier_ct_bytes(pub));
+    if (bn_cmp(t, pub->mn2.m.data(), pub->kn2) >= 0) return -1;
+    bn_to_mont(&pub->mn2, c, t);
+    return 0;
+}
+
+void paillier_ct_store(const paillier_pub *pub, uint8_t *out, const uint64_t *c) {
+    uint64_t t[BN_MAX_WORDS];
+    bn_from_mont(&pub->mn2, t, c);
+    bn_to_bytes(out, paillier_ct_bytes(pub), t, pub->kn2);
+}
+
+void paillier_ct_one(const paillier_pub *pub, uint64_t *c) {
+    memcpy(c, pub->mn2.one.data(), pub->kn2 * sizeof(uint64_t));
+}
+
+void paillier_ct_add(const paillier_pub *pub, uint64_t *acc, const uint64_t *c) {
+    bn_mont_mul(&pub->mn2, acc, acc, c);
+}
+
+int paillier_rerandomize(const paillier_pub *pub, uint64_t *c) {
+    uint64_t r[BN_MAX_WORDS];
+    if (pai_random_factor(pub, r) != 0) return -1;
+    bn_mont_mul(&pub->mn2, c, c, r);
+    return 0;
+}
+
+/* ===== 批量求和 ===== */
+
+int paillier_ct_sum(const paillier_pub *pub, const uint8_t *const *cts, size_t n, thread_pool &pool, uint64_t *acc) {
+    const size_t kn2 = pub->kn2;
+    if (n == 0) {
+        paillier_ct_one(pub, acc);
+        return 0;
+    }
+    bn_t buf(n * kn2);
+    std::atomic<int> bad(0);
+    pool.parallel_for(n, [&](size_t i) {
+        if (paillier_ct_read(pub, &buf[i * kn2], cts[i], paillier_ct_wire_bytes(pub)) != 0) {
+            bad.store(1, std::memory_order_relaxed);
+        }
+    });
+    if (bad.load()) return -1;
+    // 同一层内各对互不重叠，可以原地乘
+    for (size_t s = 1; s < n; s <<= 1) {
+        pool.parallel_for((n + 2 * s - 1) / (2 * s), [&](size_t j) {
+            size_t i = j * 2 * s;
+            if (i + s < n) bn_mont_mul(&pub->mn2, &buf[i * kn2], &buf[i * kn2], &buf[(i + s) * kn2]);
+        });
+    }
+    memcpy(acc, buf.data(), kn2 * sizeof(uint64_t));
+    return 0;
+}
+
+/* ===== 解密 ===== */
+
+int paillier_decrypt(const paillier_priv *key, const uint8_t *in, size_t len, uint64_t *m) {
+    const paillier_pub *pub = &key->pub;
+    uint64_t c[BN_MAX_WORDS], xp[BN_MAX_WORDS], xq[BN_MAX_WORDS];
+    if (len < paillier_ct_wire_bytes(pub)) return -1;
+    uint32_t n = ((uint32_t)in[0] << 24) | ((uint32_t)in[1] << 16) | ((uint32_t)in[2] << 8) | in[3];
+    if (n != paillier_ct_bytes(pub)) return -1;
+    bn_from_bytes(c, pub->kn2, in + 4, paillier_ct_bytes(pub));
+    if (bn_cmp(c, pub->mn2.m.data(), pub->kn2) >= 0) return -1;
+    pai_decrypt_half(&key->mp2, &key->mp, key->pm1.data(), key->hp.data(), c, pub->kn2, xp);
+    pai_decrypt_half(&key->mq2, &key->mq, key->qm1.data(), key->hq.data(), c, pub->kn2, xq);
+    pai_crt(key, xp, xq, m);
+    pai_wipe(xp, key->kp * 8);
+    pai_wipe(xq, key->kp * 8);
+    return 0;
+}
+
+/* ===== 随机化因子池 ===== */
+
+// 有界 MPMC 环形队列：槽 i 的序号等于 pos 时可写入，等于 pos + 1 时可读出；读出后序号加上容量留给下一圈
+struct paillier_pool {
+    const paillier_pub *pub;
+    size_t mask, kn2;
+    std::unique_ptr<std::atomic<size_t>[]> seq;
+    bn_t data;
+    // 入队、出队位置各占一条缓存行
+    char pad0[64];
+    std::atomic<size_t> tail;
+    char pad1[64 - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> head;
+    char pad2[64 - sizeof(std::atomic<size_t>)];
+    std::atomic<bool> stop;
+    std::atomic<uint64_t> hits, misses;
+    std::vector<std::thread> producers;
+};
+
+static bool pai_pool_push(paillier_pool *pool, const uint64_t *r) {
+    size_t pos = pool->tail.load(std::memory_order_relaxed);
+    for (;;) {
+        std::atomic<size_t> &s = pool->seq[pos & pool->mask];
+        size_t cur = s.load(std::memory_order_acquire);
+        intptr_t dif = (intptr_t)cur - (intptr_t)pos;
+        if (dif == 0) {
+            if (pool->tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                memcpy(&pool->data[(pos & pool->mask) * pool->kn2], r, pool->kn2 * sizeof(uint64_t));
+                s.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (dif < 0) {
+            return false;   // 满了
+        } else {
+            pos = pool->tail.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+static bool pai_pool_pop(paillier_pool *pool, uint64_t *r) {
+    size_t pos = pool->head.load(std::memory_order_relaxed);
+    for (;;) {
+        std::atomic<size_t> &s = pool->seq[pos & pool->mask];
+        size_t cur = s.load(std::memory_order_acquire);
+        intptr_t dif = (intptr_t)cur - (intptr_t)(pos + 1);
+        if (dif == 0) {
+            if (pool->head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                uint64_t *slot = &pool->data[(pos & pool->mask) * pool->kn2];
+                memcpy(r, slot, pool->kn2 * sizeof(uint64_t));
+                pai_wipe(slot, pool->kn2 * 8);
+                s.store(pos + pool->mask + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (dif < 0) {
+            return false;   // 空的
+        } else {
+            pos = pool->head.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+static void pai_pool_produce(paillier_pool *pool) {
+    uint64_t r[BN_MAX_WORDS];
+    bool have = false;
+    while (!pool->stop.load(std::memory_order_acquire)) {
+        if (!have) {
+            if (pai_random_factor(pool->pub, r) != 0) break;
+            have = true;
+        }
+        if (pai_pool_push(pool, r)) have = false;
+        else std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    pai_wipe(r, sizeof(r));
+}
+
+paillier_pool *paillier_pool_start(const paillier_pub *pub, size_t capacity, unsigned threads) {
+    paillier_pool *pool = new paillier_pool;
+    size_t cap = 2;
+    while (cap < capacity) cap <<= 1;
+    pool->pub = pub;
+    pool->mask = cap - 1;
+    pool->kn2 = pub->kn2;
+    pool->seq.reset(new std::atomic<size_t>[cap]);
+    for (size_t i = 0; i < cap; i++) pool->seq[i].store(i, std::memory_order_relaxed);
+    pool->data.assign(cap * pub->kn2, 0);
+    pool->tail.store(0);
+    pool->head.store(0);
+    pool->stop.store(false);
+    pool->hits.store(0);
+    pool->misses.store(0);
+    if (threads == 0) threads = std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+    for (unsigned i = 0; i < threads; i++) pool->producers.emplace_back(pai_pool_produce, pool);
+    return pool;
+}
+
+void paillier_pool_stop(paillier_pool *pool) {
+    if (!pool) return;
+    pool->stop.store(true, std::memory_order_release);
+    for (size_t i = 0; i < pool->producers.size(); i++) pool->producers[i].join();
+    pai_wipe(pool->data.data(), pool->data.size() * 8);
+    delete pool;
+}
+
+int paillier_pool_take(paillier_pool *pool, uint64_t *r) {
+    if (pai_pool_pop(pool, r)) {
+        pool->hits.fetch_add(1, std::memory_order_relaxed);
+        return 0;
+    }
+    pool->misses.fetch_add(1, std::memory_order_relaxed);
+    return pai_random_factor(pool->pub, r);
+}
+
+size_t paillier_pool_ready(const paillier_pool *pool) {
+    size_t tail = pool->tail.load(std::memory_order_relaxed);
+    size_t head = pool->head.load(std::memory_order_relaxed);
+    return tail > head ? tail - head : 0;
+}
+
+void paillier_pool_stats(const paillier_pool *pool, uint64_t *hits, uint64_t *misses) {
+    *hits = pool->hits.load(std::memory_order_relaxed);
+    *misses = pool->misses.load(std::memory_order_relaxed);
+}
+
+int paillier_encrypt_pooled(paillier_pool *pool, uint64_t m, uint8_t *out) {
+    uint64_t r[BN_MAX_WORDS];
+    if (paillier_pool_take(pool, r) != 0) return -1;
+    pai_encrypt_with(pool->pub, m, r, out);
+    return 0;
+}
@@ -0,0 +1,100 @@
+#ifndef PAILLIER_H
+#define PAILLIER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "bn.h"
+
+class thread_pool;
+
+/*
+ * Paillier 加法同态加密（g = n + 1），PSI-Sum 里 P2 加密自己的数值、P1 把交集对应的密文相乘。
+ * Enc(m) = (1 + m n) * h^s mod n^2：h = x^n mod n^2 在生成密钥时取定并随公钥发出，
+ * s 为 |n| 位随机数。h^s 用定点窗口表计算，只有乘法没有平方，比每次现算 r^n 快数倍；
+ * 随机化因子还可以由后台线程预先算好放进无锁队列（paillier_pool），加密时只剩一次模乘。
+ * 解密走 CRT：分别在 mod p^2、mod q^2 下做半长的模幂，再合并。
+ * 同态运算在 mod n^2 的 Montgomery 表示下进行。
+ * 结构体内部有指向自身的指针（定点表引用 mn2），初始化后不要按值复制；只读使用可在线程间共享。
+ */
+
+#define PAILLIER_WINDOW 5
+
+struct paillier_pub {
+    size_t bits;         // n 的位数，128 的倍数
+    size_t kn, kn2;      // n 与 n^2 的字数
+    bn_t n;
+    bn_mont mn2;         // mod n^2
+    bn_t h;              // 随机化底数，Montgomery 表示
+    bn_fixed_base hfb;   // h 的定点窗口表
+};
+
+struct paillier_priv {
+    paillier_pub pub;
+    size_t kp;           // p、q 的字数
+    bn_t p, q;
+    bn_t pm1, qm1;       // 解密指数 p - 1、q - 1
+    bn_mont mp, mq;      // mod p、mod q
+    bn_mont mp2, mq2;    // mod p^2、mod q^2
+    bn_t hp, hq;         // L_p((n + 1)^(p-1) mod p^2)^-1 mod p，q 同理
+    bn_t qinv;           // q^-1 mod p
+};
+
+static inline size_t paillier_n_bytes(const paillier_pub *pub) { return pub->bits / 8; }
+static inline size_t paillier_ct_bytes(const paillier_pub *pub) { return pub->bits / 4; }
+
+// bits 为 512..4096 之间 128 的倍数；随机源失败或参数不合法返回 -1
+int paillier_keygen(paillier_priv *key, size_t bits);
+// n 为 bits / 8 字节，h 为 bits / 4 字节（大端）；n 的位数不对、h 不在 [1, n^2) 内时返回 -1
+int paillier_pub_init(paillier_pub *pub, size_t bits, const uint8_t *n, const uint8_t *h);
+void paillier_pub_export(const paillier_pub *pub, uint8_t *n, uint8_t *h);
+
+/*
+ * 密文线路格式：4 字节大端长度 || n^2 下的定长大端字节串。两方收发密文（PSI 的 PAIRS、SUM）都用这一种格式，
+ * 长度前缀让接收方在解析前就能发现密钥长度不一致。
+ */
+static inline size_t paillier_ct_wire_bytes(const paillier_pub *pub) { return 4 + paillier_ct_bytes(pub); }
+void paillier_ct_write(const paillier_pub *pub, uint8_t *out, const uint64_t *c);
+// in 有 len 字节可读；长度前缀不符或密文不小于 n^2 时返回 -1
+int paillier_ct_read(const paillier_pub *pub, uint64_t *c, const uint8_t *in, size_t len);
+
+// out 为 paillier_ct_wire_bytes 字节；当场计算 h^s
+int paillier_encrypt(const paillier_pub *pub, uint64_t m, uint8_t *out);
+
+// 不带长度前缀的定长字节串 <-> Montgomery 表示（kn2 个字），公钥里的 h 用这种格式
+int paillier_ct_load(const paillier_pub *pub, uint64_t *c, const uint8_t *in);
+void paillier_ct_store(const paillier_pub *pub, uint8_t *out, const uint64_t *c);
+// Montgomery 表示的平凡密文 Enc(0; r = 1)，作累乘初值
+void paillier_ct_one(const paillier_pub *pub, uint64_t *c);
+// acc = acc * c，对应明文相加
+void paillier_ct_add(const paillier_pub *pub, uint64_t *acc, const uint64_t *c);
+// 再乘一个新的 h^s，发出前隐藏密文是由哪些密文乘出来的
+int paillier_rerandomize(const paillier_pub *pub, uint64_t *c);
+
+/*
+ * 批量同态求和：acc = ∏ cts[i]（Montgomery 表示）。各密文（线路格式）先并行转入 Montgomery 表示，
+ * 再按树形逐层两两相乘：第 s 层把 i 与 i + 2^s 的结果乘到 i 上，每层在线程池上并行，共 log2(n) 层。
+ * n 为 0 时 acc 为平凡密文；有密文格式错误时返回 -1。
+ */
+int paillier_ct_sum(const paillier_pub *pub, const uint8_t *const *cts, size_t n, thread_pool &pool, uint64_t *acc);
+
+// m 为 kn 个字；密文（线路格式）错误返回 -1。c^(p-1) mod p^2 与 c^(q-1) mod q^2 两次半长模幂后 CRT 合并
+int paillier_decrypt(const paillier_priv *key, const uint8_t *in, size_t len, uint64_t *m);
+
+/*
+ * 随机化因子池：threads 个后台线程不停计算 h^s，写入容量 capacity 的无锁有界队列（多生产者多消费者，
+ * 每个槽带序号，入队出队各一次 CAS）；队列满时生产者短暂休眠。
+ * 取用时队列为空就当场计算，记为一次未命中。公钥须在池停止前保持有效。
+ */
+struct paillier_pool;
+
+paillier_pool *paillier_pool_start(const paillier_pub *pub, size_t capacity, unsigned threads);
+void paillier_pool_stop(paillier_pool *pool);
+// r 为 Montgomery 表示的 h^s；随机源失败返回 -1
+int paillier_pool_take(paillier_pool *pool, uint64_t *r);
+// 当前可直接取用的个数
+size_t paillier_pool_ready(const paillier_pool *pool);
+void paillier_pool_stats(const paillier_pool *pool, uint64_t *hits, uint64_t *misses);
+// 与 paillier_encrypt 相同，随机化因子从池中取，命中时只有一次模乘
+int paillier_encrypt_pooled(paillier_pool *pool, uint64_t m, uint8_t *out);
+
+#endif // PAILLIER_H
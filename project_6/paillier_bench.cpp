@@ -0,0 +1,136 @@
+// Paillier 基准：2048 与 3072 位模数下各操作的吞吐
+// 编译：g++ -O2 -I../project_1 -I../project_4 -I../project_5 paillier_bench.cpp paillier.cpp bn.cpp -o paillier_bench -lpthread
+// 用法：paillier_bench [每项秒数，默认 0.5] [位数 ...，默认 2048 3072]
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "paillier.h"
+#include "../common/thread_pool.h"
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void report(const char *name, long ops, double secs) {
+    double rate = ops / secs;
+    printf("%-30s %12.1f ops/s %12.2f us/op\n", name, rate, 1e6 / rate);
+}
+
+// 反复调用 fn 直到超过时间预算
+template <class F>
+static void bench(const char *name, double budget, F fn) {
+    long ops = 0;
+    double t0 = now_sec(), t1;
+    do {
+        fn(ops);
+        ops++;
+        t1 = now_sec();
+    } while (t1 - t0 < budget);
+    report(name, ops, t1 - t0);
+}
+
+static int run(size_t bits, double budget) {
+    std::unique_ptr<paillier_priv> key(new paillier_priv);
+    double t0 = now_sec();
+    if (paillier_keygen(key.get(), bits) != 0) {
+        fprintf(stderr, "keygen failed for %zu bits\n", bits);
+        return 1;
+    }
+    const paillier_pub *pub = &key->pub;
+    const size_t ctw = paillier_ct_wire_bytes(pub), kn2 = pub->kn2;
+    const unsigned hw = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
+    printf("\nPaillier %zu bits (ciphertext %zu B), keygen %.3f s, %u hardware threads\n",
+           bits, paillier_ct_bytes(pub), now_sec() - t0, hw);
+
+    const size_t nct = 1024;
+    std::vector<uint8_t> cts(nct * ctw), scratch(ctw);
+    std::vector<const uint8_t *> ptrs(nct);
+    uint64_t expect = 0;
+    for (size_t i = 0; i < nct; i++) {
+        paillier_encrypt(pub, i * 7, &cts[i * ctw]);
+        ptrs[i] = &cts[i * ctw];
+        expect += i * 7;
+    }
+
+    bench("encrypt (h^s fixed-base)", budget, [&](long i) {
+        paillier_encrypt(pub, (uint64_t)i, scratch.data());
+    });
+
+    // 对照：直接算 r^n mod n^2（5 位窗口，|n| 次平方）；不用 CRT 的解密 c^lambda mod n^2 开销相同
+    std::vector<uint64_t> r(kn2), x(kn2);
+    bn_random_below(x.data(), pub->n.data(), pub->kn);
+    bn_to_mont(&pub->mn2, x.data(), x.data());
+    bench("r^n mod n^2 (window, no CRT)", budget, [&](long) {
+        bn_mont_exp(&pub->mn2, r.data(), x.data(), pub->n.data(), pub->kn);
+    });
+
+    // 池：先测从空到满的填充速度，再只测取用 + 一次模乘的热路径（只取一半，生产者不会来不及补）
+    {
+        const size_t cap = 512;
+        paillier_pool *pool = paillier_pool_start(pub, cap, hw);
+        double f0 = now_sec();
+        while (paillier_pool_ready(pool) < cap) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        double fill = now_sec() - f0;
+        printf("%-30s %12.1f ops/s %12.2f us/op  (%u producers)\n", "pool fill (h^s)", cap / fill,
+               1e6 * fill / cap, hw);
+        const size_t n = cap / 2;
+        double e0 = now_sec();
+        for (size_t i = 0; i < n; i++) paillier_encrypt_pooled(pool, i, scratch.data());
+        double e1 = now_sec();
+        uint64_t hits, misses;
+        paillier_pool_stats(pool, &hits, &misses);
+        printf("%-30s %12.1f ops/s %12.2f us/op  (%llu hits, %llu misses)\n", "encrypt (pooled, hot path)",
+               n / (e1 - e0), 1e6 * (e1 - e0) / n, (unsigned long long)hits, (unsigned long long)misses);
+        paillier_pool_stop(pool);
+    }
+
+    std::vector<uint64_t> acc(kn2), c(kn2);
+    paillier_ct_read(pub, c.data(), &cts[0], ctw);
+    paillier_ct_one(pub, acc.data());
+    bench("homomorphic add (mont mul)", budget, [&](long) { paillier_ct_add(pub, acc.data(), c.data()); });
+
+    for (unsigned t : {1u, hw}) {
+        thread_pool pool(t);
+        long ops = 0;
+        double s0 = now_sec(), s1;
+        do {
+            paillier_ct_sum(pub, ptrs.data(), nct, pool, acc.data());
+            ops += nct;
+            s1 = now_sec();
+        } while (s1 - s0 < budget);
+        char name[48];
+        snprintf(name, sizeof(name), "ct_sum tree x%zu (%u T)", nct, t);
+        report(name, ops, s1 - s0);
+        if (t == hw) break;
+    }
+    std::vector<uint8_t> out(ctw);
+    paillier_ct_write(pub, out.data(), acc.data());
+    std::vector<uint64_t> m(pub->kn);
+    paillier_decrypt(key.get(), out.data(), ctw, m.data());
+    int sum_ok = bn_to_dec(m.data(), pub->kn) == std::to_string(expect);
+
+    bench("decrypt (CRT)", budget, [&](long) { paillier_decrypt(key.get(), out.data(), ctw, m.data()); });
+    printf("ct_sum + decrypt check: %s\n", sum_ok ? "OK" : "MISMATCH");
+    return sum_ok ? 0 : 1;
+}
+
+int main(int argc, char **argv) {
+    double budget = argc > 1 ? atof(argv[1]) : 0.5;
+    if (budget <= 0) budget = 0.5;
+    setvbuf(stdout, NULL, _IOLBF, 0);   // 3072 位的准备工作要几十秒，逐行输出
+    std::vector<size_t> sizes;
+    for (int i = 2; i < argc; i++) sizes.push_back((size_t)atoi(argv[i]));
+    if (sizes.empty()) sizes = {2048, 3072};
+    int rc = 0;
+    for (size_t bits : sizes) rc |= run(bits, budget);
+    return rc;
+}
@@ -0,0 +1,150 @@
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include "psi_net.h"
+
+// 两方交换的是大批量数据，收发缓冲区开到 4MB，关掉 Nagle 免得帧尾等待
+static void psi_tune_socket(int fd) {
+    int one = 1, buf = 4 << 20;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &buf, sizeof(buf));
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &buf, sizeof(buf));
+}
+
+static int psi_resolve(const char *host, uint16_t port, struct sockaddr_in *addr) {
+    memset(addr, 0, sizeof(*addr));
+    addr->sin_family = AF_INET;
+    addr->sin_port = htons(port);
+    if (host == NULL || *host == '\0') {
+        addr->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        return 0;
+    }
+    if (inet_pton(AF_INET, host, &addr->sin_addr) == 1) return 0;
+    struct addrinfo hints, *res;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host, NULL, &hints, &res) != 0) return -1;
+    addr->sin_addr = ((struct sockaddr_in *)res->ai_addr)->sin_addr;
+    freeaddrinfo(res);
+    return 0;
+}
+
+int psi_listen(const char *host, uint16_t *port) {
+    struct sockaddr_in addr;
+    if (psi_resolve(host, *port, &addr) != 0) return -1;
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    socklen_t len = sizeof(addr);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, 1) != 0 ||
+        getsockname(fd, (struct sockaddr *)&addr, &len) != 0) {
+        close(fd);
+        return -1;
+    }
+    *port = ntohs(addr.sin_port);
+    return fd;
+}
+
+int psi_accept(int listen_fd, psi_conn *conn) {
+    int fd;
+    do {
+        fd = accept(listen_fd, NULL, NULL);
+    } while (fd < 0 && errno == EINTR);
+    if (fd < 0) return -1;
+    psi_tune_socket(fd);
+    conn->fd = fd;
+    conn->bytes_sent = conn->bytes_recv = 0;
+    return 0;
+}
+
+int psi_connect(const char *host, uint16_t port, psi_conn *conn) {
+    struct sockaddr_in addr;
+    if (psi_resolve(host, port, &addr) != 0) return -1;
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    psi_tune_socket(fd);
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    conn->fd = fd;
+    conn->bytes_sent = conn->bytes_recv = 0;
+    return 0;
+}
+
+void psi_close(psi_conn *conn) {
+    if (conn->fd >= 0) close(conn->fd);
+    conn->fd = -1;
+}
+
+int psi_send_frame(psi_conn *conn, uint8_t type, const void *data, size_t len) {
+    if (len > PSI_FRAME_MAX) return -1;
+    uint8_t hdr[5];
+    uint32_t flen = (uint32_t)len + 1;
+    hdr[0] = (uint8_t)(flen >> 24);
+    hdr[1] = (uint8_t)(flen >> 16);
+    hdr[2] = (uint8_t)(flen >> 8);
+    hdr[3] = (uint8_t)flen;
+    hdr[4] = type;
+    struct iovec iov[2] = {{hdr, sizeof(hdr)}, {(void *)data, len}};
+    int cnt = len ? 2 : 1;
+    struct iovec *v = iov;
+    size_t left = sizeof(hdr) + len;
+    while (left > 0) {
+        ssize_t n = writev(conn->fd, v, cnt);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        left -= (size_t)n;
+        conn->bytes_sent += (uint64_t)n;
+        // 跳过已写完的部分
+        while (cnt > 0 && (size_t)n >= v->iov_len) {
+            n -= (ssize_t)v->iov_len;
+            v++;
+            cnt--;
+        }
+        if (cnt > 0) {
+            v->iov_base = (uint8_t *)v->iov_base + n;
+            v->iov_len -= (size_t)n;
+        }
+    }
+    return 0;
+}
+
+static int psi_read_full(psi_conn *conn, void *buf, size_t len) {
+    uint8_t *p = (uint8_t *)buf;
+    while (len > 0) {
+        ssize_t n = read(conn->fd, p, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        p += n;
+        len -= (size_t)n;
+        conn->bytes_recv += (uint64_t)n;
+    }
+    return 0;
+}
+
+int psi_recv_frame(psi_conn *conn, uint8_t *type, std::vector<uint8_t> &buf) {
+    uint8_t hdr[5];
+    if (psi_read_full(conn, hdr, sizeof(hdr)) != 0) return -1;
+    uint32_t flen = ((uint32_t)hdr[0] << 24) | ((uint32_t)hdr[1] << 16) | ((uint32_t)hdr[2] << 8) | hdr[3];
+    if (flen == 0 || flen - 1 > PSI_FRAME_MAX) return -1;
+    *type = hdr[4];
+    buf.resize(flen - 1);
+    return flen > 1 ? psi_read_full(conn, buf.data(), flen - 1) : 0;
+}
+
+int psi_expect_frame(psi_conn *conn, uint8_t type, std::vector<uint8_t> &buf) {
+    uint8_t got;
+    if (psi_recv_frame(conn, &got, buf) != 0) return -1;
+    return got == type ? 0 : -1;
+}
@@ -0,0 +1,44 @@
+#ifndef PSI_NET_H
+#define PSI_NET_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+/*
+ * 长度前缀的二进制帧：4 字节大端长度（类型字节 + 负载）|| 1 字节类型 || 负载。
+ * 帧头与负载用一次 writev 发出；单帧负载不超过 PSI_FRAME_MAX，收到更长的帧按协议错误处理。
+ * 所有函数出错返回 -1（对端关闭、读写失败或帧格式不对）。
+ */
+
+#define PSI_FRAME_MAX (64u << 20)
+
+struct psi_conn {
+    int fd;
+    uint64_t bytes_sent, bytes_recv;
+};
+
+// 监听 host:port（port 为 0 时由内核分配，实际端口写回 *port），返回监听套接字
+int psi_listen(const char *host, uint16_t *port);
+int psi_accept(int listen_fd, psi_conn *conn);
+int psi_connect(const char *host, uint16_t port, psi_conn *conn);
+void psi_close(psi_conn *conn);
+
+int psi_send_frame(psi_conn *conn, uint8_t type, const void *data, size_t len);
+// 读一帧，负载放进 buf（按需扩容）
+int psi_recv_frame(psi_conn *conn, uint8_t *type, std::vector<uint8_t> &buf);
+// 读一帧并要求类型为 type
+int psi_expect_frame(psi_conn *conn, uint8_t type, std::vector<uint8_t> &buf);
+
+// 定长整数按大端写入 / 读出
+static inline void psi_put_u64(uint8_t *p, uint64_t v) {
+    for (int i = 0; i < 8; i++) p[i] = (uint8_t)(v >> (56 - 8 * i));
+}
+
+static inline uint64_t psi_get_u64(const uint8_t *p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; i++) v = (v << 8) | p[i];
+    return v;
+}
+
+#endif // PSI_NET_H
@@ -0,0 +1,529 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include "psi_sum.h"
+#include "sm3_promax.h"
+#include "sm4_pro.h"
+#include "../common/thread_pool.h"
+
+enum {
+    PSI_MSG_HELLO = 1,
+    PSI_MSG_PARAMS,
+    PSI_MSG_POINTS,
+    PSI_MSG_TAGS,
+    PSI_MSG_PAIRS,
+    PSI_MSG_SUM,
+    PSI_MSG_DONE,    // 结束一串 POINTS / TAGS / PAIRS 帧
+};
+
+#define PSI_POINT_BYTES 33
+#define PSI_TAG_FRAME 65536   // 每帧标签数（16 字节一个）
+
+static const uint8_t PSI_H2C_DST[] = "GMCRYPTO-PSI-SUM-SM2-H2C";
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static inline void psi_store_digest(uint8_t out[32], const uint32_t h[8]) {
+    for (int i = 0; i < 8; i++) {
+        out[4 * i]     = (uint8_t)(h[i] >> 24);
+        out[4 * i + 1] = (uint8_t)(h[i] >> 16);
+        out[4 * i + 2] = (uint8_t)(h[i] >> 8);
+        out[4 * i + 3] = (uint8_t)h[i];
+    }
+}
+
+static void psi_wipe(void *p, size_t len) {
+    volatile uint8_t *v = (volatile uint8_t *)p;
+    while (len--) *v++ = 0;
+}
+
+// [1, n-1] 内的随机标量
+static int psi_random_scalar(uint64_t k[4]) {
+    uint8_t buf[32];
+    do {
+        if (bn_random_bytes(buf, sizeof(buf)) != 0) {
+            psi_wipe(buf, sizeof(buf));
+            return -1;
+        }
+        sm2_from_bytes(k, buf);
+    } while (sm2_is_zero(k) || !sm2_lt(k, SM2_N));
+    psi_wipe(buf, sizeof(buf));
+    return 0;
+}
+
+/* ===== 打乱顺序：SM4-CTR 密钥流作随机源 ===== */
+
+struct psi_rng {
+    sm4_key key;
+    uint8_t ctr[16];
+    uint64_t buf[512];
+    size_t pos;
+};
+
+static int psi_rng_init(psi_rng *r) {
+    uint8_t seed[32];
+    if (bn_random_bytes(seed, sizeof(seed)) != 0) return -1;
+    sm4_set_encrypt_key(&r->key, seed);
+    memcpy(r->ctr, seed + 16, 16);
+    r->pos = 512;
+    psi_wipe(seed, sizeof(seed));
+    return 0;
+}
+
+static uint64_t psi_rng_next(psi_rng *r) {
+    if (r->pos == 512) {
+        memset(r->buf, 0, sizeof(r->buf));
+        sm4_ctr_blocks(&r->key, r->ctr, (const uint8_t *)r->buf, (uint8_t *)r->buf, sizeof(r->buf) / 16);
+        // 计数器（128 位大端）前进 256 个分组
+        unsigned carry = sizeof(r->buf) / 16;
+        for (int i = 15; i >= 0 && carry; i--) {
+            carry += r->ctr[i];
+            r->ctr[i] = (uint8_t)carry;
+            carry >>= 8;
+        }
+        r->pos = 0;
+    }
+    return r->buf[r->pos++];
+}
+
+// Fisher-Yates；64 位随机数乘 (i + 1) 取高 64 位映射到 [0, i]，偏差不超过 n / 2^64
+template <class T>
+static void psi_shuffle(T *a, size_t n, psi_rng *r) {
+    for (size_t i = n; i-- > 1;) {
+        size_t j = (size_t)(((bn_u128)psi_rng_next(r) * (i + 1)) >> 64);
+        std::swap(a[i], a[j]);
+    }
+}
+
+/* ===== 行数据 ===== */
+
+void psi_rows_add(psi_rows *rows, const char *id, size_t len, uint64_t value) {
+    if (rows->off.empty()) rows->off.push_back(0);
+    rows->ids.insert(rows->ids.end(), id, id + len);
+    rows->off.push_back(rows->ids.size());
+    rows->values.push_back(value);
+}
+
+int psi_rows_load(psi_rows *rows, const char *path, int with_values) {
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+    char *line = NULL;
+    size_t cap = 0;
+    ssize_t len;
+    int rc = 0;
+    while ((len = getline(&line, &cap, f)) >= 0) {
+        while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) line[--len] = '\0';
+        if (len == 0) continue;
+        uint64_t value = 0;
+        if (with_values) {
+            char *comma = strrchr(line, ',');
+            char *end;
+            if (!comma || comma[1] == '\0') { rc = -1; break; }
+            value = strtoull(comma + 1, &end, 10);
+            if (*end != '\0') { rc = -1; break; }
+            len = comma - line;
+        }
+        psi_rows_add(rows, line, (size_t)len, value);
+    }
+    free(line);
+    fclose(f);
+    return rc;
+}
+
+/* ===== 群运算 ===== */
+
+// x^3 - 3x + b
+static void psi_curve_rhs(uint64_t r[4], const uint64_t x[4]) {
+    uint64_t t[4], x3[4];
+    fp_sqr(t, x);
+    fp_mul(t, t, x);
+    fp_add(x3, x, x);
+    fp_add(x3, x3, x);
+    fp_sub(t, t, x3);
+    fp_add(r, t, SM2_B);
+}
+
+// 每一轮把还没成功的标识一起交给多缓冲 SM3；每轮约一半成功，期望两轮多一点
+void psi_hash_to_curve(const uint8_t *const *ids, const size_t *lens, sm2_aff *out, size_t n) {
+    const size_t dst = sizeof(PSI_H2C_DST) - 1;
+    std::vector<size_t> start(n + 1);
+    start[0] = 0;
+    for (size_t i = 0; i < n; i++) start[i + 1] = start[i] + dst + 1 + lens[i];
+    std::vector<uint8_t> msgs(start[n]);
+    for (size_t i = 0; i < n; i++) {
+        memcpy(&msgs[start[i]], PSI_H2C_DST, dst);
+        if (lens[i]) memcpy(&msgs[start[i] + dst + 1], ids[i], lens[i]);
+    }
+
+    std::vector<size_t> pending(n), next;
+    for (size_t i = 0; i < n; i++) pending[i] = i;
+    std::vector<const uint8_t *> ptrs(n);
+    std::vector<size_t> mlens(n);
+    std::vector<uint32_t> dig(8 * n);
+    for (unsigned ctr = 0; !pending.empty(); ctr++) {
+        size_t m = pending.size();
+        for (size_t j = 0; j < m; j++) {
+            size_t i = pending[j];
+            msgs[start[i] + dst] = (uint8_t)ctr;
+            ptrs[j] = &msgs[start[i]];
+            mlens[j] = start[i + 1] - start[i];
+        }
+        sm3_hash_many(ptrs.data(), mlens.data(), (uint32_t (*)[8])dig.data(), m);
+        next.clear();
+        for (size_t j = 0; j < m; j++) {
+            size_t i = pending[j];
+            uint8_t xb[32];
+            uint64_t rhs[4];
+            psi_store_digest(xb, &dig[8 * j]);
+            sm2_from_bytes(out[i].x, xb);
+            if (sm2_lt(out[i].x, SM2_P)) {
+                psi_curve_rhs(rhs, out[i].x);
+                if (fp_sqrt(out[i].y, rhs)) {
+                    if (out[i].y[0] & 1) fp_neg(out[i].y, out[i].y);
+                    continue;
+                }
+            }
+            next.push_back(i);
+        }
+        pending.swap(next);
+    }
+}
+
+static void psi_point_encode(uint8_t out[PSI_POINT_BYTES], const sm2_aff *p) {
+    out[0] = (uint8_t)(2 | (p->y[0] & 1));
+    sm2_to_bytes(out + 1, p->x);
+}
+
+// 解压并校验：前缀不是 02/03、x 越界或不在曲线上时返回 -1
+static int psi_point_decode(sm2_aff *p, const uint8_t in[PSI_POINT_BYTES]) {
+    uint64_t rhs[4];
+    if ((in[0] & 0xfe) != 2) return -1;
+    sm2_from_bytes(p->x, in + 1);
+    if (!sm2_lt(p->x, SM2_P)) return -1;
+    psi_curve_rhs(rhs, p->x);
+    if (!fp_sqrt(p->y, rhs)) return -1;
+    if ((p->y[0] & 1) != (uint64_t)(in[0] & 1)) fp_neg(p->y, p->y);
+    return 0;
+}
+
+// out[i] = k * in[i]，一组结果一起转仿射；m 不超过 PSI_CHUNK
+// （编译器看不出这一点，局部数组先清零，免得报 -Wmaybe-uninitialized，这点开销比标量乘小得多）
+static void psi_mul_chunk(const uint64_t k[4], const sm2_aff *in, size_t m, sm2_aff *out) {
+    sm2_jac r[PSI_CHUNK] = {};
+    for (size_t i = 0; i < m; i++) ec_mul_ct(&r[i], &in[i], k);
+    ec_batch_to_affine(out, r, m);
+}
+
+// out[i] = k * H(rows[idx[i]])
+static void psi_hash_mul(const psi_rows *rows, const uint32_t *idx, size_t m, const uint64_t k[4], sm2_aff *out) {
+    const uint8_t *ptrs[PSI_CHUNK] = {};
+    size_t lens[PSI_CHUNK] = {};
+    sm2_aff h[PSI_CHUNK];
+    for (size_t i = 0; i < m; i++) {
+        ptrs[i] = (const uint8_t *)rows->ids.data() + rows->off[idx[i]];
+        lens[i] = rows->off[idx[i] + 1] - rows->off[idx[i]];
+    }
+    psi_hash_to_curve(ptrs, lens, h, m);
+    psi_mul_chunk(k, h, m, out);
+}
+
+/* ===== 标签集合：开放寻址，线性探测 ===== */
+
+// 标签是 k1 k2 H(v) 的 x 坐标高 128 位（x[3], x[2]），本身近似均匀，低字直接当散列值
+struct psi_tag {
+    uint64_t lo, hi;
+};
+
+struct psi_tag_set {
+    std::vector<psi_tag> slots;   // 全 0 为空槽
+    size_t mask;
+};
+
+// 全 0 的标签与空槽冲突，统一把最低位置 1（两边用同一规则，误判概率不变）
+static inline psi_tag psi_tag_norm(uint64_t lo, uint64_t hi) {
+    psi_tag t = {lo, hi};
+    if ((lo | hi) == 0) t.lo = 1;
+    return t;
+}
+
+static void psi_tags_init(psi_tag_set *s, size_t n) {
+    size_t cap = 16;
+    while (cap < 2 * n) cap <<= 1;
+    s->slots.assign(cap, psi_tag{0, 0});
+    s->mask = cap - 1;
+}
+
+static void psi_tags_insert(psi_tag_set *s, uint64_t lo, uint64_t hi) {
+    psi_tag t = psi_tag_norm(lo, hi);
+    for (size_t i = t.lo & s->mask;; i = (i + 1) & s->mask) {
+        psi_tag &slot = s->slots[i];
+        if ((slot.lo | slot.hi) == 0) {
+            slot = t;
+            return;
+        }
+        if (slot.lo == t.lo && slot.hi == t.hi) return;
+    }
+}
+
+static int psi_tags_find(const psi_tag_set *s, uint64_t lo, uint64_t hi) {
+    psi_tag t = psi_tag_norm(lo, hi);
+    for (size_t i = t.lo & s->mask;; i = (i + 1) & s->mask) {
+        const psi_tag &slot = s->slots[i];
+        if (slot.lo == t.lo && slot.hi == t.hi) return 1;
+        if ((slot.lo | slot.hi) == 0) return 0;
+    }
+}
+
+/* ===== P1 ===== */
+
+// 协议本体，中途出错直接返回；私钥 k1 由 psi_run_p1 生成并统一擦除
+static int psi_p1_steps(psi_conn *conn, const psi_rows *rows, unsigned threads, const uint64_t k1[4],
+                        psi_stats *st) {
+    double t0 = now_sec();
+    const size_t n = psi_rows_count(rows);
+    if (n >= ((uint64_t)1 << 32)) return -1;
+    thread_pool pool(threads);
+    psi_rng rng;
+    if (psi_rng_init(&rng) != 0) return -1;
+    std::vector<uint8_t> buf;
+    st->own = n;
+
+    // 1. 交换行数与 Paillier 公钥
+    uint8_t hello[8];
+    psi_put_u64(hello, n);
+    if (psi_send_frame(conn, PSI_MSG_HELLO, hello, sizeof(hello)) != 0) return -1;
+    if (psi_expect_frame(conn, PSI_MSG_PARAMS, buf) != 0 || buf.size() < 16) return -1;
+    const size_t peer = (size_t)psi_get_u64(&buf[0]);
+    const size_t bits = (size_t)psi_get_u64(&buf[8]);
+    if (bits < 512 || bits > 4096 || buf.size() != 16 + bits / 8 + bits / 4) return -1;
+    std::unique_ptr<paillier_pub> pub(new paillier_pub);
+    if (paillier_pub_init(pub.get(), bits, &buf[16], &buf[16 + bits / 8]) != 0) return -1;
+    st->peer = peer;
+
+    // 2. 按随机顺序发出 k1 H(v)
+    std::vector<uint32_t> perm(n);
+    for (size_t i = 0; i < n; i++) perm[i] = (uint32_t)i;
+    psi_shuffle(perm.data(), n, &rng);
+    std::vector<uint8_t> out;
+    for (size_t first = 0; first < n; first += PSI_BATCH) {
+        size_t m = std::min((size_t)PSI_BATCH, n - first);
+        out.resize(m * PSI_POINT_BYTES);
+        pool.parallel_for((m + PSI_CHUNK - 1) / PSI_CHUNK, [&](size_t c) {
+            size_t lo = c * PSI_CHUNK, cnt = std::min((size_t)PSI_CHUNK, m - lo);
+            sm2_aff pts[PSI_CHUNK];
+            psi_hash_mul(rows, &perm[first + lo], cnt, k1, pts);
+            for (size_t i = 0; i < cnt; i++) psi_point_encode(&out[(lo + i) * PSI_POINT_BYTES], &pts[i]);
+        });
+        if (psi_send_frame(conn, PSI_MSG_POINTS, out.data(), out.size()) != 0) return -1;
+    }
+    if (psi_send_frame(conn, PSI_MSG_DONE, NULL, 0) != 0) return -1;
+    double t1 = now_sec();
+    st->t_own = t1 - t0;
+
+    // 3. 收齐 k2 k1 H(v) 的标签
+    psi_tag_set tags;
+    psi_tags_init(&tags, n);
+    size_t ntags = 0;
+    for (;;) {
+        uint8_t type;
+        if (psi_recv_frame(conn, &type, buf) != 0) return -1;
+        if (type == PSI_MSG_DONE) break;
+        if (type != PSI_MSG_TAGS || buf.size() % 16 != 0) return -1;
+        ntags += buf.size() / 16;
+        if (ntags > n) return -1;   // 不会多于发出去的点，也保证表不会被填满
+        for (size_t i = 0; i < buf.size(); i += 16) psi_tags_insert(&tags, psi_get_u64(&buf[i]), psi_get_u64(&buf[i + 8]));
+    }
+
+    // 4. 逐批处理 (k2 H(w), Enc(t))：各线程只标记命中，命中的密文再用树形归约一起乘进累加器
+    const size_t ctw = paillier_ct_wire_bytes(pub.get()), kn2 = pub->kn2, rec = PSI_POINT_BYTES + ctw;
+    std::vector<uint64_t> acc(kn2), part(kn2);
+    std::vector<uint8_t> hit;
+    std::vector<const uint8_t *> sel;
+    paillier_ct_one(pub.get(), acc.data());
+    std::atomic<int> bad(0);
+    size_t npairs = 0;
+    for (;;) {
+        uint8_t type;
+        if (psi_recv_frame(conn, &type, buf) != 0) return -1;
+        if (type == PSI_MSG_DONE) break;
+        if (type != PSI_MSG_PAIRS || buf.size() % rec != 0) return -1;
+        size_t m = buf.size() / rec;
+        npairs += m;
+        if (npairs > peer) return -1;
+        hit.assign(m, 0);
+        pool.parallel_for((m + PSI_CHUNK - 1) / PSI_CHUNK, [&](size_t c) {
+            size_t lo = c * PSI_CHUNK, cnt = std::min((size_t)PSI_CHUNK, m - lo);
+            sm2_aff in[PSI_CHUNK], pts[PSI_CHUNK];
+            for (size_t i = 0; i < cnt; i++) {
+                if (psi_point_decode(&in[i], &buf[(lo + i) * rec]) != 0) {
+                    bad.store(1, std::memory_order_relaxed);
+                    return;
+                }
+            }
+            psi_mul_chunk(k1, in, cnt, pts);
+            for (size_t i = 0; i < cnt; i++) hit[lo + i] = (uint8_t)psi_tags_find(&tags, pts[i].x[3], pts[i].x[2]);
+        });
+        if (bad.load()) return -1;
+        sel.clear();
+        for (size_t i = 0; i < m; i++) {
+            if (hit[i]) sel.push_back(&buf[i * rec + PSI_POINT_BYTES]);
+        }
+        if (paillier_ct_sum(pub.get(), sel.data(), sel.size(), pool, part.data()) != 0) return -1;
+        paillier_ct_add(pub.get(), acc.data(), part.data());
+        st->intersection += sel.size();
+    }
+    double t2 = now_sec();
+    st->t_peer = t2 - t1;
+
+    // 5. 重新随机化后发回
+    if (paillier_rerandomize(pub.get(), acc.data()) != 0) return -1;
+    out.resize(ctw);
+    paillier_ct_write(pub.get(), out.data(), acc.data());
+    if (psi_send_frame(conn, PSI_MSG_SUM, out.data(), ctw) != 0) return -1;
+
+    double t3 = now_sec();
+    st->t_finish = t3 - t2;
+    st->t_total = t3 - t0;
+    st->bytes_sent = conn->bytes_sent;
+    st->bytes_recv = conn->bytes_recv;
+    return 0;
+}
+
+int psi_run_p1(psi_conn *conn, const psi_rows *rows, unsigned threads, psi_stats *st) {
+    uint64_t k1[4];
+    memset(st, 0, sizeof(*st));
+    int rc = psi_random_scalar(k1);
+    if (rc == 0) rc = psi_p1_steps(conn, rows, threads, k1, st);
+    psi_wipe(k1, sizeof(k1));
+    return rc;
+}
+
+/* ===== P2 ===== */
+
+// 协议本体，中途出错直接返回；私钥 k2 由 psi_run_p2 生成并统一擦除
+static int psi_p2_steps(psi_conn *conn, const psi_rows *rows, const paillier_priv *key, paillier_pool *rpool,
+                        unsigned threads, const uint64_t k2[4], std::string *sum, psi_stats *st) {
+    double t0 = now_sec();
+    const size_t n = psi_rows_count(rows);
+    if (n >= ((uint64_t)1 << 32)) return -1;
+    thread_pool pool(threads);
+    psi_rng rng;
+    if (psi_rng_init(&rng) != 0) return -1;
+    const paillier_pub *pub = &key->pub;
+    std::vector<uint8_t> buf, out;
+    st->own = n;
+
+    // 1. 交换行数与 Paillier 公钥
+    if (psi_expect_frame(conn, PSI_MSG_HELLO, buf) != 0 || buf.size() != 8) return -1;
+    const size_t peer = (size_t)psi_get_u64(&buf[0]);
+    st->peer = peer;
+    out.resize(16 + paillier_n_bytes(pub) + paillier_ct_bytes(pub));
+    psi_put_u64(&out[0], n);
+    psi_put_u64(&out[8], pub->bits);
+    paillier_pub_export(pub, &out[16], &out[16 + paillier_n_bytes(pub)]);
+    if (psi_send_frame(conn, PSI_MSG_PARAMS, out.data(), out.size()) != 0) return -1;
+
+    // 2. 对 P1 的每个点乘 k2，只留下标签
+    std::vector<psi_tag> tags;
+    tags.reserve(std::min(peer, (size_t)1 << 26));
+    std::atomic<int> bad(0);
+    for (;;) {
+        uint8_t type;
+        if (psi_recv_frame(conn, &type, buf) != 0) return -1;
+        if (type == PSI_MSG_DONE) break;
+        if (type != PSI_MSG_POINTS || buf.size() % PSI_POINT_BYTES != 0) return -1;
+        size_t m = buf.size() / PSI_POINT_BYTES, base = tags.size();
+        if (base + m > peer) return -1;
+        tags.resize(base + m);
+        pool.parallel_for((m + PSI_CHUNK - 1) / PSI_CHUNK, [&](size_t c) {
+            size_t lo = c * PSI_CHUNK, cnt = std::min((size_t)PSI_CHUNK, m - lo);
+            sm2_aff in[PSI_CHUNK], pts[PSI_CHUNK];
+            for (size_t i = 0; i < cnt; i++) {
+                if (psi_point_decode(&in[i], &buf[(lo + i) * PSI_POINT_BYTES]) != 0) {
+                    bad.store(1, std::memory_order_relaxed);
+                    return;
+                }
+            }
+            psi_mul_chunk(k2, in, cnt, pts);
+            for (size_t i = 0; i < cnt; i++) tags[base + lo + i] = psi_tag{pts[i].x[3], pts[i].x[2]};
+        });
+        if (bad.load()) return -1;
+    }
+    if (tags.size() != peer) return -1;
+
+    // 3. 打乱后发回，P1 无法把标签对应回自己的行
+    psi_shuffle(tags.data(), tags.size(), &rng);
+    for (size_t first = 0; first < tags.size(); first += PSI_TAG_FRAME) {
+        size_t m = std::min((size_t)PSI_TAG_FRAME, tags.size() - first);
+        out.resize(m * 16);
+        for (size_t i = 0; i < m; i++) {
+            psi_put_u64(&out[16 * i], tags[first + i].lo);
+            psi_put_u64(&out[16 * i + 8], tags[first + i].hi);
+        }
+        if (psi_send_frame(conn, PSI_MSG_TAGS, out.data(), out.size()) != 0) return -1;
+    }
+    if (psi_send_frame(conn, PSI_MSG_DONE, NULL, 0) != 0) return -1;
+    double t1 = now_sec();
+    st->t_peer = t1 - t0;
+
+    // 4. 按随机顺序发出 (k2 H(w), Enc(t))
+    const size_t ctw = paillier_ct_wire_bytes(pub), rec = PSI_POINT_BYTES + ctw;
+    std::vector<uint32_t> perm(n);
+    for (size_t i = 0; i < n; i++) perm[i] = (uint32_t)i;
+    psi_shuffle(perm.data(), n, &rng);
+    for (size_t first = 0; first < n; first += PSI_BATCH) {
+        size_t m = std::min((size_t)PSI_BATCH, n - first);
+        out.resize(m * rec);
+        pool.parallel_for((m + PSI_CHUNK - 1) / PSI_CHUNK, [&](size_t c) {
+            size_t lo = c * PSI_CHUNK, cnt = std::min((size_t)PSI_CHUNK, m - lo);
+            sm2_aff pts[PSI_CHUNK];
+            psi_hash_mul(rows, &perm[first + lo], cnt, k2, pts);
+            for (size_t i = 0; i < cnt; i++) {
+                uint8_t *p = &out[(lo + i) * rec];
+                psi_point_encode(p, &pts[i]);
+                uint64_t v = rows->values[perm[first + lo + i]];
+                int rc = rpool ? paillier_encrypt_pooled(rpool, v, p + PSI_POINT_BYTES)
+                               : paillier_encrypt(pub, v, p + PSI_POINT_BYTES);
+                if (rc != 0) {
+                    bad.store(1, std::memory_order_relaxed);
+                }
+            }
+        });
+        if (bad.load()) return -1;
+        if (psi_send_frame(conn, PSI_MSG_PAIRS, out.data(), out.size()) != 0) return -1;
+    }
+    if (psi_send_frame(conn, PSI_MSG_DONE, NULL, 0) != 0) return -1;
+    double t2 = now_sec();
+    st->t_own = t2 - t1;
+
+    // 5. 解密交集和
+    uint64_t m[BN_MAX_WORDS];
+    if (psi_expect_frame(conn, PSI_MSG_SUM, buf) != 0) return -1;
+    if (paillier_decrypt(key, buf.data(), buf.size(), m) != 0) return -1;
+    *sum = bn_to_dec(m, pub->kn);
+
+    double t3 = now_sec();
+    st->t_finish = t3 - t2;
+    st->t_total = t3 - t0;
+    st->bytes_sent = conn->bytes_sent;
+    st->bytes_recv = conn->bytes_recv;
+    return 0;
+}
+
+int psi_run_p2(psi_conn *conn, const psi_rows *rows, const paillier_priv *key, paillier_pool *rpool,
+               unsigned threads, std::string *sum, psi_stats *st) {
+    uint64_t k2[4];
+    memset(st, 0, sizeof(*st));
+    int rc = psi_random_scalar(k2);
+    if (rc == 0) rc = psi_p2_steps(conn, rows, key, rpool, threads, k2, sum, st);
+    psi_wipe(k2, sizeof(k2));
+    return rc;
+}
@@ -0,0 +1,62 @@
+#ifndef PSI_SUM_H
+#define PSI_SUM_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+#include "sm2_ec.h"
+#include "paillier.h"
+#include "psi_net.h"
+
+/*
+ * DDH 型 PSI-Sum：P1 持有标识集合 V，P2 持有 (w, t) 对；P1 只得到交集大小，P2 只得到交集上 t 的和。
+ * 群取 SM2 曲线（余因子为 1），H 为 SM3 try-and-increment 映射到曲线点，k1、k2 为两方的私有标量：
+ *   1. P1 -> P2  HELLO |V|；P2 -> P1  PARAMS：Paillier 公钥 (n, h) 与 |W|
+ *   2. P1 -> P2  POINTS：按随机顺序分批发送 k1·H(v)（33 字节压缩点）
+ *   3. P2 -> P1  TAGS：k2·(k1·H(v)) 的 x 坐标前 16 字节，全部收齐后打乱再发
+ *   4. P2 -> P1  PAIRS：按随机顺序发送 (k2·H(w), Enc(t))
+ *   5. P1 把每个 k2·H(w) 乘上 k1，命中标签的 Enc(t) 逐帧树形相乘后乘进累加器；重新随机化后 SUM 发给 P2 解密
+ * 密文一律用 paillier_ct_write 的长度前缀格式。
+ * 每批 PSI_BATCH 条为一帧，批内按 PSI_CHUNK 条一组交给线程池：组内的标识一起走多缓冲 SM3，
+ * 点乘结果一起转仿射（一次求逆）。点乘用常数时间的 ec_mul_ct，k1、k2 不会从时间上泄露。
+ */
+
+#define PSI_BATCH 4096
+#define PSI_CHUNK 64
+
+// 标识首尾相接放在一块内存里，千万行时比 std::string 数组省得多
+struct psi_rows {
+    std::vector<char> ids;
+    std::vector<uint64_t> off;      // 第 i 个标识为 ids[off[i], off[i + 1])
+    std::vector<uint64_t> values;   // 只有 P2 使用
+};
+
+static inline size_t psi_rows_count(const psi_rows *rows) {
+    return rows->off.empty() ? 0 : rows->off.size() - 1;
+}
+
+void psi_rows_add(psi_rows *rows, const char *id, size_t len, uint64_t value);
+// 每行一个标识；with_values 非 0 时每行为 "标识,数值"。空行跳过，格式错误返回 -1
+int psi_rows_load(psi_rows *rows, const char *path, int with_values);
+
+// out[i] = H(ids[i])：SM3(域分隔串 || 计数字节 || 标识) 作 x 坐标，x^3 - 3x + b 是平方数时取偶数 y，否则计数加一重试
+void psi_hash_to_curve(const uint8_t *const *ids, const size_t *lens, sm2_aff *out, size_t n);
+
+struct psi_stats {
+    size_t own, peer;           // 本方与对方的行数
+    size_t intersection;        // 只有 P1 知道
+    double t_own;               // 哈希、点乘并发出本方数据
+    double t_peer;              // 处理对方发来的点（P2 还包括打乱并发回标签）
+    double t_finish;            // P1：累加与重新随机化；P2：等待并解密 SUM
+    double t_total;
+    uint64_t bytes_sent, bytes_recv;
+};
+
+// threads 为 0 时用全部硬件线程；协议或网络错误返回 -1
+int psi_run_p1(psi_conn *conn, const psi_rows *rows, unsigned threads, psi_stats *st);
+// sum 为交集和的十进制串；rpool 非空时加密的随机化因子从池中取（池须建在 key->pub 上）
+int psi_run_p2(psi_conn *conn, const psi_rows *rows, const paillier_priv *key, paillier_pool *rpool,
+               unsigned threads, std::string *sum, psi_stats *st);
+
+#endif // PSI_SUM_H
@@ -0,0 +1,409 @@
+/* 库内热点计时（接口见 include/gmcrypto_trace.h，区段宏见 common/gm_trace.h）
+ * 每个线程第一次记账时从全局链表认领一条记录：优先复用已退出线程放回的，否则新分配后无锁压栈，链表只增不删。
+ * 之后只有属主线程写自己的记录（relaxed 原子读写，编译出来就是普通的 mov），汇总时遍历链表直接读，不加锁，
+ * 读到的可能落后几次调用。清零用全局纪元号：记录的纪元落后时由属主线程下次记账前自己清掉，汇总时跳过。 */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gmcrypto_trace.h"
+#include "../common/gm_trace.h"
+
+static const char *const zoneNames[GMCRYPTO_ZONE_COUNT] = {
+    "sm3-compress", "sm3-mb", "sm4-key-schedule", "sm4-block", "sm4-batch", "sm4-ctr-blocks",
+    "sm4-ctr", "sm4-cbc", "sm4-cfb", "sm4-ofb", "sm4-xts", "sm4-gcm", "sm4-ccm",
+};
+
+const char *gmcrypto_zone_name(int zone) {
+    if (zone < 0 || zone >= GMCRYPTO_ZONE_COUNT) return "unknown";
+    return zoneNames[zone];
+}
+
+#ifdef GMCRYPTO_INSTRUMENT
+
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#define TRACE_BUCKETS 256      /* 每个 2 的幂分 4 档，覆盖整个 64 位 */
+#define TRACE_NPMC    4        /* 周期、指令、缓存缺失、分支预测失败 */
+
+#define TRACE_LOAD(x)     __atomic_load_n(&(x), __ATOMIC_RELAXED)
+#define TRACE_STORE(x, v) __atomic_store_n(&(x), (v), __ATOMIC_RELAXED)
+
+typedef struct {
+    uint64_t calls, bytes, ticks, min, max;
+    uint64_t pmc[TRACE_NPMC];
+    uint64_t hist[TRACE_BUCKETS];
+} trace_zone;
+
+typedef struct trace_thread {
+    struct trace_thread *next;
+    int inUse;
+    unsigned epoch;
+    int perfTried;
+    int perfFd[TRACE_NPMC];     /* 各计数器的 fd，-1 表示没打开 */
+    int perfLeader;             /* 组长：第一个打开成功的，读它得到整组的值 */
+    int perfSlot[TRACE_NPMC];   /* 各计数器在组读结果里的位置，-1 表示没有 */
+    trace_zone z[GMCRYPTO_ZONE_COUNT];
+} trace_thread;
+
+int gm_trace_flags = -1;
+
+static trace_thread *traceThreads;
+static unsigned traceEpoch;
+static int traceState;                  /* 0 未初始化，1 初始化中，2 完成 */
+static uint64_t traceTick0;             /* 时基：初始化时的时间戳与单调时钟，汇总时据此换算 TSC 频率 */
+static double traceNs0;
+static const char *traceDumpPath;
+static _Thread_local trace_thread *traceSelf;
+static pthread_key_t traceKey;
+
+/* ===== 时间与计数器 ===== */
+
+static double mono_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* 每个时间戳单位的纳秒数；TSC 对照单调时钟，离初始化不足 10ms 时先等够 */
+static double trace_ns_per_tick(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    double ns;
+    uint64_t ticks;
+    do {
+        ticks = gm_trace_begin_ticks();
+        ns = mono_ns();
+    } while (ns - traceNs0 < 1e7);
+    return (ns - traceNs0) / (double)(ticks - traceTick0);
+#else
+    return 1.0;
+#endif
+}
+
+static void trace_perf_close(trace_thread *t) {
+#ifdef __linux__
+    for (int i = 0; i < TRACE_NPMC; ++i) {
+        if (t->perfFd[i] >= 0) close(t->perfFd[i]);
+        t->perfFd[i] = -1;
+    }
+#endif
+    t->perfLeader = -1;
+    t->perfTried = 0;
+}
+
+/* 为调用线程开一组计数器（pid 0：只计这个线程，只计用户态）；虚拟机里通常一个也打不开 */
+static void trace_perf_open(trace_thread *t) {
+    t->perfTried = 1;
+    t->perfLeader = -1;
+    for (int i = 0; i < TRACE_NPMC; ++i) {
+        t->perfFd[i] = -1;
+        t->perfSlot[i] = -1;
+    }
+#ifdef __linux__
+    static const uint64_t configs[TRACE_NPMC] = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES,
+    };
+    int n = 0;
+    for (int i = 0; i < TRACE_NPMC; ++i) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = configs[i];
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP;
+        attr.disabled = t->perfLeader < 0;
+        int fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, t->perfLeader, 0);
+        if (fd < 0) continue;
+        if (t->perfLeader < 0) t->perfLeader = fd;
+        t->perfFd[i] = fd;
+        t->perfSlot[i] = n++;
+    }
+    if (t->perfLeader >= 0) ioctl(t->perfLeader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+}
+
+/* ===== 线程记录 ===== */
+
+/* 线程退出：关掉它的计数器，把记录放回去给以后的线程用（已累计的数据留着，汇总本来就是各线程相加） */
+static void trace_thread_exit(void *p) {
+    trace_thread *t = (trace_thread *)p;
+    trace_perf_close(t);
+    traceSelf = NULL;
+    __atomic_store_n(&t->inUse, 0, __ATOMIC_RELEASE);
+}
+
+static trace_thread *trace_self(void) {
+    trace_thread *t = traceSelf;
+    if (t) return t;
+    for (t = __atomic_load_n(&traceThreads, __ATOMIC_ACQUIRE); t; t = t->next) {
+        int expect = 0;
+        if (__atomic_load_n(&t->inUse, __ATOMIC_RELAXED) == 0 &&
+            __atomic_compare_exchange_n(&t->inUse, &expect, 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            break;
+        }
+    }
+    if (!t) {
+        t = (trace_thread *)calloc(1, sizeof(trace_thread));
+        if (!t) return NULL;
+        t->inUse = 1;
+        t->epoch = TRACE_LOAD(traceEpoch);
+        trace_perf_close(t);
+        t->next = __atomic_load_n(&traceThreads, __ATOMIC_RELAXED);
+        while (!__atomic_compare_exchange_n(&traceThreads, &t->next, t, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+        }
+    }
+    traceSelf = t;
+    pthread_setspecific(traceKey, t);
+    return t;
+}
+
+static void trace_clear(trace_thread *t) {
+    for (int z = 0; z < GMCRYPTO_ZONE_COUNT; ++z) {
+        trace_zone *d = &t->z[z];
+        TRACE_STORE(d->calls, 0);
+        TRACE_STORE(d->bytes, 0);
+        TRACE_STORE(d->ticks, 0);
+        TRACE_STORE(d->min, 0);
+        TRACE_STORE(d->max, 0);
+        for (int i = 0; i < TRACE_NPMC; ++i) TRACE_STORE(d->pmc[i], 0);
+        for (int i = 0; i < TRACE_BUCKETS; ++i) TRACE_STORE(d->hist[i], 0);
+    }
+}
+
+static unsigned trace_bucket(uint64_t v) {
+    if (v < 4) return (unsigned)v;
+    unsigned msb = 63 - (unsigned)__builtin_clzll(v);
+    return msb * 4 + (unsigned)((v >> (msb - 2)) & 3);
+}
+
+/* 桶的中点，单位为时间戳 */
+static double trace_bucket_mid(unsigned b) {
+    if (b < 4) return b;
+    unsigned msb = b / 4, sub = b % 4;
+    double width = (double)((uint64_t)1 << (msb - 2));
+    return (4 + sub) * width + width / 2;
+}
+
+/* ===== 区段进出（由 common/gm_trace.h 的内联部分调用） ===== */
+
+static void trace_dump_at_exit(void);
+
+/* 并发的首次调用由第一个线程完成初始化，其余的等它 */
+int gm_trace_init(void) {
+    int expect = 0;
+    if (__atomic_compare_exchange_n(&traceState, &expect, 1, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        traceTick0 = gm_trace_begin_ticks();
+        traceNs0 = mono_ns();
+        pthread_key_create(&traceKey, trace_thread_exit);
+        int flags = GMCRYPTO_TRACE_TIME;
+        const char *env = getenv("GMCRYPTO_TRACE");
+        if (env && (!strcmp(env, "0") || !strcmp(env, "off"))) flags = 0;
+        if (env && !strcmp(env, "perf")) flags |= GMCRYPTO_TRACE_PERF;
+        const char *dump = getenv("GMCRYPTO_TRACE_DUMP");
+        if (dump && *dump) {
+            traceDumpPath = dump;
+            atexit(trace_dump_at_exit);
+        }
+        __atomic_store_n(&traceState, 2, __ATOMIC_RELEASE);
+        __atomic_store_n(&gm_trace_flags, flags, __ATOMIC_RELEASE);
+        if (flags & GMCRYPTO_TRACE_PERF) gmcrypto_trace_enable(flags);
+    } else {
+        while (__atomic_load_n(&traceState, __ATOMIC_ACQUIRE) != 2) {
+        }
+    }
+    return __atomic_load_n(&gm_trace_flags, __ATOMIC_RELAXED);
+}
+
+void gm_trace_pmc(uint64_t v[4]) {
+    trace_thread *t = trace_self();
+    memset(v, 0, TRACE_NPMC * sizeof(uint64_t));
+    if (!t) return;
+    if (!t->perfTried) trace_perf_open(t);
+#ifdef __linux__
+    if (t->perfLeader < 0) return;
+    uint64_t buf[1 + TRACE_NPMC];
+    if (read(t->perfLeader, buf, sizeof(buf)) < (ssize_t)sizeof(uint64_t)) return;
+    for (int i = 0; i < TRACE_NPMC; ++i) {
+        if (t->perfSlot[i] >= 0 && (uint64_t)t->perfSlot[i] < buf[0]) v[i] = buf[1 + t->perfSlot[i]];
+    }
+#endif
+}
+
+void gm_trace_record(gm_trace_scope *s, uint64_t t1) {
+    uint64_t pmc[TRACE_NPMC];
+    if (s->flags & GMCRYPTO_TRACE_PERF) gm_trace_pmc(pmc);
+    trace_thread *t = trace_self();
+    if (!t || (unsigned)s->zone >= GMCRYPTO_ZONE_COUNT) return;
+    unsigned epoch = TRACE_LOAD(traceEpoch);
+    if (t->epoch != epoch) {
+        trace_clear(t);
+        TRACE_STORE(t->epoch, epoch);
+    }
+    trace_zone *d = &t->z[s->zone];
+    /* 线程在两次读 TSC 之间换了核，而各核 TSC 不同步时可能倒退 */
+    uint64_t dt = t1 > s->t0 ? t1 - s->t0 : 0;
+    uint64_t calls = TRACE_LOAD(d->calls);
+    if (calls == 0 || dt < TRACE_LOAD(d->min)) TRACE_STORE(d->min, dt);
+    if (dt > TRACE_LOAD(d->max)) TRACE_STORE(d->max, dt);
+    TRACE_STORE(d->calls, calls + 1);
+    TRACE_STORE(d->bytes, TRACE_LOAD(d->bytes) + s->bytes);
+    TRACE_STORE(d->ticks, TRACE_LOAD(d->ticks) + dt);
+    unsigned b = trace_bucket(dt);
+    TRACE_STORE(d->hist[b], TRACE_LOAD(d->hist[b]) + 1);
+    if (s->flags & GMCRYPTO_TRACE_PERF) {
+        for (int i = 0; i < TRACE_NPMC; ++i) TRACE_STORE(d->pmc[i], TRACE_LOAD(d->pmc[i]) + (pmc[i] - s->pmc[i]));
+    }
+}
+
+/* ===== 对外接口 ===== */
+
+int gmcrypto_trace_enable(int flags) {
+    if (__atomic_load_n(&traceState, __ATOMIC_ACQUIRE) != 2) gm_trace_init();
+    flags &= GMCRYPTO_TRACE_TIME | GMCRYPTO_TRACE_PERF;
+    if (flags & GMCRYPTO_TRACE_PERF) {
+        flags |= GMCRYPTO_TRACE_TIME;
+        trace_thread *t = trace_self();
+        if (t && !t->perfTried) trace_perf_open(t);
+        if (!t || t->perfLeader < 0) flags &= ~GMCRYPTO_TRACE_PERF;
+    }
+    __atomic_store_n(&gm_trace_flags, flags, __ATOMIC_RELAXED);
+    return flags;
+}
+
+int gmcrypto_trace_stats(int zone, gmcrypto_zone_stats *out) {
+    if (zone < 0 || zone >= GMCRYPTO_ZONE_COUNT || !out) return -1;
+    if (__atomic_load_n(&traceState, __ATOMIC_ACQUIRE) != 2) gm_trace_init();
+    memset(out, 0, sizeof(*out));
+    uint64_t hist[TRACE_BUCKETS] = {0};
+    uint64_t ticks = 0, mn = UINT64_MAX, mx = 0;
+    const unsigned epoch = TRACE_LOAD(traceEpoch);
+    for (trace_thread *t = __atomic_load_n(&traceThreads, __ATOMIC_ACQUIRE); t; t = t->next) {
+        if (TRACE_LOAD(t->epoch) != epoch) continue;
+        const trace_zone *d = &t->z[zone];
+        uint64_t calls = TRACE_LOAD(d->calls);
+        if (!calls) continue;
+        out->calls += calls;
+        out->bytes += TRACE_LOAD(d->bytes);
+        ticks += TRACE_LOAD(d->ticks);
+        uint64_t v = TRACE_LOAD(d->min);
+        if (v < mn) mn = v;
+        v = TRACE_LOAD(d->max);
+        if (v > mx) mx = v;
+        out->cycles += TRACE_LOAD(d->pmc[0]);
+        out->instructions += TRACE_LOAD(d->pmc[1]);
+        out->cache_misses += TRACE_LOAD(d->pmc[2]);
+        out->branch_misses += TRACE_LOAD(d->pmc[3]);
+        for (int i = 0; i < TRACE_BUCKETS; ++i) hist[i] += TRACE_LOAD(d->hist[i]);
+    }
+    if (!out->calls) return 0;
+
+    const double scale = trace_ns_per_tick();
+    out->total_ns = ticks * scale;
+    out->min_ns = mn * scale;
+    out->max_ns = mx * scale;
+    /* 分位数按直方图重新计数，与 calls 可能差几次（汇总时属主线程还在写） */
+    uint64_t total = 0, acc = 0;
+    for (int i = 0; i < TRACE_BUCKETS; ++i) total += hist[i];
+    const uint64_t r50 = (total + 1) / 2, r99 = total - total / 100;
+    for (unsigned i = 0; i < TRACE_BUCKETS; ++i) {
+        if (!hist[i]) continue;
+        if (acc < r50 && acc + hist[i] >= r50) out->p50_ns = trace_bucket_mid(i) * scale;
+        if (acc < r99 && acc + hist[i] >= r99) out->p99_ns = trace_bucket_mid(i) * scale;
+        acc += hist[i];
+    }
+    return 0;
+}
+
+void gmcrypto_trace_reset(void) {
+    __atomic_fetch_add(&traceEpoch, 1, __ATOMIC_RELAXED);
+}
+
+int gmcrypto_trace_dump(FILE *f, int json) {
+    const int flags = __atomic_load_n(&traceState, __ATOMIC_ACQUIRE) == 2 ? TRACE_LOAD(gm_trace_flags) : gm_trace_init();
+    int first = 1;
+    if (json) {
+        fprintf(f, "{\n  \"flags\": %d,\n  \"ns_per_tick\": %.6f,\n  \"zones\": [\n", flags, trace_ns_per_tick());
+    } else {
+        fprintf(f, "%-18s %10s %12s %10s %10s %10s %10s %8s %7s %6s %10s %10s\n", "zone", "calls", "bytes",
+                "total ms", "mean ns", "p50 ns", "p99 ns", "ns/B", "cyc/B", "IPC", "cache-miss", "br-miss");
+    }
+    for (int z = 0; z < GMCRYPTO_ZONE_COUNT; ++z) {
+        gmcrypto_zone_stats s;
+        if (gmcrypto_trace_stats(z, &s) != 0 || !s.calls) continue;
+        const double mean = s.total_ns / s.calls;
+        if (json) {
+            fprintf(f, "%s    {\"zone\": \"%s\", \"calls\": %llu, \"bytes\": %llu, \"total_ns\": %.0f, \"mean_ns\": %.1f, "
+                    "\"min_ns\": %.1f, \"max_ns\": %.1f, \"p50_ns\": %.1f, \"p99_ns\": %.1f, \"cycles\": %llu, "
+                    "\"instructions\": %llu, \"cache_misses\": %llu, \"branch_misses\": %llu}",
+                    first ? "" : ",\n", zoneNames[z], (unsigned long long)s.calls, (unsigned long long)s.bytes,
+                    s.total_ns, mean, s.min_ns, s.max_ns, s.p50_ns, s.p99_ns, (unsigned long long)s.cycles,
+                    (unsigned long long)s.instructions, (unsigned long long)s.cache_misses,
+                    (unsigned long long)s.branch_misses);
+        } else {
+            fprintf(f, "%-18s %10llu %12llu %10.3f %10.1f %10.1f %10.1f %8.3f", zoneNames[z],
+                    (unsigned long long)s.calls, (unsigned long long)s.bytes, s.total_ns / 1e6, mean, s.p50_ns,
+                    s.p99_ns, s.bytes ? s.total_ns / s.bytes : 0.0);
+            if (s.cycles) {
+                fprintf(f, " %7.2f %6.2f %10llu %10llu\n", s.bytes ? (double)s.cycles / s.bytes : 0.0,
+                        (double)s.instructions / s.cycles, (unsigned long long)s.cache_misses,
+                        (unsigned long long)s.branch_misses);
+            } else {
+                fprintf(f, " %7s %6s %10s %10s\n", "-", "-", "-", "-");
+            }
+        }
+        first = 0;
+    }
+    if (json) fprintf(f, "%s  ]\n}\n", first ? "" : "\n");
+    return 0;
+}
+
+static void trace_dump_at_exit(void) {
+    if (!strcmp(traceDumpPath, "stderr")) {
+        gmcrypto_trace_dump(stderr, 0);
+        return;
+    }
+    if (!strcmp(traceDumpPath, "stdout")) {
+        gmcrypto_trace_dump(stdout, 0);
+        return;
+    }
+    FILE *f = fopen(traceDumpPath, "w");
+    if (!f) return;
+    size_t n = strlen(traceDumpPath);
+    gmcrypto_trace_dump(f, n >= 5 && !strcmp(traceDumpPath + n - 5, ".json"));
+    fclose(f);
+}
+
+#else /* !GMCRYPTO_INSTRUMENT：接口保留，什么也不做 */
+
+int gmcrypto_trace_enable(int flags) {
+    (void)flags;
+    return -1;
+}
+
+int gmcrypto_trace_stats(int zone, gmcrypto_zone_stats *out) {
+    (void)zone;
+    if (out) memset(out, 0, sizeof(*out));
+    return -1;
+}
+
+void gmcrypto_trace_reset(void) {
+}
+
+int gmcrypto_trace_dump(FILE *f, int json) {
+    (void)f;
+    (void)json;
+    return -1;
+}
+
+#endif /* GMCRYPTO_INSTRUMENT */
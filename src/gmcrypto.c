@@ -0,0 +1,28 @@
+/* libgmcrypto 初始化：在库加载时做一次 CPUID 检测，把各模块的实现选择全部定下来，
+ * 之后的调用不再经过首次调用时的检测分支，多线程同时首次调用也不会竞争。 */
+#include <stdio.h>
+#include "gmcrypto.h"
+#include "../common/cpu_features.h"
+
+static char dispatchInfo[256];
+
+void gmcrypto_init(void) {
+    cpu_features();
+    snprintf(dispatchInfo, sizeof(dispatchInfo),
+             "sm4-sbox=%s sm4-block=%s sm4-batch=%s sm3=%s sm3-mb=%s sm2-fp=%s",
+             sm4_sbox_name(), sm4_block_impl_name(),
+             sm4_batch_isa_name(sm4_batch_best_isa()),
+             sm3_compress_name(), sm3_mb_isa_name(sm3_mb_best_isa()),
+             sm2_fp_impl_name());
+}
+
+const char *gmcrypto_dispatch_info(void) {
+    if (!dispatchInfo[0]) gmcrypto_init();
+    return dispatchInfo;
+}
+
+#if defined(__GNUC__)
+__attribute__((constructor)) static void gmcrypto_load(void) {
+    gmcrypto_init();
+}
+#endif